@@ -0,0 +1,37 @@
+// access.cpp
+#include "access.h"
+#include <cctype>
+
+namespace {
+    // Chi so la Role
+    const char* const ROLE_NAMES[static_cast<unsigned>(Access::Role::COUNT)] = {"normal", "auditor", "admin"};
+}
+
+namespace Access {
+
+    const char* roleName(Role role) {
+        unsigned index = static_cast<unsigned>(role);
+        return index < static_cast<unsigned>(Role::COUNT) ? ROLE_NAMES[index] : "normal";
+    }
+
+    bool parseRole(const std::string& name, Role& role) {
+        std::string lower;
+        for (char c : name) lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        for (unsigned i = 0; i < static_cast<unsigned>(Role::COUNT); ++i) {
+            if (lower == ROLE_NAMES[i]) {
+                role = static_cast<Role>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string roleNames() {
+        std::string names;
+        for (unsigned i = 0; i < static_cast<unsigned>(Role::COUNT); ++i) {
+            if (i > 0) names += '/';
+            names += ROLE_NAMES[i];
+        }
+        return names;
+    }
+}
@@ -0,0 +1,88 @@
+// access.h
+#ifndef ACCESS_H
+#define ACCESS_H
+
+#include <cstdint>
+#include <string>
+
+// Phan quyen theo vai tro: moi vai tro co mot tap quyen (bitset 32 bit) nam trong bang chinh sach
+// duoc tinh luc bien dich. Kiem tra quyen chi la mot phep dich va AND tren bang constexpr, khong
+// so sanh chuoi. Them vai tro moi: them gia tri vao Role, ten vao access.cpp va mot dong vao POLICY.
+namespace Access {
+
+    // Ma vai tro luu trong User (1 byte). Tren dia van ghi ten vai tro ("userType:admin") de file cu
+    // va cong cu ngoai doc duoc; thu tu cac gia tri o day co the doi ma khong anh huong du lieu.
+    enum class Role : std::uint8_t {
+        Normal,     // Nguoi dung thong thuong: ho so, vi va giao dich cua chinh minh
+        Auditor,    // Kiem toan: xem tai khoan, giao dich, thong ke; khong sua gi
+        Admin,      // Quan ly: toan quyen
+        COUNT
+    };
+
+    enum class Permission : std::uint8_t {
+        ViewOwnProfile,
+        UpdateOwnProfile,
+        ChangeOwnPassword,
+        ViewOwnWallet,
+        TransferPoints,
+        ViewOwnHistory,
+        AdminConsole,        // Vao menu quan ly (thay cho menu nguoi dung thong thuong)
+        ViewAllUsers,
+        CreateAccounts,
+        UpdateOtherAccounts,
+        ViewAllTransactions,
+        ViewSystemStats,
+        ViewTransactionStats,
+        ViewAnalytics,
+        SearchUsers,
+        ImportUsers,
+        BackupData,
+        COUNT
+    };
+
+    typedef std::uint32_t PermissionSet;
+    static_assert(static_cast<unsigned>(Permission::COUNT) <= 32, "PermissionSet chi co 32 bit");
+
+    constexpr PermissionSet bit(Permission permission) {
+        return PermissionSet(1) << static_cast<unsigned>(permission);
+    }
+
+    // Tap quyen dung chung
+    constexpr PermissionSet OWN_ACCOUNT = bit(Permission::ViewOwnProfile) | bit(Permission::UpdateOwnProfile) |
+                                          bit(Permission::ChangeOwnPassword);
+    constexpr PermissionSet OVERSIGHT = bit(Permission::AdminConsole) | bit(Permission::ViewAllUsers) |
+                                        bit(Permission::ViewAllTransactions) | bit(Permission::ViewSystemStats) |
+                                        bit(Permission::ViewTransactionStats) | bit(Permission::ViewAnalytics) |
+                                        bit(Permission::SearchUsers);
+
+    // Bang chinh sach, chi so la Role
+    constexpr PermissionSet POLICY[static_cast<unsigned>(Role::COUNT)] = {
+        // Normal
+        OWN_ACCOUNT | bit(Permission::ViewOwnWallet) | bit(Permission::TransferPoints) | bit(Permission::ViewOwnHistory),
+        // Auditor
+        OWN_ACCOUNT | OVERSIGHT,
+        // Admin
+        OWN_ACCOUNT | OVERSIGHT | bit(Permission::CreateAccounts) | bit(Permission::UpdateOtherAccounts) |
+            bit(Permission::ImportUsers) | bit(Permission::BackupData),
+    };
+
+    constexpr bool allows(Role role, Permission permission) {
+        return (POLICY[static_cast<unsigned>(role)] >> static_cast<unsigned>(permission)) & 1u;
+    }
+
+    // Kiem tra bang chinh sach ngay luc bien dich
+    static_assert(!allows(Role::Normal, Permission::AdminConsole), "Nguoi dung thuong khong vao menu quan ly");
+    static_assert(!allows(Role::Auditor, Permission::UpdateOtherAccounts) && !allows(Role::Auditor, Permission::ImportUsers) &&
+                  !allows(Role::Auditor, Permission::BackupData) && !allows(Role::Auditor, Permission::CreateAccounts),
+                  "Kiem toan chi duoc xem");
+    static_assert(allows(Role::Admin, Permission::BackupData), "Admin co toan quyen quan ly");
+
+    // Ten vai tro tren dia / giao dien ("normal", "auditor", "admin")
+    const char* roleName(Role role);
+    // Ten -> vai tro (khong phan biet hoa thuong); false neu khong co vai tro nay
+    bool parseRole(const std::string& name, Role& role);
+    // Danh sach ten vai tro "normal/auditor/admin" (cho loi nhac va thong bao loi)
+    std::string roleNames();
+}
+
+#endif // ACCESS_H
@@ -0,0 +1,75 @@
+// arena.cpp
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+    const std::size_t HEADER_BYTES = 64; // Giu canh le toi da cho du lieu sau header khoi
+}
+
+MonotonicArena::MonotonicArena(std::size_t initialBlockBytes)
+    : initialBuffer(nullptr), initialSize(0), blocks(nullptr), current(nullptr), remaining(0),
+      nextBlockBytes(std::max<std::size_t>(initialBlockBytes, 256)) {
+    counters = Stats{0, 0, 0, 0};
+}
+
+MonotonicArena::MonotonicArena(void* buffer, std::size_t bytes)
+    : initialBuffer(static_cast<char*>(buffer)), initialSize(bytes), blocks(nullptr),
+      current(static_cast<char*>(buffer)), remaining(bytes), nextBlockBytes(std::max<std::size_t>(bytes * 2, 256)) {
+    counters = Stats{0, 0, 0, 0};
+}
+
+MonotonicArena::~MonotonicArena() {
+    release();
+}
+
+void MonotonicArena::newBlock(std::size_t minimumBytes) {
+    std::size_t size = std::max(nextBlockBytes, minimumBytes);
+    char* raw = static_cast<char*>(::operator new(HEADER_BYTES + size));
+    Block* block = reinterpret_cast<Block*>(raw);
+    block->next = blocks;
+    block->size = size;
+    blocks = block;
+    current = raw + HEADER_BYTES;
+    remaining = size;
+    nextBlockBytes = size * 2;
+    counters.blocks++;
+    counters.bytesReserved += size;
+}
+
+void* MonotonicArena::allocate(std::size_t bytes, std::size_t alignment) {
+    if (bytes == 0) bytes = 1;
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(current);
+    std::size_t padding = (alignment - address % alignment) % alignment;
+    if (current == nullptr || padding + bytes > remaining) {
+        newBlock(bytes + alignment);
+        address = reinterpret_cast<std::uintptr_t>(current);
+        padding = (alignment - address % alignment) % alignment;
+    }
+    char* result = current + padding;
+    current = result + bytes;
+    remaining -= padding + bytes;
+    counters.allocations++;
+    counters.bytesUsed += bytes;
+    return result;
+}
+
+const char* MonotonicArena::copy(const char* data, std::size_t length) {
+    char* target = static_cast<char*>(allocate(length, 1));
+    if (length > 0) std::memcpy(target, data, length);
+    return target;
+}
+
+void MonotonicArena::release() {
+    while (blocks) {
+        Block* next = blocks->next;
+        ::operator delete(blocks);
+        blocks = next;
+    }
+    current = initialBuffer;
+    remaining = initialSize;
+}
+
+MonotonicArena::Stats MonotonicArena::stats() const {
+    return counters;
+}
@@ -0,0 +1,123 @@
+// arena.h
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+// Vung nho cap phat tuyen tinh cho mot truy van (tuong duong std::pmr::monotonic_buffer_resource).
+// Cap phat chi tang con tro trong khoi hien tai, khoi moi lon gap doi khoi truoc;
+// deallocate() khong lam gi, toan bo bo nho duoc tra lai mot lan trong release() hoac khi huy arena.
+// Khong an toan khi dung tu nhieu thread cung luc.
+class MonotonicArena {
+public:
+    struct Stats {
+        std::size_t allocations;   // So lan allocate()
+        std::size_t bytesUsed;     // Tong byte da cap cho nguoi goi
+        std::size_t bytesReserved; // Tong kich thuoc cac khoi da xin tu heap
+        std::size_t blocks;        // So khoi (= so lan goi operator new)
+    };
+
+    explicit MonotonicArena(std::size_t initialBlockBytes = 16 * 1024);
+    // Dung 'buffer' (vd mang tren stack, nguoi goi so huu) truoc khi xin khoi tu heap
+    MonotonicArena(void* buffer, std::size_t bytes);
+    ~MonotonicArena();
+
+    void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+    void deallocate(void*, std::size_t, std::size_t = alignof(std::max_align_t)) {}
+
+    // Sao chep [data, data + length) vao arena (khong them '\0')
+    const char* copy(const char* data, std::size_t length);
+
+    // Tao doi tuong trong arena. Destructor khong bao gio duoc goi nen chi nhan kieu huy tam thuong.
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "MonotonicArena::create: kieu phai huy tam thuong");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Tra lai tat ca cac khoi; moi con tro da cap tu arena tro nen khong hop le
+    void release();
+
+    Stats stats() const;
+
+private:
+    struct Block {
+        Block* next;
+        std::size_t size; // Byte du lieu sau header
+    };
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    void newBlock(std::size_t minimumBytes);
+
+    char* initialBuffer;
+    std::size_t initialSize;
+    Block* blocks;          // Khoi moi nhat dung dau
+    char* current;
+    std::size_t remaining;
+    std::size_t nextBlockBytes;
+    Stats counters;
+};
+
+// Allocator cho container STL lay bo nho tu MonotonicArena (tuong tu std::pmr::polymorphic_allocator)
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(MonotonicArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.resource()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, std::size_t n) {
+        arena->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    MonotonicArena* resource() const { return arena; }
+
+private:
+    MonotonicArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.resource() == b.resource(); }
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) { return a.resource() != b.resource(); }
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+// Chuoi chi doc tro vao bo nho cua nguoi khac (arena, vung file da mmap); khong so huu du lieu
+struct StringRef {
+    const char* data;
+    std::size_t size;
+
+    StringRef() : data(""), size(0) {}
+    StringRef(const char* data, std::size_t size) : data(data), size(size) {}
+
+    std::string str() const { return std::string(data, size); }
+    bool empty() const { return size == 0; }
+};
+
+inline bool operator==(const StringRef& a, const char* b) {
+    std::size_t length = std::strlen(b);
+    return a.size == length && std::memcmp(a.data, b, length) == 0;
+}
+inline bool operator!=(const StringRef& a, const char* b) { return !(a == b); }
+
+inline std::ostream& operator<<(std::ostream& out, const StringRef& text) {
+    return out.write(text.data, static_cast<std::streamsize>(text.size));
+}
+
+#endif // ARENA_H
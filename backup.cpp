@@ -0,0 +1,384 @@
+// backup.cpp
+#include "backup.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include "logwriter.h"
+#include "shards.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+    const char* const BACKUP_DIR = "backups";
+    const char* const CATALOG_FILE = "backups/catalog.txt";
+    const char* const DATA_DIR = "data";
+    const char* const LOG_FILE = "data/transactions.log";
+    const char* const SUPPLY_FILE = "data/supply.txt";
+    const char* const BASE_FILE = "data/backup.base"; // Ban sao luu ma data/ dang dua tren (goc cua ban tang dan ke tiep)
+    const char* const ENTITY_DIRS[] = {"users", "wallets"};
+    const std::size_t COPY_CHUNK = 4 * 1024 * 1024;
+
+    unsigned long long sizeOf(const std::string& path) {
+        long long size = 0;
+        time_t modified;
+        return FileIO::fileStat(path, size, modified) ? static_cast<unsigned long long>(size) : 0;
+    }
+
+    bool exists(const std::string& path) {
+        long long size;
+        time_t modified;
+        return FileIO::fileStat(path, size, modified);
+    }
+
+    // Them doan [begin, end) cua 'from' vao cuoi 'to', tung khoi de khong doc ca file vao bo nho
+    bool appendRange(const std::string& from, unsigned long long begin, unsigned long long end, const std::string& to) {
+        std::string chunk;
+        while (begin < end) {
+            std::size_t length = static_cast<std::size_t>(std::min<unsigned long long>(COPY_CHUNK, end - begin));
+            if (!FileIO::readRange(from, begin, length, chunk) || chunk.size() != length ||
+                !FileIO::appendFile(to, chunk.data(), chunk.size())) {
+                std::cerr << "Loi: Khong the sao chep " << from << " sang " << to << std::endl;
+                return false;
+            }
+            begin += length;
+        }
+        return true;
+    }
+
+    // Ten theo thoi diem: yyyymmdd-hhmmss
+    std::string timestampName(time_t when) {
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y%m%d-%H%M%S", std::localtime(&when));
+        return std::string(buffer);
+    }
+
+    bool isDataFile(const std::string& name) {
+        return name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0 && name.find(".tmp-") == std::string::npos;
+    }
+
+    // Giu doc quyen Instances trong pham vi (doi tu khoa chia se cua tien trinh, tra lai khi ra khoi pham vi)
+    class SoleInstance {
+    public:
+        SoleInstance()
+            : slot(LockManager::resource(LockManager::Resource::Instances)), held(LockManager::instance().upgrade(slot)) {}
+        ~SoleInstance() {
+            if (held) LockManager::instance().downgrade(slot);
+        }
+        bool isHeld() const { return held; }
+    private:
+        LockManager::Slot slot;
+        bool held;
+    };
+
+    bool parseNumber(const std::string& text, unsigned long long& out) {
+        if (text.empty() || text.size() > 19 || text.find_first_not_of("0123456789") != std::string::npos) return false;
+        out = std::stoull(text);
+        return true;
+    }
+}
+
+BackupManager::CommitFence::CommitFence() : lock(BackupManager::instance().fenceMutex) {}
+
+BackupManager::BackupManager()
+    : capturing(false), changedSince(0), capturedFiles(0), copiedOnWrite(0), captureFailures(0) {
+    FileIO::setReplaceObserver(&BackupManager::onReplace);
+}
+
+BackupManager& BackupManager::instance() {
+    static BackupManager manager;
+    return manager;
+}
+
+void BackupManager::onReplace(const std::string& path) {
+    BackupManager& manager = instance();
+    if (!manager.capturing) return; // Khong sao luu: chi mot lan doc bien nguyen tu
+    if (!manager.captureTarget(path).empty()) {
+        manager.capture(path, true);
+    }
+}
+
+std::string BackupManager::captureTarget(const std::string& path) const {
+    // entityDirs/captureDir chi doi khi capturing = false
+    if (path == SUPPLY_FILE) return captureDir + "/supply.txt";
+    std::size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) return "";
+    auto dir = entityDirs.find(path.substr(0, slash));
+    if (dir == entityDirs.end()) return "";
+    return captureDir + "/" + dir->second + path.substr(slash); // Moi phan vung -> users/, wallets/ cua ban sao luu
+}
+
+void BackupManager::capture(const std::string& path, bool beforeReplace) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (!capturing || !captured.insert(path).second) return;
+    long long size;
+    time_t modified;
+    if (!FileIO::fileStat(path, size, modified)) return;       // Chua co tai diem cat
+    if (changedSince != 0 && modified < changedSince) return;   // Khong doi tu ban truoc
+    if (FileIO::linkFile(path, captureTarget(path))) {
+        capturedFiles++;
+        if (beforeReplace) copiedOnWrite++;
+    } else {
+        captureFailures++;
+    }
+}
+
+std::vector<BackupManager::Entry> BackupManager::list() const {
+    std::vector<Entry> entries;
+    std::vector<std::string> lines;
+    if (!FileIO::readLines(CATALOG_FILE, lines)) return entries;
+    for (const std::string& line : lines) {
+        std::vector<std::string> parts = Utils::splitString(line, '|');
+        if (parts.size() != 7 && parts.size() != 8) continue;
+        Entry entry;
+        unsigned long long cutTime, files;
+        if (!parseNumber(parts[2], cutTime) || !parseNumber(parts[3], entry.logEnd) ||
+            !parseNumber(parts[4], entry.userIndexEnd) || !parseNumber(parts[5], entry.walletIndexEnd) ||
+            !parseNumber(parts[6], files)) {
+            continue;
+        }
+        entry.id = parts[0];
+        entry.parent = parts[1];
+        entry.cutTime = static_cast<time_t>(cutTime);
+        entry.files = static_cast<std::size_t>(files);
+        if (parts.size() == 8) {
+            // Hang rao index cua tung phan vung: "<user>/<wallet>,<user>/<wallet>,..."
+            bool valid = true;
+            for (const std::string& shard : Utils::splitString(parts[7], ',')) {
+                std::vector<std::string> ends = Utils::splitString(shard, '/');
+                unsigned long long userEnd, walletEnd;
+                if (ends.size() != 2 || !parseNumber(ends[0], userEnd) || !parseNumber(ends[1], walletEnd)) {
+                    valid = false;
+                    break;
+                }
+                entry.userIndexEnds.push_back(userEnd);
+                entry.walletIndexEnds.push_back(walletEnd);
+            }
+            if (!valid) continue;
+        } else {
+            entry.userIndexEnds.push_back(entry.userIndexEnd);
+            entry.walletIndexEnds.push_back(entry.walletIndexEnd);
+        }
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+bool BackupManager::createSnapshot(bool full, SnapshotReport& report) {
+    std::lock_guard<std::mutex> serial(snapshotMutex);
+    auto startTime = std::chrono::steady_clock::now();
+    report = SnapshotReport();
+    // Hang rao va chup-khi-ghi (onReplace) chi co tac dung trong tien trinh nay: tien trinh khac ghi de
+    // file sau diem cat se lam hong ban sao luu. Chi sao luu khi la tien trinh duy nhat tren data/,
+    // giu doc quyen Instances den het lan sao luu de khong tien trinh nao khoi dong chen vao.
+    SoleInstance sole;
+    if (!sole.isHeld()) {
+        std::cerr << "Loi: Co tien trinh khac dang chay tren thu muc du lieu. Chi sao luu duoc khi day la tien trinh duy nhat."
+                  << std::endl;
+        return false;
+    }
+    const ShardLayout& layout = ShardLayout::instance();
+
+    std::vector<Entry> entries = list();
+    const Entry* parent = nullptr;
+    std::vector<std::string> base;
+    if (full || entries.empty()) {
+        parent = nullptr;
+    } else if (FileIO::readLines(BASE_FILE, base) && !base.empty()) {
+        // Sau khi khoi phuc ve ban cu, ban tiep theo phai dua tren ban da khoi phuc
+        for (const Entry& candidate : entries) {
+            if (candidate.id == base[0]) parent = &candidate;
+        }
+    } else {
+        parent = &entries.back();
+    }
+    Entry& entry = report.entry;
+
+    std::string name = timestampName(time(0));
+    std::string dir = std::string(BACKUP_DIR) + "/" + name;
+    for (int suffix = 2; exists(dir); ++suffix) {
+        dir = std::string(BACKUP_DIR) + "/" + name + "-" + std::to_string(suffix);
+    }
+    entry.id = dir.substr(std::string(BACKUP_DIR).size() + 1);
+    Utils::createDirectoryIfNotExists(BACKUP_DIR);
+    Utils::createDirectoryIfNotExists(dir);
+    for (const char* sub : ENTITY_DIRS) Utils::createDirectoryIfNotExists(dir + "/" + sub);
+
+    // Diem cat: khong giao dich nao dang ghi do vi/log; log da ghi het hang doi
+    {
+        std::unique_lock<std::shared_timed_mutex> fence(fenceMutex);
+        auto pauseStart = std::chrono::steady_clock::now();
+        TransactionLogWriter::instance().flush();
+        entry.cutTime = time(0);
+        entry.logEnd = sizeOf(LOG_FILE);
+        entry.userIndexEnd = 0;
+        entry.walletIndexEnd = 0;
+        for (std::size_t shard = 0; shard < layout.count(); ++shard) {
+            entry.userIndexEnds.push_back(sizeOf(layout.userIndexFile(shard)));
+            entry.walletIndexEnds.push_back(sizeOf(layout.walletIndexFile(shard)));
+            entry.userIndexEnd += entry.userIndexEnds.back();
+            entry.walletIndexEnd += entry.walletIndexEnds.back();
+        }
+        bool stale = parent && (entry.logEnd < parent->logEnd || parent->userIndexEnds.size() != layout.count());
+        for (std::size_t shard = 0; !stale && parent && shard < layout.count(); ++shard) {
+            stale = entry.userIndexEnds[shard] < parent->userIndexEnds[shard] ||
+                    entry.walletIndexEnds[shard] < parent->walletIndexEnds[shard];
+        }
+        if (stale) {
+            // data/ da bi thay doi ngoai he thong (khoi phuc, sao chep, phan vung lai): ban tang dan khong con dung
+            parent = nullptr;
+        }
+        std::lock_guard<std::mutex> lock(captureMutex);
+        captured.clear();
+        captureDir = dir;
+        entityDirs.clear();
+        for (std::size_t shard = 0; shard < layout.count(); ++shard) {
+            entityDirs[layout.userDir(shard)] = "users";
+            entityDirs[layout.walletDir(shard)] = "wallets";
+        }
+        // Dong ho cua mtime (he thong file) co the cham hon time() mot chut: lui mot giay cho an toan
+        changedSince = parent ? parent->cutTime - 1 : 0;
+        capturedFiles = 0;
+        copiedOnWrite = 0;
+        captureFailures = 0;
+        capturing = true;
+        report.pauseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pauseStart).count();
+    }
+    entry.parent = parent ? parent->id : "";
+
+    // Chup cac file con lai (file da bi ghi de sau diem cat da duoc giu ban cu)
+    for (const auto& dataDir : entityDirs) {
+        for (const std::string& file : FileIO::listDirectory(dataDir.first)) {
+            if (isDataFile(file)) capture(dataDir.first + "/" + file, false);
+        }
+    }
+    capture(SUPPLY_FILE, false);
+    std::size_t failures;
+    {
+        std::lock_guard<std::mutex> lock(captureMutex);
+        capturing = false;
+        captured.clear();
+        entry.files = capturedFiles;
+        report.copiedOnWrite = copiedOnWrite;
+        failures = captureFailures;
+    }
+    if (failures > 0) {
+        std::cerr << "Loi: Khong the chup " << failures << " file vao " << dir << ". Ban sao luu bi huy." << std::endl;
+        return false;
+    }
+
+    // File chi ghi them: chi chep doan moi tu ban truoc den hang rao offset (index: noi doan cua tung phan vung)
+    unsigned long long logBegin = parent ? parent->logEnd : 0;
+    if (!appendRange(LOG_FILE, logBegin, entry.logEnd, dir + "/transactions.log")) return false;
+    for (std::size_t shard = 0; shard < layout.count(); ++shard) {
+        if (!appendRange(layout.userIndexFile(shard), parent ? parent->userIndexEnds[shard] : 0,
+                         entry.userIndexEnds[shard], dir + "/user_index.txt") ||
+            !appendRange(layout.walletIndexFile(shard), parent ? parent->walletIndexEnds[shard] : 0,
+                         entry.walletIndexEnds[shard], dir + "/wallet_index.txt")) {
+            return false;
+        }
+    }
+    report.logBytes = entry.logEnd - logBegin;
+
+    // Dong catalog la diem commit: thu muc khong co trong catalog bi bo qua khi khoi phuc
+    std::string line = entry.id + "|" + entry.parent + "|" + std::to_string(entry.cutTime) + "|" +
+                       std::to_string(entry.logEnd) + "|" + std::to_string(entry.userIndexEnd) + "|" +
+                       std::to_string(entry.walletIndexEnd) + "|" + std::to_string(entry.files);
+    for (std::size_t shard = 0; layout.isSharded() && shard < layout.count(); ++shard) {
+        line += (shard == 0 ? "|" : ",") + std::to_string(entry.userIndexEnds[shard]) + "/" +
+                std::to_string(entry.walletIndexEnds[shard]);
+    }
+    line += "\n";
+    if (!FileIO::sync() || !FileIO::appendFile(CATALOG_FILE, line.data(), line.size()) ||
+        !FileIO::syncFile(CATALOG_FILE)) {
+        std::cerr << "Loi: Khong the ghi " << CATALOG_FILE << std::endl;
+        return false;
+    }
+    FileIO::replaceFile(BASE_FILE, entry.id + "\n");
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
+
+bool BackupManager::restore(const std::string& id, RestoreReport& report) {
+    auto startTime = std::chrono::steady_clock::now();
+    report = RestoreReport();
+    // Ban sao luu o bo cuc phang: data/ moi khong co shards.conf (phan vung lai bang --migrate-shards)
+    report.previousShards = ShardLayout::instance().count();
+    std::vector<Entry> entries = list();
+    if (entries.empty()) {
+        std::cerr << "Loi: Chua co ban sao luu nao trong " << CATALOG_FILE << std::endl;
+        return false;
+    }
+    std::unordered_map<std::string, const Entry*> byId;
+    for (const Entry& entry : entries) byId[entry.id] = &entry;
+
+    // Chuoi ban sao luu: ban day du -> ... -> ban can khoi phuc
+    const Entry* target = id.empty() ? &entries.back() : (byId.count(id) ? byId[id] : nullptr);
+    if (!target) {
+        std::cerr << "Loi: Khong tim thay ban sao luu " << id << std::endl;
+        return false;
+    }
+    std::vector<const Entry*> chain;
+    for (const Entry* entry = target; entry; ) {
+        chain.insert(chain.begin(), entry);
+        if (entry->parent.empty()) break;
+        auto parent = byId.find(entry->parent);
+        if (parent == byId.end() || chain.size() > entries.size()) {
+            std::cerr << "Loi: Thieu ban sao luu goc " << entry->parent << " cua " << entry->id << std::endl;
+            return false;
+        }
+        entry = parent->second;
+    }
+
+    // Dung du lieu moi trong thu muc rieng roi doi ten, data/ cu giu nguyen neu co loi
+    std::string stamp = timestampName(time(0));
+    std::string staging = std::string(DATA_DIR) + ".restore-" + stamp;
+    Utils::createDirectoryIfNotExists(staging);
+    for (const char* sub : ENTITY_DIRS) Utils::createDirectoryIfNotExists(staging + "/" + sub);
+    const char* const segments[] = {"transactions.log", "user_index.txt", "wallet_index.txt"};
+    for (const Entry* entry : chain) {
+        std::string dir = std::string(BACKUP_DIR) + "/" + entry->id;
+        for (const char* sub : ENTITY_DIRS) {
+            for (const std::string& file : FileIO::listDirectory(dir + "/" + sub)) {
+                std::string to = staging + "/" + sub + "/" + file;
+                std::remove(to.c_str()); // Ban moi hon ghi de ban cu
+                if (!FileIO::linkFile(dir + "/" + sub + "/" + file, to)) return false;
+                report.files++;
+            }
+        }
+        if (exists(dir + "/supply.txt")) {
+            std::remove((staging + "/supply.txt").c_str());
+            if (!FileIO::linkFile(dir + "/supply.txt", staging + "/supply.txt")) return false;
+        }
+        for (const char* segment : segments) {
+            std::string from = dir + "/" + segment;
+            if (!appendRange(from, 0, sizeOf(from), staging + "/" + segment)) return false;
+        }
+    }
+    if (!FileIO::replaceFile(staging + "/backup.base", target->id + "\n")) return false;
+    report.chainLength = chain.size();
+    report.logBytes = sizeOf(staging + "/transactions.log");
+    if (report.logBytes != target->logEnd || sizeOf(staging + "/user_index.txt") != target->userIndexEnd ||
+        sizeOf(staging + "/wallet_index.txt") != target->walletIndexEnd) {
+        std::cerr << "Loi: Ban sao luu khong day du (kich thuoc log/index khong khop catalog). Giu nguyen data/, "
+                  << "du lieu dung do o " << staging << std::endl;
+        return false;
+    }
+
+    FileIO::closeAll(); // Khong giu fd nao trong data/ cu
+    if (exists(DATA_DIR)) {
+        report.previousDataDir = std::string(DATA_DIR) + ".before-restore-" + stamp;
+        if (std::rename(DATA_DIR, report.previousDataDir.c_str()) != 0) {
+            std::cerr << "Loi: Khong the doi ten " << DATA_DIR << " thanh " << report.previousDataDir << std::endl;
+            return false;
+        }
+    }
+    if (std::rename(staging.c_str(), DATA_DIR) != 0) {
+        std::cerr << "Loi: Khong the doi ten " << staging << " thanh " << DATA_DIR << std::endl;
+        return false;
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
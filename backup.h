@@ -0,0 +1,106 @@
+// backup.h
+#ifndef BACKUP_H
+#define BACKUP_H
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Sao luu nhat quan tai mot thoi diem (snapshot) cua thu muc data/ trong khi van chuyen diem.
+// - Diem cat: giu CommitFence doc quyen trong chot lat (cho cac giao dich dang ghi vi/log xong),
+//   flush thread ghi log, ghi nhan kich thuoc transactions.log va cac file index (hang rao offset)
+// - Copy-on-write: sau diem cat, file nguoi dung/vi/supply.txt sap bi replaceFile thay the ma
+//   chua duoc chup se duoc hard link vao ban sao luu truoc khi rename, nen ban sao luu giu dung
+//   noi dung tai diem cat; file khong doi thi duoc link (khong sao chep du lieu)
+// - Tang dan: chi file sua doi tu diem cat truoc va doan log/index moi ghi them
+// Cau truc: backups/<id>/{users/,wallets/,supply.txt,transactions.log,user_index.txt,wallet_index.txt},
+// backups/catalog.txt moi dong mot ban sao luu da hoan tat (dong cuoi cung la diem commit).
+// Du lieu da phan vung (data/shards.conf) duoc sao luu theo cung cau truc phang: file cua moi phan vung
+// vao chung users/, wallets/, doan index moi cua tung phan vung noi vao user_index.txt/wallet_index.txt;
+// catalog ghi them hang rao offset index cua tung phan vung. Khoi phuc luon tao data/ bo cuc phang.
+// Cac file dan xuat (snapshot chi muc, contact_index.txt, analytics/) khong duoc sao luu, tu dung lai.
+// Hang rao va chup-khi-ghi chi co hieu luc trong tien trinh dang sao luu: sao luu bi tu choi khi tien trinh
+// khac cung giu Instances, va giu doc quyen Instances trong luc sao luu (tien trinh moi phai cho).
+class BackupManager {
+public:
+    struct Entry {
+        std::string id;
+        std::string parent;                // Rong neu la ban day du
+        time_t cutTime;
+        unsigned long long logEnd;         // Kich thuoc transactions.log tai diem cat
+        unsigned long long userIndexEnd;   // Tong cua cac phan vung
+        unsigned long long walletIndexEnd;
+        std::vector<unsigned long long> userIndexEnds;    // Tung phan vung (mot phan tu voi bo cuc phang)
+        std::vector<unsigned long long> walletIndexEnds;
+        std::size_t files;                 // So file nguoi dung/vi trong ban nay
+    };
+
+    struct SnapshotReport {
+        Entry entry;
+        std::size_t copiedOnWrite;         // File duoc giu ban cu khi bi ghi de trong luc sao luu
+        unsigned long long logBytes;       // So byte log trong ban nay
+        double pauseMs;                    // Thoi gian chan giao dich tai diem cat
+        double seconds;
+    };
+
+    struct RestoreReport {
+        std::size_t chainLength;           // So ban sao luu da ap dung (ban day du + tang dan)
+        std::size_t files;
+        unsigned long long logBytes;
+        std::string previousDataDir;       // Thu muc data/ cu da duoc doi ten
+        std::size_t previousShards;        // > 1: data/ cu da phan vung (du lieu khoi phuc o bo cuc phang)
+        double seconds;
+    };
+
+    // Giu trong suot phan ghi vi va ghi log cua mot giao dich (khoa chia se)
+    class CommitFence {
+    public:
+        CommitFence();
+    private:
+        std::shared_lock<std::shared_timed_mutex> lock;
+    };
+
+    static BackupManager& instance();
+
+    // Tao ban sao luu. full = false: tang dan so voi ban moi nhat (neu co va con hop le).
+    bool createSnapshot(bool full, SnapshotReport& report);
+
+    // Khoi phuc data/ ve ban sao luu 'id' (rong = ban moi nhat). Goi truoc khi khoi dong he thong.
+    // data/ hien tai duoc giu lai voi ten data.before-restore-<thoi diem>.
+    bool restore(const std::string& id, RestoreReport& report);
+
+    std::vector<Entry> list() const;
+
+private:
+    BackupManager();
+    BackupManager(const BackupManager&) = delete;
+    BackupManager& operator=(const BackupManager&) = delete;
+
+    static void onReplace(const std::string& path);
+    // Duong dan trong ban sao luu dang tao cua mot file du lieu, rong neu file khong duoc sao luu
+    std::string captureTarget(const std::string& path) const;
+    // Chup mot file vao ban sao luu dang tao (mot lan moi file): ghi nhan file da bien mat/chua co,
+    // bo qua neu khong doi tu ban truoc, neu khong thi link vao thu muc sao luu
+    void capture(const std::string& path, bool beforeReplace);
+
+    std::shared_timed_mutex fenceMutex;
+    std::mutex snapshotMutex;              // Moi luc chi mot lan sao luu
+
+    std::atomic<bool> capturing;
+    std::mutex captureMutex;
+    std::unordered_set<std::string> captured;
+    std::string captureDir;
+    std::unordered_map<std::string, std::string> entityDirs; // Thu muc users/wallets cua moi phan vung -> ten con
+    time_t changedSince;                   // 0: ban day du
+    std::size_t capturedFiles;
+    std::size_t copiedOnWrite;
+    std::size_t captureFailures;
+};
+
+#endif // BACKUP_H
@@ -0,0 +1,126 @@
+// bench/arena_bench.cpp
+// Dem so lan goi bo cap phat (operator new) cua mot truy van "xem tat ca giao dich":
+// cach cu (moi dong mot Transaction tren heap, cac truong la std::string) so voi
+// LogScanner::collect tra ve TransactionView trong MonotonicArena cua truy van.
+//
+// Bien dich (tu thu muc bench/):
+//   g++ -std=c++14 -O2 -pthread -I.. arena_bench.cpp $(ls ../*.cpp | grep -v main.cpp) -o arena_bench
+// Chay:
+//   ./arena_bench                      // Log gia lap 500.000 dong
+//   ./arena_bench 2000000              // Log gia lap N dong
+//   ./arena_bench ../data/transactions.log
+#include "arena.h"
+#include "logscan.h"
+#include "fileio.h"
+#include "utils.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+    std::atomic<std::size_t> allocationCount(0);
+    std::atomic<std::size_t> allocatedBytes(0);
+}
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    const char* const LOG_PATH = "arena_bench.log";
+
+    void makeLog(std::size_t lines) {
+        std::string log;
+        log.reserve(lines * 230);
+        char buffer[320];
+        for (std::size_t i = 0; i < lines; ++i) {
+            std::snprintf(buffer, sizeof(buffer),
+                          "transactionId:%08zx-4a46-44c2-849a-0735f0f52195|senderWalletId:%08zx-9cd0-49e9-b85c-2c495dd76b2c|"
+                          "receiverWalletId:%08zx-6e67-49f9-83b6-54272589214e|amount:%zu.%02zu|timestamp:%zu|"
+                          "status:%s|description:Chuyen diem giua hai vi trong he thong\n",
+                          i, i % 100000, (i * 7) % 100000, i % 1000, i % 100, 1700000000 + i,
+                          i % 20 == 0 ? "failed" : "completed");
+            log += buffer;
+        }
+        FileIO::writeFile(LOG_PATH, log);
+    }
+
+    struct Measure {
+        std::chrono::steady_clock::time_point start;
+        std::size_t allocations;
+        std::size_t bytes;
+
+        Measure() : start(std::chrono::steady_clock::now()),
+                    allocations(allocationCount.load()), bytes(allocatedBytes.load()) {}
+
+        void report(const char* name, std::size_t rows) const {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::size_t calls = allocationCount.load() - allocations;
+            std::printf("%-34s %8.3f s  %10zu lan cap phat  %8.1f MB  (%zu dong, %.2f lan/dong)\n", name, seconds,
+                        calls, (allocatedBytes.load() - bytes) / (1024.0 * 1024.0), rows,
+                        rows ? static_cast<double>(calls) / rows : 0.0);
+        }
+    };
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = LOG_PATH;
+    if (argc > 1 && std::strtoul(argv[1], nullptr, 10) == 0) {
+        path = argv[1];
+    } else {
+        makeLog(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500000);
+    }
+    // Khoi dong TaskScheduler va bang intern truoc de khong tinh vao lan do dau tien
+    {
+        LogScanner warmup(path);
+        MonotonicArena arena;
+        ArenaVector<TransactionView> rows{ArenaAllocator<TransactionView>(arena)};
+        warmup.collect(nullptr, rows);
+    }
+
+    // 1. Cach cu: doc tung dong, moi giao dich mot lan new/delete, cac truong std::string tren heap
+    {
+        Measure measure;
+        std::vector<std::string> lines = Utils::readAllLines(path);
+        std::vector<Transaction> transactions;
+        for (const std::string& line : lines) {
+            Transaction* transaction = Transaction::fromString(line);
+            if (transaction) {
+                transactions.push_back(*transaction);
+                delete transaction;
+            }
+        }
+        measure.report("heap: readAllLines + fromString", transactions.size());
+    }
+
+    // 2. Truy van tren arena: view tro vao log da mmap, ket qua trong arena
+    {
+        Measure measure;
+        LogScanner scanner(path);
+        MonotonicArena arena;
+        ArenaVector<TransactionView> transactions{ArenaAllocator<TransactionView>(arena)};
+        scanner.collect(nullptr, transactions);
+        measure.report("arena: LogScanner::collect", transactions.size());
+        MonotonicArena::Stats stats = arena.stats();
+        std::printf("  arena truy van: %zu lan allocate, %zu khoi, %.1f MB da dung\n", stats.allocations,
+                    stats.blocks, stats.bytesUsed / (1024.0 * 1024.0));
+    }
+
+    if (path == LOG_PATH) std::remove(LOG_PATH);
+    return 0;
+}
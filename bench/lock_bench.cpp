@@ -0,0 +1,136 @@
+// bench/lock_bench.cpp
+// Do thong luong cua LockManager khi nhieu tien trinh dung chung mot thu muc du lieu:
+// moi tien trinh con lap lai "khoa -> giu mot luc ngan -> nha" trong mot khoang thoi gian co dinh,
+// voi 1, 2, 4, 8 tien trinh va bon kieu tai:
+//   - vi ngau nhien: khoa doc quyen hai o thuc the (nhu mot lan chuyen diem) trong nhieu vi
+//   - vi nong:        nhu tren nhung chi 8 vi (tranh chap cao)
+//   - index chung:    khoa doc quyen mot o chi muc (nhu them vao wallet_index.txt / transactions.log)
+//   - doc chung:      khoa chia se mot o (nhieu nguoi doc cung luc khong phai cho)
+// Chi chay tren he thong POSIX (fork). Chay trong thu muc tam (data/locks rieng).
+//
+// Bien dich (tu thu muc bench/):
+//   g++ -std=c++14 -O2 -pthread -I.. lock_bench.cpp $(ls ../*.cpp | grep -v main.cpp) -o lock_bench
+// Chay:
+//   ./lock_bench              // Moi lan do 1 giay, giu khoa 2 micro giay
+//   ./lock_bench 3 10         // Moi lan do 3 giay, giu khoa 10 micro giay
+#include "lockmanager.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+int main() {
+    std::printf("lock_bench can fork(): chi chay tren Linux/Unix.\n");
+    return 0;
+}
+#else
+namespace {
+    enum class Workload { RandomWallets, HotWallets, SharedIndex, SharedReaders };
+
+    struct Result {
+        unsigned long long operations;
+        unsigned long long waitedOnFile;
+    };
+
+    void hold(long micros) {
+        // Gia lap cong viec trong vung khoa (doc phien ban + rename) bang vong cho ban
+        auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(micros);
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+
+    // Chay trong tien trinh con: LockManager duoc tao sau fork nen moi tien trinh co fd (va khoa) rieng
+    void runChild(Workload workload, double seconds, long holdMicros, unsigned seed, Result* out) {
+        LockManager& locks = LockManager::instance();
+        const std::size_t wallets = workload == Workload::HotWallets ? 8 : 100000;
+        LockManager::Slot index = LockManager::resource(LockManager::Resource::WalletIndex);
+        unsigned long long operations = 0;
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            for (int i = 0; i < 64; ++i) {
+                seed = seed * 1103515245u + 12345u;
+                if (workload == Workload::SharedIndex) {
+                    LockManager::Guard guard(index);
+                    hold(holdMicros);
+                } else if (workload == Workload::SharedReaders) {
+                    LockManager::Guard guard(index, LockManager::Mode::Shared);
+                    hold(holdMicros);
+                } else {
+                    std::size_t a = (seed >> 8) % wallets;
+                    std::size_t b = (seed >> 4) % wallets;
+                    LockManager::Guard guard(LockManager::entity('W', "wallet" + std::to_string(a)),
+                                             LockManager::entity('W', "wallet" + std::to_string(b)));
+                    hold(holdMicros);
+                }
+                operations++;
+            }
+        }
+        out->operations = operations;
+        out->waitedOnFile = locks.stats().waitedOnFile;
+    }
+
+    void measure(const char* name, Workload workload, double seconds, long holdMicros) {
+        std::printf("%s\n", name);
+        double baseline = 0;
+        const int counts[] = {1, 2, 4, 8};
+        for (int processes : counts) {
+            // Ket qua cua tien trinh con tra ve qua vung nho chia se
+            Result* results = static_cast<Result*>(::mmap(nullptr, sizeof(Result) * processes, PROT_READ | PROT_WRITE,
+                                                          MAP_SHARED | MAP_ANONYMOUS, -1, 0));
+            std::vector<pid_t> children;
+            for (int p = 0; p < processes; ++p) {
+                pid_t pid = ::fork();
+                if (pid == 0) {
+                    runChild(workload, seconds, holdMicros, 7919u * (p + 1), &results[p]);
+                    ::_exit(0);
+                }
+                children.push_back(pid);
+            }
+            for (pid_t pid : children) ::waitpid(pid, nullptr, 0);
+            unsigned long long operations = 0, waits = 0;
+            for (int p = 0; p < processes; ++p) {
+                operations += results[p].operations;
+                waits += results[p].waitedOnFile;
+            }
+            ::munmap(results, sizeof(Result) * processes);
+            double perSecond = operations / seconds;
+            if (processes == 1) baseline = perSecond;
+            std::printf("  %d tien trinh: %10.0f lan/giay (x%.2f so voi 1), %5.1f%% lan phai cho tien trinh khac\n",
+                        processes, perSecond, baseline > 0 ? perSecond / baseline : 0.0,
+                        operations ? 100.0 * waits / operations : 0.0);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+    long holdMicros = argc > 2 ? std::atol(argv[2]) : 2;
+    if (seconds <= 0) seconds = 1.0;
+
+    char dir[] = "/tmp/lock_bench.XXXXXX";
+    if (!::mkdtemp(dir) || ::chdir(dir) != 0 || ::mkdir("data", 0755) != 0) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    std::printf("Moi lan do %.1f giay, giu khoa %ld micro giay, %ld CPU\n", seconds, holdMicros,
+                ::sysconf(_SC_NPROCESSORS_ONLN));
+    measure("Vi ngau nhien (2 o doc quyen / lan, 100000 vi):", Workload::RandomWallets, seconds, holdMicros);
+    measure("Vi nong (2 o doc quyen / lan, 8 vi):", Workload::HotWallets, seconds, holdMicros);
+    measure("Index chung (1 o doc quyen):", Workload::SharedIndex, seconds, holdMicros);
+    measure("Doc chung (1 o chia se):", Workload::SharedReaders, seconds, holdMicros);
+
+    std::remove("data/locks");
+    ::rmdir("data");
+    ::chdir("/");
+    ::rmdir(dir);
+    return 0;
+}
+#endif
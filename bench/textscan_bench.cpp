@@ -0,0 +1,137 @@
+// bench/textscan_bench.cpp
+// So sanh cach parse transactions.log cu (std::getline tren istringstream) voi bo quet SIMD
+// (TextScan) tren tung tap lenh: scalar, SSE2, AVX2.
+//
+// Bien dich (tu thu muc bench/):
+//   g++ -std=c++14 -O2 -pthread -I.. textscan_bench.cpp $(ls ../*.cpp | grep -v main.cpp) -o textscan_bench
+// Chay:
+//   ./textscan_bench                      // Log gia lap 1.000.000 dong
+//   ./textscan_bench 5000000              // Log gia lap N dong
+//   ./textscan_bench ../data/transactions.log
+#include "textscan.h"
+#include "wallet.h"
+#include "fileio.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Cach parse truoc day: tach bang std::getline, sau do tach tung truong theo ':'
+    std::vector<std::string> legacySplit(const std::string& s, char delimiter) {
+        std::vector<std::string> tokens;
+        std::string token;
+        std::istringstream tokenStream(s);
+        while (std::getline(tokenStream, token, delimiter)) {
+            tokens.push_back(token);
+        }
+        return tokens;
+    }
+
+    bool legacyParse(const std::string& line, Transaction& transaction) {
+        std::vector<std::string> parts = legacySplit(line, '|');
+        if (parts.size() != 7) return false;
+        for (const std::string& part : parts) {
+            std::vector<std::string> keyValue = legacySplit(part, ':');
+            if (keyValue.size() < 2) continue;
+            std::string key = Utils::trimString(keyValue[0]);
+            std::string value = Utils::trimString(keyValue[1]);
+            if (key == "transactionId") transaction.transactionId = value;
+            else if (key == "senderWalletId") transaction.sender = internId(value);
+            else if (key == "receiverWalletId") transaction.receiver = internId(value);
+            else if (key == "amount") transaction.amount = std::stod(value);
+            else if (key == "timestamp") transaction.timestamp = std::stoll(value);
+            else if (key == "status") transaction.status = value;
+            else if (key == "description") transaction.description = value;
+        }
+        return true;
+    }
+
+    std::string makeLog(std::size_t lines) {
+        std::string log;
+        log.reserve(lines * 230);
+        char buffer[320];
+        for (std::size_t i = 0; i < lines; ++i) {
+            std::snprintf(buffer, sizeof(buffer),
+                          "transactionId:%08zx-4a46-44c2-849a-0735f0f52195|senderWalletId:%08zx-9cd0-49e9-b85c-2c495dd76b2c|"
+                          "receiverWalletId:%08zx-6e67-49f9-83b6-54272589214e|amount:%zu.%02zu|timestamp:%zu|"
+                          "status:%s|description:Chuyen diem\n",
+                          i, i % 100000, (i * 7) % 100000, i % 1000, i % 100, 1700000000 + i,
+                          i % 20 == 0 ? "failed" : "completed");
+            log += buffer;
+        }
+        return log;
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void report(const char* name, double seconds, std::size_t bytes, std::size_t count) {
+        std::printf("%-28s %8.3f s  %8.1f MB/s  (%zu)\n", name, seconds, bytes / seconds / (1024.0 * 1024.0), count);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::string log;
+    if (argc > 1 && std::strtoul(argv[1], nullptr, 10) == 0) {
+        if (!FileIO::readFileOnce(argv[1], log)) {
+            std::cerr << "Khong doc duoc " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        log = makeLog(argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000);
+    }
+    std::printf("Du lieu: %.1f MB, CPU ho tro: %s\n\n", log.size() / (1024.0 * 1024.0),
+                TextScan::isaName(TextScan::detectedIsa()));
+
+    // 1. Tach dong bang std::getline (cach cu cua readAllLines/splitString)
+    std::vector<std::string> lines;
+    {
+        auto start = std::chrono::steady_clock::now();
+        lines = legacySplit(log, '\n');
+        report("tach dong: getline", secondsSince(start), log.size(), lines.size());
+    }
+
+    // 2. Quet ky tu phan cach tren tung tap lenh
+    const TextScan::Isa isas[] = {TextScan::Isa::Scalar, TextScan::Isa::SSE2, TextScan::Isa::AVX2};
+    std::vector<std::size_t> positions;
+    for (TextScan::Isa isa : isas) {
+        if (static_cast<int>(isa) > static_cast<int>(TextScan::detectedIsa())) continue;
+        TextScan::setIsa(isa);
+        positions.clear();
+        positions.reserve(log.size() / 8);
+        auto start = std::chrono::steady_clock::now();
+        TextScan::findDelimiters(log.data(), log.size(), "\n|:", positions);
+        std::string name = std::string("quet \\n|: ") + TextScan::isaName(isa);
+        report(name.c_str(), secondsSince(start), log.size(), positions.size());
+    }
+    std::printf("\n");
+
+    // 3. Parse toan bo ban ghi giao dich
+    {
+        Transaction transaction;
+        std::size_t parsed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& line : lines) {
+            if (legacyParse(line, transaction)) parsed++;
+        }
+        report("parse: getline + split", secondsSince(start), log.size(), parsed);
+    }
+    for (TextScan::Isa isa : isas) {
+        if (static_cast<int>(isa) > static_cast<int>(TextScan::detectedIsa())) continue;
+        TextScan::setIsa(isa);
+        std::size_t parsed = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& line : lines) {
+            std::unique_ptr<Transaction> transaction(Transaction::fromString(line));
+            if (transaction) parsed++;
+        }
+        std::string name = std::string("parse: TextScan ") + TextScan::isaName(isa);
+        report(name.c_str(), secondsSince(start), log.size(), parsed);
+    }
+    return 0;
+}
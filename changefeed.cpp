@@ -0,0 +1,269 @@
+// changefeed.cpp
+#include "changefeed.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include "utils.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char* const CHANGES_FILE = "data/changes.log";
+    const char* const OFFSETS_DIR = "data/changes";
+    const std::size_t MAX_READ = 4 * 1024 * 1024;
+    const int FALLBACK_POLL_MS = 20;
+
+    // Su kien dang gom cua Batch ngoai cung tren thread nay (nullptr: ghi ngay)
+    struct PendingBatch {
+        std::string lines;
+        std::size_t events;
+    };
+    thread_local PendingBatch* currentBatch = nullptr;
+
+    long long nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // "thoi diem|loai|khoa|noi dung": '|' va xuong dong trong khoa bi thay de dong luon tach duoc
+    void formatLine(ChangeFeed::Kind kind, const std::string& key, const std::string& payload, std::string& out) {
+        out += std::to_string(nowMs());
+        out += '|';
+        out += static_cast<char>(kind);
+        out += '|';
+        for (char c : key) out += (c == '|' || c == '\n' || c == '\r') ? '_' : c;
+        out += '|';
+        for (char c : payload) {
+            if (c == '\n') out += '\t';
+            else if (c != '\r') out += c;
+        }
+        out += '\n';
+    }
+
+    bool parseLine(const char* data, std::size_t length, unsigned long long offset, ChangeFeed::Event& event) {
+        const char* end = data + length;
+        const char* first = static_cast<const char*>(std::memchr(data, '|', length));
+        if (!first || end - first < 3 || first[2] != '|') return false;
+        const char* third = static_cast<const char*>(std::memchr(first + 3, '|', end - first - 3));
+        if (!third) return false;
+        char kind = first[1];
+        if (kind != 'U' && kind != 'W' && kind != 'T') return false;
+        event.offset = offset;
+        event.timeMs = std::strtoll(data, nullptr, 10);
+        event.kind = static_cast<ChangeFeed::Kind>(kind);
+        event.key.assign(first + 3, third);
+        event.payload.assign(third + 1, end);
+        return true;
+    }
+}
+
+ChangeFeed::ChangeFeed() : published(0) {}
+
+ChangeFeed& ChangeFeed::instance() {
+    static ChangeFeed feed;
+    return feed;
+}
+
+std::string ChangeFeed::payloadOf(const std::string& record, const char* omitKey) {
+    std::string payload;
+    std::size_t omitLength = omitKey ? std::strlen(omitKey) : 0;
+    std::size_t pos = 0;
+    while (pos < record.size()) {
+        std::size_t lineEnd = record.find('\n', pos);
+        if (lineEnd == std::string::npos) lineEnd = record.size();
+        bool omit = omitKey && lineEnd - pos > omitLength && record.compare(pos, omitLength, omitKey) == 0 &&
+                    record[pos + omitLength] == ':';
+        if (!omit && lineEnd > pos) {
+            if (!payload.empty()) payload += '\t';
+            payload.append(record, pos, lineEnd - pos);
+        }
+        pos = lineEnd + 1;
+    }
+    return payload;
+}
+
+bool ChangeFeed::publish(Kind kind, const std::string& key, const std::string& payload) {
+    if (currentBatch) {
+        formatLine(kind, key, payload, currentBatch->lines);
+        currentBatch->events++;
+        return true;
+    }
+    std::string line;
+    formatLine(kind, key, payload, line);
+    return write(line, 1);
+}
+
+bool ChangeFeed::write(const std::string& lines, std::size_t events) {
+    if (lines.empty()) return true;
+    bool ok;
+    {
+        // Thu tu trong file = thu tu ghi giua moi thread/tien trinh; moi lo mot lan append nen khong xen ke
+        LockManager::Guard lock(LockManager::resource(LockManager::Resource::ChangeFeed));
+        ok = FileIO::appendFile(CHANGES_FILE, lines.data(), lines.size());
+    }
+    if (ok) {
+        published += events;
+    } else {
+        std::cerr << "Loi: Khong ghi duoc " << events << " su kien vao " << CHANGES_FILE << "." << std::endl;
+    }
+    return ok;
+}
+
+void ChangeFeed::recover() {
+    long long size = 0;
+    time_t modified = 0;
+    if (!FileIO::fileStat(CHANGES_FILE, size, modified) || size == 0) return;
+    std::string last;
+    if (FileIO::readRange(CHANGES_FILE, static_cast<unsigned long long>(size - 1), 1, last) && last != "\n") {
+        // Dong do dang tro thanh mot dong hong (nguoi doc bo qua) thay vi dinh vao su kien ke tiep
+        FileIO::appendFile(CHANGES_FILE, "\n", 1);
+        std::cerr << "Canh bao: Da bit dong ghi do dang o cuoi " << CHANGES_FILE << "." << std::endl;
+    }
+}
+
+ChangeFeed::Batch::Batch() : active(currentBatch == nullptr) {
+    if (active) {
+        currentBatch = new PendingBatch();
+        currentBatch->events = 0;
+    }
+}
+
+ChangeFeed::Batch::~Batch() {
+    if (!active) return;
+    PendingBatch* batch = currentBatch;
+    currentBatch = nullptr;
+    ChangeFeed::instance().write(batch->lines, batch->events);
+    delete batch;
+}
+
+ChangeFeed::Subscriber::Subscriber(const std::string& name)
+    : offsetPath(std::string(OFFSETS_DIR) + "/" + name + ".offset"), readPosition(0), watchFd(-1), wakeFd(-1),
+      wakeRequested(false) {
+    Utils::createDirectoryIfNotExists("data");
+    Utils::createDirectoryIfNotExists(OFFSETS_DIR);
+    FileIO::appendFile(CHANGES_FILE, "", 0); // Tao file neu chua co de theo doi duoc ngay
+    std::vector<std::string> lines;
+    if (FileIO::readLines(offsetPath, lines)) {
+        for (const std::string& line : lines) {
+            if (line.compare(0, 7, "offset:") == 0) readPosition = std::strtoull(line.c_str() + 7, nullptr, 10);
+        }
+    }
+#ifdef __linux__
+    watchFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd >= 0 && ::inotify_add_watch(watchFd, CHANGES_FILE, IN_MODIFY) < 0) {
+        ::close(watchFd);
+        watchFd = -1;
+    }
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#endif
+}
+
+ChangeFeed::Subscriber::~Subscriber() {
+#ifdef __linux__
+    if (watchFd >= 0) ::close(watchFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+#endif
+}
+
+bool ChangeFeed::Subscriber::readAvailable(std::vector<Event>& out, std::size_t maxEvents) {
+    long long size = 0;
+    time_t modified = 0;
+    if (!FileIO::fileStat(CHANGES_FILE, size, modified) || static_cast<unsigned long long>(size) <= readPosition) {
+        return false;
+    }
+    std::size_t length = static_cast<std::size_t>(
+        std::min<unsigned long long>(static_cast<unsigned long long>(size) - readPosition, MAX_READ));
+    std::string chunk;
+    if (!FileIO::readRange(CHANGES_FILE, readPosition, length, chunk)) return false;
+
+    // Chi nhan cac dong day du: dong cuoi co the dang duoc ghi
+    std::size_t added = 0;
+    std::size_t pos = 0;
+    while (pos < chunk.size() && added < maxEvents) {
+        std::size_t lineEnd = chunk.find('\n', pos);
+        if (lineEnd == std::string::npos) break;
+        Event event;
+        if (parseLine(chunk.data() + pos, lineEnd - pos, readPosition + pos, event)) {
+            out.push_back(std::move(event));
+            added++;
+        }
+        pos = lineEnd + 1;
+    }
+    readPosition += pos;
+    return added > 0;
+}
+
+bool ChangeFeed::Subscriber::waitForChange(int timeoutMs) {
+#ifdef __linux__
+    if (watchFd >= 0) {
+        struct pollfd fds[2];
+        fds[0].fd = watchFd;
+        fds[0].events = POLLIN;
+        fds[1].fd = wakeFd;
+        fds[1].events = POLLIN;
+        int ready = ::poll(fds, wakeFd >= 0 ? 2 : 1, timeoutMs);
+        if (ready <= 0) return false;
+        // Bo cac thong bao da nhan: poll() tiep theo chi thuc day khi file lai thay doi
+        char buffer[4096];
+        while (::read(watchFd, buffer, sizeof(buffer)) > 0) {
+        }
+        if (wakeFd >= 0 && (fds[1].revents & POLLIN)) {
+            unsigned long long counter;
+            ssize_t ignored = ::read(wakeFd, &counter, sizeof(counter));
+            (void)ignored;
+            wakeRequested = false;
+            return false;
+        }
+        return !wakeRequested.exchange(false);
+    }
+#endif
+    if (wakeRequested.exchange(false)) return false;
+    // Khong co inotify: cho tung khoang ngan roi de poll() kiem tra lai kich thuoc file
+    int slice = timeoutMs < 0 || timeoutMs > FALLBACK_POLL_MS ? FALLBACK_POLL_MS : timeoutMs;
+    std::this_thread::sleep_for(std::chrono::milliseconds(slice));
+    return !wakeRequested.exchange(false);
+}
+
+std::size_t ChangeFeed::Subscriber::poll(std::vector<Event>& out, int timeoutMs, std::size_t maxEvents) {
+    std::size_t before = out.size();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    for (;;) {
+        if (readAvailable(out, maxEvents)) break;
+        int remaining = -1;
+        if (timeoutMs >= 0) {
+            remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count());
+            if (remaining <= 0) break;
+        }
+        if (!waitForChange(remaining)) {
+            // Het thoi gian hoac wakeup(): lay not nhung gi vua den roi tra ve
+            readAvailable(out, maxEvents);
+            break;
+        }
+    }
+    return out.size() - before;
+}
+
+bool ChangeFeed::Subscriber::commit() {
+    return FileIO::replaceFile(offsetPath, "offset:" + std::to_string(readPosition) + "\n");
+}
+
+void ChangeFeed::Subscriber::wakeup() {
+    wakeRequested = true;
+#ifdef __linux__
+    if (wakeFd >= 0) {
+        unsigned long long one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+#endif
+}
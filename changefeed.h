@@ -0,0 +1,100 @@
+// changefeed.h
+#ifndef CHANGEFEED_H
+#define CHANGEFEED_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Luong thay doi (change data capture): moi lan luu nguoi dung, luu vi va moi giao dich chuyen diem
+// thanh cong duoc ghi them vao data/changes.log theo dung thu tu da xay ra (ca giua cac tien trinh,
+// xem LockManager). He thong khac doc luong nay thay vi quet va so sanh thu muc data/.
+// - Mot dong mot su kien: "thoi diem ms|loai|khoa|noi dung", loai U (nguoi dung), W (vi), T (giao dich).
+//   Noi dung la ban ghi "key:value" noi bang tab (nguoi dung: bo hashedPassword), giao dich: dong log.
+// - Vi tri (byte) cua dong trong file la ma su kien: tang dan, khong doi, dung lam offset cua nguoi doc
+// - Chi ghi them, khong bao gio bi thay the; dong bi ghi do dang luc crash duoc bit lai khi khoi dong
+// - Batch: cac su kien cua mot thao tac (hai vi + giao dich) ghi bang mot lan append, khong xen ke
+class ChangeFeed {
+public:
+    enum class Kind : char { User = 'U', Wallet = 'W', Transfer = 'T' };
+
+    struct Event {
+        unsigned long long offset;   // Vi tri dong trong changes.log (ma su kien)
+        long long timeMs;            // Thoi diem ghi (ms ke tu epoch)
+        Kind kind;
+        std::string key;             // username / walletId / transactionId
+        std::string payload;
+    };
+
+    // Gom cac su kien ghi tren thread nay trong pham vi doi tuong, ghi mot lan khi huy.
+    // Batch long trong Batch khac khong co tac dung (su kien vao batch ngoai cung).
+    class Batch {
+    public:
+        Batch();
+        ~Batch();
+    private:
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+        bool active;
+    };
+
+    // Nguoi doc co ten: vi tri da xu ly luu o data/changes/<ten>.offset (commit() moi ghi lai).
+    // Sau khi khoi dong lai, doc tiep tu vi tri da commit (su kien sau do co the duoc giao lai).
+    // Cho su kien moi bang inotify (Linux) va eventfd de wakeup(); he thong khac: hoi kich thuoc file dinh ky.
+    class Subscriber {
+    public:
+        explicit Subscriber(const std::string& name);
+        ~Subscriber();
+
+        // Lay toi da 'maxEvents' su kien moi; neu chua co thi cho toi da 'timeoutMs' (-1: cho mai).
+        // Tra ve so su kien them vao 'out' (0: het thoi gian cho hoac bi wakeup()).
+        std::size_t poll(std::vector<Event>& out, int timeoutMs, std::size_t maxEvents = 1024);
+        // Ghi lai vi tri sau su kien cuoi cung da tra ve
+        bool commit();
+        // Goi tu thread khac: poll() dang cho tra ve ngay
+        void wakeup();
+
+        unsigned long long position() const { return readPosition; }
+
+    private:
+        Subscriber(const Subscriber&) = delete;
+        Subscriber& operator=(const Subscriber&) = delete;
+
+        // Doc cac dong day du tu readPosition; false neu chua co gi moi
+        bool readAvailable(std::vector<Event>& out, std::size_t maxEvents);
+        // Cho file thay doi hoac wakeup(); false neu het thoi gian
+        bool waitForChange(int timeoutMs);
+
+        std::string offsetPath;
+        unsigned long long readPosition;
+        int watchFd;     // inotify (-1 neu khong co)
+        int wakeFd;      // eventfd (-1 neu khong co)
+        std::atomic<bool> wakeRequested;
+    };
+
+    static ChangeFeed& instance();
+
+    // Ghi mot su kien (hoac dua vao Batch dang mo tren thread nay)
+    bool publish(Kind kind, const std::string& key, const std::string& payload);
+
+    // Ban ghi "key:value" nhieu dong -> noi dung mot dong (noi bang tab), bo truong 'omitKey' neu co
+    static std::string payloadOf(const std::string& record, const char* omitKey = nullptr);
+
+    // Goi khi khoi dong (truoc moi lan ghi): bit dong ghi do dang o cuoi file bang '\n'
+    void recover();
+
+    unsigned long long publishedCount() const { return published.load(); }
+
+private:
+    ChangeFeed();
+    ChangeFeed(const ChangeFeed&) = delete;
+    ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+    // Append cac dong da dinh dang (duoi khoa ChangeFeed giua cac tien trinh)
+    bool write(const std::string& lines, std::size_t events);
+
+    std::atomic<unsigned long long> published;
+};
+
+#endif // CHANGEFEED_H
@@ -0,0 +1,520 @@
+// columnstore.cpp
+#include "columnstore.h"
+#include "logscan.h"
+#include "scheduler.h"
+#include "textscan.h"
+#include "utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COLUMNSTORE_X86 1
+#include <immintrin.h>
+#endif
+
+struct ColumnStore::Manifest {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t blockRows;
+    std::uint64_t rows;
+    std::uint64_t logOffset;          // Vi tri trong transactions.log da duoc xuat
+    std::uint64_t dictionaryEntries;
+    std::uint64_t dictionaryBytes;
+    std::uint64_t blockCount;
+};
+
+struct ColumnStore::ZoneMap {
+    std::uint64_t firstRow;
+    std::uint32_t rows;
+    std::uint32_t reserved;
+    std::int64_t baseTimestamp;       // Thoi gian cua dong dau khoi (moc giai ma chenh lech)
+    std::int64_t minTimestamp;
+    std::int64_t maxTimestamp;
+    std::int64_t minAmount;
+    std::int64_t maxAmount;
+};
+
+struct ColumnStore::Row {
+    std::int64_t timestamp;
+    std::uint32_t sender;
+    std::uint32_t receiver;
+    std::int64_t cents;
+    std::uint8_t status;
+};
+
+namespace {
+    const char MANIFEST_MAGIC[8] = {'H', 'T', 'Q', 'L', 'C', 'O', 'L', '1'};
+    const std::uint32_t MANIFEST_VERSION = 1;
+
+    const char* const MANIFEST_FILE = "manifest.bin";
+    const char* const DICTIONARY_FILE = "wallets.dict";
+    const char* const TIMESTAMP_FILE = "timestamp.col";
+    const char* const SENDER_FILE = "sender.col";
+    const char* const RECEIVER_FILE = "receiver.col";
+    const char* const AMOUNT_FILE = "amount.col";
+    const char* const STATUS_FILE = "status.col";
+
+    // Ket qua cua kernel tong hop tren mot doan dong
+    struct Totals {
+        long long cents;
+        std::size_t completed;
+        std::size_t failed;
+    };
+
+    template <typename T>
+    void appendValue(std::string& column, T value) {
+        column.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    T readValue(const std::string& column, std::size_t index) {
+        T value;
+        std::memcpy(&value, column.data() + index * sizeof(T), sizeof(T));
+        return value;
+    }
+
+    std::uint8_t statusCode(const StringRef& status) {
+        if (status == "completed") return ColumnStore::STATUS_COMPLETED;
+        if (status == "failed") return ColumnStore::STATUS_FAILED;
+        return ColumnStore::STATUS_OTHER;
+    }
+
+    // Cong so diem cua dong completed, dem completed/failed trong [0, n).
+    // times = nullptr: khong loc theo thoi gian (ca khoi nam trong khoang truy van)
+    void sumScalar(const std::int64_t* amounts, const std::uint8_t* status, const long long* times,
+                   std::size_t n, long long from, long long to, Totals& totals) {
+        long long cents = 0;
+        std::size_t completed = 0, failed = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            bool inRange = !times || (times[i] >= from && times[i] <= to);
+            bool isCompleted = inRange && status[i] == ColumnStore::STATUS_COMPLETED;
+            cents += isCompleted ? amounts[i] : 0;
+            completed += isCompleted;
+            failed += inRange && status[i] == ColumnStore::STATUS_FAILED;
+        }
+        totals.cents += cents;
+        totals.completed += completed;
+        totals.failed += failed;
+    }
+
+#ifdef COLUMNSTORE_X86
+    __attribute__((target("avx2")))
+    long long horizontalSum(__m256i v) {
+        alignas(32) long long lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    // Ban AVX2 cua sumScalar: moi vong xu ly 4 dong, mat na so sanh thay cho re nhanh
+    __attribute__((target("avx2")))
+    void sumAvx2(const std::int64_t* amounts, const std::uint8_t* status, const long long* times,
+                 std::size_t n, long long from, long long to, Totals& totals) {
+        const __m256i completedCode = _mm256_set1_epi64x(ColumnStore::STATUS_COMPLETED);
+        const __m256i failedCode = _mm256_set1_epi64x(ColumnStore::STATUS_FAILED);
+        const __m256i lower = _mm256_set1_epi64x(from);
+        const __m256i upper = _mm256_set1_epi64x(to);
+        __m256i sum = _mm256_setzero_si256();
+        __m256i completedCount = _mm256_setzero_si256();
+        __m256i failedCount = _mm256_setzero_si256();
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            std::int32_t packed;
+            std::memcpy(&packed, status + i, sizeof(packed));
+            __m256i codes = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packed));
+            __m256i isCompleted = _mm256_cmpeq_epi64(codes, completedCode);
+            __m256i isFailed = _mm256_cmpeq_epi64(codes, failedCode);
+            if (times) {
+                __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(times + i));
+                __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(lower, t), _mm256_cmpgt_epi64(t, upper));
+                isCompleted = _mm256_andnot_si256(outside, isCompleted);
+                isFailed = _mm256_andnot_si256(outside, isFailed);
+            }
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(amounts + i));
+            sum = _mm256_add_epi64(sum, _mm256_and_si256(a, isCompleted));
+            completedCount = _mm256_sub_epi64(completedCount, isCompleted); // Mat na dung = -1
+            failedCount = _mm256_sub_epi64(failedCount, isFailed);
+        }
+        totals.cents += horizontalSum(sum);
+        totals.completed += static_cast<std::size_t>(horizontalSum(completedCount));
+        totals.failed += static_cast<std::size_t>(horizontalSum(failedCount));
+        sumScalar(amounts + i, status + i, times ? times + i : nullptr, n - i, from, to, totals);
+    }
+#endif
+
+    void sumRows(const std::int64_t* amounts, const std::uint8_t* status, const long long* times,
+                 std::size_t n, long long from, long long to, Totals& totals) {
+#ifdef COLUMNSTORE_X86
+        if (TextScan::activeIsa() == TextScan::Isa::AVX2) {
+            sumAvx2(amounts, status, times, n, from, to, totals);
+            return;
+        }
+#endif
+        sumScalar(amounts, status, times, n, from, to, totals);
+    }
+}
+
+ColumnStore::ColumnStore(const std::string& dir) : dir(dir) {}
+
+ColumnStore::~ColumnStore() {}
+
+std::string ColumnStore::pathOf(const char* name) const {
+    return dir + "/" + name;
+}
+
+std::size_t ColumnStore::rowCount() const {
+    return manifest ? static_cast<std::size_t>(manifest->rows) : 0;
+}
+
+bool ColumnStore::loadManifest(Manifest& out, std::vector<ZoneMap>& outZones) const {
+    std::string content;
+    if (!FileIO::readFileOnce(pathOf(MANIFEST_FILE), content) || content.size() < sizeof(Manifest)) {
+        return false;
+    }
+    std::memcpy(&out, content.data(), sizeof(Manifest));
+    if (std::memcmp(out.magic, MANIFEST_MAGIC, sizeof(out.magic)) != 0 || out.version != MANIFEST_VERSION ||
+        out.blockRows != BLOCK_ROWS || content.size() != sizeof(Manifest) + out.blockCount * sizeof(ZoneMap)) {
+        return false;
+    }
+    outZones.resize(static_cast<std::size_t>(out.blockCount));
+    if (!outZones.empty()) {
+        std::memcpy(&outZones[0], content.data() + sizeof(Manifest), outZones.size() * sizeof(ZoneMap));
+    }
+    return true;
+}
+
+bool ColumnStore::writeManifest(const Manifest& m, const std::vector<ZoneMap>& z) const {
+    std::string content(reinterpret_cast<const char*>(&m), sizeof(Manifest));
+    if (!z.empty()) {
+        content.append(reinterpret_cast<const char*>(&z[0]), z.size() * sizeof(ZoneMap));
+    }
+    return FileIO::replaceFile(pathOf(MANIFEST_FILE), content);
+}
+
+bool ColumnStore::truncateColumns(std::uint64_t rows, std::uint64_t dictionaryBytes) const {
+    return FileIO::truncateFile(pathOf(TIMESTAMP_FILE), rows * sizeof(std::int32_t)) &&
+           FileIO::truncateFile(pathOf(SENDER_FILE), rows * sizeof(std::uint32_t)) &&
+           FileIO::truncateFile(pathOf(RECEIVER_FILE), rows * sizeof(std::uint32_t)) &&
+           FileIO::truncateFile(pathOf(AMOUNT_FILE), rows * sizeof(std::int64_t)) &&
+           FileIO::truncateFile(pathOf(STATUS_FILE), rows * sizeof(std::uint8_t)) &&
+           FileIO::truncateFile(pathOf(DICTIONARY_FILE), dictionaryBytes);
+}
+
+bool ColumnStore::readBlockRows(const ZoneMap& zone, std::vector<Row>& rows) const {
+    std::string deltas, sendersData, receiversData, amountsData, statusData;
+    std::size_t n = zone.rows;
+    if (!FileIO::readRange(pathOf(TIMESTAMP_FILE), zone.firstRow * sizeof(std::int32_t), n * sizeof(std::int32_t), deltas) ||
+        !FileIO::readRange(pathOf(SENDER_FILE), zone.firstRow * sizeof(std::uint32_t), n * sizeof(std::uint32_t), sendersData) ||
+        !FileIO::readRange(pathOf(RECEIVER_FILE), zone.firstRow * sizeof(std::uint32_t), n * sizeof(std::uint32_t), receiversData) ||
+        !FileIO::readRange(pathOf(AMOUNT_FILE), zone.firstRow * sizeof(std::int64_t), n * sizeof(std::int64_t), amountsData) ||
+        !FileIO::readRange(pathOf(STATUS_FILE), zone.firstRow, n, statusData)) {
+        return false;
+    }
+    std::int64_t timestamp = zone.baseTimestamp;
+    for (std::size_t i = 0; i < n; ++i) {
+        Row row;
+        timestamp += readValue<std::int32_t>(deltas, i);
+        row.timestamp = timestamp;
+        row.sender = readValue<std::uint32_t>(sendersData, i);
+        row.receiver = readValue<std::uint32_t>(receiversData, i);
+        row.cents = readValue<std::int64_t>(amountsData, i);
+        row.status = static_cast<std::uint8_t>(statusData[i]);
+        rows.push_back(row);
+    }
+    return true;
+}
+
+bool ColumnStore::exportFrom(const std::string& logPath, bool incremental, ExportReport& report) {
+    report = ExportReport{0, 0, 0, 0, false};
+    // Du lieu dang mo se thay doi: dong lai, goi open() sau khi xuat
+    manifest.reset();
+    timestamps.close();
+    senders.close();
+    receivers.close();
+    amounts.close();
+    statuses.close();
+    Utils::createDirectoryIfNotExists(dir);
+
+    Manifest m;
+    std::vector<ZoneMap> z;
+    std::vector<std::string> names;
+    std::unordered_map<IdHandle, std::uint32_t> ids; // Handle cua walletId -> ma trong tu dien
+    bool resume = incremental && loadManifest(m, z);
+
+    LogScanner scanner(logPath);
+    scanner.setStartOffset(resume ? static_cast<std::size_t>(m.logOffset) : 0);
+    if (!scanner.open()) {
+        std::cerr << "Loi: Khong the doc " << logPath << "." << std::endl;
+        return false;
+    }
+    if (resume && scanner.size() < m.logOffset) {
+        resume = false; // Log da bi thay the hoac cat ngan: xuat lai tu dau
+    }
+    if (resume) {
+        std::string dictionary;
+        FileIO::readRange(pathOf(DICTIONARY_FILE), 0, static_cast<std::size_t>(m.dictionaryBytes), dictionary);
+        names = Utils::splitString(dictionary, '\n');
+        resume = names.size() == m.dictionaryEntries;
+    }
+    if (!resume) {
+        std::memcpy(m.magic, MANIFEST_MAGIC, sizeof(m.magic));
+        m.version = MANIFEST_VERSION;
+        m.blockRows = BLOCK_ROWS;
+        m.rows = 0;
+        m.logOffset = 0;
+        m.dictionaryEntries = 0;
+        m.dictionaryBytes = 0;
+        m.blockCount = 0;
+        z.clear();
+        names.clear();
+        report.rebuilt = true;
+        scanner.setStartOffset(0);
+    }
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        ids[internId(names[i])] = static_cast<std::uint32_t>(i);
+    }
+
+    // Bo du lieu cot ghi do dang o lan truoc (vuot qua manifest)
+    if (!truncateColumns(m.rows, m.dictionaryBytes)) {
+        return false;
+    }
+
+    // Khoi cuoi chua day duoc mo lai de noi them dong moi vao
+    std::vector<Row> rows;
+    if (!z.empty() && z.back().rows < BLOCK_ROWS) {
+        if (!readBlockRows(z.back(), rows)) {
+            std::cerr << "Loi: Khong the doc lai khoi cuoi cua du lieu cot." << std::endl;
+            return false;
+        }
+        m.rows -= z.back().rows;
+        z.pop_back();
+        if (!truncateColumns(m.rows, m.dictionaryBytes)) {
+            return false;
+        }
+    }
+    std::size_t reopenedRows = rows.size();
+
+    // Doc phan log moi (song song theo doan); ban ghi tam nam trong arena, giai phong khi xuat xong
+    MonotonicArena arena;
+    ArenaVector<TransactionView> transactions{ArenaAllocator<TransactionView>(arena)};
+    if (!scanner.collect(nullptr, transactions)) {
+        std::cerr << "Loi: Khong the doc " << logPath << "." << std::endl;
+        return false;
+    }
+    std::string newNames;
+    auto encodeWallet = [&](IdHandle walletId) {
+        auto it = ids.find(walletId);
+        if (it != ids.end()) return it->second;
+        std::uint32_t id = static_cast<std::uint32_t>(names.size());
+        ids.emplace(walletId, id);
+        names.push_back(idToString(walletId));
+        newNames += names.back();
+        newNames += '\n';
+        return id;
+    };
+    rows.reserve(rows.size() + transactions.size());
+    for (const TransactionView& transaction : transactions) {
+        Row row;
+        row.timestamp = static_cast<std::int64_t>(transaction.timestamp);
+        row.sender = encodeWallet(transaction.sender);
+        row.receiver = encodeWallet(transaction.receiver);
+        row.cents = static_cast<std::int64_t>(std::llround(transaction.amount * 100.0));
+        row.status = statusCode(transaction.status);
+        rows.push_back(row);
+    }
+
+    // Ma hoa theo khoi; khoi ket thuc som neu chenh lech thoi gian vuot qua int32
+    std::string deltaColumn, senderColumn, receiverColumn, amountColumn, statusColumn;
+    std::size_t i = 0;
+    while (i < rows.size()) {
+        ZoneMap zone;
+        std::memset(&zone, 0, sizeof(zone));
+        zone.firstRow = m.rows;
+        zone.baseTimestamp = rows[i].timestamp;
+        zone.minTimestamp = zone.maxTimestamp = rows[i].timestamp;
+        zone.minAmount = zone.maxAmount = rows[i].cents;
+        std::int64_t previous = rows[i].timestamp;
+        while (i < rows.size() && zone.rows < BLOCK_ROWS) {
+            const Row& row = rows[i];
+            std::int64_t delta = row.timestamp - previous;
+            if (delta > INT32_MAX || delta < INT32_MIN) break;
+            appendValue<std::int32_t>(deltaColumn, static_cast<std::int32_t>(delta));
+            appendValue<std::uint32_t>(senderColumn, row.sender);
+            appendValue<std::uint32_t>(receiverColumn, row.receiver);
+            appendValue<std::int64_t>(amountColumn, row.cents);
+            appendValue<std::uint8_t>(statusColumn, row.status);
+            zone.minTimestamp = std::min(zone.minTimestamp, row.timestamp);
+            zone.maxTimestamp = std::max(zone.maxTimestamp, row.timestamp);
+            zone.minAmount = std::min(zone.minAmount, row.cents);
+            zone.maxAmount = std::max(zone.maxAmount, row.cents);
+            previous = row.timestamp;
+            zone.rows++;
+            m.rows++;
+            i++;
+        }
+        z.push_back(zone);
+    }
+
+    // Du lieu cot truoc, manifest sau cung (diem commit)
+    if (!FileIO::appendFile(pathOf(TIMESTAMP_FILE), deltaColumn.data(), deltaColumn.size()) ||
+        !FileIO::appendFile(pathOf(SENDER_FILE), senderColumn.data(), senderColumn.size()) ||
+        !FileIO::appendFile(pathOf(RECEIVER_FILE), receiverColumn.data(), receiverColumn.size()) ||
+        !FileIO::appendFile(pathOf(AMOUNT_FILE), amountColumn.data(), amountColumn.size()) ||
+        !FileIO::appendFile(pathOf(STATUS_FILE), statusColumn.data(), statusColumn.size()) ||
+        !FileIO::appendFile(pathOf(DICTIONARY_FILE), newNames.data(), newNames.size())) {
+        return false;
+    }
+    m.logOffset = scanner.scannedEnd();
+    m.dictionaryEntries = names.size();
+    m.dictionaryBytes += newNames.size();
+    m.blockCount = z.size();
+    if (!writeManifest(m, z)) {
+        return false;
+    }
+
+    report.appendedRows = rows.size() - reopenedRows;
+    report.totalRows = static_cast<std::size_t>(m.rows);
+    report.blocks = z.size();
+    report.walletIds = names.size();
+    return true;
+}
+
+bool ColumnStore::open() {
+    std::unique_ptr<Manifest> m(new Manifest());
+    std::vector<ZoneMap> z;
+    if (!loadManifest(*m, z)) {
+        return false;
+    }
+    std::string dictionaryData;
+    if (!FileIO::readRange(pathOf(DICTIONARY_FILE), 0, static_cast<std::size_t>(m->dictionaryBytes), dictionaryData)) {
+        return false;
+    }
+    std::vector<std::string> names = Utils::splitString(dictionaryData, '\n');
+    std::size_t rows = static_cast<std::size_t>(m->rows);
+    if (names.size() != m->dictionaryEntries ||
+        !timestamps.open(pathOf(TIMESTAMP_FILE)) || timestamps.size() < rows * sizeof(std::int32_t) ||
+        !senders.open(pathOf(SENDER_FILE)) || senders.size() < rows * sizeof(std::uint32_t) ||
+        !receivers.open(pathOf(RECEIVER_FILE)) || receivers.size() < rows * sizeof(std::uint32_t) ||
+        !amounts.open(pathOf(AMOUNT_FILE)) || amounts.size() < rows * sizeof(std::int64_t) ||
+        !statuses.open(pathOf(STATUS_FILE)) || statuses.size() < rows) {
+        std::cerr << "Loi: Du lieu cot trong " << dir << " khong hop le." << std::endl;
+        return false;
+    }
+    manifest = std::move(m);
+    zones.swap(z);
+    dictionary.swap(names);
+    return true;
+}
+
+void ColumnStore::decodeTimestamps(const ZoneMap& zone, std::vector<long long>& out) const {
+    out.resize(zone.rows);
+    const std::int32_t* deltas = reinterpret_cast<const std::int32_t*>(timestamps.data()) + zone.firstRow;
+    long long timestamp = zone.baseTimestamp;
+    for (std::uint32_t i = 0; i < zone.rows; ++i) {
+        timestamp += deltas[i];
+        out[i] = timestamp;
+    }
+}
+
+std::vector<ColumnStore::DailyVolume> ColumnStore::dailyVolumes(time_t from, time_t to) const {
+    std::vector<std::map<int, Totals> > partials(zones.size());
+    const std::int64_t* amountData = reinterpret_cast<const std::int64_t*>(amounts.data());
+    const std::uint8_t* statusData = reinterpret_cast<const std::uint8_t*>(statuses.data());
+
+    // Moi khoi duoc xu ly doc lap tren TaskScheduler
+    TaskScheduler::instance().parallelFor(0, zones.size(), 1, [&](std::size_t first, std::size_t last) {
+        std::vector<long long> times;
+        for (std::size_t b = first; b < last; ++b) {
+            const ZoneMap& zone = zones[b];
+            // Zone map: bo qua khoi nam ngoai khoang truy van ma khong can giai ma
+            if (zone.maxTimestamp < from || zone.minTimestamp > to) continue;
+            bool whole = zone.minTimestamp >= from && zone.maxTimestamp <= to;
+            const std::int64_t* blockAmounts = amountData + zone.firstRow;
+            const std::uint8_t* blockStatus = statusData + zone.firstRow;
+            decodeTimestamps(zone, times);
+
+            int firstDay = LogScanner::dayOf(static_cast<time_t>(zone.minTimestamp));
+            if (firstDay == LogScanner::dayOf(static_cast<time_t>(zone.maxTimestamp))) {
+                // Ca khoi trong mot ngay: mot lan chay kernel
+                sumRows(blockAmounts, blockStatus, whole ? nullptr : times.data(), zone.rows, from, to,
+                        partials[b][firstDay]);
+                continue;
+            }
+            // Khoi vat qua nhieu ngay: chia thanh cac doan lien tiep cung ngay
+            long long cachedSlot = -1;
+            int cachedDay = 0;
+            auto dayAt = [&](long long timestamp) {
+                if (timestamp / 900 != cachedSlot) {
+                    cachedSlot = timestamp / 900;
+                    cachedDay = LogScanner::dayOf(static_cast<time_t>(timestamp));
+                }
+                return cachedDay;
+            };
+            std::size_t runBegin = 0;
+            while (runBegin < zone.rows) {
+                int day = dayAt(times[runBegin]);
+                std::size_t runEnd = runBegin + 1;
+                while (runEnd < zone.rows && dayAt(times[runEnd]) == day) ++runEnd;
+                sumRows(blockAmounts + runBegin, blockStatus + runBegin, times.data() + runBegin,
+                        runEnd - runBegin, from, to, partials[b][day]);
+                runBegin = runEnd;
+            }
+        }
+    });
+
+    std::map<int, Totals> merged;
+    for (const std::map<int, Totals>& partial : partials) {
+        for (const auto& entry : partial) {
+            Totals& totals = merged[entry.first];
+            totals.cents += entry.second.cents;
+            totals.completed += entry.second.completed;
+            totals.failed += entry.second.failed;
+        }
+    }
+    std::vector<DailyVolume> result;
+    for (const auto& entry : merged) {
+        if (entry.second.completed == 0 && entry.second.failed == 0) continue;
+        result.push_back(DailyVolume{entry.first, entry.second.cents, entry.second.completed, entry.second.failed});
+    }
+    return result;
+}
+
+std::vector<ColumnStore::SenderVolume> ColumnStore::topSenders(std::size_t limit, time_t from, time_t to) const {
+    // Ma vi la chi so lien tuc nen tong hop bang mang thay vi bang bam
+    std::vector<long long> cents(dictionary.size(), 0);
+    std::vector<std::size_t> counts(dictionary.size(), 0);
+    const std::uint32_t* senderData = reinterpret_cast<const std::uint32_t*>(senders.data());
+    const std::int64_t* amountData = reinterpret_cast<const std::int64_t*>(amounts.data());
+    const std::uint8_t* statusData = reinterpret_cast<const std::uint8_t*>(statuses.data());
+    std::vector<long long> times;
+
+    for (const ZoneMap& zone : zones) {
+        if (zone.maxTimestamp < from || zone.minTimestamp > to) continue;
+        bool whole = zone.minTimestamp >= from && zone.maxTimestamp <= to;
+        if (!whole) decodeTimestamps(zone, times);
+        for (std::uint32_t i = 0; i < zone.rows; ++i) {
+            std::size_t row = static_cast<std::size_t>(zone.firstRow) + i;
+            if (statusData[row] != STATUS_COMPLETED) continue;
+            if (!whole && (times[i] < from || times[i] > to)) continue;
+            std::uint32_t sender = senderData[row];
+            if (sender >= cents.size()) continue;
+            cents[sender] += amountData[row];
+            counts[sender]++;
+        }
+    }
+
+    std::vector<std::uint32_t> order;
+    for (std::uint32_t id = 0; id < cents.size(); ++id) {
+        if (counts[id] > 0) order.push_back(id);
+    }
+    std::size_t shown = std::min(limit, order.size());
+    std::partial_sort(order.begin(), order.begin() + shown, order.end(),
+                      [&](std::uint32_t a, std::uint32_t b) { return cents[a] > cents[b]; });
+    std::vector<SenderVolume> result;
+    for (std::size_t i = 0; i < shown; ++i) {
+        result.push_back(SenderVolume{dictionary[order[i]], cents[order[i]], counts[order[i]]});
+    }
+    return result;
+}
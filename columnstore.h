@@ -0,0 +1,95 @@
+// columnstore.h
+#ifndef COLUMNSTORE_H
+#define COLUMNSTORE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
+#include <ctime>
+#include "fileio.h"
+
+// Ban xuat dang cot cua lich su giao dich cho bao cao (thu muc data/analytics/).
+// Moi cot nam trong mot file rieng, chia thanh cac khoi toi da BLOCK_ROWS dong:
+//   timestamp.col  int32  chenh lech so voi dong truoc (dong dau khoi so voi moc cua khoi)
+//   sender.col     uint32 ma vi trong tu dien wallets.dict
+//   receiver.col   uint32 ma vi trong tu dien wallets.dict
+//   amount.col     int64  so diem tinh bang phan tram (x100)
+//   status.col     uint8  0 = completed, 1 = failed, 2 = khac
+// manifest.bin chua so dong, vi tri da doc trong transactions.log, kich thuoc tu dien va
+// zone map (min/max thoi gian va so diem) cua tung khoi. manifest.bin duoc thay the nguyen tu
+// sau cung nen la diem commit: du lieu cot vuot qua manifest (do crash) bi cat bo o lan xuat sau.
+class ColumnStore {
+public:
+    enum Status {
+        STATUS_COMPLETED = 0,
+        STATUS_FAILED = 1,
+        STATUS_OTHER = 2
+    };
+
+    struct ExportReport {
+        std::size_t appendedRows;
+        std::size_t totalRows;
+        std::size_t blocks;
+        std::size_t walletIds;  // So ma trong tu dien
+        bool rebuilt;           // true neu xuat lai tu dau
+    };
+
+    // Tong hop theo ngay (so diem tinh bang phan tram)
+    struct DailyVolume {
+        int day;                // yyyymmdd
+        long long cents;
+        std::size_t completed;
+        std::size_t failed;
+    };
+
+    struct SenderVolume {
+        std::string walletId;
+        long long cents;
+        std::size_t transactions;
+    };
+
+    explicit ColumnStore(const std::string& dir = "data/analytics");
+    ~ColumnStore();
+
+    // Xuat transactions.log sang dang cot. incremental = true: chi doc phan log moi hon lan truoc
+    // (tu dong xuat lai tu dau neu chua co du lieu cot hoac log ngan hon vi tri da doc).
+    bool exportFrom(const std::string& logPath, bool incremental, ExportReport& report);
+
+    // Mo du lieu cot de truy van. Tra ve false neu chua xuat hoac du lieu khong hop le.
+    bool open();
+
+    std::size_t rowCount() const;
+
+    // Tong hop theo ngay cho cac giao dich co thoi gian trong [from, to]
+    std::vector<DailyVolume> dailyVolumes(time_t from, time_t to) const;
+
+    // 'limit' vi gui nhieu diem nhat (chi tinh giao dich thanh cong) trong [from, to]
+    std::vector<SenderVolume> topSenders(std::size_t limit, time_t from, time_t to) const;
+
+    static const std::uint32_t BLOCK_ROWS = 4096;
+
+private:
+    struct Manifest;
+    struct ZoneMap;
+    struct Row;
+
+    ColumnStore(const ColumnStore&) = delete;
+    ColumnStore& operator=(const ColumnStore&) = delete;
+
+    std::string pathOf(const char* name) const;
+    bool loadManifest(Manifest& manifest, std::vector<ZoneMap>& zones) const;
+    bool writeManifest(const Manifest& manifest, const std::vector<ZoneMap>& zones) const;
+    bool readBlockRows(const ZoneMap& zone, std::vector<Row>& rows) const;
+    bool truncateColumns(std::uint64_t rows, std::uint64_t dictionaryBytes) const;
+    void decodeTimestamps(const ZoneMap& zone, std::vector<long long>& out) const;
+
+    std::string dir;
+    std::unique_ptr<Manifest> manifest;
+    std::vector<ZoneMap> zones;
+    std::vector<std::string> dictionary;
+    FileIO::MappedFile timestamps, senders, receivers, amounts, statuses;
+};
+
+#endif // COLUMNSTORE_H
@@ -0,0 +1,289 @@
+// contactindex.cpp
+#include "contactindex.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include "scheduler.h"
+#include "shards.h"
+#include "utils.h"
+#include <iostream>
+#include <memory>
+#include <vector>
+
+namespace {
+    const char* const CONTACT_INDEX_FILE = "data/contact_index.txt";
+
+    std::string formatLine(const std::string& username, const std::string& email, const std::string& phone) {
+        return username + "\t" + email + "\t" + phone + "\n";
+    }
+
+    // Dong dau cua 'content' (ke ca '\n'), rong neu chua co dong day du
+    std::string firstLine(const std::string& content) {
+        std::size_t end = content.find('\n');
+        return end == std::string::npos ? std::string() : content.substr(0, end + 1);
+    }
+}
+
+ContactIndex::ContactIndex() : loaded(false), fileLines(0), fileSize(0) {}
+
+ContactIndex& ContactIndex::instance() {
+    static ContactIndex index;
+    return index;
+}
+
+std::string ContactIndex::normalizeEmail(const std::string& email) {
+    std::string result = Utils::trimString(email);
+    for (char& c : result) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return result;
+}
+
+std::string ContactIndex::normalizePhone(const std::string& phone) {
+    std::string digits;
+    for (char c : phone) {
+        if (c >= '0' && c <= '9') digits += c;
+    }
+    // Ma quoc gia Viet Nam: 84xxxxxxxxx tuong duong 0xxxxxxxxx
+    if (digits.size() == 11 && digits.compare(0, 2, "84") == 0) {
+        digits = "0" + digits.substr(2);
+    }
+    return digits;
+}
+
+void ContactIndex::applyLocked(const std::string& username, const Contacts& contacts) {
+    auto previous = contactsOf.find(username);
+    if (previous != contactsOf.end()) {
+        auto email = emailOwner.find(previous->second.email);
+        if (email != emailOwner.end() && email->second == username) emailOwner.erase(email);
+        auto phone = phoneOwner.find(previous->second.phone);
+        if (phone != phoneOwner.end() && phone->second == username) phoneOwner.erase(phone);
+    }
+    contactsOf[username] = contacts;
+    // Du lieu cu co the da trung: giu chu so huu dau tien
+    if (!contacts.email.empty()) emailOwner.emplace(contacts.email, username);
+    if (!contacts.phone.empty()) phoneOwner.emplace(contacts.phone, username);
+}
+
+std::size_t ContactIndex::applyContentLocked(const std::string& content) {
+    std::size_t pos = 0;
+    for (;;) {
+        std::size_t end = content.find('\n', pos);
+        if (end == std::string::npos) break; // Dong ghi do dang: doc lai lan sau
+        std::size_t length = end - pos;
+        if (length > 0 && content[end - 1] == '\r') --length;
+        std::string line = content.substr(pos, length);
+        pos = end + 1;
+        std::size_t first = line.find('\t');
+        std::size_t second = first == std::string::npos ? std::string::npos : line.find('\t', first + 1);
+        if (second == std::string::npos) continue; // Dong dau "#<ma>" cua file da nen
+        Contacts contacts = {line.substr(first + 1, second - first - 1), line.substr(second + 1)};
+        applyLocked(line.substr(0, first), contacts);
+        fileLines++;
+    }
+    return pos;
+}
+
+void ContactIndex::catchUpLocked() {
+    // Tien trinh khac co the vua nen (thay) file: bo fd cu trong cache
+    FileIO::invalidate(CONTACT_INDEX_FILE);
+    long long size = 0;
+    time_t modified = 0;
+    if (!FileIO::fileStat(CONTACT_INDEX_FILE, size, modified)) return;
+    std::string head;
+    bool replaced = static_cast<unsigned long long>(size) < fileSize ||
+                    (fileSize > 0 && (!FileIO::readRange(CONTACT_INDEX_FILE, 0, fileHead.size(), head) || head != fileHead));
+    if (replaced) {
+        // File da nen chua trang thai day du: ap dung lai tu dau (dong sau cung cua moi username van dung)
+        std::string content;
+        if (!FileIO::readFileOnce(CONTACT_INDEX_FILE, content)) return;
+        fileHead = firstLine(content);
+        fileLines = 0;
+        fileSize = applyContentLocked(content);
+        return;
+    }
+    if (static_cast<unsigned long long>(size) == fileSize) return;
+    std::string tail;
+    if (!FileIO::readRange(CONTACT_INDEX_FILE, fileSize, static_cast<std::size_t>(size - fileSize), tail)) return;
+    if (fileSize == 0) fileHead = firstLine(tail);
+    fileSize += applyContentLocked(tail);
+}
+
+bool ContactIndex::appendLocked(const std::string& lines, std::size_t count) {
+    if (!FileIO::appendFile(CONTACT_INDEX_FILE, lines.data(), lines.size())) {
+        return false;
+    }
+    if (fileSize == 0) fileHead = firstLine(lines);
+    fileSize += lines.size();
+    fileLines += count;
+    return true;
+}
+
+void ContactIndex::ensureLoadedLocked() {
+    if (loaded) return;
+    loaded = true;
+    std::string content;
+    if (!FileIO::readFileOnce(CONTACT_INDEX_FILE, content)) {
+        rebuildLocked();
+        return;
+    }
+    fileHead = firstLine(content);
+    fileSize = applyContentLocked(content);
+    if (fileLines > 2 * contactsOf.size() + 1024) {
+        compactLocked();
+    }
+}
+
+void ContactIndex::rebuildLocked() {
+    // Lan dau (chua co file): doc song song cac file nguoi dung mot lan
+    std::vector<std::string> usernames = ShardLayout::instance().allUsernames();
+    std::vector<std::unique_ptr<User> > users(usernames.size());
+    TaskScheduler::instance().parallelFor(0, usernames.size(), 0, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!usernames[i].empty()) users[i].reset(User::loadFromFile(usernames[i]));
+        }
+    });
+    std::size_t duplicates = 0;
+    for (const std::unique_ptr<User>& user : users) {
+        if (!user) continue;
+        Contacts contacts = {normalizeEmail(user->getEmail()), normalizePhone(user->getPhoneNumber())};
+        if ((!contacts.email.empty() && emailOwner.count(contacts.email)) ||
+            (!contacts.phone.empty() && phoneOwner.count(contacts.phone))) {
+            duplicates++;
+        }
+        applyLocked(user->getUsername(), contacts);
+    }
+    if (duplicates > 0) {
+        std::cerr << "Canh bao: " << duplicates << " tai khoan cu co email/so dien thoai trung voi tai khoan khac." << std::endl;
+    }
+    compactLocked();
+}
+
+bool ContactIndex::compactLocked() {
+    LockManager::Guard fileLock(LockManager::resource(LockManager::Resource::ContactIndex));
+    catchUpLocked(); // Dong cua tien trinh khac; dong cua tien trinh nay da co san
+    // Dong dau moi lan nen mot khac: tien trinh khac nhan ra file da bi thay
+    std::string content = "#" + Utils::generateUniqueId() + "\n";
+    for (const auto& entry : contactsOf) {
+        content += formatLine(entry.first, entry.second.email, entry.second.phone);
+    }
+    if (!FileIO::replaceFile(CONTACT_INDEX_FILE, content)) {
+        std::cerr << "Loi: Khong the ghi " << CONTACT_INDEX_FILE << std::endl;
+        return false;
+    }
+    FileIO::invalidate(CONTACT_INDEX_FILE);
+    fileHead = firstLine(content);
+    fileSize = content.size();
+    fileLines = contactsOf.size();
+    return true;
+}
+
+ContactIndex::Conflict ContactIndex::check(const std::string& email, const std::string& phone,
+                                           const std::string& exceptUsername, std::string& owner) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ensureLoadedLocked();
+    {
+        LockManager::Guard fileLock(LockManager::resource(LockManager::Resource::ContactIndex), LockManager::Mode::Shared);
+        catchUpLocked();
+    }
+    std::string normalizedEmail = normalizeEmail(email);
+    if (!normalizedEmail.empty()) {
+        auto it = emailOwner.find(normalizedEmail);
+        if (it != emailOwner.end() && it->second != exceptUsername) {
+            owner = it->second;
+            return Conflict::Email;
+        }
+    }
+    std::string normalizedPhone = normalizePhone(phone);
+    if (!normalizedPhone.empty()) {
+        auto it = phoneOwner.find(normalizedPhone);
+        if (it != phoneOwner.end() && it->second != exceptUsername) {
+            owner = it->second;
+            return Conflict::Phone;
+        }
+    }
+    return Conflict::None;
+}
+
+ContactIndex::Conflict ContactIndex::reserve(const User& user, Reservation& reservation, std::string& owner) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ensureLoadedLocked();
+    const std::string& username = user.getUsername();
+    Contacts contacts = {normalizeEmail(user.getEmail()), normalizePhone(user.getPhoneNumber())};
+    reservation.username = username;
+    reservation.changed = false;
+    {
+        LockManager::Guard fileLock(LockManager::resource(LockManager::Resource::ContactIndex));
+        catchUpLocked();
+        Contacts current;
+        auto previous = contactsOf.find(username);
+        if (previous != contactsOf.end()) current = previous->second;
+        if (current.email == contacts.email && current.phone == contacts.phone) {
+            return Conflict::None;
+        }
+        // Chi kiem tra truong thay doi: du lieu cu da trung khong chan viec luu lai tai khoan
+        if (!contacts.email.empty() && contacts.email != current.email) {
+            auto it = emailOwner.find(contacts.email);
+            if (it != emailOwner.end() && it->second != username) {
+                owner = it->second;
+                return Conflict::Email;
+            }
+        }
+        if (!contacts.phone.empty() && contacts.phone != current.phone) {
+            auto it = phoneOwner.find(contacts.phone);
+            if (it != phoneOwner.end() && it->second != username) {
+                owner = it->second;
+                return Conflict::Phone;
+            }
+        }
+        applyLocked(username, contacts);
+        if (!appendLocked(formatLine(username, contacts.email, contacts.phone), 1)) {
+            applyLocked(username, current); // put() sau khi luu se thu ghi lai
+            return Conflict::None;
+        }
+        reservation.email = current.email;
+        reservation.phone = current.phone;
+        reservation.changed = true;
+    }
+    if (fileLines > 2 * contactsOf.size() + 1024) {
+        compactLocked();
+    }
+    return Conflict::None;
+}
+
+void ContactIndex::release(const Reservation& reservation) {
+    if (!reservation.changed) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    Contacts contacts = {reservation.email, reservation.phone};
+    LockManager::Guard fileLock(LockManager::resource(LockManager::Resource::ContactIndex));
+    catchUpLocked();
+    applyLocked(reservation.username, contacts);
+    appendLocked(formatLine(reservation.username, contacts.email, contacts.phone), 1);
+}
+
+void ContactIndex::put(const User& user) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ensureLoadedLocked();
+    Contacts contacts = {normalizeEmail(user.getEmail()), normalizePhone(user.getPhoneNumber())};
+    auto previous = contactsOf.find(user.getUsername());
+    if (previous != contactsOf.end() && previous->second.email == contacts.email &&
+        previous->second.phone == contacts.phone) {
+        return; // Doi mat khau...: email/so dien thoai khong doi, khong can ghi
+    }
+    {
+        LockManager::Guard fileLock(LockManager::resource(LockManager::Resource::ContactIndex));
+        catchUpLocked();
+        applyLocked(user.getUsername(), contacts);
+        if (!appendLocked(formatLine(user.getUsername(), contacts.email, contacts.phone), 1)) {
+            return;
+        }
+    }
+    if (fileLines > 2 * contactsOf.size() + 1024) {
+        compactLocked();
+    }
+}
+
+std::size_t ContactIndex::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ensureLoadedLocked();
+    return contactsOf.size();
+}
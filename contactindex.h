@@ -0,0 +1,89 @@
+// contactindex.h
+#ifndef CONTACTINDEX_H
+#define CONTACTINDEX_H
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "user.h"
+
+// Chi muc duy nhat (bang bam) cho email va so dien thoai da chuan hoa -> username.
+// Dang ky/tao tai khoan/cap nhat thong tin kiem tra trung trong O(1) thay vi doc moi file nguoi dung.
+// - Luu o data/contact_index.txt (canh user_index.txt), moi dong "username<TAB>email<TAB>so dien thoai";
+//   User::saveToFile them mot dong khi email/so dien thoai thay doi, dong sau cung cua mot username la dung
+// - File duoc nen lai (ghi thay the, dong dau "#<ma>" danh dau ban nen) khi so dong cu vuot qua so tai khoan
+// - Neu chua co file, chi muc duoc dung lai mot lan tu cac file nguoi dung
+// - Them dong va nen file duoi khoa LockManager (nhieu tien trinh dung chung data/). Truoc moi lan them,
+//   cac dong tien trinh khac da them tu lan doc truoc duoc ap dung (file bi nen lai thi doc lai tu dau),
+//   nen reserve() kiem tra va giu cho tren trang thai chung cua moi tien trinh.
+class ContactIndex {
+public:
+    enum class Conflict { None, Email, Phone };
+
+    static ContactIndex& instance();
+
+    // Chuan hoa: email bo khoang trang hai dau va viet thuong; so dien thoai chi giu chu so
+    // ("+84xxxxxxxxx"/"84xxxxxxxxx" -> "0xxxxxxxxx")
+    static std::string normalizeEmail(const std::string& email);
+    static std::string normalizePhone(const std::string& phone);
+
+    // Kiem tra email/so dien thoai da thuoc ve tai khoan khac 'exceptUsername' chua.
+    // Truong rong khong duoc kiem tra. 'owner' nhan username dang giu (neu trung).
+    Conflict check(const std::string& email, const std::string& phone, const std::string& exceptUsername,
+                   std::string& owner);
+
+    // Email/so dien thoai truoc khi reserve() (de tra lai neu luu tai khoan that bai)
+    struct Reservation {
+        std::string username;
+        std::string email;
+        std::string phone;
+        bool changed;       // false: khong co gi de tra lai
+    };
+
+    // Kiem tra va giu cho email/so dien thoai cua 'user' trong mot lan khoa (goi truoc khi ghi file
+    // nguoi dung). Chi cac truong thay doi so voi ban ghi hien tai cua username moi duoc kiem tra.
+    Conflict reserve(const User& user, Reservation& reservation, std::string& owner);
+    // Tra lai email/so dien thoai cu khi luu tai khoan sau reserve() that bai
+    void release(const Reservation& reservation);
+
+    // Cap nhat sau khi luu tai khoan thanh cong
+    void put(const User& user);
+
+    std::size_t size();
+
+private:
+    ContactIndex();
+    ContactIndex(const ContactIndex&) = delete;
+    ContactIndex& operator=(const ContactIndex&) = delete;
+
+    struct Contacts {
+        std::string email;   // Da chuan hoa
+        std::string phone;
+    };
+
+    void ensureLoadedLocked();
+    void rebuildLocked();
+    // Ghi thay the file bang trang thai hien tai (doc lai file duoi khoa truoc: tien trinh khac co the da them dong)
+    bool compactLocked();
+    void applyLocked(const std::string& username, const Contacts& contacts);
+    // Ap dung cac dong day du trong 'content' (bat dau tu dau mot dong); tra ve so byte da dung
+    std::size_t applyContentLocked(const std::string& content);
+    // Ap dung cac dong moi them cua file (dang giu khoa o ContactIndex)
+    void catchUpLocked();
+    // Them dong vao file (dang giu khoa o ContactIndex, da catchUpLocked)
+    bool appendLocked(const std::string& lines, std::size_t count);
+
+    std::mutex mutex;
+    bool loaded;
+    std::size_t fileLines;                                    // So dong hien co trong file
+    unsigned long long fileSize;                              // So byte cua file da doc/ghi
+    std::string fileHead;                                     // Dong dau cua file da doc (nhan ra file bi nen lai)
+    std::unordered_map<std::string, Contacts> contactsOf;      // username -> email, so dien thoai
+    std::unordered_map<std::string, std::string> emailOwner;   // email -> username
+    std::unordered_map<std::string, std::string> phoneOwner;   // so dien thoai -> username
+};
+
+#endif // CONTACTINDEX_H
@@ -0,0 +1,631 @@
+// dataindex.cpp
+#include "dataindex.h"
+#include "fileio.h"
+#include "textscan.h"
+#include "shards.h"
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <set>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    const char* const TRANSACTION_LOG_FILE = "data/transactions.log";
+    const char* const SNAPSHOT_FILE = "data/index.snapshot";
+    const char* const DATA_DIR = "data";
+    const char* const DELTA_PREFIX = "index_delta.";
+    const char* const DELTA_SUFFIX = ".log";
+    // Journal cua the he hien tai vuot nguong nay thi duoc xoay vong (xem DataIndex::rotateDeltas)
+    const long long MAX_DELTA_BYTES = 4LL * 1024 * 1024;
+
+    // Ket qua doc cua mot phan du lieu, duoc gop lai sau khi tat ca cac phan ket thuc
+    struct PartialLoad {
+        std::vector<User> users;
+        std::vector<Wallet> wallets;
+        std::vector<std::pair<IdHandle, DataIndex::TransactionRef> > transactions;
+        std::size_t failedFiles;
+
+        PartialLoad() : failedFiles(0) {}
+    };
+
+    // Parse mot file du lieu, tra ve nullptr neu file hong
+    template <typename T, typename Parse>
+    T* parseRecord(const std::string& content, Parse parse) {
+        try {
+            return parse(content);
+        } catch (const std::exception&) {
+            return nullptr;
+        }
+    }
+
+    void loadUsers(const std::vector<std::string>& usernames, std::size_t begin, std::size_t end, PartialLoad& out) {
+        const ShardLayout& layout = ShardLayout::instance();
+        std::string content;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (usernames[i].empty()) continue;
+            User* user = nullptr;
+            if (FileIO::readFileOnce(layout.userFile(usernames[i]), content)) {
+                user = parseRecord<User>(content, User::fromString);
+            }
+            if (user) {
+                out.users.push_back(*user);
+                delete user;
+            } else {
+                out.failedFiles++;
+            }
+        }
+    }
+
+    void loadWallets(const std::vector<std::string>& walletIds, std::size_t begin, std::size_t end, PartialLoad& out) {
+        const ShardLayout& layout = ShardLayout::instance();
+        std::string content;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (walletIds[i].empty()) continue;
+            Wallet* wallet = nullptr;
+            if (FileIO::readFileOnce(layout.walletFile(walletIds[i]), content)) {
+                wallet = parseRecord<Wallet>(content, Wallet::fromString);
+            }
+            if (wallet) {
+                out.wallets.push_back(*wallet);
+                delete wallet;
+            } else {
+                out.failedFiles++;
+            }
+        }
+    }
+
+    // Parse cac dong cua log trong khoang [begin, end) (da duoc canh theo dau dong)
+    // 'baseOffset': vi tri cua log[0] trong transactions.log
+    void loadTransactions(const char* log, std::size_t begin, std::size_t end, unsigned long long baseOffset,
+                          PartialLoad& out) {
+        // Tim tat ca cac dau xuong dong cua doan trong mot lan quet
+        std::vector<std::size_t> lineEnds;
+        TextScan::findDelimiters(log + begin, end - begin, "\n", lineEnds);
+        std::size_t pos = begin;
+        std::size_t nextLine = 0;
+        while (pos < end) {
+            std::size_t lineEnd = nextLine < lineEnds.size() ? begin + lineEnds[nextLine++] : end;
+            std::size_t length = lineEnd - pos;
+            if (length > 0 && log[lineEnd - 1] == '\r') --length;
+
+            Transaction* transaction = parseRecord<Transaction>(std::string(log + pos, length), Transaction::fromString);
+            if (transaction) {
+                DataIndex::TransactionRef ref = {baseOffset + pos, static_cast<unsigned int>(length)};
+                out.transactions.push_back(std::make_pair(transaction->sender, ref));
+                if (transaction->receiver != transaction->sender) {
+                    out.transactions.push_back(std::make_pair(transaction->receiver, ref));
+                }
+                delete transaction;
+            }
+            pos = lineEnd + 1;
+        }
+    }
+
+    // Vi tri bat dau dong dau tien tai hoac sau 'pos'
+    std::size_t alignToLineStart(const std::string& text, std::size_t pos) {
+        if (pos == 0 || pos >= text.size()) return std::min(pos, text.size());
+        if (text[pos - 1] == '\n') return pos;
+        std::size_t next = text.find('\n', pos);
+        return next == std::string::npos ? text.size() : next + 1;
+    }
+
+    std::string deltaJournalPath(unsigned int generation) {
+        return std::string(DATA_DIR) + "/" + DELTA_PREFIX + std::to_string(generation) + DELTA_SUFFIX;
+    }
+
+    // Cac the he journal thay doi dang ton tai trong thu muc data (tang dan)
+    std::vector<unsigned int> existingDeltaGenerations() {
+        std::vector<unsigned int> generations;
+        const std::string prefix = DELTA_PREFIX;
+        const std::string suffix = DELTA_SUFFIX;
+        for (const std::string& name : FileIO::listDirectory(DATA_DIR)) {
+            if (name.size() <= prefix.size() + suffix.size() ||
+                name.compare(0, prefix.size(), prefix) != 0 ||
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+                continue;
+            }
+            std::string number = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+            if (number.find_first_not_of("0123456789") != std::string::npos) continue;
+            generations.push_back(static_cast<unsigned int>(std::stoul(number)));
+        }
+        std::sort(generations.begin(), generations.end());
+        return generations;
+    }
+}
+
+DataIndex::DataIndex() : loaded(false), indexedLogEnd(0), deltaGeneration(-1), rotating(false), walletChanges(0) {}
+
+DataIndex::~DataIndex() {
+    // Cong viec nen dung den cac bang ben duoi nen phai ket thuc truoc khi chung bi huy
+    try {
+        background.wait();
+    } catch (...) {
+    }
+}
+
+DataIndex& DataIndex::instance() {
+    static DataIndex index;
+    return index;
+}
+
+DataIndex::LoadReport DataIndex::warmStart(unsigned int partitions) {
+    auto startTime = std::chrono::steady_clock::now();
+    LoadReport report = {0, 0, 0, 0, 1, 0.0, false, 0};
+
+    if (!loadSnapshot(report)) {
+        loadAll(partitions, report);
+        // Ghi snapshot ngay de lan khoi dong sau khong phai doc lai toan bo du lieu
+        writeSnapshot();
+    } else {
+        verifySnapshotInBackground();
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return report;
+}
+
+bool DataIndex::loadSnapshot(LoadReport& report) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!snapshot.open(SNAPSHOT_FILE)) {
+        return false;
+    }
+    // Log bi cat ngan hoac thay the: snapshot khong con khop, nap lai toan bo
+    FileIO::MappedFile log;
+    if (!log.open(TRANSACTION_LOG_FILE) && snapshot.logOffset() > 0) {
+        snapshot.close();
+        return false;
+    }
+    if (log.size() < snapshot.logOffset()) {
+        snapshot.close();
+        return false;
+    }
+
+    users.clear();
+    transactionsByWallet.clear();
+    loaded = true;
+
+    // Bang vi giu toan bo cac vi (khong chi thay doi): sao chep cac cot so du / phien ban cua snapshot
+    walletTable.loadBase(snapshot.walletBalances(), snapshot.walletVersions(), snapshot.walletCount());
+    walletChanges = 0;
+
+    // Doc lai cac thuc the da thay doi ke tu snapshot
+    report.deltasReplayed = replayDeltas(snapshot.deltaGeneration());
+
+    // Chi parse phan log moi hon snapshot
+    PartialLoad tail;
+    loadTransactions(log.data(), static_cast<std::size_t>(snapshot.logOffset()), log.size(), 0, tail);
+    for (auto& entry : tail.transactions) {
+        transactionsByWallet[entry.first].push_back(entry.second);
+    }
+    indexedLogEnd = log.size();
+
+    report.fromSnapshot = true;
+    report.users = snapshot.userCount();
+    for (const auto& entry : users) {
+        if (!snapshot.hasUser(entry.first)) report.users++;
+    }
+    report.wallets = walletTable.size();
+    report.transactions = tail.transactions.size();
+    return true;
+}
+
+void DataIndex::loadAll(unsigned int partitions, LoadReport& report) {
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    if (partitions == 0) {
+        // Nhieu phan hon so worker de cac worker ranh co viec de danh cap
+        partitions = scheduler.workerCount() * 4;
+    }
+
+    // Index cua cac phan vung duoc doc song song (bo cuc phang: mot file moi loai)
+    ShardLayout& layout = ShardLayout::instance();
+    std::vector<std::string> usernames = layout.allUsernames();
+    std::vector<std::string> walletIds = layout.allWalletIds();
+    std::string log;
+    FileIO::readFileOnce(TRANSACTION_LOG_FILE, log);
+
+    // Chia deu danh sach user, vi va cac doan log (canh theo dong) thanh tung phan
+    std::vector<PartialLoad> partials(partitions);
+    for (PartialLoad& partial : partials) {
+        partial.users.reserve(usernames.size() / partitions + 1);
+        partial.wallets.reserve(walletIds.size() / partitions + 1);
+    }
+    scheduler.parallelFor(0, partitions, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t t = begin; t < end; ++t) {
+            loadUsers(usernames, usernames.size() * t / partitions, usernames.size() * (t + 1) / partitions, partials[t]);
+            loadWallets(walletIds, walletIds.size() * t / partitions, walletIds.size() * (t + 1) / partitions, partials[t]);
+            std::size_t logBegin = alignToLineStart(log, log.size() * t / partitions);
+            std::size_t logEnd = alignToLineStart(log, log.size() * (t + 1) / partitions);
+            loadTransactions(log.data(), logBegin, logEnd, 0, partials[t]);
+        }
+    });
+
+    // Gop ket qua theo thu tu cac phan de giu dung thu tu giao dich trong log
+    report.threads = scheduler.workerCount();
+    std::lock_guard<std::mutex> lock(mutex);
+    snapshot.close();
+    users.clear();
+    walletTable.clear();
+    transactionsByWallet.clear();
+    users.reserve(usernames.size());
+    walletTable.reserve(walletIds.size());
+    walletChanges = 0;
+
+    IdInterner& interner = IdInterner::instance();
+    for (PartialLoad& partial : partials) {
+        for (User& user : partial.users) {
+            std::string key = user.username;
+            users.emplace(std::move(key), std::move(user));
+        }
+        for (const Wallet& wallet : partial.wallets) {
+            walletTable.upsert(interner.intern(wallet.walletId), interner.intern(wallet.ownerUserId), wallet.balance,
+                               wallet.version);
+        }
+        std::vector<Wallet>().swap(partial.wallets);
+        for (auto& entry : partial.transactions) {
+            transactionsByWallet[entry.first].push_back(entry.second);
+            report.transactions++;
+        }
+        report.failedFiles += partial.failedFiles;
+    }
+    report.users = users.size();
+    report.wallets = walletTable.size();
+    indexedLogEnd = log.size();
+    loaded = true;
+}
+
+// Doc lai cac user/vi duoc ghi trong journal tu the he 'fromGeneration' tro di (da giu mutex)
+std::size_t DataIndex::replayDeltas(unsigned int fromGeneration) {
+    std::set<std::string> seenUsers, seenWallets;
+    std::vector<std::string> lines;
+    std::string content;
+    for (unsigned int generation : existingDeltaGenerations()) {
+        if (generation < fromGeneration) continue;
+        FileIO::readLines(deltaJournalPath(generation), lines);
+        for (const std::string& line : lines) {
+            if (line.size() < 3 || line[1] != '|') continue;
+            std::string key = line.substr(2);
+            if (line[0] == 'U' && seenUsers.insert(key).second) {
+                User* user = nullptr;
+                if (FileIO::readFileOnce(ShardLayout::instance().userFile(key), content)) {
+                    user = parseRecord<User>(content, User::fromString);
+                }
+                if (user) {
+                    users.erase(user->username);
+                    users.emplace(user->username, *user);
+                    delete user;
+                }
+            } else if (line[0] == 'W' && seenWallets.insert(key).second) {
+                Wallet* wallet = nullptr;
+                if (FileIO::readFileOnce(ShardLayout::instance().walletFile(key), content)) {
+                    wallet = parseRecord<Wallet>(content, Wallet::fromString);
+                }
+                if (wallet) {
+                    upsertWalletLocked(*wallet);
+                    delete wallet;
+                }
+            }
+        }
+    }
+    return seenUsers.size() + seenWallets.size();
+}
+
+// Kiem tra checksum toan bo snapshot o nen (TaskScheduler); neu hong thi nap lai tu cac file du lieu
+void DataIndex::verifySnapshotInBackground() {
+    background.run([this]() {
+        if (snapshot.verifyBody()) return;
+        std::cerr << "Canh bao: Snapshot chi muc bi hong (sai checksum). Dang nap lai tu cac file du lieu..." << std::endl;
+        LoadReport report = {0, 0, 0, 0, 1, 0.0, false, 0};
+        loadAll(0, report);
+        writeSnapshot();
+    });
+}
+
+unsigned int DataIndex::currentDeltaGeneration() {
+    // Da giu deltaMutex
+    if (deltaGeneration < 0) {
+        std::vector<unsigned int> generations = existingDeltaGenerations();
+        if (!generations.empty()) {
+            deltaGeneration = static_cast<int>(generations.back());
+        } else {
+            IndexSnapshot existing;
+            deltaGeneration = existing.open(SNAPSHOT_FILE) ? static_cast<int>(existing.deltaGeneration()) : 0;
+        }
+    }
+    return static_cast<unsigned int>(deltaGeneration);
+}
+
+void DataIndex::recordDelta(char type, const std::string& key) {
+    std::string record;
+    record.reserve(key.size() + 3);
+    record += type;
+    record += '|';
+    record += key;
+    record += '\n';
+    appendDeltas(record);
+}
+
+void DataIndex::recordDeltas(char type, const std::vector<std::string>& keys) {
+    if (keys.empty()) return;
+    std::string records;
+    for (const std::string& key : keys) {
+        records += type;
+        records += '|';
+        records += key;
+        records += '\n';
+    }
+    appendDeltas(records);
+}
+
+void DataIndex::appendDeltas(const std::string& records) {
+    bool overflow = false;
+    {
+        std::lock_guard<std::mutex> lock(deltaMutex);
+        // Chua co snapshot: lan warm-start sau nap toan bo tu file du lieu, journal khong can thiet
+        long long size = 0;
+        time_t modified = 0;
+        if (!FileIO::fileStat(SNAPSHOT_FILE, size, modified)) return;
+        std::string path = deltaJournalPath(currentDeltaGeneration());
+        FileIO::appendFile(path, records.data(), records.size());
+        overflow = FileIO::fileStat(path, size, modified) && size >= MAX_DELTA_BYTES;
+    }
+    if (overflow) rotateDeltas();
+}
+
+// Journal qua lon: tien trinh da warm-start ghi snapshot moi o nen (cac journal cu bi xoa sau do);
+// tien trinh khong warm-start khong co chi muc de ghi snapshot nen bo snapshot cung cac journal,
+// lan warm-start sau nap lai toan bo.
+void DataIndex::rotateDeltas() {
+    if (isLoaded()) {
+        bool expected = false;
+        if (rotating.compare_exchange_strong(expected, true)) {
+            background.run([this]() {
+                writeSnapshot();
+                rotating = false;
+            });
+        }
+        return;
+    }
+    std::lock_guard<std::mutex> lock(deltaMutex);
+    FileIO::invalidate(SNAPSHOT_FILE);
+    std::remove(SNAPSHOT_FILE);
+    for (unsigned int generation : existingDeltaGenerations()) {
+        FileIO::invalidate(deltaJournalPath(generation));
+        std::remove(deltaJournalPath(generation).c_str());
+    }
+    deltaGeneration = -1;
+}
+
+bool DataIndex::writeSnapshot() {
+    IndexSnapshot::Contents contents;
+    unsigned int newGeneration;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!loaded) return false;
+
+        // Gop snapshot cu voi cac thay doi moi (thay doi moi duoc uu tien)
+        std::string key, value;
+        contents.users.reserve(snapshot.userCount() + users.size());
+        for (std::size_t i = 0; i < snapshot.userCount(); ++i) {
+            snapshot.userAt(i, key, value);
+            if (!users.count(key)) contents.users.push_back(IndexSnapshot::KeyValue{key, value});
+        }
+        for (const auto& entry : users) {
+            contents.users.push_back(IndexSnapshot::KeyValue{entry.first, entry.second.toString()});
+        }
+        // Bang vi chua tat ca cac vi nen duoc ghi lai toan bo
+        IdInterner& interner = IdInterner::instance();
+        contents.wallets.reserve(walletTable.size());
+        contents.owners.reserve(walletTable.size());
+        for (WalletTable::Row row = 0; row < walletTable.size(); ++row) {
+            IndexSnapshot::WalletRow wallet;
+            if (walletTable.walletAt(row) != IdInterner::NONE) {
+                wallet.walletId = interner.str(walletTable.walletAt(row));
+                wallet.ownerUserId = interner.str(walletTable.ownerAt(row));
+            } else {
+                // Hang nap tu snapshot dang mo va chua thay doi
+                snapshot.walletAt(row, wallet.walletId, wallet.ownerUserId);
+            }
+            wallet.balance = walletTable.balanceAt(row);
+            wallet.version = walletTable.versionAt(row);
+            contents.owners.push_back(IndexSnapshot::KeyValue{wallet.ownerUserId, wallet.walletId});
+            contents.wallets.push_back(std::move(wallet));
+        }
+
+        // Giao dich: vi tri trong snapshot cu dung truoc, giao dich moi noi tiep theo
+        std::set<IdHandle> merged;
+        for (std::size_t i = 0; i < snapshot.transactionKeyCount(); ++i) {
+            std::size_t count = 0;
+            const IndexSnapshot::LogRef* refs = snapshot.transactionsAt(i, key, count);
+            IndexSnapshot::KeyRefs keyRefs;
+            keyRefs.key = key;
+            keyRefs.refs.assign(refs, refs + count);
+            IdHandle handle = interner.find(key);
+            auto it = handle == IdInterner::NONE ? transactionsByWallet.end() : transactionsByWallet.find(handle);
+            if (it != transactionsByWallet.end()) {
+                for (const TransactionRef& ref : it->second) {
+                    keyRefs.refs.push_back(IndexSnapshot::LogRef{ref.offset, ref.length, 0});
+                }
+                merged.insert(handle);
+            }
+            contents.transactions.push_back(std::move(keyRefs));
+        }
+        for (const auto& entry : transactionsByWallet) {
+            if (merged.count(entry.first)) continue;
+            IndexSnapshot::KeyRefs keyRefs;
+            keyRefs.key = interner.str(entry.first);
+            for (const TransactionRef& ref : entry.second) {
+                keyRefs.refs.push_back(IndexSnapshot::LogRef{ref.offset, ref.length, 0});
+            }
+            contents.transactions.push_back(std::move(keyRefs));
+        }
+        contents.logOffset = indexedLogEnd;
+
+        // Thay doi ke tu thoi diem nay duoc ghi vao journal cua the he moi
+        std::lock_guard<std::mutex> deltaLock(deltaMutex);
+        newGeneration = currentDeltaGeneration() + 1;
+        deltaGeneration = static_cast<int>(newGeneration);
+        contents.deltaGeneration = newGeneration;
+    }
+
+    if (!IndexSnapshot::write(SNAPSHOT_FILE, contents)) {
+        std::cerr << "Loi: Khong the ghi snapshot chi muc " << SNAPSHOT_FILE << "." << std::endl;
+        return false;
+    }
+    // Journal cua cac the he cu da nam trong snapshot
+    for (unsigned int generation : existingDeltaGenerations()) {
+        if (generation < newGeneration) {
+            FileIO::invalidate(deltaJournalPath(generation));
+            std::remove(deltaJournalPath(generation).c_str());
+        }
+    }
+    return true;
+}
+
+void DataIndex::shutdown() {
+    background.wait();
+    bool changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Khong co thay doi nao moi hon snapshot dang mo thi khong can ghi lai
+        changed = loaded && (!snapshot.isOpen() || !users.empty() || walletChanges > 0 ||
+                             indexedLogEnd != snapshot.logOffset());
+    }
+    if (changed) {
+        writeSnapshot();
+    }
+}
+
+bool DataIndex::isLoaded() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loaded;
+}
+
+User* DataIndex::findUser(const std::string& username) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = users.find(username);
+    if (it != users.end()) return new User(it->second);
+    std::string record;
+    if (!snapshot.findUser(username, record)) return nullptr;
+    return parseRecord<User>(record, User::fromString);
+}
+
+std::unique_ptr<Wallet> DataIndex::findWallet(const std::string& walletId) const {
+    IdHandle handle = IdInterner::instance().find(walletId);
+    std::lock_guard<std::mutex> lock(mutex);
+    WalletTable::Row row = walletRowLocked(walletId, handle);
+    if (row == WalletTable::NO_ROW) return nullptr;
+    IdHandle owner = walletTable.ownerAt(row);
+    return std::unique_ptr<Wallet>(new Wallet(walletId, owner != IdInterner::NONE ? idToString(owner) : snapshot.walletOwnerAt(row),
+                                              walletTable.balanceAt(row), walletTable.versionAt(row)));
+}
+
+bool DataIndex::findWalletIdByOwner(const std::string& ownerUserId, std::string& walletId) const {
+    IdHandle owner = IdInterner::instance().find(ownerUserId);
+    std::lock_guard<std::mutex> lock(mutex);
+    WalletTable::Row row = owner == IdInterner::NONE ? WalletTable::NO_ROW : walletTable.findByOwner(owner);
+    if (row != WalletTable::NO_ROW) {
+        walletId = idToString(walletTable.walletAt(row));
+        return true;
+    }
+    // Vi nap tu snapshot va chua thay doi: tra bang owners cua snapshot
+    return walletTable.baseSize() > 0 && snapshot.findOwner(ownerUserId, walletId);
+}
+
+bool DataIndex::hasUser(const std::string& username) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return users.count(username) > 0 || snapshot.hasUser(username);
+}
+
+bool DataIndex::hasWallet(const std::string& walletId) const {
+    IdHandle handle = IdInterner::instance().find(walletId);
+    std::lock_guard<std::mutex> lock(mutex);
+    return walletRowLocked(walletId, handle) != WalletTable::NO_ROW;
+}
+
+void DataIndex::putUser(const User& user) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) return;
+    auto it = users.find(user.username);
+    if (it == users.end()) {
+        users.emplace(user.username, user);
+    } else {
+        it->second = user;
+    }
+}
+
+void DataIndex::putWallet(const Wallet& wallet) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) return;
+    upsertWalletLocked(wallet);
+}
+
+// Hang cua vi: bang handle neu vi da tung thay doi, neu khong thi tim trong bang wallets cua snapshot
+// (hang thu i cua bang vi nap tu phan tu thu i cua snapshot). Da giu mutex.
+WalletTable::Row DataIndex::walletRowLocked(const std::string& walletId, IdHandle handle) const {
+    WalletTable::Row row = handle == IdInterner::NONE ? WalletTable::NO_ROW : walletTable.find(handle);
+    if (row != WalletTable::NO_ROW) return row;
+    std::size_t index = 0;
+    if (walletTable.baseSize() > 0 && snapshot.findWallet(walletId, index) && index < walletTable.baseSize()) {
+        return static_cast<WalletTable::Row>(index);
+    }
+    return WalletTable::NO_ROW;
+}
+
+void DataIndex::upsertWalletLocked(const Wallet& wallet) {
+    IdHandle handle = internId(wallet.walletId);
+    IdHandle owner = internId(wallet.ownerUserId);
+    WalletTable::Row row = walletRowLocked(wallet.walletId, handle);
+    if (row != WalletTable::NO_ROW && walletTable.walletAt(row) == IdInterner::NONE) {
+        walletTable.bind(row, handle, owner);
+    }
+    walletTable.upsert(handle, owner, wallet.balance, wallet.version);
+    walletChanges++;
+}
+
+bool DataIndex::walletDistribution(WalletTable::Distribution& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) return false;
+    out = walletTable.distribution();
+    return true;
+}
+
+bool DataIndex::totalSupply(double& out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) return false;
+    out = walletTable.totalSupply();
+    return true;
+}
+
+void DataIndex::addTransaction(IdHandle sender, IdHandle receiver, const TransactionRef& ref) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded) return;
+    addTransactionLocked(sender, receiver, ref);
+}
+
+void DataIndex::addTransactionLocked(IdHandle sender, IdHandle receiver, const TransactionRef& ref) {
+    transactionsByWallet[sender].push_back(ref);
+    if (receiver != sender) {
+        transactionsByWallet[receiver].push_back(ref);
+    }
+    indexedLogEnd = std::max(indexedLogEnd, ref.offset + ref.length + 1);
+}
+
+std::vector<DataIndex::TransactionRef> DataIndex::transactionsOf(const std::string& walletId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TransactionRef> result;
+    std::size_t count = 0;
+    const IndexSnapshot::LogRef* refs = snapshot.transactionsOf(walletId, count);
+    result.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        result.push_back(TransactionRef{refs[i].offset, refs[i].length});
+    }
+    IdHandle handle = IdInterner::instance().find(walletId);
+    auto it = handle == IdInterner::NONE ? transactionsByWallet.end() : transactionsByWallet.find(handle);
+    if (it != transactionsByWallet.end()) {
+        result.insert(result.end(), it->second.begin(), it->second.end());
+    }
+    return result;
+}
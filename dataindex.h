@@ -0,0 +1,130 @@
+// dataindex.h
+#ifndef DATAINDEX_H
+#define DATAINDEX_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "user.h"
+#include "wallet.h"
+#include "snapshot.h"
+#include "scheduler.h"
+#include "intern.h"
+#include "wallettable.h"
+
+// Chi muc trong bo nho cho toan bo du lieu (che do warm-start).
+// Khi duoc nap luc khoi dong, cac ham User::loadFromFile, Wallet::loadFromFile,
+// Wallet::loadWalletByUserId va lich su giao dich tra cuu truc tiep tai day
+// thay vi doc file tren dia. Cac ham saveToFile cap nhat chi muc sau khi ghi thanh cong.
+//
+// Chi muc gom hai tang:
+// - Snapshot (data/index.snapshot) duoc mmap, tra cuu nhi phan tren vung nho anh xa
+// - Cac bang bam chua nhung thay doi moi hon snapshot (doc lai tu journal thay doi
+//   data/index_delta.<the he>.log va phan cuoi transactions.log luc khoi dong)
+// Nho vay thoi gian khoi dong chi phu thuoc vao luong thay doi, khong phu thuoc kich thuoc du lieu.
+// Rieng cac vi duoc giu toan bo trong WalletTable (dang cot) de cac phep tong hop so du khong phai doc file;
+// khi khoi dong tu snapshot, cot so du / phien ban duoc sao chep khoi tu snapshot, ID vi va chu so huu
+// van tra cuu tren snapshot cho den khi vi thay doi.
+class DataIndex {
+public:
+    // Vi tri mot ban ghi giao dich trong transactions.log
+    struct TransactionRef {
+        unsigned long long offset;
+        unsigned int length; // Khong tinh ky tu xuong dong
+    };
+
+    // Ket qua nap du lieu luc khoi dong
+    struct LoadReport {
+        std::size_t users;
+        std::size_t wallets;
+        std::size_t transactions;
+        std::size_t failedFiles; // File trong index nhung khong doc/parse duoc
+        unsigned int threads;            // So worker cua TaskScheduler tham gia nap
+        double seconds;
+        bool fromSnapshot;       // true neu khoi dong tu snapshot (chi doc lai cac thay doi)
+        std::size_t deltasReplayed;
+    };
+
+    static DataIndex& instance();
+
+    // Khoi dong tu snapshot neu hop le; neu khong, nap song song (tren TaskScheduler)
+    // user_index.txt, wallet_index.txt, cac file du lieu va transactions.log roi ghi snapshot moi.
+    // partitions = 0: tu chon theo so worker cua TaskScheduler
+    LoadReport warmStart(unsigned int partitions = 0);
+
+    // Ghi snapshot tu trang thai hien tai (snapshot cu + cac thay doi moi)
+    bool writeSnapshot();
+
+    // Ghi nhan mot thay doi vao journal ('U' = nguoi dung, 'W' = vi) de snapshot
+    // cu co the duoc cap nhat luc khoi dong. Duoc goi sau moi lan saveToFile thanh cong,
+    // ke ca khi chua warm-start; chi ghi khi data/index.snapshot ton tai. Journal qua lon thi
+    // duoc xoay vong: ghi snapshot moi (da warm-start) hoac bo snapshot de lan sau nap toan bo.
+    void recordDelta(char type, const std::string& key);
+    // Nhu tren cho nhieu khoa cung loai, ghi trong mot lan append (nhap tai khoan hang loat)
+    void recordDeltas(char type, const std::vector<std::string>& keys);
+
+    // Cho kiem tra snapshot o nen ket thuc va ghi snapshot moi (khi thoat chuong trinh)
+    void shutdown();
+
+    // true neu chi muc da duoc nap (warm-start)
+    bool isLoaded() const;
+
+    // Tra cuu: tra ve ban sao moi (nguoi goi so huu), nullptr neu khong co trong chi muc
+    User* findUser(const std::string& username) const;
+    std::unique_ptr<Wallet> findWallet(const std::string& walletId) const;
+    bool findWalletIdByOwner(const std::string& ownerUserId, std::string& walletId) const;
+
+    bool hasUser(const std::string& username) const;
+    bool hasWallet(const std::string& walletId) const;
+
+    // Cap nhat chi muc sau khi luu thanh cong
+    void putUser(const User& user);
+    void putWallet(const Wallet& wallet);
+    void addTransaction(IdHandle sender, IdHandle receiver, const TransactionRef& ref);
+
+    // Phan bo so du cua tat ca cac vi (quet bang vi dang cot). false neu chua warm-start.
+    bool walletDistribution(WalletTable::Distribution& out) const;
+    // Tong so du cua tat ca cac vi. false neu chua warm-start.
+    bool totalSupply(double& out) const;
+
+    // Danh sach vi tri giao dich lien quan den mot vi (theo thu tu trong log)
+    std::vector<TransactionRef> transactionsOf(const std::string& walletId) const;
+
+private:
+    DataIndex();
+    ~DataIndex();
+    DataIndex(const DataIndex&) = delete;
+    DataIndex& operator=(const DataIndex&) = delete;
+
+    bool loadSnapshot(LoadReport& report);
+    void loadAll(unsigned int partitions, LoadReport& report);
+    std::size_t replayDeltas(unsigned int fromGeneration);
+    void verifySnapshotInBackground();
+    unsigned int currentDeltaGeneration();
+    void appendDeltas(const std::string& records);
+    void rotateDeltas();
+    void addTransactionLocked(IdHandle sender, IdHandle receiver, const TransactionRef& ref);
+    WalletTable::Row walletRowLocked(const std::string& walletId, IdHandle handle) const;
+    void upsertWalletLocked(const Wallet& wallet);
+
+    mutable std::mutex mutex;
+    bool loaded;
+    IndexSnapshot snapshot;               // Tang duoi (co the rong)
+    unsigned long long indexedLogEnd;     // Vi tri cuoi transactions.log da duoc dua vao chi muc
+    std::mutex deltaMutex;
+    int deltaGeneration;                  // -1: chua xac dinh
+    std::atomic<bool> rotating;           // Dang ghi snapshot o nen do journal qua lon
+    TaskGroup background;                 // Kiem tra snapshot o nen
+    // Tat ca cac vi (nap tu snapshot hoac file du lieu), dang cot; ID la handle cua IdInterner
+    // (NONE voi cac hang nap tu snapshot chua thay doi)
+    WalletTable walletTable;
+    std::size_t walletChanges;            // So lan cap nhat vi ke tu snapshot
+    // Cac bang duoi day chua thay doi moi hon snapshot (hoac toan bo du lieu neu khong co snapshot).
+    std::unordered_map<std::string, User> users;                  // username -> User
+    std::unordered_map<IdHandle, std::vector<TransactionRef> > transactionsByWallet; // walletId -> giao dich
+};
+
+#endif // DATAINDEX_H
@@ -0,0 +1,933 @@
+// fileio.cpp
+#include "fileio.h"
+#include <iostream>
+#include <unordered_map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <set>
+#include <string.h> // De su dung strerror
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <io.h> // _open, _read, _write, _lseeki64, _chsize_s, _commit, _findfirst
+#include <process.h> // _getpid
+#include <windows.h> // MoveFileExA
+#else
+#include <unistd.h> // pread, pwrite, fdatasync, ftruncate, close
+#include <dirent.h> // opendir, readdir
+#include <sys/mman.h> // mmap, munmap
+#endif
+
+namespace FileIO {
+
+    namespace {
+
+        // --- Cac ham bao boc loi goi he thong (POSIX / Windows) ---
+
+#ifdef _WIN32
+        int sysOpen(const std::string& path, int flags) {
+            return _open(path.c_str(), flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+        }
+        void sysClose(int fd) { _close(fd); }
+        // Windows khong co pread/pwrite: dung lseek + read/write (da duoc khoa boi Handle::ioMutex)
+        long long sysPread(int fd, char* buf, std::size_t len, long long offset) {
+            if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+            return _read(fd, buf, static_cast<unsigned int>(len));
+        }
+        long long sysPwrite(int fd, const char* buf, std::size_t len, long long offset) {
+            if (_lseeki64(fd, offset, SEEK_SET) < 0) return -1;
+            return _write(fd, buf, static_cast<unsigned int>(len));
+        }
+        long long sysWrite(int fd, const char* buf, std::size_t len) {
+            return _write(fd, buf, static_cast<unsigned int>(len));
+        }
+        int sysTruncate(int fd, long long size) { return _chsize_s(fd, size); }
+        int sysDataSync(int fd) { return _commit(fd); }
+        long long sysFileSize(int fd) {
+            struct _stati64 st;
+            if (_fstati64(fd, &st) != 0) return -1;
+            return st.st_size;
+        }
+        // Windows: rename khong ghi de file da ton tai, dung MoveFileEx
+        bool sysRename(const std::string& from, const std::string& to) {
+            return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        }
+        bool sysSyncDirectory(const std::string&) { return true; } // Khong ho tro fsync thu muc
+        int sysGetPid() { return _getpid(); }
+        const int OPEN_READ = _O_RDONLY;
+        const int OPEN_RDWR = _O_RDWR;
+        const int OPEN_CREATE = _O_CREAT;
+        const int OPEN_APPEND = _O_APPEND;
+        const int OPEN_TRUNC = _O_TRUNC;
+#else
+        int sysOpen(const std::string& path, int flags) {
+            int fd;
+            do {
+                fd = ::open(path.c_str(), flags | O_CLOEXEC, 0666);
+            } while (fd < 0 && errno == EINTR);
+            return fd;
+        }
+        void sysClose(int fd) { ::close(fd); }
+        long long sysPread(int fd, char* buf, std::size_t len, long long offset) {
+            ssize_t n;
+            do { n = ::pread(fd, buf, len, static_cast<off_t>(offset)); } while (n < 0 && errno == EINTR);
+            return n;
+        }
+        long long sysPwrite(int fd, const char* buf, std::size_t len, long long offset) {
+            ssize_t n;
+            do { n = ::pwrite(fd, buf, len, static_cast<off_t>(offset)); } while (n < 0 && errno == EINTR);
+            return n;
+        }
+        long long sysWrite(int fd, const char* buf, std::size_t len) {
+            ssize_t n;
+            do { n = ::write(fd, buf, len); } while (n < 0 && errno == EINTR);
+            return n;
+        }
+        int sysTruncate(int fd, long long size) { return ::ftruncate(fd, static_cast<off_t>(size)); }
+        int sysDataSync(int fd) {
+#if defined(__APPLE__)
+            return ::fsync(fd); // macOS khong co fdatasync
+#else
+            return ::fdatasync(fd);
+#endif
+        }
+        long long sysFileSize(int fd) {
+            struct stat st;
+            if (::fstat(fd, &st) != 0) return -1;
+            return st.st_size;
+        }
+        bool sysRename(const std::string& from, const std::string& to) {
+            return ::rename(from.c_str(), to.c_str()) == 0;
+        }
+        // fsync thu muc de ban ghi rename duoc ghi xuong dia
+        bool sysSyncDirectory(const std::string& dir) {
+            int fd = sysOpen(dir, O_RDONLY);
+            if (fd < 0) return false;
+            bool ok = ::fsync(fd) == 0;
+            ::close(fd);
+            return ok;
+        }
+        int sysGetPid() { return static_cast<int>(::getpid()); }
+        const int OPEN_READ = O_RDONLY;
+        const int OPEN_RDWR = O_RDWR;
+        const int OPEN_CREATE = O_CREAT;
+        const int OPEN_APPEND = O_APPEND;
+        const int OPEN_TRUNC = O_TRUNC;
+#endif
+
+        // File descriptor duoc cache. Dong fd khi khong con ai giu shared_ptr.
+        struct Handle {
+            int fd;
+            bool writable;
+            bool appendMode;
+#ifndef _WIN32
+            dev_t dev; // Dinh danh inode luc mo, de phat hien file bi thay the tu ben ngoai
+            ino_t ino;
+#endif
+            std::mutex ioMutex; // Tuan tu hoa cac thao tac ghi tren cung mot fd
+
+            Handle(int fd, bool writable, bool appendMode)
+                : fd(fd), writable(writable), appendMode(appendMode) {
+#ifndef _WIN32
+                struct stat st;
+                if (::fstat(fd, &st) == 0) {
+                    dev = st.st_dev;
+                    ino = st.st_ino;
+                } else {
+                    dev = 0;
+                    ino = 0;
+                }
+#endif
+            }
+            ~Handle() { sysClose(fd); }
+        };
+        typedef std::shared_ptr<Handle> HandlePtr;
+
+        enum class Mode { Read, Write, Append };
+
+        struct CacheEntry {
+            HandlePtr handle;
+            std::list<std::string>::iterator lruPos;
+        };
+
+        std::mutex cacheMutex;
+        std::unordered_map<std::string, CacheEntry> cache;
+        std::list<std::string> lruList; // Dau danh sach la file duoc dung gan nhat
+        std::size_t maxOpenFiles = 64;
+
+        Durability durability = Durability::None;
+        std::size_t batchSize = 32;
+        std::vector<HandlePtr> dirtyHandles; // Cac fd cho sync o che do Batched
+        std::set<std::string> dirtyDirs;     // Cac thu muc co rename cho fsync o che do Batched
+        std::vector<std::string> doneJournals; // Journal cua nhom da rename, chi xoa sau khi dirtyDirs da fsync
+        std::size_t pendingWrites = 0;
+
+        // File tam da ghi xong, cho rename de thay the file dich
+        struct StagedFile {
+            std::string tmpPath;
+            std::string targetPath;
+        };
+        thread_local std::vector<StagedFile>* currentGroup = nullptr; // ReplaceGroup dang mo tren thread nay
+        std::string journalPath = "data/replace.journal";
+        std::atomic<unsigned long long> tmpCounter(0);
+        std::atomic<ReplaceObserver> replaceObserver(nullptr);
+        const char* const TMP_MARKER = ".tmp-";
+        const char* const JOURNAL_COMMIT = "COMMIT";
+
+        std::atomic<unsigned long long> statOpens(0), statHits(0), statReads(0),
+                                        statWrites(0), statAppends(0), statSyncs(0);
+
+        // Kiem tra fd trong cache con tro dung file tren dia hay khong
+        bool stillValid(const HandlePtr& handle, const std::string& path) {
+#ifdef _WIN32
+            (void)handle; (void)path;
+            return true;
+#else
+            struct stat st;
+            if (::stat(path.c_str(), &st) != 0) return false;
+            return st.st_dev == handle->dev && st.st_ino == handle->ino;
+#endif
+        }
+
+        bool compatible(const HandlePtr& handle, Mode mode) {
+            switch (mode) {
+                case Mode::Read: return true;
+                case Mode::Write: return handle->writable && !handle->appendMode;
+                case Mode::Append: return handle->writable && handle->appendMode;
+            }
+            return false;
+        }
+
+        void dropLocked(const std::string& path) {
+            auto it = cache.find(path);
+            if (it != cache.end()) {
+                lruList.erase(it->second.lruPos);
+                cache.erase(it);
+            }
+        }
+
+        // Lay fd tu cache hoac mo moi. Tra ve nullptr neu khong mo duoc.
+        HandlePtr acquire(const std::string& path, Mode mode) {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            auto it = cache.find(path);
+            if (it != cache.end()) {
+                if (compatible(it->second.handle, mode) && stillValid(it->second.handle, path)) {
+                    lruList.splice(lruList.begin(), lruList, it->second.lruPos);
+                    statHits++;
+                    return it->second.handle;
+                }
+                dropLocked(path);
+            }
+
+            int fd = -1;
+            bool writable = true;
+            bool appendMode = false;
+            if (mode == Mode::Read) {
+                // Uu tien mo doc/ghi de fd co the tai su dung cho lan ghi sau
+                fd = sysOpen(path, OPEN_RDWR);
+                if (fd < 0 && errno != ENOENT) {
+                    fd = sysOpen(path, OPEN_READ);
+                    writable = false;
+                }
+            } else if (mode == Mode::Write) {
+                fd = sysOpen(path, OPEN_RDWR | OPEN_CREATE);
+            } else {
+                fd = sysOpen(path, OPEN_RDWR | OPEN_CREATE | OPEN_APPEND);
+                appendMode = true;
+            }
+            if (fd < 0) {
+                return nullptr;
+            }
+            statOpens++;
+
+            HandlePtr handle = std::make_shared<Handle>(fd, writable, appendMode);
+            lruList.push_front(path);
+            cache[path] = CacheEntry{handle, lruList.begin()};
+
+            // Dong bot cac fd it dung nhat khi vuot qua gioi han
+            while (cache.size() > maxOpenFiles) {
+                dropLocked(lruList.back());
+            }
+            return handle;
+        }
+
+        // Thuc hien chinh sach do ben sau mot lan ghi thanh cong
+        bool afterWrite(const HandlePtr& handle) {
+            Durability policy;
+            bool flushNow = false;
+            {
+                std::lock_guard<std::mutex> lock(cacheMutex);
+                policy = durability;
+                if (policy == Durability::Batched) {
+                    bool alreadyDirty = false;
+                    for (const HandlePtr& h : dirtyHandles) {
+                        if (h == handle) { alreadyDirty = true; break; }
+                    }
+                    if (!alreadyDirty) dirtyHandles.push_back(handle);
+                    flushNow = ++pendingWrites >= batchSize;
+                }
+            }
+            if (policy == Durability::DataSync) {
+                statSyncs++;
+                return sysDataSync(handle->fd) == 0;
+            }
+            if (flushNow) {
+                return sync();
+            }
+            return true;
+        }
+
+        bool writeAll(int fd, const char* data, std::size_t length, long long offset) {
+            while (length > 0) {
+                long long n = offset >= 0 ? sysPwrite(fd, data, length, offset) : sysWrite(fd, data, length);
+                if (n <= 0) return false;
+                data += n;
+                length -= static_cast<std::size_t>(n);
+                if (offset >= 0) offset += n;
+            }
+            return true;
+        }
+
+        // Bo dem tai su dung cho readLines (moi thread mot bo dem)
+        thread_local std::string lineBuffer;
+
+        std::string directoryOf(const std::string& path) {
+            std::size_t pos = path.find_last_of("/\\");
+            if (pos == std::string::npos) return ".";
+            if (pos == 0) return path.substr(0, 1);
+            return path.substr(0, pos);
+        }
+
+        bool fileExists(const std::string& path) {
+            struct stat st;
+            return ::stat(path.c_str(), &st) == 0;
+        }
+
+        // Ghi toan bo noi dung ra mot file moi (khong qua cache), dong bo neu can
+        bool writeFresh(const std::string& path, const std::string& content, bool syncData) {
+            int fd = sysOpen(path, OPEN_RDWR | OPEN_CREATE | OPEN_TRUNC);
+            if (fd < 0) return false;
+            bool ok = writeAll(fd, content.data(), content.size(), -1);
+            if (ok && syncData) {
+                statSyncs++;
+                ok = sysDataSync(fd) == 0;
+            }
+            sysClose(fd);
+            return ok;
+        }
+
+        // Rename cac file tam da dong bo thanh file dich va dong bo thu muc theo chinh sach
+        bool commitStaged(std::vector<StagedFile>& files) {
+            if (files.empty()) return true;
+            Durability policy = getDurability();
+            bool durable = policy != Durability::None;
+
+            // Nhom nhieu file: ghi journal truoc de co the hoan tat neu crash giua cac lan rename.
+            // Moi lan commit mot journal rieng (<journal>.<pid>-<so>): cac thread va cac tien trinh
+            // dung chung data/ khong ghi de journal cua nhau.
+            bool useJournal = files.size() > 1;
+            std::string journalFile;
+            if (useJournal) {
+                journalFile = journalPath + "." + std::to_string(sysGetPid()) + "-" + std::to_string(++tmpCounter);
+                std::string journal;
+                for (const StagedFile& f : files) {
+                    journal += f.tmpPath + "|" + f.targetPath + "\n";
+                }
+                journal += JOURNAL_COMMIT;
+                journal += "\n";
+                // Chinh sach ben vung: journal (ca muc thu muc cua no) phai xuong dia truoc lan rename dau
+                // tien, neu khong sau khi mat dien co the con nua nhom da rename ma khong con journal
+                bool written = writeFresh(journalFile, journal, durable);
+                if (written && durable) {
+                    statSyncs++;
+                    written = sysSyncDirectory(directoryOf(journalFile));
+                }
+                if (!written) {
+                    std::cerr << "Loi: Khong the ghi journal " << journalFile << ": " << strerror(errno) << std::endl;
+                    for (const StagedFile& f : files) ::remove(f.tmpPath.c_str());
+                    ::remove(journalFile.c_str());
+                    files.clear();
+                    return false;
+                }
+            }
+
+            bool ok = true;
+            std::set<std::string> dirs;
+            for (const StagedFile& f : files) {
+                if (!ok) {
+                    ::remove(f.tmpPath.c_str());
+                    continue;
+                }
+                ReplaceObserver observer = replaceObserver.load();
+                if (observer) observer(f.targetPath);
+                if (!sysRename(f.tmpPath, f.targetPath)) {
+                    std::cerr << "Loi: Khong the thay the file " << f.targetPath << ": " << strerror(errno) << std::endl;
+                    ::remove(f.tmpPath.c_str());
+                    ok = false;
+                    continue;
+                }
+                invalidate(f.targetPath); // fd cu tro toi inode da bi thay the
+                dirs.insert(directoryOf(f.targetPath));
+            }
+            files.clear();
+
+            // Journal chi duoc xoa khi cac rename da xuong dia (thu muc dich da fsync): xoa som hon thi
+            // mat dien co the de lai nhom rename do dang ma khong con gi de hoan tat
+            if (policy == Durability::DataSync) {
+                bool dirsSynced = true;
+                for (const std::string& dir : dirs) {
+                    statSyncs++;
+                    if (!sysSyncDirectory(dir)) dirsSynced = false;
+                }
+                if (!dirsSynced) ok = false;
+                if (useJournal && dirsSynced) ::remove(journalFile.c_str());
+            } else if (policy == Durability::Batched) {
+                bool flushNow;
+                {
+                    std::lock_guard<std::mutex> lock(cacheMutex);
+                    dirtyDirs.insert(dirs.begin(), dirs.end());
+                    if (useJournal) doneJournals.push_back(journalFile);
+                    flushNow = ++pendingWrites >= batchSize;
+                }
+                if (flushNow && !sync()) ok = false;
+            } else if (useJournal) {
+                ::remove(journalFile.c_str());
+            }
+            return ok;
+        }
+    }
+
+    void setDurability(Durability policy) {
+        if (policy != Durability::Batched) {
+            sync(); // Khong de lai du lieu cho khi roi che do Batched
+        }
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        durability = policy;
+    }
+
+    Durability getDurability() {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        return durability;
+    }
+
+    void setBatchSize(std::size_t writesPerSync) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        batchSize = writesPerSync == 0 ? 1 : writesPerSync;
+    }
+
+    void setMaxOpenFiles(std::size_t maxFiles) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        maxOpenFiles = maxFiles == 0 ? 1 : maxFiles;
+        while (cache.size() > maxOpenFiles) {
+            dropLocked(lruList.back());
+        }
+    }
+
+    bool readFile(const std::string& path, std::string& out) {
+        HandlePtr handle = acquire(path, Mode::Read);
+        if (!handle) {
+            out.clear();
+            return false;
+        }
+        statReads++;
+        long long size = sysFileSize(handle->fd);
+        if (size < 0) {
+            out.clear();
+            return false;
+        }
+        out.resize(static_cast<std::size_t>(size));
+        std::size_t done = 0;
+#ifdef _WIN32
+        std::lock_guard<std::mutex> lock(handle->ioMutex); // Emulate pread can giu vi tri con tro file
+#endif
+        while (done < out.size()) {
+            long long n = sysPread(handle->fd, &out[done], out.size() - done, static_cast<long long>(done));
+            if (n < 0) {
+                out.clear();
+                return false;
+            }
+            if (n == 0) break; // File bi cat ngan trong luc doc
+            done += static_cast<std::size_t>(n);
+        }
+        out.resize(done);
+        return true;
+    }
+
+    bool readFileOnce(const std::string& path, std::string& out) {
+        out.clear();
+        int fd = sysOpen(path, OPEN_READ);
+        if (fd < 0) return false;
+        statOpens++;
+        statReads++;
+        bool ok = true;
+        long long size = sysFileSize(fd);
+        if (size < 0) {
+            ok = false;
+        } else {
+            out.resize(static_cast<std::size_t>(size));
+            std::size_t done = 0;
+            while (done < out.size()) {
+                long long n = sysPread(fd, &out[done], out.size() - done, static_cast<long long>(done));
+                if (n < 0) { ok = false; break; }
+                if (n == 0) break;
+                done += static_cast<std::size_t>(n);
+            }
+            out.resize(ok ? done : 0);
+        }
+        sysClose(fd);
+        return ok;
+    }
+
+    bool readLines(const std::string& path, std::vector<std::string>& lines) {
+        lines.clear();
+        if (!readFile(path, lineBuffer)) {
+            return false;
+        }
+        std::size_t start = 0;
+        const std::size_t size = lineBuffer.size();
+        while (start < size) {
+            std::size_t end = lineBuffer.find('\n', start);
+            if (end == std::string::npos) end = size;
+            std::size_t lineEnd = end;
+            if (lineEnd > start && lineBuffer[lineEnd - 1] == '\r') --lineEnd;
+            lines.emplace_back(lineBuffer, start, lineEnd - start);
+            start = end + 1;
+        }
+        return true;
+    }
+
+    bool writeFile(const std::string& path, const std::string& content) {
+        HandlePtr handle = acquire(path, Mode::Write);
+        if (!handle) {
+            std::cerr << "Loi: Khong the mo file " << path << " de ghi: " << strerror(errno) << std::endl;
+            return false;
+        }
+        statWrites++;
+        {
+            std::lock_guard<std::mutex> lock(handle->ioMutex);
+            if (sysTruncate(handle->fd, 0) != 0 ||
+                !writeAll(handle->fd, content.data(), content.size(), 0)) {
+                std::cerr << "Loi: Ghi file " << path << " that bai: " << strerror(errno) << std::endl;
+                return false;
+            }
+        }
+        return afterWrite(handle);
+    }
+
+    bool readRange(const std::string& path, unsigned long long offset, std::size_t length, std::string& out) {
+        HandlePtr handle = acquire(path, Mode::Read);
+        if (!handle) {
+            out.clear();
+            return false;
+        }
+        statReads++;
+        out.resize(length);
+        std::size_t done = 0;
+#ifdef _WIN32
+        std::lock_guard<std::mutex> lock(handle->ioMutex);
+#endif
+        while (done < length) {
+            long long n = sysPread(handle->fd, &out[done], length - done, static_cast<long long>(offset + done));
+            if (n < 0) {
+                out.clear();
+                return false;
+            }
+            if (n == 0) break;
+            done += static_cast<std::size_t>(n);
+        }
+        out.resize(done);
+        return done == length;
+    }
+
+    bool appendFile(const std::string& path, const char* data, std::size_t length,
+                    unsigned long long* offsetOut) {
+        HandlePtr handle = acquire(path, Mode::Append);
+        if (!handle) {
+            std::cerr << "Loi: Khong the mo file " << path << " de them: " << strerror(errno) << std::endl;
+            return false;
+        }
+        statAppends++;
+        {
+            std::lock_guard<std::mutex> lock(handle->ioMutex);
+            // fd mo voi O_APPEND: moi lan write duoc dat nguyen khoi vao cuoi file
+            if (offsetOut) {
+                long long size = sysFileSize(handle->fd);
+                *offsetOut = size < 0 ? 0 : static_cast<unsigned long long>(size);
+            }
+            if (!writeAll(handle->fd, data, length, -1)) {
+                std::cerr << "Loi: Them du lieu vao file " << path << " that bai: " << strerror(errno) << std::endl;
+                return false;
+            }
+        }
+        return afterWrite(handle);
+    }
+
+    bool truncateFile(const std::string& path, unsigned long long size) {
+        // Dung fd che do them (ftruncate van hop le voi O_APPEND) de lan append sau tai su dung
+        HandlePtr handle = acquire(path, Mode::Append);
+        if (!handle) {
+            std::cerr << "Loi: Khong the mo file " << path << " de cat: " << strerror(errno) << std::endl;
+            return false;
+        }
+        statWrites++;
+        {
+            std::lock_guard<std::mutex> lock(handle->ioMutex);
+            if (sysTruncate(handle->fd, static_cast<long long>(size)) != 0) {
+                std::cerr << "Loi: Cat file " << path << " that bai: " << strerror(errno) << std::endl;
+                return false;
+            }
+        }
+        return afterWrite(handle);
+    }
+
+    bool replaceFile(const std::string& path, const std::string& content) {
+        std::string tmpPath = path + TMP_MARKER + std::to_string(sysGetPid()) + "-" + std::to_string(++tmpCounter);
+        // Chinh sach ben vung: file tam phai nam tren dia truoc khi rename, neu khong rename co the
+        // tro toi file rong. Durability::None khong sync gi (khong dam bao khi mat dien).
+        if (!writeFresh(tmpPath, content, getDurability() != Durability::None)) {
+            std::cerr << "Loi: Khong the ghi file tam " << tmpPath << ": " << strerror(errno) << std::endl;
+            ::remove(tmpPath.c_str());
+            return false;
+        }
+        statWrites++;
+        if (currentGroup) {
+            currentGroup->push_back(StagedFile{tmpPath, path});
+            return true;
+        }
+        std::vector<StagedFile> single(1, StagedFile{tmpPath, path});
+        return commitStaged(single);
+    }
+
+    bool createPrivateFile(const std::string& path, const std::string& content) {
+#ifdef _WIN32
+        return fileExists(path) || writeFresh(path, content, getDurability() != Durability::None);
+#else
+        // Tao voi quyen 0600 ngay tu dau: khong co luc nao file bi doc duoc boi nguoi khac
+        int fd;
+        do {
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        } while (fd < 0 && errno == EINTR);
+        if (fd < 0 && errno == EEXIST) {
+            if (::chmod(path.c_str(), 0600) == 0) return true;
+        } else if (fd >= 0) {
+            statOpens++;
+            bool ok = writeAll(fd, content.data(), content.size(), -1) &&
+                      (getDurability() == Durability::None || sysDataSync(fd) == 0);
+            sysClose(fd);
+            statWrites++;
+            if (ok) return true;
+        }
+        std::cerr << "Loi: Khong the tao file " << path << ": " << strerror(errno) << std::endl;
+        return false;
+#endif
+    }
+
+    MappedFile::MappedFile() : ptr(nullptr), length(0), mapped(false) {}
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& path) {
+        close();
+#ifndef _WIN32
+        int fd = sysOpen(path, OPEN_READ);
+        if (fd < 0) return false;
+        statOpens++;
+        long long size = sysFileSize(fd);
+        if (size > 0) {
+            void* addr = ::mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, MAP_SHARED, fd, 0);
+            if (addr != MAP_FAILED) {
+                ptr = static_cast<const char*>(addr);
+                length = static_cast<std::size_t>(size);
+                mapped = true;
+            }
+        }
+        sysClose(fd); // Vung anh xa van hop le sau khi dong fd
+        if (mapped || size == 0) {
+            if (!mapped) ptr = buffer.data();
+            return true;
+        }
+#endif
+        // Khong mmap duoc (hoac Windows): doc toan bo vao bo dem
+        if (!readFileOnce(path, buffer)) return false;
+        ptr = buffer.data();
+        length = buffer.size();
+        return true;
+    }
+
+    void MappedFile::close() {
+#ifndef _WIN32
+        if (mapped) {
+            ::munmap(const_cast<char*>(ptr), length);
+        }
+#endif
+        ptr = nullptr;
+        length = 0;
+        mapped = false;
+        buffer.clear();
+    }
+
+    ReplaceGroup::ReplaceGroup() : active(currentGroup == nullptr) {
+        if (active) {
+            currentGroup = new std::vector<StagedFile>();
+        }
+    }
+
+    ReplaceGroup::~ReplaceGroup() {
+        if (!active) return;
+        // Nhom chua commit: bo cac file tam, file dich khong bi thay doi
+        for (const StagedFile& f : *currentGroup) {
+            ::remove(f.tmpPath.c_str());
+        }
+        delete currentGroup;
+        currentGroup = nullptr;
+    }
+
+    bool ReplaceGroup::commit() {
+        if (!active) return true; // Nhom ngoai cung se commit
+        return commitStaged(*currentGroup);
+    }
+
+    void setJournalPath(const std::string& path) {
+        journalPath = path;
+    }
+
+    std::vector<std::string> listDirectory(const std::string& dir) {
+        std::vector<std::string> names;
+#ifdef _WIN32
+        struct _finddata_t data;
+        intptr_t h = _findfirst((dir + "/*").c_str(), &data);
+        if (h == -1) return names;
+        do {
+            if (!(data.attrib & _A_SUBDIR)) names.push_back(data.name);
+        } while (_findnext(h, &data) == 0);
+        _findclose(h);
+#else
+        DIR* d = ::opendir(dir.c_str());
+        if (!d) return names;
+        while (struct dirent* entry = ::readdir(d)) {
+            std::string name = entry->d_name;
+            if (name == "." || name == "..") continue;
+            struct stat st;
+            if (::stat((dir + "/" + name).c_str(), &st) == 0 && S_ISDIR(st.st_mode)) continue;
+            names.push_back(name);
+        }
+        ::closedir(d);
+#endif
+        return names;
+    }
+
+    bool fileStat(const std::string& path, long long& size, time_t& modified) {
+#ifdef _WIN32
+        struct _stati64 st;
+        if (_stati64(path.c_str(), &st) != 0) return false;
+#else
+        struct stat st;
+        if (::stat(path.c_str(), &st) != 0) return false;
+#endif
+        size = static_cast<long long>(st.st_size);
+        modified = st.st_mtime;
+        return true;
+    }
+
+    bool linkFile(const std::string& from, const std::string& to, bool durable) {
+#ifdef _WIN32
+        bool linked = CreateHardLinkA(to.c_str(), from.c_str(), nullptr) != 0;
+#else
+        bool linked = ::link(from.c_str(), to.c_str()) == 0;
+        if (!linked && errno == ENOENT) return false;
+#endif
+        if (linked) {
+            if (!durable) return true;
+            // Noi dung cua inode co the van chi nam trong page cache (chinh sach None)
+            int fd = sysOpen(to, OPEN_READ);
+            if (fd < 0) return false;
+            statSyncs++;
+            bool ok = sysDataSync(fd) == 0;
+            sysClose(fd);
+            return ok;
+        }
+        std::string content;
+        if (!readFileOnce(from, content)) return false;
+        if (!writeFresh(to, content, durable || getDurability() != Durability::None)) {
+            std::cerr << "Loi: Khong the sao chep " << from << " sang " << to << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        statWrites++;
+        return true;
+    }
+
+    void setReplaceObserver(ReplaceObserver observer) {
+        replaceObserver = observer;
+    }
+
+    namespace {
+        int replayJournal(const std::string& path) {
+            std::vector<std::string> lines;
+            if (!readLines(path, lines)) return 0;
+            invalidate(path);
+
+            int rolled = 0;
+            // Chi hoan tat khi journal day du (co dong COMMIT). Journal do dang nghia la
+            // chua co file nao bi rename, cac file tam se duoc don o recoverDirectory.
+            if (!lines.empty() && lines.back() == JOURNAL_COMMIT) {
+                std::set<std::string> dirs;
+                for (std::size_t i = 0; i + 1 < lines.size(); ++i) {
+                    std::size_t sep = lines[i].find('|');
+                    if (sep == std::string::npos) continue;
+                    std::string tmpPath = lines[i].substr(0, sep);
+                    std::string targetPath = lines[i].substr(sep + 1);
+                    if (fileExists(tmpPath) && sysRename(tmpPath, targetPath)) {
+                        invalidate(targetPath);
+                        dirs.insert(directoryOf(targetPath));
+                        rolled++;
+                    }
+                }
+                for (const std::string& dir : dirs) {
+                    statSyncs++;
+                    sysSyncDirectory(dir);
+                }
+            }
+            ::remove(path.c_str());
+            return rolled;
+        }
+    }
+
+    int recoverJournal() {
+        // Journal cu (mot file chung) va journal cua tung lan commit (<journal>.<pid>-<so>).
+        // Chi goi khi khong con tien trinh nao khac dang chay tren data/.
+        int rolled = replayJournal(journalPath);
+        std::string dir = directoryOf(journalPath);
+        std::string prefix = journalPath.substr(journalPath.find_last_of("/\\") + 1) + ".";
+        for (const std::string& name : listDirectory(dir)) {
+            if (name.compare(0, prefix.size(), prefix) == 0 && name.find(TMP_MARKER) == std::string::npos) {
+                rolled += replayJournal(dir + "/" + name);
+            }
+        }
+        return rolled;
+    }
+
+    RecoveryReport recoverDirectory(const std::string& dir, const std::string& suffix,
+                                    const std::function<bool(const std::string&)>& isValid) {
+        RecoveryReport report = {0, 0, 0, 0};
+        std::vector<std::string> names = listDirectory(dir);
+        std::string content;
+
+        // Buoc 1: file tam con sot lai sau crash
+        for (const std::string& name : names) {
+            std::size_t pos = name.find(TMP_MARKER);
+            if (pos == std::string::npos) continue;
+            std::string tmpPath = dir + "/" + name;
+            std::string targetPath = dir + "/" + name.substr(0, pos);
+
+            bool targetOk = readFile(targetPath, content) && isValid(content);
+            bool tmpOk = !targetOk && readFile(tmpPath, content) && isValid(content);
+            invalidate(tmpPath);
+            if (tmpOk && sysRename(tmpPath, targetPath)) {
+                invalidate(targetPath);
+                report.restoredFromTemp++;
+            } else {
+                ::remove(tmpPath.c_str());
+                report.removedTemp++;
+            }
+        }
+
+        // Buoc 2: cach ly cac file du lieu bi hong (vi du bi cat ngan boi phien ban cu ghi de tai cho)
+        for (const std::string& name : names) {
+            if (name.find(TMP_MARKER) != std::string::npos) continue;
+            if (name.size() < suffix.size() || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+            std::string path = dir + "/" + name;
+            if (!readFile(path, content)) continue; // Da duoc thay the o buoc 1 hoac khong doc duoc
+            if (!isValid(content)) {
+                invalidate(path);
+                if (sysRename(path, path + ".corrupt")) {
+                    report.quarantined++;
+                }
+            }
+        }
+
+        if (report.restoredFromTemp > 0 || report.quarantined > 0) {
+            statSyncs++;
+            sysSyncDirectory(dir);
+        }
+        return report;
+    }
+
+    bool sync() {
+        std::vector<HandlePtr> toSync;
+        std::set<std::string> dirsToSync;
+        std::vector<std::string> journals;
+        {
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            toSync.swap(dirtyHandles);
+            dirsToSync.swap(dirtyDirs);
+            journals.swap(doneJournals);
+            pendingWrites = 0;
+        }
+        bool ok = true;
+        for (const HandlePtr& handle : toSync) {
+            statSyncs++;
+            if (sysDataSync(handle->fd) != 0) ok = false;
+        }
+        // Nhieu lan thay the file trong cung thu muc chi can mot lan fsync thu muc
+        bool dirsSynced = true;
+        for (const std::string& dir : dirsToSync) {
+            statSyncs++;
+            if (!sysSyncDirectory(dir)) dirsSynced = false;
+        }
+        if (dirsSynced) {
+            for (const std::string& journal : journals) ::remove(journal.c_str());
+        } else {
+            // Giu journal (phuc hoi chay lai vo hai) va thu muc cho lan sync sau
+            ok = false;
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            dirtyDirs.insert(dirsToSync.begin(), dirsToSync.end());
+            doneJournals.insert(doneJournals.end(), journals.begin(), journals.end());
+        }
+        return ok;
+    }
+
+    bool syncFile(const std::string& path) {
+        HandlePtr handle = acquire(path, Mode::Append);
+        if (!handle) {
+            std::cerr << "Loi: Khong the mo file " << path << " de dong bo: " << strerror(errno) << std::endl;
+            return false;
+        }
+        statSyncs++;
+        return sysDataSync(handle->fd) == 0;
+    }
+
+    bool syncDirectory(const std::string& dir) {
+        statSyncs++;
+        return sysSyncDirectory(dir);
+    }
+
+    void invalidate(const std::string& path) {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        dropLocked(path);
+    }
+
+    void closeAll() {
+        sync();
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cache.clear();
+        lruList.clear();
+    }
+
+    Stats getStats() {
+        Stats s;
+        s.opens = statOpens.load();
+        s.cacheHits = statHits.load();
+        s.reads = statReads.load();
+        s.writes = statWrites.load();
+        s.appends = statAppends.load();
+        s.syncs = statSyncs.load();
+        return s;
+    }
+}
@@ -0,0 +1,180 @@
+// fileio.h
+#ifndef FILEIO_H
+#define FILEIO_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+
+// Lop I/O muc thap (POSIX) dung chung cho toan bo du lieu cua he thong.
+// - Giu lai (cache) cac file descriptor da mo thay vi tao fstream moi cho moi lan goi
+// - Doc bang pread vao bo dem tai su dung (moi thread mot bo dem)
+// - Ghi bang pwrite/write, khong qua bo dem stdio nen khong can flush tung dong
+// - Do ben (durability) duoc dieu khien ro rang bang chinh sach
+namespace FileIO {
+
+    // Chinh sach dam bao du lieu da xuong dia. So lan sync cho mot giao dich chuyen diem (hai vi luu
+    // trong mot ReplaceGroup, mot dong transactions.log, mot dong changes.log):
+    // - None: 0. Replace van nguyen tu khi tien trinh bi kill (rename + journal trong page cache),
+    //   khong dam bao gi khi mat dien.
+    // - DataSync: 2 file tam + journal + thu muc journal + moi thu muc vi (1 khi khong phan vung)
+    //   + 2 lan them vao log = 7.
+    // - Batched: 2 file tam + journal + thu muc journal = 4; fsync thu muc vi va cac log duoc gom
+    //   lai moi 'batchSize' lan ghi.
+    enum class Durability {
+        None,     // Khong goi fdatasync/fsync nao (nhanh nhat, giong hanh vi cu)
+        DataSync, // Goi fdatasync sau moi lan ghi
+        Batched   // Gom nhieu lan ghi, fdatasync mot lan khi du so luong hoac khi goi sync()
+    };
+
+    // Thong ke hoat dong cua lop I/O
+    struct Stats {
+        unsigned long long opens;      // So lan mo file thuc su (cache miss)
+        unsigned long long cacheHits;  // So lan tai su dung file descriptor
+        unsigned long long reads;
+        unsigned long long writes;
+        unsigned long long appends;
+        unsigned long long syncs;      // So lan goi fdatasync/fsync
+    };
+
+    // Dat/lay chinh sach do ben
+    void setDurability(Durability policy);
+    Durability getDurability();
+
+    // So lan ghi toi da truoc khi tu dong sync o che do Batched
+    void setBatchSize(std::size_t writesPerSync);
+
+    // So file descriptor toi da duoc giu mo dong thoi
+    void setMaxOpenFiles(std::size_t maxFiles);
+
+    // Doc toan bo file vao 'out'. Tra ve false neu file khong ton tai hoac loi doc.
+    bool readFile(const std::string& path, std::string& out);
+
+    // Doc toan bo file ma khong giu fd trong cache (dung khi quet hang loat nhieu file)
+    bool readFileOnce(const std::string& path, std::string& out);
+
+    // Doc tat ca cac dong cua file (bo ky tu '\n', '\r' o cuoi dong)
+    bool readLines(const std::string& path, std::vector<std::string>& lines);
+
+    // Ghi de toan bo noi dung file (tao moi neu chua ton tai)
+    bool writeFile(const std::string& path, const std::string& content);
+
+    // Doc 'length' byte bat dau tu vi tri 'offset' (pread, khong doc ca file)
+    bool readRange(const std::string& path, unsigned long long offset, std::size_t length, std::string& out);
+
+    // Them du lieu vao cuoi file bang mot lan ghi duy nhat
+    // Neu 'offsetOut' khac nullptr, tra ve vi tri bat dau cua ban ghi trong file
+    bool appendFile(const std::string& path, const char* data, std::size_t length,
+                    unsigned long long* offsetOut = nullptr);
+
+    // Cat (hoac noi dai) file ve dung 'size' byte, tao moi neu chua co.
+    // Dung de bo phan du lieu ghi do dang cua file chi-ghi-them sau crash.
+    bool truncateFile(const std::string& path, unsigned long long size);
+
+    // Anh xa mot file vao bo nho chi doc (mmap). Tren Windows noi dung duoc doc vao bo dem.
+    // Vung nho van hop le ke ca khi file bi thay the bang rename trong luc dang anh xa.
+    class MappedFile {
+    public:
+        MappedFile();
+        ~MappedFile();
+        bool open(const std::string& path);
+        void close();
+        const char* data() const { return ptr; }
+        std::size_t size() const { return length; }
+
+    private:
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        const char* ptr;
+        std::size_t length;
+        bool mapped;        // true neu ptr den tu mmap
+        std::string buffer; // Du lieu khi khong dung duoc mmap
+    };
+
+    // Ghi thay the file mot cach nguyen tu: ghi ra file tam, fdatasync (theo chinh sach),
+    // rename de thay file cu, roi fsync thu muc. Khi crash (mat dien: chi voi chinh sach ben vung),
+    // file dich hoac con noi dung cu hoac da co day du noi dung moi, khong bao gio bi cat ngan.
+    // Neu dang co ReplaceGroup tren thread hien tai, file chi duoc dua vao nhom (chua rename).
+    bool replaceFile(const std::string& path, const std::string& content);
+
+    // Tao file chi chu so huu doc/ghi duoc (0600) voi noi dung 'content' (dung cho du lieu bi mat).
+    // File da ton tai thi giu noi dung, chi thu hep quyen. Windows: tao binh thuong.
+    bool createPrivateFile(const std::string& path, const std::string& content);
+
+    // Nhom nhieu lan replaceFile de commit cung nhau:
+    // - Cac file tam duoc dong bo, sau do rename lien tiep
+    // - Moi thu muc chi fsync mot lan cho ca nhom
+    // - Neu nhom co nhieu file, mot journal nho dam bao khi crash giua chung se duoc
+    //   hoan tat (roll forward) luc khoi dong. Chinh sach ben vung: journal va thu muc cua no
+    //   duoc fsync truoc lan rename dau, journal chi bi xoa sau khi thu muc dich da fsync.
+    // Neu huy doi tuong ma chua commit, cac file tam bi xoa va file dich giu nguyen.
+    class ReplaceGroup {
+    public:
+        ReplaceGroup();
+        ~ReplaceGroup();
+        bool commit();
+
+    private:
+        ReplaceGroup(const ReplaceGroup&) = delete;
+        ReplaceGroup& operator=(const ReplaceGroup&) = delete;
+        bool active; // false neu day la nhom long ben trong mot nhom khac
+    };
+
+    // Duong dan journal cua ReplaceGroup (mac dinh: data/replace.journal).
+    // Moi lan commit ghi journal rieng <duong dan>.<pid>-<so thu tu>.
+    void setJournalPath(const std::string& path);
+
+    // Liet ke ten cac file (khong gom thu muc con) trong mot thu muc
+    std::vector<std::string> listDirectory(const std::string& dir);
+
+    // Kich thuoc va thoi diem sua doi cuoi cua file. false neu file khong ton tai.
+    bool fileStat(const std::string& path, long long& size, time_t& modified);
+
+    // Tao hard link 'to' tro toi noi dung hien tai cua 'from' (khong sao chep du lieu).
+    // Vi replaceFile thay file bang rename, ban link giu nguyen noi dung cu ve sau.
+    // Neu khong link duoc (khac o dia, he thong file khong ho tro) thi sao chep.
+    // durable = true: fdatasync file dich (ban sao hoac inode duoc link) bat ke chinh sach do ben.
+    bool linkFile(const std::string& from, const std::string& to, bool durable = false);
+
+    // Ham duoc goi ngay truoc khi replaceFile/ReplaceGroup thay the (rename) mot file dich,
+    // dung cho sao luu copy-on-write. nullptr de bo.
+    typedef void (*ReplaceObserver)(const std::string& targetPath);
+    void setReplaceObserver(ReplaceObserver observer);
+
+    // Ket qua phuc hoi du lieu luc khoi dong
+    struct RecoveryReport {
+        int rolledForward;    // File duoc hoan tat tu journal cua nhom dang commit do
+        int restoredFromTemp; // File dich hong/mat duoc thay bang file tam hop le
+        int removedTemp;      // File tam thua bi xoa
+        int quarantined;      // File hong khong phuc hoi duoc, doi ten thanh *.corrupt
+    };
+
+    // Hoan tat cac nhom dang commit do neu journal con ton tai
+    // (chi goi khi khong co tien trinh nao khac dang ghi vao cung thu muc du lieu)
+    int recoverJournal();
+
+    // Quet mot thu muc: xu ly file tam con sot lai va cach ly cac file co duoi 'suffix'
+    // khong vuot qua ham kiem tra 'isValid' (vi du file rong do ghi do dang)
+    RecoveryReport recoverDirectory(const std::string& dir, const std::string& suffix,
+                                    const std::function<bool(const std::string&)>& isValid);
+
+    // Dong bo xuong dia tat ca cac file dang cho o che do Batched
+    bool sync();
+
+    // fdatasync mot file bat ke chinh sach do ben (vi du khi nguoi goi can xac nhan da xuong dia)
+    bool syncFile(const std::string& path);
+    // fsync mot thu muc bat ke chinh sach do ben (cac file vua tao/link/rename trong do xuong dia)
+    bool syncDirectory(const std::string& dir);
+
+    // Bo file descriptor da cache cua mot duong dan (vi du sau khi file bi doi ten/xoa)
+    void invalidate(const std::string& path);
+
+    // Sync (neu can) va dong tat ca file descriptor dang giu
+    void closeAll();
+
+    Stats getStats();
+}
+
+#endif // FILEIO_H
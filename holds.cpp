@@ -0,0 +1,156 @@
+// holds.cpp
+#include "holds.h"
+
+HoldManager::HoldManager()
+    : nextSequence(1), stopping(false), placed(0), committed(0), cancelled(0), expired(0) {}
+
+HoldManager::~HoldManager() {
+    shutdown();
+}
+
+HoldManager& HoldManager::instance() {
+    static HoldManager manager;
+    return manager;
+}
+
+HoldManager::HoldId HoldManager::place(IdHandle sender, IdHandle receiver, long long cents, long long balanceCents,
+                                       unsigned int seconds) {
+    // Ma giu cho mang so phan cua vi gui: moi thao tac ve sau chi khoa dung mot phan
+    std::size_t stripeIndex = sender % STRIPES;
+    Stripe& stripe = stripes[stripeIndex];
+    Hold hold;
+    {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        long long& held = stripe.heldByWallet[sender];
+        if (balanceCents - held < cents) {
+            if (held == 0) stripe.heldByWallet.erase(sender);
+            return NO_HOLD;
+        }
+        hold.id = nextSequence.fetch_add(1) * STRIPES + stripeIndex;
+        hold.sender = sender;
+        hold.receiver = receiver;
+        hold.cents = cents;
+        hold.expires = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+        hold.committing = false;
+        held += cents;
+        stripe.holds.emplace(hold.id, hold);
+    }
+    placed++;
+    schedule(Deadline(hold.expires, hold.id));
+    return hold.id;
+}
+
+void HoldManager::removeLocked(Stripe& stripe, std::unordered_map<HoldId, Hold>::iterator it) {
+    auto held = stripe.heldByWallet.find(it->second.sender);
+    if (held != stripe.heldByWallet.end()) {
+        held->second -= it->second.cents;
+        if (held->second <= 0) stripe.heldByWallet.erase(held);
+    }
+    stripe.holds.erase(it);
+}
+
+bool HoldManager::beginCommit(HoldId id, Hold& out) {
+    Stripe& stripe = stripeOf(id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.holds.find(id);
+    if (it == stripe.holds.end() || it->second.committing) return false;
+    if (it->second.expires <= std::chrono::steady_clock::now()) {
+        // Qua han nhung thread hen gio chua kip xoa
+        removeLocked(stripe, it);
+        expired++;
+        return false;
+    }
+    it->second.committing = true;
+    out = it->second;
+    return true;
+}
+
+void HoldManager::release(HoldId id) {
+    Stripe& stripe = stripeOf(id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.holds.find(id);
+    if (it == stripe.holds.end()) return;
+    removeLocked(stripe, it);
+    committed++;
+}
+
+bool HoldManager::cancel(HoldId id) {
+    Stripe& stripe = stripeOf(id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.holds.find(id);
+    if (it == stripe.holds.end() || it->second.committing) return false;
+    removeLocked(stripe, it);
+    cancelled++;
+    return true;
+}
+
+long long HoldManager::heldCents(IdHandle wallet) const {
+    const Stripe& stripe = stripes[wallet % STRIPES];
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.heldByWallet.find(wallet);
+    return it == stripe.heldByWallet.end() ? 0 : it->second;
+}
+
+void HoldManager::expire(HoldId id) {
+    Stripe& stripe = stripeOf(id);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.holds.find(id);
+    if (it == stripe.holds.end() || it->second.committing) return;
+    if (it->second.expires > std::chrono::steady_clock::now()) return;
+    removeLocked(stripe, it);
+    expired++;
+}
+
+void HoldManager::schedule(const Deadline& deadline) {
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        if (stopping) return;
+        if (!timer.joinable()) {
+            // Thread hen gio chi chay khi da co giu cho dau tien
+            timer = std::thread([this]() { runTimer(); });
+        }
+        earliest = deadlines.empty() || deadline.first < deadlines.top().first;
+        deadlines.push(deadline);
+    }
+    if (earliest) timerWake.notify_one();
+}
+
+void HoldManager::runTimer() {
+    std::unique_lock<std::mutex> lock(timerMutex);
+    while (!stopping) {
+        if (deadlines.empty()) {
+            timerWake.wait(lock);
+            continue;
+        }
+        Deadline next = deadlines.top();
+        if (next.first > std::chrono::steady_clock::now()) {
+            timerWake.wait_until(lock, next.first);
+            continue;
+        }
+        deadlines.pop();
+        // Giu cho da commit/huy thi expire() khong lam gi
+        lock.unlock();
+        expire(next.second);
+        lock.lock();
+    }
+}
+
+void HoldManager::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(timerMutex);
+        stopping = true;
+    }
+    timerWake.notify_all();
+    if (timer.joinable()) timer.join();
+}
+
+HoldManager::Stats HoldManager::stats() const {
+    Stats s = {0, 0, placed, committed, cancelled, expired};
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        s.active += stripe.holds.size();
+        for (const auto& entry : stripe.heldByWallet) s.heldCents += entry.second;
+    }
+    return s;
+}
@@ -0,0 +1,110 @@
+// holds.h
+#ifndef HOLDS_H
+#define HOLDS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "intern.h"
+
+// Giu cho (reservation hold) cho chuyen diem hai giai doan: giai doan 1 giu 'so diem' tren vi gui,
+// giai doan 2 commit (chuyen diem that) hoac huy. So du kha dung = so du - tong dang giu.
+// - Chi nam trong bo nho: giu cho khong ghi lai file vi; vi chi bi ghi mot lan khi commit
+// - Chi trong tien trinh nay: tien trinh khac khong thay giu cho, nen chi dat giu cho khi khong co tien
+//   trinh nao khac giu Instances (Wallet::holdsAvailable). Tien trinh khoi dong sau do van co the tieu
+//   phan diem dang giu; commit luon kiem tra lai so du that nen khi do chi that bai, khong bao gio am.
+// - Khong co khoa toan cuc: bang chia thanh STRIPES phan theo handle vi gui, moi phan mot mutex
+// - Het han tu dong: hang doi uu tien theo thoi diem het han, mot thread hen gio xoa giu cho qua han
+class HoldManager {
+public:
+    typedef std::uint64_t HoldId;
+    static const HoldId NO_HOLD = 0;
+
+    struct Hold {
+        HoldId id;
+        IdHandle sender;
+        IdHandle receiver;
+        long long cents;     // So diem dang giu (x100)
+        std::chrono::steady_clock::time_point expires;
+        bool committing;     // Dang commit: khong bi huy hay het han nua
+    };
+
+    struct Stats {
+        std::size_t active;
+        long long heldCents;
+        std::size_t placed;
+        std::size_t committed;
+        std::size_t cancelled;
+        std::size_t expired;
+    };
+
+    static HoldManager& instance();
+
+    // Giu 'cents' tren vi gui neu so du kha dung ('balanceCents' tru tong dang giu) du.
+    // Tra ve NO_HOLD neu khong du.
+    HoldId place(IdHandle sender, IdHandle receiver, long long cents, long long balanceCents, unsigned int seconds);
+
+    // Bat dau commit: chep giu cho ra 'out' va danh dau dang commit.
+    // Tra ve false neu giu cho khong ton tai, da huy hoac da het han.
+    bool beginCommit(HoldId id, Hold& out);
+    // Bo giu cho sau khi commit xong (thanh cong hay that bai)
+    void release(HoldId id);
+    // Huy giu cho chua commit. Tra ve false neu khong con.
+    bool cancel(HoldId id);
+
+    // Tong so diem dang giu tren mot vi (x100)
+    long long heldCents(IdHandle wallet) const;
+
+    // Dung thread hen gio (khi thoat chuong trinh)
+    void shutdown();
+
+    Stats stats() const;
+
+private:
+    HoldManager();
+    ~HoldManager();
+    HoldManager(const HoldManager&) = delete;
+    HoldManager& operator=(const HoldManager&) = delete;
+
+    static const std::size_t STRIPES = 64;
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<HoldId, Hold> holds;
+        std::unordered_map<IdHandle, long long> heldByWallet;
+    };
+
+    typedef std::pair<std::chrono::steady_clock::time_point, HoldId> Deadline;
+
+    Stripe& stripeOf(HoldId id) { return stripes[id % STRIPES]; }
+    static void removeLocked(Stripe& stripe, std::unordered_map<HoldId, Hold>::iterator it);
+    void schedule(const Deadline& deadline);
+    void expire(HoldId id);
+    void runTimer();
+
+    Stripe stripes[STRIPES];
+    std::atomic<HoldId> nextSequence;
+
+    // Hang doi het han (phan tu som nhat o dinh)
+    std::mutex timerMutex;
+    std::condition_variable timerWake;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline> > deadlines;
+    std::thread timer;
+    bool stopping;
+
+    std::atomic<std::size_t> placed;
+    std::atomic<std::size_t> committed;
+    std::atomic<std::size_t> cancelled;
+    std::atomic<std::size_t> expired;
+};
+
+#endif // HOLDS_H
@@ -0,0 +1,158 @@
+// idempotency.cpp
+#include "idempotency.h"
+#include "logscan.h"
+#include "logwriter.h"
+#include <cmath>
+#include <iostream>
+
+namespace {
+    const unsigned int DEFAULT_WINDOW_SECONDS = 24 * 60 * 60;
+    const std::size_t DEFAULT_MAX_ENTRIES = 262144;
+    const std::size_t MAX_KEY_LENGTH = 64;
+
+    long long toCents(double amount) {
+        return std::llround(amount * 100.0);
+    }
+}
+
+IdempotencyTable::IdempotencyTable()
+    : windowSeconds(DEFAULT_WINDOW_SECONDS), maxEntries(DEFAULT_MAX_ENTRIES), duplicates(0),
+      conflicts(0), expired(0), recoveredEntries(0) {}
+
+IdempotencyTable& IdempotencyTable::instance() {
+    static IdempotencyTable table;
+    return table;
+}
+
+void IdempotencyTable::configure(unsigned int window, std::size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    windowSeconds = window;
+    maxEntries = limit > 0 ? limit : 1;
+}
+
+bool IdempotencyTable::isValidKey(const std::string& key) {
+    if (key.empty() || key.size() > MAX_KEY_LENGTH) return false;
+    for (char c : key) {
+        if (c == '|' || static_cast<unsigned char>(c) < 0x21 || c == 0x7f) return false;
+    }
+    return true;
+}
+
+void IdempotencyTable::recover() {
+    // Cac giao dich con trong hang doi ghi log cung phai duoc tinh
+    TransactionLogWriter::instance().flush();
+    time_t cutoff;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        cutoff = time(0) - static_cast<time_t>(windowSeconds);
+    }
+    LogScanner scanner;
+    MonotonicArena arena;
+    ArenaVector<TransactionView> keyed{ArenaAllocator<TransactionView>(arena)};
+    if (!scanner.collect([cutoff](const TransactionView& view) {
+            return !view.requestKey.empty() && view.timestamp >= cutoff;
+        }, keyed)) {
+        return; // Chua co log
+    }
+    // Quet xong moi khoa bang: claim() khong phai cho mot lan quet toan bo log
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const TransactionView& view : keyed) {
+        Key key = {view.sender, view.requestKey.str()};
+        if (entries.count(key)) continue; // Da co tu lan claim() chay truoc (moi hon ban trong log)
+        Entry entry;
+        entry.added = view.timestamp;
+        entry.receiver = view.receiver;
+        entry.amountCents = toCents(view.amount);
+        entry.pending = false;
+        entry.outcome.transactionId = view.transactionId.str();
+        entry.outcome.completed = view.status == "completed";
+        entry.outcome.timestamp = view.timestamp;
+        insertLocked(key, entry);
+        recoveredEntries++;
+    }
+}
+
+void IdempotencyTable::expireLocked(time_t now) {
+    time_t cutoff = now - static_cast<time_t>(windowSeconds);
+    while (!order.empty() && (order.front().first < cutoff || entries.size() > maxEntries)) {
+        auto it = entries.find(order.front().second);
+        if (it != entries.end() && it->second.added == order.front().first) {
+            if (it->second.pending) break; // Dang xu ly: giu lai den khi co ket qua
+            entries.erase(it);
+            expired++;
+        }
+        order.pop_front();
+    }
+}
+
+void IdempotencyTable::insertLocked(const Key& key, const Entry& entry) {
+    entries[key] = entry;
+    order.push_back(std::make_pair(entry.added, key));
+}
+
+IdempotencyTable::Claim IdempotencyTable::claim(IdHandle sender, const std::string& requestKey, IdHandle receiver,
+                                                double amount, Outcome& previous) {
+    std::unique_lock<std::mutex> lock(mutex);
+    time_t now = time(0);
+    expireLocked(now);
+
+    Key key = {sender, requestKey};
+    for (;;) {
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            Entry entry;
+            entry.added = now;
+            entry.receiver = receiver;
+            entry.amountCents = toCents(amount);
+            entry.pending = true;
+            entry.outcome.completed = false;
+            entry.outcome.timestamp = 0;
+            insertLocked(key, entry);
+            expireLocked(now);
+            return Claim::New;
+        }
+        if (it->second.receiver != receiver || it->second.amountCents != toCents(amount)) {
+            conflicts++;
+            return Claim::Conflict;
+        }
+        if (!it->second.pending) {
+            previous = it->second.outcome;
+            duplicates++;
+            return Claim::Duplicate;
+        }
+        // Lan gui lai den trong khi lan dau chua xong: cho ket qua cua lan dau
+        settled.wait(lock);
+    }
+}
+
+bool IdempotencyTable::find(IdHandle sender, const std::string& requestKey, Outcome& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(Key{sender, requestKey});
+    if (it == entries.end() || it->second.pending) return false;
+    out = it->second.outcome;
+    return true;
+}
+
+void IdempotencyTable::complete(IdHandle sender, const std::string& requestKey, const Outcome& outcome) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(Key{sender, requestKey});
+        if (it != entries.end()) {
+            it->second.pending = false;
+            it->second.outcome = outcome;
+        }
+    }
+    settled.notify_all();
+}
+
+IdempotencyTable::Stats IdempotencyTable::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats s;
+    s.entries = entries.size();
+    s.duplicates = duplicates;
+    s.conflicts = conflicts;
+    s.expired = expired;
+    s.recovered = recoveredEntries;
+    s.windowSeconds = windowSeconds;
+    return s;
+}
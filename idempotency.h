@@ -0,0 +1,110 @@
+// idempotency.h
+#ifndef IDEMPOTENCY_H
+#define IDEMPOTENCY_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "intern.h"
+
+// Bang chong trung lap cho transferPoints: client gui kem ma yeu cau (idempotency key),
+// lan gui lai cung ma (vi du sau timeout) nhan lai ket qua cu thay vi chuyen diem lan nua.
+// - Khoa la (vi gui, ma yeu cau): hai nguoi dung khac nhau co the dung cung mot ma
+// - Tra cuu O(1) (unordered_map); ban ghi cu hon cua so luu giu bi bo theo thu tu them vao,
+//   so ban ghi con bi chan boi maxEntries nen bo nho co gioi han
+// - Ma yeu cau duoc ghi trong transactions.log (truong requestKey); sau khi khoi dong lai,
+//   recover() dung lai bang tu cac giao dich trong cua so (goi khi khoi dong, truoc giao dich dau tien).
+//   Giao dich co ma duoc dam bao nam trong log: xem Wallet::saveTransfer (bien nhan cung nhom commit)
+class IdempotencyTable {
+public:
+    enum class Claim {
+        New,       // Chua co: nguoi goi thuc hien giao dich roi goi complete()
+        Duplicate, // Da xu ly: 'previous' la ket qua cu
+        Conflict   // Ma da dung cho mot yeu cau khac (nguoi nhan hoac so diem khac)
+    };
+
+    // Ket qua cua mot giao dich da ghi log
+    struct Outcome {
+        std::string transactionId;
+        bool completed;
+        time_t timestamp;
+    };
+
+    struct Stats {
+        std::size_t entries;
+        std::size_t duplicates;  // So lan tra lai ket qua cu
+        std::size_t conflicts;
+        std::size_t expired;     // So ban ghi bo do het cua so hoac vuot maxEntries
+        std::size_t recovered;   // So ban ghi dung lai tu log
+        unsigned int windowSeconds;
+    };
+
+    static IdempotencyTable& instance();
+
+    // Cua so luu giu (giay) va so ban ghi toi da
+    void configure(unsigned int windowSeconds, std::size_t maxEntries);
+
+    // Dung lai bang tu transactions.log (quet log ngoai khoa cua bang)
+    void recover();
+
+    // Ma hop le: 1..64 ky tu in duoc, khong chua '|' (ky tu phan cach cua log)
+    static bool isValidKey(const std::string& key);
+
+    // Giu cho ma truoc khi thuc hien giao dich. Neu mot lan goi khac dang xu ly cung ma,
+    // cho den khi lan do xong roi tra ve ket qua cua no.
+    Claim claim(IdHandle sender, const std::string& key, IdHandle receiver, double amount, Outcome& previous);
+    // Ket qua da co cua ma (khong giu cho). Tra ve false neu ma chua dung hoac dang xu ly.
+    bool find(IdHandle sender, const std::string& key, Outcome& out);
+    // Giao dich da ghi log voi ma nay
+    void complete(IdHandle sender, const std::string& key, const Outcome& outcome);
+
+    Stats stats() const;
+
+private:
+    IdempotencyTable();
+    IdempotencyTable(const IdempotencyTable&) = delete;
+    IdempotencyTable& operator=(const IdempotencyTable&) = delete;
+
+    struct Key {
+        IdHandle sender;
+        std::string requestKey;
+        bool operator==(const Key& other) const {
+            return sender == other.sender && requestKey == other.requestKey;
+        }
+    };
+
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const {
+            return std::hash<std::string>()(key.requestKey) ^ (static_cast<std::size_t>(key.sender) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+
+    struct Entry {
+        time_t added;       // Thoi diem them vao bang (khop voi phan tu tuong ung trong 'order')
+        IdHandle receiver;
+        long long amountCents;
+        bool pending;       // Dang duoc thuc hien (chua co ket qua)
+        Outcome outcome;
+    };
+
+    void expireLocked(time_t now);
+    void insertLocked(const Key& key, const Entry& entry);
+
+    mutable std::mutex mutex;
+    std::condition_variable settled;   // Bao mot ma dang xu ly da co ket qua
+    std::unordered_map<Key, Entry, KeyHash> entries;
+    std::deque<std::pair<time_t, Key> > order;   // Thu tu them vao (de bo ban ghi cu)
+    unsigned int windowSeconds;
+    std::size_t maxEntries;
+    std::size_t duplicates;
+    std::size_t conflicts;
+    std::size_t expired;
+    std::size_t recoveredEntries;
+};
+
+#endif // IDEMPOTENCY_H
@@ -0,0 +1,171 @@
+// intern.cpp
+#include "intern.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // FNV-1a 32 bit
+    std::uint32_t hashChars(const char* data, std::size_t length) {
+        std::uint32_t hash = 2166136261u;
+        for (std::size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+}
+
+IdInterner::Table::Table(std::size_t size) : mask(size - 1), slots(new std::atomic<IdHandle>[size]) {
+    for (std::size_t i = 0; i < size; ++i) {
+        slots[i].store(NONE, std::memory_order_relaxed);
+    }
+}
+
+IdInterner::IdInterner()
+    : chunks(new std::atomic<Entry*>[MAX_CHUNKS]), pageUsed(PAGE_BYTES), count(0), charBytes(0) {
+    for (std::size_t i = 0; i < MAX_CHUNKS; ++i) {
+        chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+    // Handle 0 danh cho chuoi rong
+    ownedChunks.push_back(std::unique_ptr<Entry[]>(new Entry[CHUNK_SIZE]));
+    ownedChunks[0][0] = Entry{"", 0, hashChars("", 0)};
+    chunks[0].store(ownedChunks[0].get(), std::memory_order_release);
+    count.store(1, std::memory_order_release);
+    tables.push_back(std::unique_ptr<Table>(new Table(1024)));
+    table.store(tables.back().get(), std::memory_order_release);
+}
+
+IdInterner& IdInterner::instance() {
+    static IdInterner interner;
+    return interner;
+}
+
+const IdInterner::Entry& IdInterner::entry(IdHandle handle) const {
+    if (handle >= count.load(std::memory_order_acquire)) {
+        throw std::out_of_range("IdInterner: handle khong hop le");
+    }
+    return chunks[handle >> CHUNK_BITS].load(std::memory_order_acquire)[handle & (CHUNK_SIZE - 1)];
+}
+
+IdHandle IdInterner::lookup(const char* data, std::size_t length, std::uint32_t hash) const {
+    const Table* current = table.load(std::memory_order_acquire);
+    for (std::size_t slot = hash & current->mask;; slot = (slot + 1) & current->mask) {
+        // acquire: entry cua handle da duoc ghi truoc khi handle vao o
+        IdHandle handle = current->slots[slot].load(std::memory_order_acquire);
+        if (handle == NONE) return NONE;
+        const Entry& e = entry(handle);
+        if (e.hash == hash && e.length == length && std::memcmp(e.chars, data, length) == 0) {
+            return handle;
+        }
+    }
+}
+
+const char* IdInterner::storeChars(const char* data, std::size_t length) {
+    if (length > PAGE_BYTES / 4) {
+        // ID dai bat thuong: cap rieng de khong lang phi trang
+        pages.push_back(std::unique_ptr<char[]>(new char[length]));
+        std::memcpy(pages.back().get(), data, length);
+        charBytes += length;
+        return pages.back().get();
+    }
+    if (pageUsed + length > PAGE_BYTES) {
+        pages.push_back(std::unique_ptr<char[]>(new char[PAGE_BYTES]));
+        pageUsed = 0;
+        charBytes += PAGE_BYTES;
+    }
+    char* target = pages.back().get() + pageUsed;
+    std::memcpy(target, data, length);
+    pageUsed += length;
+    return target;
+}
+
+void IdInterner::growTable() {
+    const Table* current = table.load(std::memory_order_relaxed);
+    std::unique_ptr<Table> bigger(new Table((current->mask + 1) * 2));
+    for (std::size_t i = 0; i <= current->mask; ++i) {
+        IdHandle handle = current->slots[i].load(std::memory_order_relaxed);
+        if (handle == NONE) continue;
+        std::size_t slot = entry(handle).hash & bigger->mask;
+        while (bigger->slots[slot].load(std::memory_order_relaxed) != NONE) slot = (slot + 1) & bigger->mask;
+        bigger->slots[slot].store(handle, std::memory_order_relaxed);
+    }
+    // Bang cu van con nguoi doc: chi cong bo bang moi, khong giai phong
+    table.store(bigger.get(), std::memory_order_release);
+    tables.push_back(std::move(bigger));
+}
+
+IdHandle IdInterner::intern(const std::string& id) {
+    return intern(id.data(), id.size());
+}
+
+IdHandle IdInterner::intern(const char* data, std::size_t length) {
+    if (length == 0) return NONE;
+    std::uint32_t hash = hashChars(data, length);
+    IdHandle existing = lookup(data, length, hash);
+    if (existing != NONE) return existing;
+    std::lock_guard<std::mutex> lock(mutex);
+    existing = lookup(data, length, hash); // Thread khac co the vua them
+    if (existing != NONE) return existing;
+
+    IdHandle handle = count.load(std::memory_order_relaxed);
+    std::size_t chunk = handle >> CHUNK_BITS;
+    if (chunk >= MAX_CHUNKS) {
+        throw std::length_error("IdInterner: qua nhieu ID");
+    }
+    if (chunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+        ownedChunks.push_back(std::unique_ptr<Entry[]>(new Entry[CHUNK_SIZE]));
+        chunks[chunk].store(ownedChunks.back().get(), std::memory_order_release);
+    }
+    chunks[chunk].load(std::memory_order_relaxed)[handle & (CHUNK_SIZE - 1)] =
+        Entry{storeChars(data, length), static_cast<std::uint32_t>(length), hash};
+    count.store(handle + 1, std::memory_order_release);
+
+    // Giu he so tai <= 1/2 de chuoi do ngan
+    if (static_cast<std::size_t>(handle) * 2 > table.load(std::memory_order_relaxed)->mask + 1) {
+        growTable();
+    }
+    const Table* current = table.load(std::memory_order_relaxed);
+    std::size_t slot = hash & current->mask;
+    while (current->slots[slot].load(std::memory_order_relaxed) != NONE) slot = (slot + 1) & current->mask;
+    current->slots[slot].store(handle, std::memory_order_release);
+    return handle;
+}
+
+IdHandle IdInterner::find(const std::string& id) const {
+    if (id.empty()) return NONE;
+    return lookup(id.data(), id.size(), hashChars(id.data(), id.size()));
+}
+
+std::string IdInterner::str(IdHandle handle) const {
+    const Entry& e = entry(handle);
+    return std::string(e.chars, e.length);
+}
+
+void IdInterner::appendTo(IdHandle handle, std::string& out) const {
+    const Entry& e = entry(handle);
+    out.append(e.chars, e.length);
+}
+
+bool IdInterner::equals(IdHandle handle, const std::string& id) const {
+    const Entry& e = entry(handle);
+    return e.length == id.size() && std::memcmp(e.chars, id.data(), id.size()) == 0;
+}
+
+std::size_t IdInterner::size() const {
+    return count.load(std::memory_order_acquire) - 1;
+}
+
+std::size_t IdInterner::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t tableBytes = 0;
+    for (const std::unique_ptr<Table>& t : tables) tableBytes += (t->mask + 1) * sizeof(IdHandle);
+    return charBytes + ownedChunks.size() * CHUNK_SIZE * sizeof(Entry) + tableBytes;
+}
+
+IdHandle internId(const std::string& id) {
+    return IdInterner::instance().intern(id);
+}
+
+std::string idToString(IdHandle handle) {
+    return IdInterner::instance().str(handle);
+}
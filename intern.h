@@ -0,0 +1,91 @@
+// intern.h
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Handle 32 bit cho mot ID (wallet ID, user ID) da duoc intern
+typedef std::uint32_t IdHandle;
+
+// Bang intern dung chung: moi ID dang chuoi (36 ky tu) chi duoc luu mot lan,
+// chi muc, ban ghi giao dich va cache chi giu handle 32 bit. So sanh hai ID la so sanh so nguyen;
+// chuoi chi duoc tao lai o bien I/O (ghi file, in ra man hinh).
+// - Handle duoc cap lien tuc tu 1 (0 = chuoi rong) va khong bao gio bi thu hoi
+// - Doc chuoi tu handle khong can khoa (du lieu da cap khong bao gio bi di chuyen)
+// - Tra cuu (find, intern cua ID da co) khong can khoa: bang bam la mang nguyen tu, handle duoc ghi
+//   vao o (release) sau khi entry da cong bo; bang cu sau khi mo rong duoc giu lai cho nguoi doc dang
+//   duyet no (tong cac bang cu nho hon bang hien tai). Chi them ID moi moi lay mutex.
+class IdInterner {
+public:
+    static const IdHandle NONE = 0;
+
+    static IdInterner& instance();
+
+    // Tra ve handle cua 'id', them moi neu chua co
+    IdHandle intern(const std::string& id);
+    IdHandle intern(const char* data, std::size_t length);
+
+    // Handle cua 'id' neu da tung intern, NONE neu chua (khong them moi)
+    IdHandle find(const std::string& id) const;
+
+    // Chuoi cua handle (tao ban sao; dung o bien I/O)
+    std::string str(IdHandle handle) const;
+    // Them chuoi cua handle vao cuoi 'out' (khong tao chuoi tam)
+    void appendTo(IdHandle handle, std::string& out) const;
+    bool equals(IdHandle handle, const std::string& id) const;
+
+    std::size_t size() const;         // So ID da intern
+    std::size_t memoryUsage() const;  // Byte da cap (ky tu + bang tra cuu)
+
+private:
+    struct Entry {
+        const char* chars;
+        std::uint32_t length;
+        std::uint32_t hash;
+    };
+
+    static const std::size_t CHUNK_BITS = 14;                    // 16384 entry moi chunk
+    static const std::size_t CHUNK_SIZE = std::size_t(1) << CHUNK_BITS;
+    static const std::size_t MAX_CHUNKS = std::size_t(1) << 14;  // Toi da ~268 trieu ID
+    static const std::size_t PAGE_BYTES = 1 << 16;
+
+    IdInterner();
+    IdInterner(const IdInterner&) = delete;
+    IdInterner& operator=(const IdInterner&) = delete;
+
+    // Bang bam dia chi mo (NONE = o trong), khong bao gio cap phat lai sau khi cong bo
+    struct Table {
+        std::size_t mask;
+        std::unique_ptr<std::atomic<IdHandle>[]> slots;
+
+        explicit Table(std::size_t size);
+    };
+
+    const Entry& entry(IdHandle handle) const;
+    // Duyet bang dang cong bo, khong khoa. NONE neu chua co (hoac vua duoc them vao bang moi hon)
+    IdHandle lookup(const char* data, std::size_t length, std::uint32_t hash) const;
+    const char* storeChars(const char* data, std::size_t length);
+    void growTable();
+
+    mutable std::mutex mutex;
+    std::unique_ptr<std::atomic<Entry*>[]> chunks;   // Khong bao gio cap phat lai
+    std::vector<std::unique_ptr<Entry[]> > ownedChunks;
+    std::vector<std::unique_ptr<char[]> > pages;     // Vung luu ky tu
+    std::size_t pageUsed;
+    std::atomic<const Table*> table;                 // Bang dang dung (doc khong khoa)
+    std::vector<std::unique_ptr<Table> > tables;     // Moi bang da cap, ke ca bang cu (duoi mutex)
+    std::atomic<std::uint32_t> count;                // So handle da cap (ke ca NONE)
+    std::size_t charBytes;
+};
+
+// Viet tat cho IdInterner::instance().intern / str
+IdHandle internId(const std::string& id);
+std::string idToString(IdHandle handle);
+
+#endif // INTERN_H
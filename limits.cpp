@@ -0,0 +1,411 @@
+// limits.cpp
+#include "limits.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include "scheduler.h"
+#include "utils.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace {
+    const char* const LIMITS_CONFIG_FILE = "data/limits.conf";
+    const char* const LIMITS_STATE_FILE = "data/limits.state";
+
+    const unsigned int FIELD_PER_TRANSFER = 1u << 0;
+    const unsigned int FIELD_PER_DAY = 1u << 1;
+    const unsigned int FIELD_PER_MINUTE = 1u << 2;
+
+    std::uint32_t nowSeconds() {
+        return static_cast<std::uint32_t>(std::time(nullptr));
+    }
+
+    // So lan chuyen trong 60 giay va so diem trong 24 gio gan nhat cua mot lop dem
+    template <typename Counts>
+    unsigned int minuteCount(const Counts& counts, std::uint32_t now, std::size_t slots) {
+        unsigned int count = 0;
+        for (std::size_t i = 0; i < slots; ++i) {
+            if (now - counts.secondOf[i] < slots) count += counts.countOf[i];
+        }
+        return count;
+    }
+
+    template <typename Counts>
+    long long dayCents(const Counts& counts, std::uint32_t hour, std::size_t slots) {
+        long long total = 0;
+        for (std::size_t i = 0; i < slots; ++i) {
+            if (hour - counts.hourOf[i] < slots) total += counts.centsOf[i];
+        }
+        return total;
+    }
+
+    // "maxPerTransfer" / "maxPerDay" (diem) / "perMinute" (so lan) -> truong trong Limits
+    bool applyField(const std::string& field, const std::string& value, TransferLimits::Limits& limits,
+                    unsigned int& fields) {
+        char* end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        if (end == value.c_str() || number < 0) return false;
+        if (field == "maxPerTransfer") {
+            limits.maxPerTransferCents = std::llround(number * 100.0);
+            fields |= FIELD_PER_TRANSFER;
+        } else if (field == "maxPerDay") {
+            limits.maxPerDayCents = std::llround(number * 100.0);
+            fields |= FIELD_PER_DAY;
+        } else if (field == "perMinute") {
+            limits.maxPerMinute = static_cast<unsigned int>(number);
+            fields |= FIELD_PER_MINUTE;
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
+
+TransferLimits::TransferLimits()
+    : ruleCount(0), dirty(false), saving(false), lastSave(0), othersSeen(false), checked(0), rejected(0) {
+    for (Limits& limits : roleLimits) limits = Limits{0, 0, 0};
+}
+
+TransferLimits& TransferLimits::instance() {
+    static TransferLimits limits;
+    return limits;
+}
+
+void TransferLimits::load() {
+    loadConfig();
+    origin = Utils::generateUniqueId();
+    {
+        LockManager::Guard stateLock(LockManager::resource(LockManager::Resource::LimitsState));
+        loadState();
+    }
+    lastSave = nowSeconds();
+}
+
+void TransferLimits::loadConfig() {
+    std::vector<std::string> lines;
+    if (!FileIO::readLines(LIMITS_CONFIG_FILE, lines)) return; // Khong co file: khong gioi han
+    for (const std::string& raw : lines) {
+        std::string line = Utils::trimString(raw);
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t colon = line.find(':');
+        std::size_t dot = colon == std::string::npos ? std::string::npos : line.rfind('.', colon);
+        std::size_t scopeEnd = line.find('.');
+        if (dot == std::string::npos || scopeEnd == dot) {
+            std::cerr << "Canh bao: Bo qua dong khong hop le trong " << LIMITS_CONFIG_FILE << ": " << line << std::endl;
+            continue;
+        }
+        std::string scope = line.substr(0, scopeEnd);
+        std::string name = line.substr(scopeEnd + 1, dot - scopeEnd - 1);
+        std::string field = line.substr(dot + 1, colon - dot - 1);
+        std::string value = Utils::trimString(line.substr(colon + 1));
+
+        bool applied = false;
+        unsigned int fields = 0;
+        if (scope == "role") {
+            Access::Role role;
+            applied = Access::parseRole(name, role) &&
+                      applyField(field, value, roleLimits[static_cast<unsigned>(role)], fields);
+        } else if (scope == "user") {
+            Override& entry = userOverrides[name];
+            applied = applyField(field, value, entry.limits, entry.fields);
+        }
+        if (applied) {
+            ruleCount++;
+        } else {
+            std::cerr << "Canh bao: Bo qua dong khong hop le trong " << LIMITS_CONFIG_FILE << ": " << line << std::endl;
+        }
+    }
+}
+
+TransferLimits::Limits TransferLimits::limitsFor(const std::string& username, Access::Role role) const {
+    Limits limits = roleLimits[static_cast<unsigned>(role)];
+    auto it = userOverrides.find(username);
+    if (it != userOverrides.end()) {
+        const Override& entry = it->second;
+        if (entry.fields & FIELD_PER_TRANSFER) limits.maxPerTransferCents = entry.limits.maxPerTransferCents;
+        if (entry.fields & FIELD_PER_DAY) limits.maxPerDayCents = entry.limits.maxPerDayCents;
+        if (entry.fields & FIELD_PER_MINUTE) limits.maxPerMinute = entry.limits.maxPerMinute;
+    }
+    return limits;
+}
+
+TransferLimits::Verdict TransferLimits::evaluate(const Window* window, const Limits& limits, long long cents,
+                                                 std::uint32_t now) {
+    if (limits.maxPerTransferCents > 0 && cents > limits.maxPerTransferCents) return Verdict::OverTransferLimit;
+    if (!window) {
+        return limits.maxPerDayCents > 0 && cents > limits.maxPerDayCents ? Verdict::OverDailyLimit : Verdict::Allowed;
+    }
+    if (limits.maxPerMinute > 0) {
+        unsigned int count = minuteCount(window->own, now, MINUTE_SLOTS) + minuteCount(window->others, now, MINUTE_SLOTS);
+        if (count >= limits.maxPerMinute) return Verdict::TooFrequent;
+    }
+    if (limits.maxPerDayCents > 0) {
+        std::uint32_t hour = now / 3600;
+        long long total = cents + dayCents(window->own, hour, DAY_SLOTS) + dayCents(window->others, hour, DAY_SLOTS);
+        if (total > limits.maxPerDayCents) return Verdict::OverDailyLimit;
+    }
+    return Verdict::Allowed;
+}
+
+bool TransferLimits::sharedDataDir() {
+    return LockManager::instance().heldByOtherProcess(LockManager::resource(LockManager::Resource::Instances));
+}
+
+TransferLimits::Verdict TransferLimits::check(IdHandle wallet, const Limits& limits, long long cents) {
+    if (limits.unlimited()) return Verdict::Allowed;
+    if (sharedDataDir()) {
+        // Lay cac lan chuyen tien trinh khac vua ghi nhan
+        othersSeen = true;
+        LockManager::Guard stateLock(LockManager::resource(LockManager::Resource::LimitsState));
+        loadState();
+    }
+    std::uint32_t now = nowSeconds();
+    const Stripe& stripe = stripeOf(wallet);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.windows.find(wallet);
+    return evaluate(it == stripe.windows.end() ? nullptr : &it->second, limits, cents, now);
+}
+
+TransferLimits::Verdict TransferLimits::consume(IdHandle wallet, const Limits& limits, long long cents, Usage& usage) {
+    usage.recorded = false;
+    if (limits.unlimited()) return Verdict::Allowed; // Khong can dem cho vi khong bi gioi han
+    checked++;
+    std::uint32_t now = nowSeconds();
+    if (sharedDataDir()) {
+        // Doc-gop-ghi trong mot lan khoa file: tien trinh khac khong the cung lot qua han muc giua luc
+        // minh doc va luc minh ghi lai
+        othersSeen = true;
+        LockManager::Guard stateLock(LockManager::resource(LockManager::Resource::LimitsState));
+        loadState();
+        Verdict verdict = record(wallet, limits, cents, now, usage);
+        if (verdict == Verdict::Allowed) writeStateLocked();
+        return verdict;
+    }
+    if (othersSeen.exchange(false)) {
+        // Tien trinh khac vua thoat: lay cac lan chuyen no da ghi nhan (ban luu khi thoat)
+        LockManager::Guard stateLock(LockManager::resource(LockManager::Resource::LimitsState));
+        loadState();
+    }
+    Verdict verdict = record(wallet, limits, cents, now, usage);
+    if (verdict == Verdict::Allowed) {
+        dirty = true;
+        maybeScheduleSave(now);
+    }
+    return verdict;
+}
+
+TransferLimits::Verdict TransferLimits::record(IdHandle wallet, const Limits& limits, long long cents,
+                                               std::uint32_t now, Usage& usage) {
+    {
+        Stripe& stripe = stripeOf(wallet);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        auto it = stripe.windows.find(wallet);
+        Verdict verdict = evaluate(it == stripe.windows.end() ? nullptr : &it->second, limits, cents, now);
+        if (verdict != Verdict::Allowed) {
+            rejected++;
+            return verdict;
+        }
+        if (it == stripe.windows.end()) it = stripe.windows.emplace(wallet, Window()).first; // Window() = toan 0
+
+        Counts& own = it->second.own;
+        std::size_t slot = now % MINUTE_SLOTS;
+        if (own.secondOf[slot] != now) {
+            own.secondOf[slot] = now;
+            own.countOf[slot] = 0;
+        }
+        own.countOf[slot]++;
+        std::uint32_t hour = now / 3600;
+        slot = hour % DAY_SLOTS;
+        if (own.hourOf[slot] != hour) {
+            own.hourOf[slot] = hour;
+            own.centsOf[slot] = 0;
+        }
+        own.centsOf[slot] += cents;
+    }
+    usage.wallet = wallet;
+    usage.second = now;
+    usage.cents = cents;
+    usage.recorded = true;
+    return Verdict::Allowed;
+}
+
+void TransferLimits::refund(const Usage& usage) {
+    if (!usage.recorded) return;
+    if (sharedDataDir()) {
+        // Tien trinh khac dang tinh ca lan ghi nhan nay: ghi lai ngay
+        LockManager::Guard stateLock(LockManager::resource(LockManager::Resource::LimitsState));
+        loadState();
+        unrecord(usage);
+        writeStateLocked();
+        return;
+    }
+    unrecord(usage);
+    dirty = true;
+}
+
+void TransferLimits::unrecord(const Usage& usage) {
+    Stripe& stripe = stripeOf(usage.wallet);
+    std::lock_guard<std::mutex> lock(stripe.mutex);
+    auto it = stripe.windows.find(usage.wallet);
+    if (it == stripe.windows.end()) return;
+    // O da bi dung lai cho giay/gio khac thi lan ghi nhan cu da het han, khong con gi de hoan
+    Counts& own = it->second.own;
+    std::size_t slot = usage.second % MINUTE_SLOTS;
+    if (own.secondOf[slot] == usage.second && own.countOf[slot] > 0) own.countOf[slot]--;
+    std::uint32_t hour = usage.second / 3600;
+    slot = hour % DAY_SLOTS;
+    if (own.hourOf[slot] == hour) {
+        own.centsOf[slot] = own.centsOf[slot] > usage.cents ? own.centsOf[slot] - usage.cents : 0;
+    }
+}
+
+const char* TransferLimits::describe(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::OverTransferLimit: return "Vuot han muc diem cho mot lan chuyen.";
+        case Verdict::OverDailyLimit: return "Vuot han muc tong diem chuyen trong 24 gio.";
+        case Verdict::TooFrequent: return "Chuyen diem qua nhieu lan trong mot phut, vui long thu lai sau.";
+        default: return "";
+    }
+}
+
+void TransferLimits::maybeScheduleSave(std::uint32_t now) {
+    if (now - lastSave.load(std::memory_order_relaxed) < SAVE_INTERVAL_SECONDS) return;
+    if (saving.exchange(true)) return; // Da co lan luu dang cho
+    lastSave = now;
+    TaskScheduler::instance().submit([this]() {
+        save();
+        saving = false;
+    });
+}
+
+bool TransferLimits::save() {
+    if (!dirty.load()) return true;
+    // Tien trinh khac co the da luu tu lan truoc: doc lai dong cua ho roi moi ghi de (trong khoa file)
+    LockManager::Guard stateLock(LockManager::resource(LockManager::Resource::LimitsState));
+    loadState();
+    return writeStateLocked();
+}
+
+// Moi dong mot o con hieu luc: "m|walletId|giay|so lan|ma tien trinh" hoac "d|walletId|gio|so diem x100|ma".
+// Vi khong con o nao hieu luc bi bo khoi bo nho luon.
+bool TransferLimits::writeStateLocked() {
+    dirty = false;
+    std::uint32_t now = nowSeconds();
+    std::uint32_t hour = now / 3600;
+    std::string content;
+    for (const std::string& line : foreignLines) {
+        content += line;
+        content += "\n";
+    }
+    for (Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (auto it = stripe.windows.begin(); it != stripe.windows.end();) {
+            const Counts& own = it->second.own;
+            std::string walletId = idToString(it->first);
+            bool live = minuteCount(it->second.others, now, MINUTE_SLOTS) > 0 ||
+                        dayCents(it->second.others, hour, DAY_SLOTS) > 0;
+            for (std::size_t i = 0; i < MINUTE_SLOTS; ++i) {
+                if (now - own.secondOf[i] < MINUTE_SLOTS && own.countOf[i] > 0) {
+                    content += "m|" + walletId + "|" + std::to_string(own.secondOf[i]) + "|" +
+                               std::to_string(own.countOf[i]) + "|" + origin + "\n";
+                    live = true;
+                }
+            }
+            for (std::size_t i = 0; i < DAY_SLOTS; ++i) {
+                if (hour - own.hourOf[i] < DAY_SLOTS && own.centsOf[i] > 0) {
+                    content += "d|" + walletId + "|" + std::to_string(own.hourOf[i]) + "|" +
+                               std::to_string(own.centsOf[i]) + "|" + origin + "\n";
+                    live = true;
+                }
+            }
+            it = live ? std::next(it) : stripe.windows.erase(it);
+        }
+    }
+    if (!FileIO::replaceFile(LIMITS_STATE_FILE, content)) {
+        dirty = true; // Thu lai o lan luu sau
+        std::cerr << "Loi: Khong luu duoc trang thai han muc chuyen diem vao " << LIMITS_STATE_FILE << "." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void TransferLimits::loadState() {
+    std::vector<std::string> lines;
+    FileIO::readLines(LIMITS_STATE_FILE, lines); // Khong co file: khong tien trinh nao khac ghi nhan
+    std::uint32_t now = nowSeconds();
+    std::uint32_t hour = now / 3600;
+    std::unordered_map<IdHandle, Counts> fresh;
+    foreignLines.clear();
+    for (const std::string& line : lines) {
+        std::size_t first = line.find('|');
+        std::size_t second = first == std::string::npos ? first : line.find('|', first + 1);
+        std::size_t third = second == std::string::npos ? second : line.find('|', second + 1);
+        if (first != 1 || third == std::string::npos) continue;
+        std::size_t fourth = line.find('|', third + 1);
+        // Dong khong co ma (ban luu cu) coi nhu cua tien trinh khac
+        if (fourth != std::string::npos && line.compare(fourth + 1, std::string::npos, origin) == 0) continue;
+        std::uint32_t at = static_cast<std::uint32_t>(std::strtoul(line.c_str() + second + 1, nullptr, 10));
+        long long value = std::strtoll(line.c_str() + third + 1, nullptr, 10);
+        if (value <= 0) continue;
+        bool minute = line[0] == 'm';
+        if (minute ? now - at >= MINUTE_SLOTS : (line[0] != 'd' || hour - at >= DAY_SLOTS)) continue; // Da het han
+        foreignLines.push_back(line);
+
+        // Cac tien trinh dem rieng nen cung mot o thi cong lai
+        Counts& counts = fresh.emplace(internId(line.substr(first + 1, second - first - 1)), Counts()).first->second;
+        if (minute) {
+            std::size_t slot = at % MINUTE_SLOTS;
+            if (counts.secondOf[slot] > at) continue; // O da dem giay moi hon
+            if (counts.secondOf[slot] < at) counts.countOf[slot] = 0;
+            counts.secondOf[slot] = at;
+            counts.countOf[slot] += static_cast<std::uint32_t>(value);
+        } else {
+            std::size_t slot = at % DAY_SLOTS;
+            if (counts.hourOf[slot] > at) continue;
+            if (counts.hourOf[slot] < at) counts.centsOf[slot] = 0;
+            counts.hourOf[slot] = at;
+            counts.centsOf[slot] += value;
+        }
+    }
+
+    // Thay 'others' cua tung vi trong mot lan khoa stripe: kiem tra dong thoi khong thay trang thai nua voi
+    for (Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        for (auto& entry : stripe.windows) {
+            auto it = fresh.find(entry.first);
+            if (it == fresh.end()) {
+                entry.second.others = Counts();
+            } else {
+                entry.second.others = it->second;
+                fresh.erase(it);
+            }
+        }
+    }
+    for (const auto& entry : fresh) {
+        Stripe& stripe = stripeOf(entry.first);
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        stripe.windows[entry.first].others = entry.second;
+    }
+}
+
+void TransferLimits::shutdown() {
+    while (saving.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    save();
+}
+
+TransferLimits::Stats TransferLimits::stats() const {
+    Stats s;
+    s.rules = ruleCount;
+    s.trackedWallets = 0;
+    for (const Stripe& stripe : stripes) {
+        std::lock_guard<std::mutex> lock(stripe.mutex);
+        s.trackedWallets += stripe.windows.size();
+    }
+    s.checked = checked;
+    s.rejected = rejected;
+    return s;
+}
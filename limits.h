@@ -0,0 +1,152 @@
+// limits.h
+#ifndef LIMITS_H
+#define LIMITS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "access.h"
+#include "intern.h"
+
+// Han muc chuyen diem theo vai tro va theo nguoi dung:
+// - So diem toi da mot lan chuyen, tong so diem chuyen trong 24 gio, so lan chuyen trong mot phut.
+// - Cau hinh o data/limits.conf, moi dong "role.<vai tro>.<truong>:<gia tri>" (mac dinh cua vai tro)
+//   hoac "user.<username>.<truong>:<gia tri>" (ghi de tung truong cho mot nguoi dung); truong la
+//   maxPerTransfer, maxPerDay (diem) hoac perMinute (so lan). Khong co dong nao / gia tri 0: khong gioi han.
+// - Moi vi co hai vong xoay trong bo nho: 60 o mot giay (so lan) va 24 o mot gio (so diem). Moi o
+//   ghi kem giay/gio ma no dang dem nen o cu tu het han, khong can thread don dep. "Trong ngay" la
+//   24 o gio gan nhat (cua so truot do min mot gio), "trong mot phut" la 60 o giay gan nhat.
+// - Kiem tra va ghi nhan nam trong mot lan khoa stripe cua vi (khong I/O khi chi mot tien trinh), cong mot lan hoi kernel
+//   xem co tien trinh khac tren data/ khong (F_GETLK tren o Instances): vai micro giay.
+// - Cac o con hieu luc duoc luu vao data/limits.state dinh ky (nen, qua TaskScheduler) va khi thoat,
+//   nap lai khi khoi dong. Moi dong mang ma cua tien trinh da ghi nhan (moi lan chay mot ma): o cua
+//   tien trinh nay nam trong 'own', tong cac tien trinh khac (ke ca lan chay truoc) nam trong 'others'.
+// - Khi tien trinh khac cung giu Instances, moi lan kiem tra/ghi nhan chiu han muc doc-gop-ghi
+//   limits.state trong khoa LimitsState (doc o cua moi tien trinh khac, cong vao, ghi lai kem o cua minh),
+//   nen ca he thong chung mot han muc. Khi chi con mot tien trinh, lan ghi nhan dau tien doc lai ban luu
+//   cuoi cua tien trinh vua thoat.
+class TransferLimits {
+public:
+    // 0: khong gioi han
+    struct Limits {
+        long long maxPerTransferCents;
+        long long maxPerDayCents;
+        unsigned int maxPerMinute;
+
+        bool unlimited() const { return maxPerTransferCents == 0 && maxPerDayCents == 0 && maxPerMinute == 0; }
+    };
+
+    enum class Verdict { Allowed, OverTransferLimit, OverDailyLimit, TooFrequent };
+
+    // Mot lan ghi nhan cua consume(); dua cho refund() neu giao dich khong thanh cong
+    struct Usage {
+        IdHandle wallet;
+        std::uint32_t second;
+        long long cents;
+        bool recorded;
+    };
+
+    struct Stats {
+        std::size_t rules;              // So dong hop le trong limits.conf
+        std::size_t trackedWallets;
+        unsigned long long checked;
+        unsigned long long rejected;
+    };
+
+    static const std::size_t STRIPES = 64;
+    static const std::size_t MINUTE_SLOTS = 60;     // O 1 giay
+    static const std::size_t DAY_SLOTS = 24;        // O 1 gio
+    static const std::uint32_t SAVE_INTERVAL_SECONDS = 30;
+
+    static TransferLimits& instance();
+
+    // Doc data/limits.conf va data/limits.state (goi mot lan khi khoi dong)
+    void load();
+
+    // Han muc ap dung cho nguoi dung: truong duoc ghi de rieng, con lai theo vai tro
+    Limits limitsFor(const std::string& username, Access::Role role) const;
+
+    // Kiem tra 'cents' tren vi ma khong ghi nhan (bao loi som truoc khi giu diem / gui OTP)
+    Verdict check(IdHandle wallet, const Limits& limits, long long cents);
+    // Kiem tra va ghi nhan trong cung mot lan khoa: hai giao dich dong thoi khong the cung lot qua han muc
+    Verdict consume(IdHandle wallet, const Limits& limits, long long cents, Usage& usage);
+    // Hoan lai mot lan ghi nhan (giao dich that bai sau consume())
+    void refund(const Usage& usage);
+
+    // Thong bao cho nguoi dung (va mo ta giao dich bi tu choi)
+    static const char* describe(Verdict verdict);
+
+    // Cho lan luu nen (neu dang chay) roi luu trang thai lan cuoi (khi thoat chuong trinh)
+    void shutdown();
+
+    Stats stats() const;
+
+private:
+    struct Counts {
+        std::uint32_t secondOf[MINUTE_SLOTS];   // Giay (epoch) ma o dang dem, 0: trong
+        std::uint32_t countOf[MINUTE_SLOTS];
+        std::uint32_t hourOf[DAY_SLOTS];        // Gio (epoch / 3600) ma o dang dem
+        long long centsOf[DAY_SLOTS];
+    };
+
+    struct Window {
+        Counts own;      // Ghi nhan cua tien trinh nay (chi no ghi cac dong mang 'origin' cua minh)
+        Counts others;   // Tong cac tien trinh khac theo limits.state lan doc gan nhat
+    };
+
+    struct Stripe {
+        mutable std::mutex mutex;
+        std::unordered_map<IdHandle, Window> windows;
+    };
+
+    // Ghi de tung truong cua mot nguoi dung (bit 0: maxPerTransfer, 1: maxPerDay, 2: perMinute)
+    struct Override {
+        Limits limits;
+        unsigned int fields;
+    };
+
+    TransferLimits();
+    TransferLimits(const TransferLimits&) = delete;
+    TransferLimits& operator=(const TransferLimits&) = delete;
+
+    Stripe& stripeOf(IdHandle wallet) { return stripes[wallet % STRIPES]; }
+    const Stripe& stripeOf(IdHandle wallet) const { return stripes[wallet % STRIPES]; }
+    static Verdict evaluate(const Window* window, const Limits& limits, long long cents, std::uint32_t now);
+    // Kiem tra va ghi nhan vao 'own' (trong khoa stripe)
+    Verdict record(IdHandle wallet, const Limits& limits, long long cents, std::uint32_t now, Usage& usage);
+    void unrecord(const Usage& usage);
+
+    void loadConfig();
+    // Doc data/limits.state (giu khoa LimitsState): dong cua tien trinh khac duoc cong vao 'others' (thay
+    // gia tri cu) va giu nguyen van trong 'foreignLines'; dong mang 'origin' cua minh bo qua (bo nho dung hon)
+    void loadState();
+    // Ghi 'foreignLines' cung cac o 'own' con hieu luc (giu khoa LimitsState, ngay sau loadState())
+    bool writeStateLocked();
+    // Tien trinh khac dang giu Instances (bo dem trong bo nho khong con la cua toan he thong)
+    static bool sharedDataDir();
+    bool save();
+    // Luu nen neu da qua SAVE_INTERVAL_SECONDS tu lan luu truoc (goi sau khi ghi nhan)
+    void maybeScheduleSave(std::uint32_t now);
+
+    Limits roleLimits[static_cast<unsigned>(Access::Role::COUNT)];
+    std::unordered_map<std::string, Override> userOverrides;
+    std::size_t ruleCount;
+
+    Stripe stripes[STRIPES];
+    std::atomic<bool> dirty;
+    std::atomic<bool> saving;
+    std::atomic<std::uint32_t> lastSave;
+    std::atomic<bool> othersSeen;           // Da thay tien trinh khac tu lan gop trang thai truoc
+    std::string origin;                     // Ma cua lan chay nay trong limits.state
+    std::vector<std::string> foreignLines;  // Dong cua tien trinh khac (giu khoa LimitsState)
+
+    mutable std::atomic<unsigned long long> checked;
+    mutable std::atomic<unsigned long long> rejected;
+};
+
+#endif // LIMITS_H
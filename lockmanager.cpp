@@ -0,0 +1,216 @@
+// lockmanager.cpp
+#include "lockmanager.h"
+#include "utils.h"
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <thread>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const char* const LOCK_FILE = "data/locks";
+    const std::size_t TOTAL_SLOTS = LockManager::ENTITY_SLOTS + LockManager::RESOURCE_COUNT;
+}
+
+LockManager::LockManager()
+    : fd(-1), states(new SlotState[TOTAL_SLOTS]), acquiredCount(0), waitedInProcessCount(0), waitedOnFileCount(0) {
+#ifndef _WIN32
+    // Mo mot lan va giu suot doi tien trinh: voi khoa POSIX, dong bat ky fd nao cua file se nha het khoa
+    Utils::createDirectoryIfNotExists("data");
+    fd = ::open(LOCK_FILE, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        std::cerr << "Canh bao: Khong mo duoc " << LOCK_FILE << " (" << std::strerror(errno)
+                  << "), chi khoa giua cac thread trong tien trinh nay." << std::endl;
+    }
+#endif
+}
+
+LockManager& LockManager::instance() {
+    static LockManager manager;
+    return manager;
+}
+
+LockManager::Slot LockManager::entity(char kind, const std::string& id) {
+    std::size_t hash = std::hash<std::string>()(id);
+    return (hash ^ (static_cast<std::size_t>(static_cast<unsigned char>(kind)) * 0x9E3779B9u)) % ENTITY_SLOTS;
+}
+
+LockManager::Slot LockManager::resource(Resource which) {
+    return ENTITY_SLOTS + static_cast<Slot>(which);
+}
+
+bool LockManager::lockRange(Slot slot, Mode mode, bool wait) {
+#ifdef _WIN32
+    (void)slot;
+    (void)mode;
+    (void)wait;
+    return true;
+#else
+    if (fd < 0) return true;
+    struct flock range;
+    std::memset(&range, 0, sizeof(range));
+    range.l_type = mode == Mode::Exclusive ? F_WRLCK : F_RDLCK;
+    range.l_whence = SEEK_SET;
+    range.l_start = static_cast<off_t>(slot);
+    range.l_len = 1;
+#ifdef F_OFD_SETLKW
+    // Khoa OFD (Linux): kernel khong bao nham tac nghen khi nhieu thread cung tien trinh cho khoa
+    const int tryCommand = F_OFD_SETLK, waitCommand = F_OFD_SETLKW;
+#else
+    const int tryCommand = F_SETLK, waitCommand = F_SETLKW;
+#endif
+    // Thu khong cho truoc de dem so lan phai cho tien trinh khac
+    if (::fcntl(fd, tryCommand, &range) == 0) return true;
+    if (errno != EAGAIN && errno != EACCES && errno != EINTR) {
+        std::cerr << "Canh bao: Khong khoa duoc " << LOCK_FILE << ": " << std::strerror(errno) << std::endl;
+        return true; // Van chay (nhu khi khong co file khoa) thay vi chan giao dich
+    }
+    if (!wait) return false;
+    waitedOnFileCount++;
+    while (::fcntl(fd, waitCommand, &range) != 0) {
+        if (errno == EDEADLK) {
+            // Khoa POSIX tinh theo tien trinh: kernel co the bao tac nghen gia khi thread khac cua tien trinh
+            // nay dang giu o kia; thu tu khoa tang dan dam bao o do se duoc nha
+            std::this_thread::yield();
+        } else if (errno != EINTR) {
+            std::cerr << "Canh bao: Khong khoa duoc " << LOCK_FILE << ": " << std::strerror(errno) << std::endl;
+            break;
+        }
+    }
+    return true;
+#endif
+}
+
+void LockManager::unlockRange(Slot slot) {
+#ifdef _WIN32
+    (void)slot;
+#else
+    if (fd < 0) return;
+    struct flock range;
+    std::memset(&range, 0, sizeof(range));
+    range.l_type = F_UNLCK;
+    range.l_whence = SEEK_SET;
+    range.l_start = static_cast<off_t>(slot);
+    range.l_len = 1;
+#ifdef F_OFD_SETLK
+    ::fcntl(fd, F_OFD_SETLK, &range);
+#else
+    ::fcntl(fd, F_SETLK, &range);
+#endif
+#endif
+}
+
+bool LockManager::acquire(Slot slot, Mode mode, bool wait) {
+    SlotState& state = states[slot];
+    std::unique_lock<std::mutex> lock(state.mutex);
+    bool busy = mode == Mode::Exclusive ? (state.writer || state.readers > 0) : state.writer;
+    if (busy) {
+        if (!wait) return false;
+        waitedInProcessCount++;
+        if (mode == Mode::Exclusive) {
+            state.released.wait(lock, [&state] { return !state.writer && state.readers == 0; });
+        } else {
+            state.released.wait(lock, [&state] { return !state.writer; });
+        }
+    }
+    // Chi thread dau tien khoa byte trong file. Van giu mutex cua o trong luc cho tien trinh khac:
+    // cac thread khac muon o nay cung phai cho, con thread dang giu o khac khong can mutex nay.
+    if (mode == Mode::Exclusive || state.readers == 0) {
+        if (!lockRange(slot, mode, wait)) return false;
+    }
+    if (mode == Mode::Exclusive) {
+        state.writer = true;
+    } else {
+        state.readers++;
+    }
+    acquiredCount++;
+    return true;
+}
+
+void LockManager::release(Slot slot) {
+    SlotState& state = states[slot];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.writer) {
+        state.writer = false;
+        unlockRange(slot);
+    } else if (state.readers > 0 && --state.readers == 0) {
+        unlockRange(slot);
+    }
+    state.released.notify_all();
+}
+
+void LockManager::downgrade(Slot slot) {
+    SlotState& state = states[slot];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.writer) return;
+    lockRange(slot, Mode::Shared, true); // Doi khoa ghi thanh khoa doc luon thanh cong ngay
+    state.writer = false;
+    state.readers = 1;
+    state.released.notify_all();
+}
+
+bool LockManager::upgrade(Slot slot) {
+    SlotState& state = states[slot];
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.writer || state.readers != 1) return false;
+    // fcntl doi kieu khoa tai cho: that bai thi khoa doc van con nguyen
+    if (!lockRange(slot, Mode::Exclusive, false)) return false;
+    state.readers = 0;
+    state.writer = true;
+    return true;
+}
+
+bool LockManager::heldByOtherProcess(Slot slot) const {
+#ifdef _WIN32
+    (void)slot;
+    return false;
+#else
+    if (fd < 0) return false;
+    struct flock range;
+    std::memset(&range, 0, sizeof(range));
+    range.l_type = F_WRLCK; // Xung dot voi moi khoa cua tien trinh khac, khong voi khoa cua chinh minh
+    range.l_whence = SEEK_SET;
+    range.l_start = static_cast<off_t>(slot);
+    range.l_len = 1;
+#ifdef F_OFD_GETLK
+    if (::fcntl(fd, F_OFD_GETLK, &range) != 0) return false;
+#else
+    if (::fcntl(fd, F_GETLK, &range) != 0) return false;
+#endif
+    return range.l_type != F_UNLCK;
+#endif
+}
+
+LockManager::Stats LockManager::stats() const {
+    Stats result;
+    result.shared = fd >= 0;
+    result.acquired = acquiredCount.load();
+    result.waitedInProcess = waitedInProcessCount.load();
+    result.waitedOnFile = waitedOnFileCount.load();
+    return result;
+}
+
+LockManager::Guard::Guard(Slot slot, Mode mode) : count(1) {
+    slots[0] = slot;
+    LockManager::instance().acquire(slot, mode);
+}
+
+LockManager::Guard::Guard(Slot first, Slot second, Mode mode) : count(first == second ? 1 : 2) {
+    slots[0] = first < second ? first : second;
+    slots[1] = first < second ? second : first;
+    LockManager& manager = LockManager::instance();
+    for (std::size_t i = 0; i < count; ++i) {
+        manager.acquire(slots[i], mode);
+    }
+}
+
+LockManager::Guard::~Guard() {
+    LockManager& manager = LockManager::instance();
+    for (std::size_t i = count; i-- > 0;) {
+        manager.release(slots[i]);
+    }
+}
@@ -0,0 +1,102 @@
+// lockmanager.h
+#ifndef LOCKMANAGER_H
+#define LOCKMANAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Khoa dung chung giua cac tien trinh chay tren cung thu muc data/ (cung mot may).
+// Moi tai nguyen la mot byte trong file data/locks, khoa bang fcntl (khoa OFD neu he thong ho tro)
+// o che do chia se (doc) hoac doc quyen (ghi). Khoa fcntl thuoc ve ca tien trinh (hoac ca fd) nen
+// trong tien trinh moi o co them bo dem nguoi doc/nguoi ghi rieng: chi thread dau tien khoa byte
+// trong file, thread cuoi cung nha ra.
+// - Thuc the (vi, nguoi dung): ten duoc bam vao ENTITY_SLOTS o; hai thuc the chung o chi lam khoa tho hon
+// - Chi muc/log: moi loai mot o rieng, nam SAU tat ca cac o thuc the
+// Thu tu chong tac nghen: Guard khoa cac o theo thu tu tang dan. Khi dang giu khoa chi duoc khoa them
+// o lon hon (dang giu vi -> them wallet_index.txt), khong lam nguoc lai.
+// Windows: chi khoa giua cac thread trong tien trinh.
+class LockManager {
+public:
+    enum class Mode { Shared, Exclusive };
+    enum class Resource {
+        UserIndex,      // user_index.txt
+        WalletIndex,    // wallet_index.txt
+        ContactIndex,   // contact_index.txt
+        TransactionLog, // transactions.log (vi tri ban ghi suy ra tu kich thuoc file truoc khi ghi)
+        Instances,      // Moi tien trinh dang chay giu chia se; doc quyen = tien trinh duy nhat
+        ChangeFeed,     // changes.log (thu tu su kien giua cac tien trinh)
+        LimitsState     // limits.state (gop-roi-ghi giua cac tien trinh)
+    };
+    typedef std::size_t Slot;
+
+    static const std::size_t ENTITY_SLOTS = 1024;
+    static const std::size_t RESOURCE_COUNT = 7;
+
+    struct Stats {
+        bool shared;                       // false: khong mo duoc file khoa, chi khoa trong tien trinh
+        unsigned long long acquired;
+        unsigned long long waitedInProcess; // Phai cho thread khac cua tien trinh nay
+        unsigned long long waitedOnFile;    // Phai cho tien trinh khac
+    };
+
+    // Khoa mot hoac hai o trong pham vi (hai o: theo thu tu tang dan, trung nhau thi khoa mot lan)
+    class Guard {
+    public:
+        explicit Guard(Slot slot, Mode mode = Mode::Exclusive);
+        Guard(Slot first, Slot second, Mode mode = Mode::Exclusive);
+        ~Guard();
+    private:
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Slot slots[2];
+        std::size_t count;
+    };
+
+    static LockManager& instance();
+
+    // O cua mot thuc the ('W' + walletId, 'U' + username)
+    static Slot entity(char kind, const std::string& id);
+    static Slot resource(Resource which);
+
+    // wait = false: tra ve false ngay neu o dang bi giu (trong hoac ngoai tien trinh)
+    bool acquire(Slot slot, Mode mode, bool wait = true);
+    void release(Slot slot);
+    // Doi khoa doc quyen dang giu thanh chia se ma khong nha (khong ai chen vao giua)
+    void downgrade(Slot slot);
+    // Nguoc lai: doi khoa chia se dang giu thanh doc quyen ma khong nha, khong cho. false (van giu khoa
+    // chia se) neu thread khac cua tien trinh hoac tien trinh khac cung dang giu o.
+    bool upgrade(Slot slot);
+    // Tien trinh khac dang giu o (che do bat ky)? Chi hoi kernel, khong khoa. Windows: luon false.
+    bool heldByOtherProcess(Slot slot) const;
+
+    Stats stats() const;
+
+private:
+    LockManager();
+    LockManager(const LockManager&) = delete;
+    LockManager& operator=(const LockManager&) = delete;
+
+    struct SlotState {
+        std::mutex mutex;
+        std::condition_variable released;
+        std::size_t readers;
+        bool writer;
+        SlotState() : readers(0), writer(false) {}
+    };
+
+    // Khoa/nha byte 'slot' trong file khoa (khoa lai o dang giu = doi che do)
+    bool lockRange(Slot slot, Mode mode, bool wait);
+    void unlockRange(Slot slot);
+
+    int fd;
+    std::unique_ptr<SlotState[]> states;
+    std::atomic<unsigned long long> acquiredCount;
+    std::atomic<unsigned long long> waitedInProcessCount;
+    std::atomic<unsigned long long> waitedOnFileCount;
+};
+
+#endif // LOCKMANAGER_H
@@ -0,0 +1,217 @@
+// logscan.cpp
+#include "logscan.h"
+#include "scheduler.h"
+#include "textscan.h"
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+
+namespace {
+    // Doan nho nhat: doan qua nho thi chi phi lap lich lon hon loi ich song song
+    const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+    // So doan tren moi worker, du de cac worker ranh co viec de danh cap
+    const std::size_t CHUNKS_PER_WORKER = 8;
+
+    // Goi 'visit' cho tung dong trong [begin, end) (parse tai cho tren vung log, khong sao chep dong);
+    // dong hong lam tang 'malformed'
+    template <typename Visit>
+    void forEachTransaction(const char* begin, const char* end, std::size_t& malformed, Visit visit) {
+        std::vector<std::size_t> lineEnds;
+        TextScan::findDelimiters(begin, static_cast<std::size_t>(end - begin), "\n", lineEnds);
+        lineEnds.push_back(static_cast<std::size_t>(end - begin));
+
+        TransactionView transaction;
+        std::size_t lineBegin = 0;
+        for (std::size_t lineEnd : lineEnds) {
+            if (lineEnd > lineBegin) {
+                std::size_t length = lineEnd - lineBegin;
+                if (begin[lineEnd - 1] == '\r') --length;
+                if (TransactionView::parse(begin + lineBegin, length, transaction)) {
+                    visit(transaction);
+                } else if (length > 0) {
+                    malformed++;
+                }
+            }
+            lineBegin = lineEnd + 1;
+        }
+    }
+}
+
+LogScanner::LogScanner(const std::string& path) : path(path), startOffset(0), incremental(false) {}
+
+void LogScanner::setStartOffset(std::size_t offset) {
+    startOffset = offset;
+    incremental = true;
+}
+
+bool LogScanner::open() {
+    boundaries.clear();
+    if (!file.open(path)) {
+        return false;
+    }
+
+    std::size_t total = file.size();
+    std::size_t pos = std::min(startOffset, total);
+    if (incremental) {
+        // Chi lay cac dong da ghi tron ven
+        while (total > pos && file.data()[total - 1] != '\n') --total;
+    }
+    std::size_t chunks = TaskScheduler::instance().workerCount() * CHUNKS_PER_WORKER;
+    std::size_t chunkBytes = std::max(MIN_CHUNK_BYTES, (total - pos) / std::max<std::size_t>(1, chunks) + 1);
+
+    // Dat ranh gioi doan tai dau dong ke tiep de khong dong nao bi cat doi
+    while (pos < total) {
+        boundaries.push_back(pos);
+        std::size_t target = pos + chunkBytes;
+        if (target >= total) break;
+        const void* newline = std::memchr(file.data() + target, '\n', total - target);
+        if (!newline) break;
+        pos = static_cast<std::size_t>(static_cast<const char*>(newline) - file.data()) + 1;
+    }
+    boundaries.push_back(total);
+    return true;
+}
+
+std::size_t LogScanner::scannedEnd() const {
+    return boundaries.empty() ? startOffset : boundaries.back();
+}
+
+std::size_t LogScanner::chunkCount() const {
+    return boundaries.empty() ? 0 : boundaries.size() - 1;
+}
+
+std::size_t LogScanner::size() const {
+    return file.size();
+}
+
+void LogScanner::forEachChunk(
+        const std::function<void(std::size_t chunk, const char* begin, const char* end)>& handler) const {
+    const char* data = file.data();
+    const std::vector<std::size_t>& bounds = boundaries;
+    TaskScheduler::instance().parallelFor(0, chunkCount(), 1, [&](std::size_t first, std::size_t last) {
+        for (std::size_t chunk = first; chunk < last; ++chunk) {
+            handler(chunk, data + bounds[chunk], data + bounds[chunk + 1]);
+        }
+    });
+}
+
+bool LogScanner::collect(const std::function<bool(const TransactionView&)>& filter, ArenaVector<TransactionView>& out) {
+    out.clear();
+    if (!open()) {
+        return false;
+    }
+    // Ket qua tung doan nam trong arena rieng cua doan (arena khong dung chung giua cac thread)
+    std::vector<std::unique_ptr<MonotonicArena> > arenas;
+    std::vector<ArenaVector<TransactionView> > partials;
+    arenas.reserve(chunkCount());
+    partials.reserve(chunkCount());
+    for (std::size_t chunk = 0; chunk < chunkCount(); ++chunk) {
+        arenas.emplace_back(new MonotonicArena((boundaries[chunk + 1] - boundaries[chunk]) / 8));
+        partials.emplace_back(ArenaAllocator<TransactionView>(*arenas.back()));
+    }
+    forEachChunk([&](std::size_t chunk, const char* begin, const char* end) {
+        std::size_t malformed = 0;
+        forEachTransaction(begin, end, malformed, [&](const TransactionView& transaction) {
+            if (!filter || filter(transaction)) {
+                partials[chunk].push_back(transaction);
+            }
+        });
+    });
+
+    // Gop theo thu tu doan = thu tu trong log
+    std::size_t total = 0;
+    for (const ArenaVector<TransactionView>& partial : partials) total += partial.size();
+    out.reserve(total);
+    for (const ArenaVector<TransactionView>& partial : partials) {
+        out.insert(out.end(), partial.begin(), partial.end());
+    }
+    return true;
+}
+
+bool LogScanner::aggregate(Aggregates& out) {
+    out.transactions = 0;
+    out.failed = 0;
+    out.malformed = 0;
+    out.volume = 0.0;
+    out.perWallet.clear();
+    out.perDay.clear();
+    if (!open()) {
+        return false;
+    }
+
+    std::vector<Aggregates> partials(chunkCount());
+    forEachChunk([&](std::size_t chunk, const char* begin, const char* end) {
+        Aggregates& partial = partials[chunk];
+        partial.transactions = 0;
+        partial.failed = 0;
+        partial.malformed = 0;
+        partial.volume = 0.0;
+        // Cache ngay theo khoang 15 phut (moi mui gio deu lech boi so cua 15 phut):
+        // log ghi theo thoi gian nen cac dong lien tiep thuong roi vao cung khoang
+        time_t cachedSlot = 0;
+        int cachedDay = 0;
+        forEachTransaction(begin, end, partial.malformed, [&](const TransactionView& transaction) {
+            partial.transactions++;
+            time_t slot = transaction.timestamp / 900;
+            if (cachedDay == 0 || slot != cachedSlot) {
+                cachedSlot = slot;
+                cachedDay = dayOf(transaction.timestamp);
+            }
+            DayTotals& day = partial.perDay[cachedDay];
+            if (transaction.status == "failed") {
+                partial.failed++;
+                day.failed++;
+                return;
+            }
+            if (transaction.status != "completed") return;
+            partial.volume += transaction.amount;
+            day.volume += transaction.amount;
+            day.completed++;
+            WalletTotals& sender = partial.perWallet[transaction.sender];
+            sender.sent += transaction.amount;
+            sender.transactions++;
+            WalletTotals& receiver = partial.perWallet[transaction.receiver];
+            receiver.received += transaction.amount;
+            receiver.transactions++;
+        });
+    });
+
+    // Gop theo thu tu doan de tong so thuc khong phu thuoc vao thu tu cac worker ket thuc
+    for (const Aggregates& partial : partials) {
+        out.transactions += partial.transactions;
+        out.failed += partial.failed;
+        out.malformed += partial.malformed;
+        out.volume += partial.volume;
+        for (const auto& entry : partial.perWallet) {
+            WalletTotals& totals = out.perWallet[entry.first];
+            totals.sent += entry.second.sent;
+            totals.received += entry.second.received;
+            totals.transactions += entry.second.transactions;
+        }
+        for (const auto& entry : partial.perDay) {
+            DayTotals& totals = out.perDay[entry.first];
+            totals.volume += entry.second.volume;
+            totals.completed += entry.second.completed;
+            totals.failed += entry.second.failed;
+        }
+    }
+    return true;
+}
+
+int LogScanner::dayOf(time_t timestamp) {
+    struct tm local = {};
+#ifdef _WIN32
+    localtime_s(&local, &timestamp);
+#else
+    localtime_r(&timestamp, &local);
+#endif
+    return (local.tm_year + 1900) * 10000 + (local.tm_mon + 1) * 100 + local.tm_mday;
+}
+
+std::string LogScanner::dayToString(int day) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d", day / 10000, (day / 100) % 100, day % 100);
+    return std::string(buffer);
+}
@@ -0,0 +1,84 @@
+// logscan.h
+#ifndef LOGSCAN_H
+#define LOGSCAN_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <ctime>
+#include "fileio.h"
+#include "wallet.h"
+#include "arena.h"
+
+// Quet song song transactions.log cho cac truy van va thong ke cua admin.
+// Log duoc mmap, chia thanh cac doan canh theo dau dong; moi doan duoc parse va loc
+// tren mot worker cua TaskScheduler, ket qua tung doan duoc gop lai theo dung thu tu trong log.
+class LogScanner {
+public:
+    // Tong hop theo vi (chi tinh giao dich thanh cong)
+    struct WalletTotals {
+        double sent;
+        double received;
+        std::size_t transactions;
+    };
+
+    // Tong hop theo ngay (gio dia phuong)
+    struct DayTotals {
+        double volume;           // Tong diem cua giao dich thanh cong
+        std::size_t completed;
+        std::size_t failed;
+    };
+
+    struct Aggregates {
+        std::size_t transactions; // So ban ghi hop le
+        std::size_t failed;       // So giao dich co trang thai "failed"
+        std::size_t malformed;    // So dong khong parse duoc
+        double volume;            // Tong diem cua giao dich thanh cong
+        std::unordered_map<IdHandle, WalletTotals> perWallet; // Khoa: handle cua walletId
+        std::map<int, DayTotals> perDay; // Khoa: yyyymmdd
+    };
+
+    explicit LogScanner(const std::string& path = "data/transactions.log");
+
+    // Che do doc tang dan: chi quet tu 'offset' (phan truoc da duoc xu ly o lan truoc),
+    // dong cuoi chua ket thuc bang '\n' duoc de lai cho lan sau
+    void setStartOffset(std::size_t offset);
+
+    // Anh xa log va chia doan. Tra ve false neu khong mo duoc file.
+    bool open();
+
+    std::size_t chunkCount() const;
+    std::size_t size() const;
+    // Vi tri ngay sau du lieu da quet (dung lam 'offset' cho lan doc tang dan tiep theo)
+    std::size_t scannedEnd() const;
+
+    // Goi 'handler' song song cho tung doan [begin, end) (moi doan gom cac dong tron ven)
+    void forEachChunk(const std::function<void(std::size_t chunk, const char* begin, const char* end)>& handler) const;
+
+    // Lay cac giao dich thoa 'filter' (nullptr: tat ca) theo thu tu trong log vao 'out'
+    // (vector cap phat trong arena cua truy van). Cac view tro vao vung log da mmap
+    // nen chi hop le den lan open()/collect() tiep theo hoac khi LogScanner bi huy.
+    bool collect(const std::function<bool(const TransactionView&)>& filter, ArenaVector<TransactionView>& out);
+
+    // Tinh cac tong hop tren toan bo log
+    bool aggregate(Aggregates& out);
+
+    // Khoa ngay yyyymmdd (gio dia phuong) cua mot thoi diem
+    static int dayOf(time_t timestamp);
+    // Dinh dang khoa ngay yyyymmdd thanh "yyyy-mm-dd"
+    static std::string dayToString(int day);
+
+private:
+    LogScanner(const LogScanner&) = delete;
+    LogScanner& operator=(const LogScanner&) = delete;
+
+    std::string path;
+    std::size_t startOffset;
+    bool incremental;
+    FileIO::MappedFile file;
+    std::vector<std::size_t> boundaries; // Diem bat dau cac doan, phan tu cuoi = kich thuoc log
+};
+
+#endif // LOGSCAN_H
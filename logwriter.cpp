@@ -0,0 +1,381 @@
+// logwriter.cpp
+#include "logwriter.h"
+#include "dataindex.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+
+namespace {
+    const char* const DEFAULT_LOG_PATH = "data/transactions.log";
+    const std::size_t DEFAULT_CAPACITY = 4096;
+    // Thread ghi tu thuc day dinh ky ke ca khi lo mat tin hieu danh thuc
+    const std::chrono::milliseconds IDLE_WAIT(10);
+    const int SPINS_BEFORE_WAIT = 64;
+    // appendFile chua bao vi tri: chua mo duoc file, chua ghi byte nao
+    const unsigned long long NO_OFFSET = ~0ULL;
+
+    std::size_t roundUpPowerOfTwo(std::size_t value) {
+        std::size_t result = 2;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    void raiseTo(std::atomic<std::size_t>& target, std::size_t value) {
+        std::size_t current = target.load(std::memory_order_relaxed);
+        while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+TransactionLogWriter::TransactionLogWriter()
+    : path(DEFAULT_LOG_PATH), capacity(DEFAULT_CAPACITY), policy(Backpressure::Block), ack(Ack::None), mask(0),
+      enqueuePos(0), dequeuePos(0), writtenPos(0), syncedPos(0), running(false), closed(false), appenders(0),
+      writerSleeping(false),
+      stopping(false), finished(false), batchDurable(false), enqueued(0), written(0), batches(0), inlineWrites(0), fullEvents(0), maxBatch(0),
+      highWater(0) {}
+
+TransactionLogWriter::~TransactionLogWriter() {
+    stop();
+}
+
+TransactionLogWriter& TransactionLogWriter::instance() {
+    static TransactionLogWriter writerInstance;
+    return writerInstance;
+}
+
+void TransactionLogWriter::configure(std::size_t queueCapacity, Backpressure backpressure, Ack ackLevel) {
+    if (running) return;
+    capacity = roundUpPowerOfTwo(std::max<std::size_t>(queueCapacity, 2));
+    policy = backpressure;
+    ack = ackLevel;
+}
+
+void TransactionLogWriter::setPath(const std::string& logPath) {
+    if (running) return;
+    path = logPath;
+}
+
+void TransactionLogWriter::start() {
+    if (running) return;
+    slots.reset(new Slot[capacity]);
+    mask = capacity - 1;
+    for (std::size_t i = 0; i < capacity; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    enqueuePos.store(0);
+    dequeuePos = 0;
+    writtenPos.store(0);
+    syncedPos.store(0);
+    failures.clear();
+    stopping = false;
+    finished = false;
+    closed = false;
+    batch.reserve(capacity * 256);
+    pending.reserve(capacity);
+    running = true;
+    writer = std::thread([this]() { run(); });
+}
+
+void TransactionLogWriter::stop() {
+    if (!writer.joinable()) return;
+    {
+        // Dong hang doi: tu day append() moi se ghi dong bo; thread ghi van ghi het nhung ban ghi da vao hang doi
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        closed = true;
+        stopping = true;
+    }
+    running = false;
+    wake.notify_one();
+    writer.join();
+    // append() da qua buoc kiem tra 'closed' truoc khi dong co the dua ban ghi vao sau khi thread ghi
+    // thoat: cho chung xong roi tu ghi not phan con lai, khong de ban ghi nao nam lai trong hang doi
+    while (appenders.load() != 0) {
+        std::this_thread::yield();
+    }
+    while (std::size_t count = drainBatch()) {
+        writeDrained(count);
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        finished = true;
+    }
+    progress.notify_all();
+}
+
+bool TransactionLogWriter::tryPush(std::string& record, IdHandle sender, IdHandle receiver, bool durable,
+                                   std::size_t& ticket) {
+    // Hang doi vong co gioi han (Vyukov): moi o co so thu tu cho biet o trong hay da co du lieu
+    std::size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = slots[pos & mask];
+        std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.record.swap(record);
+                slot.sender = sender;
+                slot.receiver = receiver;
+                slot.durable = durable;
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                ticket = pos;
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // Day: o nay chua duoc thread ghi lay ra
+        } else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool TransactionLogWriter::writeNow(const std::string& record, IdHandle sender, IdHandle receiver, bool durable) {
+    unsigned long long offset = 0;
+    bool complete = false;
+    Torn torn = {0, 0};
+    if (!appendLocked(record, offset, complete, torn)) {
+        if (complete) {
+            // Ban ghi da nam trong file nhung khong dong bo duoc: van dua vao chi muc, bao that bai
+            DataIndex::TransactionRef ref = {offset, static_cast<unsigned int>(record.size() - 1)};
+            DataIndex::instance().addTransaction(sender, receiver, ref);
+            written++;
+        }
+        return false;
+    }
+    bool synced = (ack != Ack::Synced && !durable) || FileIO::syncFile(path);
+    if (!synced) std::cerr << "Loi: Khong the dong bo " << path << " xuong dia." << std::endl;
+    DataIndex::TransactionRef ref = {offset, static_cast<unsigned int>(record.size() - 1)};
+    DataIndex::instance().addTransaction(sender, receiver, ref);
+    written++;
+    return synced;
+}
+
+bool TransactionLogWriter::append(std::string&& record, IdHandle sender, IdHandle receiver, bool durable) {
+    if (!running) {
+        return writeNow(record, sender, receiver, durable);
+    }
+    // Dang ky truoc khi xem 'closed' (ca hai seq_cst): hoac thay hang doi da dong, hoac stop() thay
+    // minh va cho minh dua xong ban ghi roi moi ghi not hang doi
+    appenders++;
+    if (closed.load()) {
+        appenders--;
+        return writeNow(record, sender, receiver, durable);
+    }
+    enqueued++;
+    std::size_t ticket = 0;
+    int spins = 0;
+    while (!tryPush(record, sender, receiver, durable, ticket)) {
+        if (spins == 0) fullEvents++;
+        if (policy == Backpressure::Inline || closed.load()) {
+            // Khong cho: ghi ngay tren thread goi (thu tu trong log co the dao voi hang doi)
+            appenders--;
+            inlineWrites++;
+            return writeNow(record, sender, receiver, durable);
+        }
+        if (++spins < SPINS_BEFORE_WAIT) {
+            std::this_thread::yield();
+        } else {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            progress.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    appenders--;
+    raiseTo(highWater, ticket + 1 - writtenPos.load(std::memory_order_relaxed));
+
+    // Chi danh thuc khi thread ghi dang ngu (hoac khi nguoi goi se cho xac nhan)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (writerSleeping.load() || ack != Ack::None || durable) {
+        { std::lock_guard<std::mutex> lock(wakeMutex); }
+        wake.notify_one();
+    }
+    if (ack != Ack::None || durable) {
+        return waitFor(ticket, ack == Ack::Synced || durable);
+    }
+    return true;
+}
+
+bool TransactionLogWriter::waitFor(std::size_t ticket, bool synced) {
+    std::atomic<std::size_t>& done = synced ? syncedPos : writtenPos;
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    progress.wait(lock, [&]() { return done.load() > ticket || finished; });
+    if (done.load() <= ticket) return false; // Thread ghi da dung ma chua xu ly toi ban ghi nay
+    for (const Failure& failure : failures) {
+        if (ticket >= failure.begin && ticket < failure.end && (synced || !failure.written)) return false;
+    }
+    return true;
+}
+
+void TransactionLogWriter::flush() {
+    if (!running) return;
+    std::size_t target = enqueuePos.load();
+    if (target == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wake.notify_one();
+    waitFor(target - 1, false);
+}
+
+std::size_t TransactionLogWriter::drainBatch() {
+    batch.clear();
+    pending.clear();
+    batchDurable = false;
+    while (pending.size() < capacity) {
+        Slot& slot = slots[dequeuePos & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePos + 1) break;
+        Pending entry = {slot.sender, slot.receiver, static_cast<unsigned int>(slot.record.size() - 1)};
+        batch += slot.record;
+        batchDurable = batchDurable || slot.durable;
+        pending.push_back(entry);
+        slot.record.clear();
+        // Tra o cho vong tiep theo cua nguoi ghi
+        slot.sequence.store(dequeuePos + mask + 1, std::memory_order_release);
+        dequeuePos++;
+    }
+    return pending.size();
+}
+
+bool TransactionLogWriter::appendLocked(const std::string& data, unsigned long long& offset, bool& complete,
+                                        Torn& torn) {
+    // Vi tri ghi la kich thuoc file truoc khi ghi: tien trinh khac dung chung data/ khong duoc them vao giua
+    LockManager::Guard fileLock(LockManager::resource(LockManager::Resource::TransactionLog));
+    if (torn.to != 0) cutTorn(torn);
+    offset = NO_OFFSET;
+    complete = false;
+    if (FileIO::appendFile(path, data.data(), data.size(), &offset)) {
+        complete = true;
+        return true;
+    }
+    if (offset == NO_OFFSET) return false;
+    long long size = 0;
+    time_t modified = 0;
+    if (!FileIO::fileStat(path, size, modified)) return false;
+    if (static_cast<unsigned long long>(size) == offset + data.size()) {
+        complete = true; // Da ghi du, chi fdatasync cua chinh sach loi
+        return false;
+    }
+    if (static_cast<unsigned long long>(size) > offset) {
+        // Ghi do giua chung: cat truoc khi nha khoa de khong ai noi tiep sau mot dong bi xe
+        torn = Torn{offset, static_cast<unsigned long long>(size)};
+        cutTorn(torn);
+    }
+    return false;
+}
+
+void TransactionLogWriter::cutTorn(Torn& torn) {
+    long long size = 0;
+    time_t modified = 0;
+    if (!FileIO::fileStat(path, size, modified)) return; // Giu 'torn', thu lai lan sau
+    if (static_cast<unsigned long long>(size) != torn.to) {
+        // Tien trinh khac da ghi tiep sau doan do: cat bay gio se xoa ban ghi cua ho
+        if (static_cast<unsigned long long>(size) != torn.from) {
+            std::cerr << "Loi: Khong the cat dong ghi do trong " << path << " (file da thay doi)." << std::endl;
+        }
+        torn.to = 0;
+        return;
+    }
+    FileIO::truncateFile(path, torn.from);
+    // truncateFile co the bao loi o buoc dong bo du da cat xong: xem lai kich thuoc
+    if (FileIO::fileStat(path, size, modified) && static_cast<unsigned long long>(size) == torn.from) {
+        torn.to = 0;
+    } else {
+        std::cerr << "Loi: Khong the cat dong ghi do trong " << path << ", se thu lai." << std::endl;
+    }
+}
+
+bool TransactionLogWriter::writeBatch(bool& synced, bool& appended, Torn& torn) {
+    synced = false;
+    if (appended) {
+        // Lan truoc da ghi du lo nhung fdatasync loi: chi dong bo lai, khong them lo vao file lan nua
+        synced = FileIO::syncFile(path);
+        return synced;
+    }
+    unsigned long long offset = 0;
+    bool ok = appendLocked(batch, offset, appended, torn);
+    if (appended) {
+        // Mot lan append: vi tri tung ban ghi suy ra tu vi tri dau lo
+        DataIndex& index = DataIndex::instance();
+        for (const Pending& entry : pending) {
+            DataIndex::TransactionRef ref = {offset, entry.length};
+            index.addTransaction(entry.sender, entry.receiver, ref);
+            offset += entry.length + 1;
+        }
+    }
+    if (!ok) return false;
+    if (ack == Ack::Synced || batchDurable) {
+        synced = FileIO::syncFile(path);
+        if (!synced) std::cerr << "Loi: Khong the dong bo " << path << " xuong dia." << std::endl;
+    }
+    return true;
+}
+
+void TransactionLogWriter::writeDrained(std::size_t count) {
+    int attempts = 0;
+    bool dropped = false;
+    bool synced = false;
+    bool appended = false;
+    Torn torn = {0, 0};
+    while (!writeBatch(synced, appended, torn)) {
+        // Loi ghi (dia day...): giu lo hien tai va thu lai, khong bo ban ghi
+        if (++attempts >= 3 && stopping) {
+            if (!appended) {
+                std::cerr << "Loi: Bo " << count << " giao dich khong ghi duoc vao " << path << "." << std::endl;
+                dropped = true;
+            }
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    if (!dropped) written += count;
+    batches++;
+    raiseTo(maxBatch, count);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        // Lo bi bo hoac khong dong bo duoc: nguoi dang cho xac nhan nhan false, khong phai "da ghi"
+        bool syncRequired = ack == Ack::Synced || batchDurable;
+        if (dropped || (syncRequired && !synced)) {
+            failures.push_back(Failure{dequeuePos - count, dequeuePos, !dropped});
+        }
+        writtenPos.store(dequeuePos);
+        // fdatasync cua lo nay cung phu cac lo truoc do (cung mot file)
+        if (syncRequired) syncedPos.store(dequeuePos);
+    }
+    progress.notify_all();
+}
+
+void TransactionLogWriter::run() {
+    for (;;) {
+        std::size_t count = drainBatch();
+        if (count > 0) {
+            writeDrained(count);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (stopping && dequeuePos == enqueuePos.load()) {
+            break; // stop() ghi not phan dua vao muon roi moi bao 'finished'
+        }
+        writerSleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        wake.wait_for(lock, IDLE_WAIT, [this]() {
+            return stopping || slots[dequeuePos & mask].sequence.load(std::memory_order_acquire) == dequeuePos + 1;
+        });
+        writerSleeping = false;
+    }
+}
+
+TransactionLogWriter::Stats TransactionLogWriter::stats() const {
+    Stats s;
+    s.enqueued = enqueued;
+    s.written = written;
+    s.batches = batches;
+    s.inlineWrites = inlineWrites;
+    s.fullEvents = fullEvents;
+    s.maxBatch = maxBatch;
+    s.highWater = highWater;
+    s.capacity = capacity;
+    s.running = running;
+    return s;
+}
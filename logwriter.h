@@ -0,0 +1,152 @@
+// logwriter.h
+#ifndef LOGWRITER_H
+#define LOGWRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "intern.h"
+
+// Ghi transactions.log bat dong bo: transferPoints chi dua ban ghi da dinh dang san vao
+// mot hang doi vong (ring buffer) nhieu-nguoi-ghi/mot-nguoi-doc khong khoa; mot thread rieng
+// gom nhieu ban ghi thanh mot lan append duy nhat va cap nhat chi muc giao dich.
+// - Bo nho hang doi co gioi han: so o co dinh (luy thua cua 2), dat truoc khi start()
+// - Khi hang doi day: cho (Block) hoac tu ghi dong bo ngay tren thread goi (Inline)
+// - Muc xac nhan: khong cho (None), cho den khi da ghi vao file (Written) hoac da fdatasync (Synced)
+// Voi Ack::None, cac ban ghi con trong hang doi se mat neu tien trinh bi kill; thoat binh thuong
+// (stop()) luon ghi het truoc.
+class TransactionLogWriter {
+public:
+    enum class Backpressure { Block, Inline };
+    enum class Ack { None, Written, Synced };
+
+    struct Stats {
+        unsigned long long enqueued;
+        unsigned long long written;     // So ban ghi da ghi vao file (ca ghi Inline)
+        unsigned long long batches;     // So lan append cua thread ghi
+        unsigned long long inlineWrites; // So ban ghi phai ghi dong bo do hang doi day
+        unsigned long long fullEvents;  // So lan hang doi day khi dua vao
+        std::size_t maxBatch;
+        std::size_t highWater;          // So ban ghi cho ghi nhieu nhat tung thay
+        std::size_t capacity;
+        bool running;
+    };
+
+    static TransactionLogWriter& instance();
+
+    // Cau hinh (chi co tac dung truoc start())
+    void configure(std::size_t capacity, Backpressure policy, Ack ack);
+    void setPath(const std::string& path);
+
+    // Khoi dong thread ghi. Truoc khi start() (hoac sau stop()), append() ghi dong bo.
+    void start();
+    // Ghi het hang doi roi dung thread ghi
+    void stop();
+
+    // Dua mot ban ghi (da co '\n' o cuoi) vao hang doi; sender/receiver dung cho chi muc giao dich.
+    // Tra ve false neu ghi dong bo that bai (khi chua start hoac ghi Inline), hoac neu nguoi goi cho
+    // xac nhan (Ack) ma ban ghi bi bo / khong dong bo duoc xuong dia.
+    // durable = true: cho den khi ban ghi nay da fdatasync (nhu Ack::Synced) bat ke cau hinh
+    // (giao dich co ma yeu cau, xem Wallet::saveTransfer).
+    bool append(std::string&& record, IdHandle sender, IdHandle receiver, bool durable = false);
+
+    // Cho den khi moi ban ghi da dua vao truoc do deu nam trong file (dung truoc khi doc log)
+    void flush();
+
+    Stats stats() const;
+
+private:
+    TransactionLogWriter();
+    ~TransactionLogWriter();
+    TransactionLogWriter(const TransactionLogWriter&) = delete;
+    TransactionLogWriter& operator=(const TransactionLogWriter&) = delete;
+
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        std::string record;
+        IdHandle sender;
+        IdHandle receiver;
+        bool durable;
+    };
+
+    // Doan ticket [begin, end) xu ly khong thanh cong: bo han (written = false) hoac da ghi nhung
+    // fdatasync loi (written = true). Hiem khi co, nen chi la danh sach tim tuyen tinh.
+    struct Failure {
+        std::size_t begin;
+        std::size_t end;
+        bool written;
+    };
+
+    // Ban ghi da lay khoi hang doi, dang nam trong 'batch'
+    struct Pending {
+        IdHandle sender;
+        IdHandle receiver;
+        unsigned int length;    // Khong gom '\n'
+    };
+
+    // Doan [from, to) con sot lai trong file tu mot lan append do ma chua cat duoc (to = 0: khong co)
+    struct Torn {
+        unsigned long long from;
+        unsigned long long to;
+    };
+
+    bool tryPush(std::string& record, IdHandle sender, IdHandle receiver, bool durable, std::size_t& ticket);
+    bool writeNow(const std::string& record, IdHandle sender, IdHandle receiver, bool durable);
+    void run();
+    std::size_t drainBatch();
+    // Ghi lo hien tai, thu lai den khi xong (hoac bo sau 3 lan khi dang dung) va bao cho nguoi cho
+    void writeDrained(std::size_t count);
+    // false neu chua xong; 'synced' = da fdatasync thanh cong (chi khi Ack::Synced hoac lo co ban ghi durable).
+    // 'appended' giu qua cac lan thu: lo da nam tron trong file thi lan sau chi thu dong bo lai.
+    bool writeBatch(bool& synced, bool& appended, Torn& torn);
+    // Them vao cuoi log duoi khoa LockManager; 'offset' = vi tri bat dau cua 'data' trong file.
+    // Khi loi: complete = true neu moi byte da vao file (chi buoc dong bo cua chinh sach loi); nguoc lai
+    // phan ghi do duoc cat bo ngay duoi khoa, hoac - neu cat that bai - ghi vao 'torn' de lan sau cat lai.
+    bool appendLocked(const std::string& data, unsigned long long& offset, bool& complete, Torn& torn);
+    // Cat doan do 'torn' (dang giu khoa TransactionLog); bo qua neu file da doi kich thuoc
+    void cutTorn(Torn& torn);
+    // Cho ban ghi 'ticket' duoc xu ly; false neu no nam trong mot doan that bai
+    bool waitFor(std::size_t ticket, bool synced);
+
+    std::string path;
+    std::size_t capacity;
+    Backpressure policy;
+    Ack ack;
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask;
+    alignas(64) std::atomic<std::size_t> enqueuePos;
+    alignas(64) std::size_t dequeuePos;        // Chi thread ghi doc/ghi
+    std::atomic<std::size_t> writtenPos;       // Moi ticket < writtenPos da duoc xu ly (tru doan trong 'failures')
+    std::atomic<std::size_t> syncedPos;        // Moi ticket < syncedPos da qua fdatasync (tru doan trong 'failures')
+    std::vector<Failure> failures;             // Giu wakeMutex
+
+    std::atomic<bool> running;
+    std::atomic<bool> closed;                  // Dat duoi wakeMutex trong stop(): append() moi ghi dong bo
+    std::atomic<int> appenders;                // So append() dang dua vao hang doi (stop() cho ve 0)
+    std::atomic<bool> writerSleeping;
+    bool stopping;
+    bool finished;                             // Thread ghi da ket thuc (giu wakeMutex)
+    std::thread writer;
+    std::mutex wakeMutex;
+    std::condition_variable wake;              // Danh thuc thread ghi
+    std::condition_variable progress;          // Bao da ghi xong / da co cho trong
+
+    std::string batch;                         // Bo dem gom ban ghi cua thread ghi
+    std::vector<Pending> pending;
+    bool batchDurable;                         // Lo hien tai co ban ghi durable: phai fdatasync
+    std::atomic<unsigned long long> enqueued;
+    std::atomic<unsigned long long> written;
+    std::atomic<unsigned long long> batches;
+    std::atomic<unsigned long long> inlineWrites;
+    std::atomic<unsigned long long> fullEvents;
+    std::atomic<std::size_t> maxBatch;
+    std::atomic<std::size_t> highWater;
+};
+
+#endif // LOGWRITER_H
@@ -5,11 +5,29 @@
 #include <vector>
 #include <algorithm> // De su dung std::remove_if
 #include <memory> // Them dong nay de su dung std::unique_ptr
+#include <cstdio> // De su dung std::remove
+#include <mutex>
 
 #include "user.h"
 #include "wallet.h"
 #include "otp.h"
 #include "utils.h"
+#include "fileio.h"
+#include "dataindex.h"
+#include "scheduler.h"
+#include "logscan.h"
+#include "columnstore.h"
+#include "supply.h"
+#include "logwriter.h"
+#include "idempotency.h"
+#include "usersearch.h"
+#include "contactindex.h"
+#include "userimport.h"
+#include "backup.h"
+#include "lockmanager.h"
+#include "shards.h"
+#include "changefeed.h"
+#include "limits.h"
 
 // Bien toan cuc de quan ly OTP (co the truyen qua ham neu muon)
 OTPManager otpManager;
@@ -18,13 +36,120 @@ OTPManager otpManager;
 // Su dung unique_ptr de tu dong quan ly bo nho
 std::unique_ptr<User> currentUser = nullptr;
 
+// Bat che do warm-start: nap toan bo chi muc vao bo nho luc khoi dong (--warm-start)
+bool warmStartEnabled = false;
+// Che do xuat du lieu cot (--export-analytics): 0 = khong, 1 = tang dan, 2 = xuat lai toan bo
+int analyticsExportMode = 0;
+// Chu ky (giay) kiem tra tong cung diem o nen (--supply-check=N, 0 = tat)
+unsigned int supplyCheckSeconds = 60;
+// Cau hinh thread ghi transactions.log (--log-queue=N, --log-backpressure=..., --log-ack=...)
+std::size_t logQueueCapacity = 4096;
+TransactionLogWriter::Backpressure logBackpressure = TransactionLogWriter::Backpressure::Block;
+TransactionLogWriter::Ack logAck = TransactionLogWriter::Ack::None;
+// Cua so (giay) nho ma yeu cau chuyen diem de chong gui trung (--dedup-window=N)
+unsigned int dedupWindowSeconds = 24 * 60 * 60;
+// Nhap tai khoan hang loat tu file CSV/JSONL roi thoat (--import-users=FILE)
+std::string importUsersPath;
+// Sao luu roi thoat (--backup: 1 = tang dan, 2 = day du); khoi phuc roi thoat (--restore=ID|latest)
+int backupMode = 0;
+std::string restoreBackupId;
+bool restoreRequested = false;
+// Doc luong thay doi voi ten nguoi doc nay, in ra tung su kien (--tail-changes=TEN)
+std::string tailConsumerName;
+// Chuyen data/ sang N phan vung roi thoat (--migrate-shards=N, --shard-dirs=P0,P1,...)
+std::size_t migrateShardCount = 0;
+std::vector<std::string> shardDirs;
+
+// File danh dau chuong trinh dang chay; con ton tai luc khoi dong nghia la lan truoc bi dung dot ngot
+const char* const RUNNING_MARKER_FILE = "data/.running";
+
+// Phan phuc hoi file (goi khi dang giu doc quyen khoa Instances)
+void recoverFiles() {
+    int rolledForward = FileIO::recoverJournal();
+    ChangeFeed::instance().recover();
+    // Sau journal: nhom commit cua giao dich co ma yeu cau da hoan tat thi bien nhan cua no cung da co
+    int receipts = Wallet::recoverReceipts();
+    if (receipts > 0) {
+        std::cout << "Phuc hoi du lieu: ghi bo sung " << receipts << " giao dich co ma yeu cau vao transactions.log." << std::endl;
+    }
+    int restored = 0, removed = 0, quarantined = 0;
+    std::string marker;
+    if (FileIO::readFileOnce(RUNNING_MARKER_FILE, marker)) {
+        // Moi phan vung quet song song (bo cuc phang: mot lan cho data/users va data/wallets)
+        ShardLayout& layout = ShardLayout::instance();
+        std::mutex totalsMutex;
+        layout.forEachShard([&](std::size_t shard) {
+            FileIO::RecoveryReport users = FileIO::recoverDirectory(layout.userDir(shard), ".txt", User::isValidRecord);
+            FileIO::RecoveryReport wallets = FileIO::recoverDirectory(layout.walletDir(shard), ".txt", Wallet::isValidRecord);
+            std::lock_guard<std::mutex> lock(totalsMutex);
+            restored += users.restoredFromTemp + wallets.restoredFromTemp;
+            removed += users.removedTemp + wallets.removedTemp;
+            quarantined += users.quarantined + wallets.quarantined;
+        });
+    }
+    FileIO::replaceFile(RUNNING_MARKER_FILE, "1");
+
+    if (rolledForward + restored + removed + quarantined > 0) {
+        std::cout << "Phuc hoi du lieu: hoan tat " << rolledForward << " file tu journal, khoi phuc "
+                  << restored << " file tu ban tam, xoa " << removed << " file tam." << std::endl;
+    }
+    if (quarantined > 0) {
+        std::cerr << "Canh bao: " << quarantined << " file du lieu bi hong da duoc doi ten thanh *.corrupt." << std::endl;
+    }
+}
+
+// Ham phuc hoi du lieu luc khoi dong:
+// hoan tat nhom ghi dang do, xu ly file tam con sot, cach ly file bi ghi do dang
+// (Chi quet toan bo thu muc du lieu khi lan chay truoc khong thoat binh thuong)
+void recoverDataFiles() {
+    // Chi tien trinh dau tien tren data/ moi phuc hoi: file tam/journal cua tien trinh khac dang chay
+    // khong phai ban ghi do dang. Moi tien trinh giu khoa chia se Instances den khi thoat.
+    LockManager& locks = LockManager::instance();
+    LockManager::Slot instances = LockManager::resource(LockManager::Resource::Instances);
+    if (!locks.acquire(instances, LockManager::Mode::Exclusive, false)) {
+        locks.acquire(instances, LockManager::Mode::Shared); // Cho neu tien trinh khac dang phuc hoi
+        std::cout << "Dang co tien trinh khac dung chung thu muc du lieu: bo qua buoc phuc hoi." << std::endl;
+        return;
+    }
+    recoverFiles();
+    locks.downgrade(instances); // Phuc hoi xong: tien trinh khac co the khoi dong cung
+}
+
 // Ham khoi tao he thong (tao thu muc, vi tong)
 void initializeSystem() {
     // Chu y: createDirectoryIfNotExists chi tao duoc mot cap thu muc.
-    // Dam bao "data" duoc tao truoc khi tao "data/users" va "data/wallets"
-    Utils::createDirectoryIfNotExists("data");
-    Utils::createDirectoryIfNotExists("data/users");
-    Utils::createDirectoryIfNotExists("data/wallets");
+    // Tao "data" roi thu muc users/, wallets/ cua tung phan vung (bo cuc phang: data/users, data/wallets)
+    ShardLayout::instance().createDirectories();
+    Utils::createDirectoryIfNotExists("data/requests"); // Bien nhan giao dich co ma yeu cau
+
+    // Phuc hoi cac lan ghi do dang neu lan chay truoc bi dung dot ngot
+    recoverDataFiles();
+
+    // Nap song song toan bo du lieu vao chi muc trong bo nho
+    if (warmStartEnabled) {
+        DataIndex::LoadReport report = DataIndex::instance().warmStart();
+        std::ostringstream elapsed;
+        elapsed << std::fixed << std::setprecision(3) << report.seconds;
+        if (report.fromSnapshot) {
+            std::cout << "Warm-start: mo snapshot chi muc (" << report.users << " nguoi dung, " << report.wallets
+                      << " vi), doc lai " << report.deltasReplayed << " thay doi va " << report.transactions
+                      << " ban ghi giao dich moi trong " << elapsed.str() << " giay." << std::endl;
+        } else {
+            std::cout << "Warm-start: da nap " << report.users << " nguoi dung, " << report.wallets << " vi, "
+                      << report.transactions << " ban ghi giao dich trong " << elapsed.str()
+                      << " giay (" << report.threads << " thread)." << std::endl;
+        }
+        if (report.failedFiles > 0) {
+            std::cerr << "Canh bao: " << report.failedFiles << " file trong index khong doc duoc." << std::endl;
+        }
+    }
+
+    // Han muc chuyen diem va bo dem cua lan chay truoc
+    TransferLimits::instance().load();
+
+    // Tong cung diem ky vong (doi chieu ngay voi bang vi neu da warm-start)
+    SupplyMonitor& supply = SupplyMonitor::instance();
+    supply.initialize();
 
     // Kiem tra va tao vi tong neu chua co
     // Su dung unique_ptr de tu dong quan ly bo nho
@@ -35,11 +160,24 @@ void initializeSystem() {
         masterWallet->walletId = "MASTER_WALLET"; // Dat ID co dinh
         masterWallet->balance = 1000000.0; // Khoi tao so diem lon cho vi tong
         masterWallet->saveToFile();
+        supply.mint(masterWallet->balance); // Lan phat hanh diem duy nhat
         std::cout << "Da khoi tao vi tong voi ID: MASTER_WALLET va so du " << masterWallet->balance << " diem." << std::endl;
     } else {
         std::cout << "Vi tong da ton tai voi ID: MASTER_WALLET va so du " << masterWallet->balance << " diem." << std::endl;
     }
     // unique_ptr masterWallet se tu dong giai phong bo nho khi ra khoi scope
+
+    supply.startVerifier(supplyCheckSeconds); // Khong warm-start: doi chieu voi file vi
+
+    // Ghi log giao dich tren thread rieng (sau warm-start: chi muc giao dich da nap xong)
+    TransactionLogWriter& logWriter = TransactionLogWriter::instance();
+    logWriter.configure(logQueueCapacity, logBackpressure, logAck);
+    logWriter.start();
+
+    // Dung lai bang ma yeu cau tu log ngay khi khoi dong (khong de lan chuyen diem dau tien phai cho quet log)
+    IdempotencyTable& dedup = IdempotencyTable::instance();
+    dedup.configure(dedupWindowSeconds, 262144);
+    dedup.recover();
 }
 
 // Ham xoa bo dem ban phim
@@ -48,6 +186,20 @@ void clearInputBuffer() {
 }
 
 // Ham dang ky tai khoan
+// Kiem tra email/so dien thoai da duoc tai khoan khac su dung chua (chi muc bam, O(1)).
+// showOwner: admin duoc biet tai khoan dang giu, nguoi dang ky thi khong.
+bool checkContactUnique(const std::string& email, const std::string& phoneNumber, const std::string& exceptUsername,
+                        bool showOwner) {
+    std::string owner;
+    ContactIndex::Conflict conflict = ContactIndex::instance().check(email, phoneNumber, exceptUsername, owner);
+    if (conflict == ContactIndex::Conflict::None) return true;
+    std::cout << (conflict == ContactIndex::Conflict::Email ? "Email" : "So dien thoai")
+              << " da duoc su dung boi tai khoan khac";
+    if (showOwner) std::cout << " (" << owner << ")";
+    std::cout << ". Vui long nhap thong tin khac." << std::endl;
+    return false;
+}
+
 void registerAccount() {
     std::string username, password, confirmPassword, fullName, email, phoneNumber;
     std::cout << "\n--- Dang ky tai khoan ---" << std::endl;
@@ -85,9 +237,10 @@ void registerAccount() {
     std::cout << "Nhap so dien thoai: ";
     std::cin >> phoneNumber;
     clearInputBuffer();
+    if (!checkContactUnique(email, phoneNumber, username, false)) return;
 
     // Mac dinh la nguoi dung thong thuong khi tu dang ky
-    User newUser(username, Utils::hashPassword(password), fullName, email, phoneNumber, "normal");
+    User newUser(username, Utils::hashPassword(password), fullName, email, phoneNumber, Access::Role::Normal);
     if (newUser.saveToFile()) { // Ham saveToFile da tu dong cap nhat file index
         std::cout << "Dang ky tai khoan thanh cong!" << std::endl;
         // Tao vi cho nguoi dung moi
@@ -206,6 +359,11 @@ void updateProfile(User* userToUpdate, bool isAdminUpdating = false) {
 
     std::cout << changesSummary << std::endl;
 
+    if (!checkContactUnique(newEmail, newPhoneNumber, userToUpdate->getUsername(), isAdminUpdating)) {
+        std::cout << "Huy bo cap nhat." << std::endl;
+        return;
+    }
+
     // Sinh va xac thuc OTP
     std::string otpCode = otpManager.generateOTP(userToUpdate->getUserId(), "update_profile");
     std::string enteredOTP;
@@ -311,6 +469,42 @@ void transferPoints() {
         return;
     }
 
+    // Ma yeu cau: client gui lai cung ma (vi du sau khi mat ket noi) se khong bi chuyen diem hai lan
+    std::string requestKey;
+    std::cout << "Nhap ma yeu cau (Enter de bo qua): ";
+    std::getline(std::cin, requestKey);
+    requestKey = Utils::trimString(requestKey);
+
+    // Han muc chuyen diem cua nguoi dung nay (theo vai tro, co the ghi de rieng trong data/limits.conf)
+    TransferLimits::Limits limits = TransferLimits::instance().limitsFor(currentUser->getUsername(), currentUser->getRole());
+
+    if (!Wallet::holdsAvailable()) {
+        // Tien trinh khac dung chung data/: giu cho trong bo nho khong co tac dung, xac thuc OTP roi chuyen mot lan
+        std::string otpCode = otpManager.generateOTP(currentUser->getUserId(), "transfer_points");
+        std::string enteredOTP;
+        std::cout << "Ma OTP da duoc gui den ban. Vui long nhap OTP de xac nhan giao dich: ";
+        std::cin >> enteredOTP;
+        clearInputBuffer();
+        if (!otpManager.verifyOTP(currentUser->getUserId(), "transfer_points", enteredOTP)) {
+            std::cout << "Xac thuc OTP that bai. Giao dich chuyen diem bi huy bo." << std::endl;
+        } else if (Wallet::transferPoints(currentUser->getUserId(), receiverWalletId, amount, limits, requestKey)) {
+            std::cout << "Giao dich chuyen diem da hoan tat." << std::endl;
+        } else {
+            std::cout << "Giao dich chuyen diem that bai." << std::endl;
+        }
+        otpManager.invalidateOTP(currentUser->getUserId(), "transfer_points");
+        return;
+    }
+
+    // Giai doan 1: giu so diem tren vi trong suot thoi gian hieu luc cua OTP
+    // (giao dich khac cua cung vi khong the dung phan diem nay)
+    HoldManager::HoldId hold = Wallet::reserveTransfer(currentUser->getUserId(), receiverWalletId, amount, limits,
+                                                       requestKey, OTPManager::OTP_EXPIRATION_SECONDS);
+    if (hold == HoldManager::NO_HOLD) {
+        std::cout << "Giao dich chuyen diem khong duoc thuc hien." << std::endl;
+        return;
+    }
+
     // Sinh va xac thuc OTP truoc khi chuyen diem
     std::string otpCode = otpManager.generateOTP(currentUser->getUserId(), "transfer_points");
     std::string enteredOTP;
@@ -318,18 +512,32 @@ void transferPoints() {
     std::cin >> enteredOTP;
     clearInputBuffer();
 
+    // Giai doan 2: commit neu OTP dung, nguoc lai bo giu cho
     if (otpManager.verifyOTP(currentUser->getUserId(), "transfer_points", enteredOTP)) {
-        if (Wallet::transferPoints(currentUser->getUserId(), receiverWalletId, amount)) {
+        if (Wallet::commitTransfer(currentUser->getUserId(), hold, limits, requestKey)) {
             std::cout << "Giao dich chuyen diem da hoan tat." << std::endl;
         } else {
             std::cout << "Giao dich chuyen diem that bai." << std::endl;
         }
     } else {
+        Wallet::cancelTransfer(hold);
         std::cout << "Xac thuc OTP that bai. Giao dich chuyen diem bi huy bo." << std::endl;
     }
     otpManager.invalidateOTP(currentUser->getUserId(), "transfer_points"); // Huy OTP
 }
 
+// In mot giao dich (dung chung cho lich su cua nguoi dung va cua admin)
+void printTransaction(const TransactionView& transaction) {
+    std::cout << "------------------------------------" << std::endl;
+    std::cout << "ID Giao dich: " << transaction.transactionId << std::endl;
+    std::cout << "Tu vi: " << idToString(transaction.sender) << std::endl;
+    std::cout << "Den vi: " << idToString(transaction.receiver) << std::endl;
+    std::cout << "So diem: " << std::fixed << std::setprecision(2) << transaction.amount << std::endl;
+    std::cout << "Thoi gian: " << Utils::timeToString(transaction.timestamp) << std::endl;
+    std::cout << "Trang thai: " << transaction.status << std::endl;
+    std::cout << "Mo ta: " << transaction.description << std::endl;
+}
+
 // Ham xem lich su giao dich cua nguoi dung hien tai
 void viewTransactionHistory() {
     if (!currentUser) {
@@ -345,25 +553,34 @@ void viewTransactionHistory() {
     }
 
     std::cout << "\n--- Lich su giao dich cua ban (" << userWallet->walletId << ") ---" << std::endl;
-    std::vector<std::string> lines = Utils::readAllLines("data/transactions.log");
+    TransactionLogWriter::instance().flush(); // Cac giao dich vua thuc hien phai co trong log
     bool foundTransactions = false;
-
-    for (const std::string& line : lines) {
-        Transaction* transaction = Transaction::fromString(line);
-        if (transaction) {
-            if (transaction->senderWalletId == userWallet->walletId || transaction->receiverWalletId == userWallet->walletId) {
-                std::cout << "------------------------------------" << std::endl;
-                std::cout << "ID Giao dich: " << transaction->transactionId << std::endl;
-                std::cout << "Tu vi: " << transaction->senderWalletId << std::endl;
-                std::cout << "Den vi: " << transaction->receiverWalletId << std::endl;
-                std::cout << "So diem: " << std::fixed << std::setprecision(2) << transaction->amount << std::endl;
-                std::cout << "Thoi gian: " << Utils::timeToString(transaction->timestamp) << std::endl;
-                std::cout << "Trang thai: " << transaction->status << std::endl;
-                std::cout << "Mo ta: " << transaction->description << std::endl;
-                foundTransactions = true;
+    // Moi ban ghi tam cua truy van nam trong arena, duoc giai phong mot lan khi ham ket thuc
+    MonotonicArena arena;
+    ArenaVector<TransactionView> transactions{ArenaAllocator<TransactionView>(arena)};
+    LogScanner scanner;
+    DataIndex& index = DataIndex::instance();
+    if (index.isLoaded()) {
+        // Chi doc cac ban ghi lien quan den vi nay theo vi tri da duoc chi muc
+        std::string line;
+        TransactionView transaction;
+        for (const DataIndex::TransactionRef& ref : index.transactionsOf(userWallet->walletId)) {
+            if (!FileIO::readRange("data/transactions.log", ref.offset, ref.length, line)) continue;
+            const char* text = arena.copy(line.data(), line.size());
+            if (TransactionView::parse(text, line.size(), transaction)) {
+                transactions.push_back(transaction);
             }
-            delete transaction; // Giai phong bo nho cho Transaction*
         }
+    } else {
+        // Quet song song toan bo log, chi giu cac giao dich cua vi nay (so sanh handle, khong so chuoi)
+        const IdHandle walletId = internId(userWallet->walletId);
+        scanner.collect([walletId](const TransactionView& transaction) {
+            return transaction.sender == walletId || transaction.receiver == walletId;
+        }, transactions);
+    }
+    for (const TransactionView& transaction : transactions) {
+        printTransaction(transaction);
+        foundTransactions = true;
     }
 
     if (!foundTransactions) {
@@ -374,21 +591,43 @@ void viewTransactionHistory() {
 }
 
 // Menu cho nguoi dung thong thuong
+// Mot muc menu va quyen can co de hien/chon no (Access::POLICY)
+struct MenuItem {
+    int choice;
+    const char* label;
+    Access::Permission permission;
+};
+const MenuItem NORMAL_MENU[] = {
+    {1, "Xem thong tin ca nhan", Access::Permission::ViewOwnProfile},
+    {2, "Cap nhat thong tin ca nhan", Access::Permission::UpdateOwnProfile},
+    {3, "Thay doi mat khau", Access::Permission::ChangeOwnPassword},
+    {4, "Xem thong tin vi diem thuong", Access::Permission::ViewOwnWallet},
+    {5, "Chuyen diem", Access::Permission::TransferPoints},
+    {6, "Xem lich su giao dich", Access::Permission::ViewOwnHistory},
+};
+
 void normalUserMenu() {
     int choice;
     do {
         std::cout << "\n--- Menu nguoi dung thong thuong (" << currentUser->getUsername() << ") ---" << std::endl;
-        std::cout << "1. Xem thong tin ca nhan" << std::endl;
-        std::cout << "2. Cap nhat thong tin ca nhan" << std::endl;
-        std::cout << "3. Thay doi mat khau" << std::endl;
-        std::cout << "4. Xem thong tin vi diem thuong" << std::endl;
-        std::cout << "5. Chuyen diem" << std::endl;
-        std::cout << "6. Xem lich su giao dich" << std::endl;
+        // Nhu menu quan ly: chi hien va chi cho chon cac muc vai tro duoc phep
+        for (const MenuItem& item : NORMAL_MENU) {
+            if (currentUser->can(item.permission)) std::cout << item.choice << ". " << item.label << std::endl;
+        }
         std::cout << "0. Dang xuat" << std::endl;
         std::cout << "Nhap lua chon cua ban: ";
         std::cin >> choice;
         clearInputBuffer();
 
+        bool allowed = true;
+        for (const MenuItem& item : NORMAL_MENU) {
+            if (item.choice == choice) allowed = currentUser->can(item.permission);
+        }
+        if (!allowed) {
+            std::cout << "Tai khoan " << currentUser->getUserType() << " khong co quyen thuc hien chuc nang nay." << std::endl;
+            continue;
+        }
+
         switch (choice) {
             case 1: currentUser->displayUserInfo(); break;
             case 2: updateProfile(currentUser.get()); break; // Truyen raw pointer
@@ -408,6 +647,7 @@ void normalUserMenu() {
 // Ham tao tai khoan moi boi admin
 void adminCreateNewAccount() {
     std::string username, fullName, email, phoneNumber, userTypeChoice;
+    Access::Role role = Access::Role::Normal;
     bool isAutoGeneratedPassword = false;
     std::string password = "";
 
@@ -456,16 +696,17 @@ void adminCreateNewAccount() {
     std::cout << "Nhap so dien thoai: ";
     std::cin >> phoneNumber;
     clearInputBuffer();
+    if (!checkContactUnique(email, phoneNumber, username, true)) return;
 
-    std::cout << "Chon loai tai khoan (normal/admin): ";
+    std::cout << "Chon loai tai khoan (" << Access::roleNames() << "): ";
     std::cin >> userTypeChoice;
     clearInputBuffer();
-    if (userTypeChoice != "normal" && userTypeChoice != "admin") {
-        userTypeChoice = "normal"; // Mac dinh la normal neu nhap sai
+    if (!Access::parseRole(userTypeChoice, role)) {
+        role = Access::Role::Normal; // Mac dinh la normal neu nhap sai
         std::cout << "Loai tai khoan khong hop le. Mac dinh la 'normal'." << std::endl;
     }
 
-    User newUser(username, Utils::hashPassword(password), fullName, email, phoneNumber, userTypeChoice, isAutoGeneratedPassword);
+    User newUser(username, Utils::hashPassword(password), fullName, email, phoneNumber, role, isAutoGeneratedPassword);
     if (newUser.saveToFile()) { // Ham saveToFile da tu dong cap nhat file index
         std::cout << "Tao tai khoan thanh cong!" << std::endl;
         // Tao vi cho nguoi dung moi
@@ -484,18 +725,24 @@ void adminCreateNewAccount() {
 // (Da sua doi de doc tu file index)
 void adminViewAllUsers() {
     std::cout << "\n--- Danh sach tat ca tai khoan ---" << std::endl;
-    std::string userIndexFile = "data/user_index.txt"; // File index nguoi dung
-    std::vector<std::string> usernames = Utils::readAllLines(userIndexFile); // Doc tat ca usernames tu file index
+    // Doc tat ca usernames tu file index (cua moi phan vung)
+    std::vector<std::string> usernames = ShardLayout::instance().allUsernames();
 
     if (usernames.empty()) {
         std::cout << "Chua co tai khoan nao trong he thong." << std::endl;
         return;
     }
 
+    // Doc song song cac file nguoi dung, in ra theo thu tu trong index
+    std::vector<std::unique_ptr<User> > users(usernames.size());
+    TaskScheduler::instance().parallelFor(0, usernames.size(), 0, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            users[i].reset(User::loadFromFile(usernames[i]));
+        }
+    });
+
     bool foundUsers = false;
-    for (const std::string& username : usernames) {
-        // Su dung unique_ptr de tu dong quan ly bo nho
-        std::unique_ptr<User> user = std::unique_ptr<User>(User::loadFromFile(username));
+    for (const std::unique_ptr<User>& user : users) {
         if (user) {
             std::cout << "------------------------------------" << std::endl;
             std::cout << "User ID: " << user->getUserId() << std::endl;
@@ -524,6 +771,16 @@ void adminUpdateOtherAccount() {
     std::unique_ptr<User> targetUser = std::unique_ptr<User>(User::loadFromFile(targetUsername));
     if (!targetUser) {
         std::cout << "Tai khoan " << targetUsername << " khong ton tai." << std::endl;
+        // Goi y cac tai khoan gan dung tu chi muc tim kiem (rut ngan dan tu khoa neu khong khop)
+        UserSearchIndex::Page similar = UserSearchIndex::instance().search(targetUsername, 1, 5);
+        for (std::size_t length = targetUsername.size(); similar.hits.empty() && length > 3; --length) {
+            similar = UserSearchIndex::instance().search(targetUsername.substr(0, length - 1), 1, 5);
+        }
+        if (!similar.hits.empty()) {
+            std::cout << "Co the ban muon tim:";
+            for (const UserSearchIndex::Hit& hit : similar.hits) std::cout << " " << hit.username;
+            std::cout << std::endl;
+        }
         return;
     }
 
@@ -536,57 +793,395 @@ void adminUpdateOtherAccount() {
     // unique_ptr targetUser se tu dong giai phong bo nho khi ra khoi scope
 }
 
+// Ham tim kiem tai khoan theo ten dang nhap, ho ten, email, so dien thoai (admin)
+void adminSearchUsers() {
+    const std::size_t PAGE_SIZE = 10;
+    std::string query;
+    std::cout << "\n--- Tim kiem tai khoan ---" << std::endl;
+    std::cout << "Nhap tu khoa (ten dang nhap, ho ten, email hoac so dien thoai): ";
+    std::getline(std::cin, query);
+
+    std::size_t page = 1;
+    for (;;) {
+        UserSearchIndex::Page result = UserSearchIndex::instance().search(query, page, PAGE_SIZE);
+        if (result.total == 0) {
+            std::cout << "Khong tim thay tai khoan nao." << std::endl;
+            return;
+        }
+        std::cout << "Tim thay " << result.total << " tai khoan (trang " << result.page << "/" << result.pages << "):"
+                  << std::endl;
+        std::size_t rank = (result.page - 1) * PAGE_SIZE;
+        for (const UserSearchIndex::Hit& hit : result.hits) {
+            std::cout << ++rank << ". " << hit.username << " | " << hit.fullName << " | " << hit.email << " | "
+                      << hit.phoneNumber << std::endl;
+        }
+        if (result.page >= result.pages) break;
+        std::string next;
+        std::cout << "Nhap so trang muon xem (Enter de ket thuc): ";
+        std::getline(std::cin, next);
+        next = Utils::trimString(next);
+        if (next.empty() || next.size() > 6 || next.find_first_not_of("0123456789") != std::string::npos) break;
+        page = static_cast<std::size_t>(std::stoul(next));
+    }
+    std::cout << "------------------------------------" << std::endl;
+}
+
 // Ham xem tat ca lich su giao dich (admin)
 void adminViewAllTransactions() {
     std::cout << "\n--- Tat ca lich su giao dich ---" << std::endl;
-    std::vector<std::string> lines = Utils::readAllLines("data/transactions.log");
-    bool foundTransactions = false;
+    TransactionLogWriter::instance().flush();
+    // Quet song song theo doan, ket qua giu dung thu tu trong log.
+    // Danh sach ket qua nam trong arena cua truy van, cac truong chuoi tro thang vao log da mmap.
+    MonotonicArena arena;
+    ArenaVector<TransactionView> transactions{ArenaAllocator<TransactionView>(arena)};
+    LogScanner scanner;
+    if (!scanner.collect(nullptr, transactions) || scanner.size() == 0) {
+        std::cout << "Chua co giao dich nao trong he thong." << std::endl;
+        return;
+    }
+
+    for (const TransactionView& transaction : transactions) {
+        printTransaction(transaction);
+    }
 
-    if (lines.empty()) {
+    if (transactions.empty()) {
+        std::cout << "Khong co giao dich nao." << std::endl;
+    }
+    std::cout << "------------------------------------" << std::endl;
+}
+
+// Ham thong ke giao dich tren toan bo log (admin)
+void adminViewTransactionStats() {
+    std::cout << "\n--- Thong ke giao dich ---" << std::endl;
+    TransactionLogWriter::instance().flush();
+    auto startTime = std::chrono::steady_clock::now();
+    LogScanner::Aggregates stats;
+    LogScanner scanner;
+    if (!scanner.aggregate(stats) || stats.transactions == 0) {
         std::cout << "Chua co giao dich nao trong he thong." << std::endl;
         return;
     }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(2);
+    out << "Tong so giao dich: " << stats.transactions << " (that bai: " << stats.failed
+        << ", dong loi: " << stats.malformed << ")" << std::endl;
+    out << "Tong diem da chuyen: " << stats.volume << std::endl;
+
+    out << "\nTheo ngay (ngay | so diem | thanh cong | that bai):" << std::endl;
+    for (const auto& entry : stats.perDay) {
+        out << LogScanner::dayToString(entry.first) << " | " << entry.second.volume << " | "
+            << entry.second.completed << " | " << entry.second.failed << std::endl;
+    }
 
-    for (const std::string& line : lines) {
-        Transaction* transaction = Transaction::fromString(line);
-        if (transaction) {
-            std::cout << "------------------------------------" << std::endl;
-            std::cout << "ID Giao dich: " << transaction->transactionId << std::endl;
-            std::cout << "Tu vi: " << transaction->senderWalletId << std::endl;
-            std::cout << "Den vi: " << transaction->receiverWalletId << std::endl;
-            std::cout << "So diem: " << std::fixed << std::setprecision(2) << transaction->amount << std::endl;
-            std::cout << "Thoi gian: " << Utils::timeToString(transaction->timestamp) << std::endl;
-            std::cout << "Trang thai: " << transaction->status << std::endl;
-            std::cout << "Mo ta: " << transaction->description << std::endl;
-            foundTransactions = true;
-            delete transaction; // Giai phong bo nho cho Transaction*
+    // Cac vi co tong diem gui + nhan lon nhat
+    const std::size_t TOP_WALLETS = 10;
+    std::vector<std::pair<IdHandle, LogScanner::WalletTotals> > wallets(stats.perWallet.begin(), stats.perWallet.end());
+    std::size_t shown = std::min(TOP_WALLETS, wallets.size());
+    std::partial_sort(wallets.begin(), wallets.begin() + shown, wallets.end(),
+                      [](const std::pair<IdHandle, LogScanner::WalletTotals>& a,
+                         const std::pair<IdHandle, LogScanner::WalletTotals>& b) {
+                          return a.second.sent + a.second.received > b.second.sent + b.second.received;
+                      });
+    out << "\nTop " << shown << " vi theo tong diem (vi | da gui | da nhan | so giao dich):" << std::endl;
+    for (std::size_t i = 0; i < shown; ++i) {
+        out << idToString(wallets[i].first) << " | " << wallets[i].second.sent << " | " << wallets[i].second.received
+            << " | " << wallets[i].second.transactions << std::endl;
+    }
+    out << std::setprecision(3) << "\n(Quet " << scanner.chunkCount() << " doan tren "
+        << TaskScheduler::instance().workerCount() << " worker trong " << seconds << " giay)" << std::endl;
+    std::cout << out.str() << "------------------------------------" << std::endl;
+}
+
+// Cap nhat ban xuat dang cot (tang dan hoac toan bo) va in bao cao tu du lieu cot
+bool runAnalyticsExport(bool incremental) {
+    TransactionLogWriter::instance().flush();
+    std::string probe;
+    if (!FileIO::readRange("data/transactions.log", 0, 0, probe)) {
+        std::cout << "Chua co giao dich nao trong he thong." << std::endl;
+        return true;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+    ColumnStore store;
+    ColumnStore::ExportReport exported;
+    if (!store.exportFrom("data/transactions.log", incremental, exported) || !store.open()) {
+        std::cout << "Khong the xuat du lieu phan tich." << std::endl;
+        return false;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << (exported.rebuilt ? "Da xuat lai toan bo: " : "Da cap nhat: ") << exported.appendedRows
+        << " dong moi, tong " << exported.totalRows << " dong, " << exported.blocks << " khoi, "
+        << exported.walletIds << " ma vi (" << seconds << " giay)." << std::endl;
+
+    out << std::setprecision(2);
+    out << "\nTheo ngay (ngay | so diem | thanh cong | that bai):" << std::endl;
+    const time_t allTime = std::numeric_limits<time_t>::max();
+    for (const ColumnStore::DailyVolume& day : store.dailyVolumes(0, allTime)) {
+        out << LogScanner::dayToString(day.day) << " | " << day.cents / 100.0 << " | "
+            << day.completed << " | " << day.failed << std::endl;
+    }
+    out << "\nTop 10 vi gui nhieu diem nhat (vi | so diem | so giao dich):" << std::endl;
+    for (const ColumnStore::SenderVolume& sender : store.topSenders(10, 0, allTime)) {
+        out << sender.walletId << " | " << sender.cents / 100.0 << " | " << sender.transactions << std::endl;
+    }
+    std::cout << out.str() << "------------------------------------" << std::endl;
+    return true;
+}
+
+// Nhap tai khoan hang loat va in tom tat (dung chung cho --import-users va menu admin)
+bool runUserImport(const std::string& path) {
+    UserImporter importer;
+    UserImporter::ImportReport report;
+    bool ok = importer.run(path, UserImporter::Format::Auto, report);
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    if (report.resumedFromLine > 0) {
+        out << "Tiep tuc lan nhap truoc tu dong " << report.resumedFromLine << "." << std::endl;
+    }
+    out << "Da xu ly " << report.rows << " dong trong " << report.batches << " lo (" << report.seconds << " giay): "
+        << report.imported << " tai khoan moi, " << report.alreadyImported << " da co tu truoc, "
+        << report.failed << " dong loi." << std::endl;
+    if (report.failed > 0) {
+        out << "Chi tiet loi: " << UserImporter::errorReportPath(path) << std::endl;
+    }
+    if (report.generatedPasswords > 0) {
+        out << report.generatedPasswords << " mat khau tu sinh duoc ghi vao " << UserImporter::passwordsPath(path)
+            << " (hay gui cho nguoi dung roi xoa file)." << std::endl;
+    }
+    if (!ok) {
+        out << "Nhap chua hoan tat. Chay lai voi cung file de tiep tuc." << std::endl;
+    }
+    std::cout << out.str();
+    return ok;
+}
+
+// Ham nhap tai khoan hang loat tu file CSV/JSONL (admin)
+void adminImportUsers() {
+    std::string path;
+    std::cout << "\n--- Nhap tai khoan hang loat ---" << std::endl;
+    std::cout << "Nhap duong dan file (.csv hoac .jsonl): ";
+    std::getline(std::cin, path);
+    path = Utils::trimString(path);
+    if (path.empty()) {
+        std::cout << "Chua nhap duong dan file." << std::endl;
+        return;
+    }
+    runUserImport(path);
+}
+
+// Tao ban sao luu va in tom tat (dung chung cho --backup va menu admin)
+bool runBackup(bool full) {
+    BackupManager::SnapshotReport report;
+    if (!BackupManager::instance().createSnapshot(full, report)) {
+        std::cout << "Sao luu that bai." << std::endl;
+        return false;
+    }
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "Da tao ban sao luu " << report.entry.id
+        << (report.entry.parent.empty() ? " (day du)" : " (tang dan tu " + report.entry.parent + ")") << ": "
+        << report.entry.files << " file, " << report.logBytes << " byte log, " << report.copiedOnWrite
+        << " file giu ban cu khi bi ghi de. Chan giao dich " << report.pauseMs << " ms, tong "
+        << report.seconds << " giay." << std::endl;
+    std::cout << out.str();
+    return true;
+}
+
+// Chia data/ thanh phan vung (--migrate-shards=N) va in tom tat; chay truoc initializeSystem
+bool runShardMigration() {
+    LockManager& locks = LockManager::instance();
+    LockManager::Slot instances = LockManager::resource(LockManager::Resource::Instances);
+    if (!locks.acquire(instances, LockManager::Mode::Exclusive, false)) {
+        std::cerr << "Loi: Co tien trinh khac dang chay tren thu muc du lieu. Dung tat ca truoc khi phan vung." << std::endl;
+        return false;
+    }
+    // Hoan tat cac lan ghi do dang truoc khi di chuyen file
+    recoverFiles();
+    ShardLayout::MigrationReport report;
+    bool ok = ShardLayout::instance().migrate(migrateShardCount, shardDirs, report);
+    if (ok) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(3);
+        out << "Da chia du lieu thanh " << report.shards << " phan vung: " << report.users << " nguoi dung, "
+            << report.wallets << " vi trong " << report.seconds << " giay." << std::endl;
+        if (report.missingFiles > 0) {
+            out << "Bo qua " << report.missingFiles << " ID co trong index nhung khong co file." << std::endl;
         }
+        std::cout << out.str();
     }
+    std::remove(RUNNING_MARKER_FILE);
+    locks.release(instances);
+    return ok;
+}
 
-    if (!foundTransactions) {
-        std::cout << "Khong co giao dich nao." << std::endl;
+// In cac su kien cua luong thay doi ngay khi co (--tail-changes); luu vi tri sau moi lo da in
+void runChangeTail(const std::string& name) {
+    ChangeFeed::Subscriber subscriber(name);
+    std::cerr << "Dang doc data/changes.log tu vi tri " << subscriber.position() << " (nguoi doc " << name
+              << "). Nhan Ctrl+C de dung." << std::endl;
+    std::vector<ChangeFeed::Event> events;
+    for (;;) {
+        events.clear();
+        if (subscriber.poll(events, -1) == 0) continue;
+        std::string out;
+        for (const ChangeFeed::Event& event : events) {
+            out += std::to_string(event.offset) + "|" + std::to_string(event.timeMs) + "|" +
+                   static_cast<char>(event.kind) + "|" + event.key + "|" + event.payload + "\n";
+        }
+        std::cout << out << std::flush;
+        subscriber.commit();
     }
+}
+
+// Ham sao luu du lieu (admin)
+void adminBackupData() {
+    std::cout << "\n--- Sao luu du lieu ---" << std::endl;
+    std::vector<BackupManager::Entry> entries = BackupManager::instance().list();
+    std::size_t first = entries.size() > 5 ? entries.size() - 5 : 0;
+    for (std::size_t i = first; i < entries.size(); ++i) {
+        std::cout << entries[i].id << " | " << Utils::timeToString(entries[i].cutTime) << " | "
+                  << (entries[i].parent.empty() ? "day du" : "tang dan") << " | " << entries[i].files << " file"
+                  << std::endl;
+    }
+    if (entries.empty()) std::cout << "Chua co ban sao luu nao." << std::endl;
+    std::cout << "Tao ban sao luu day du? (y = day du, n = tang dan): ";
+    char fullChoice;
+    std::cin >> fullChoice;
+    clearInputBuffer();
+    runBackup(tolower(fullChoice) == 'y');
+}
+
+// Ham bao cao phan tich tu du lieu dang cot (admin)
+void adminViewAnalyticsReport() {
+    std::cout << "\n--- Bao cao phan tich (du lieu cot) ---" << std::endl;
+    runAnalyticsExport(true);
+}
+
+// Ham xem thong ke hoat dong cua bo lap lich va lop I/O (admin)
+void adminViewSystemStats() {
+    TaskScheduler::Stats scheduler = TaskScheduler::instance().getStats();
+    FileIO::Stats io = FileIO::getStats();
+    std::cout << "\n--- Thong ke he thong ---" << std::endl;
+    std::cout << "So worker: " << scheduler.workers << std::endl;
+    std::cout << "Cong viec dang cho: " << scheduler.queueDepth
+              << " (toi da " << scheduler.maxQueueDepth << ")" << std::endl;
+    std::cout << "Cong viec da nhan/da chay: " << scheduler.submitted << "/" << scheduler.executed << std::endl;
+    std::cout << "So lan danh cap cong viec: " << scheduler.steals << std::endl;
+    std::cout << "Cong viec bi huy: " << scheduler.cancelled << std::endl;
+    std::cout << "File I/O - mo: " << io.opens << ", tai su dung: " << io.cacheHits
+              << ", doc: " << io.reads << ", ghi: " << io.writes << ", them: " << io.appends
+              << ", sync: " << io.syncs << std::endl;
+
+    // Phan bo so du: quet cot so du cua bang vi trong bo nho (chi co khi warm-start)
+    WalletTable::Distribution wallets;
+    auto startTime = std::chrono::steady_clock::now();
+    if (DataIndex::instance().walletDistribution(wallets)) {
+        double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "So vi: " << wallets.wallets << " (so du bang 0: " << wallets.empty << ")" << std::endl;
+        out << "Tong diem dang luu hanh: " << wallets.total << std::endl;
+        out << "So du - nho nhat: " << wallets.min << ", lon nhat: " << wallets.max
+            << ", trung binh: " << wallets.mean << ", do lech chuan: " << wallets.stddev << std::endl;
+        out << std::setprecision(1) << "(Tinh trong " << micros << " micro giay)" << std::endl;
+        std::cout << out.str();
+    } else {
+        std::cout << "Thong ke so du chi co khi khoi dong voi --warm-start." << std::endl;
+    }
+
+    SupplyMonitor::Status supply = SupplyMonitor::instance().status();
+    if (supply.initialized) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "Tong cung ky vong: " << supply.expectedCents / 100.0 << " (" << supply.settledTransfers
+            << " giao dich tu khi khoi dong)" << std::endl;
+        if (supply.lastCheck != 0) {
+            out << "Kiem tra tong cung: " << supply.checks << " lan, lan cuoi " << Utils::timeToString(supply.lastCheck)
+                << (supply.observedCents == supply.expectedCents ? " - khop" : " - LECH")
+                << ", canh bao: " << supply.alarms << ", bo qua: " << supply.skipped << std::endl;
+        } else if (supply.skipped != 0) {
+            out << "Kiem tra tong cung: bo qua " << supply.skipped << " lan (tien trinh khac dang dung chung data/)"
+                << std::endl;
+        }
+        std::cout << out.str();
+    }
+
+    TransactionLogWriter::Stats log = TransactionLogWriter::instance().stats();
+    std::cout << "Ghi log giao dich: " << (log.running ? "bat dong bo" : "dong bo") << ", hang doi " << log.capacity
+              << " o (cao nhat " << log.highWater << "), da ghi " << log.written << "/" << log.enqueued
+              << " trong " << log.batches << " lan (lo lon nhat " << log.maxBatch << "), hang doi day "
+              << log.fullEvents << " lan, ghi truc tiep " << log.inlineWrites << std::endl;
+
+    LockManager::Stats locks = LockManager::instance().stats();
+    std::cout << "Khoa du lieu: " << (locks.shared ? "dung chung giua cac tien trinh" : "chi trong tien trinh")
+              << ", da khoa " << locks.acquired << " lan, cho thread khac " << locks.waitedInProcess
+              << ", cho tien trinh khac " << locks.waitedOnFile << std::endl;
+
+    std::cout << "Luong thay doi (changes.log): da ghi " << ChangeFeed::instance().publishedCount()
+              << " su kien" << std::endl;
+
+    TransferLimits::Stats limits = TransferLimits::instance().stats();
+    std::cout << "Han muc chuyen diem: " << limits.rules << " quy tac, dang dem " << limits.trackedWallets
+              << " vi, da kiem tra " << limits.checked << " lan, tu choi " << limits.rejected << std::endl;
+
+    HoldManager::Stats holds = HoldManager::instance().stats();
+    std::cout << "Giu cho chuyen diem: " << holds.active << " dang giu (" << holds.heldCents / 100.0 << " diem), da dat "
+              << holds.placed << ", commit " << holds.committed << ", huy " << holds.cancelled << ", het han "
+              << holds.expired << std::endl;
+
+    IdempotencyTable::Stats dedup = IdempotencyTable::instance().stats();
+    std::cout << "Ma yeu cau chuyen diem: " << dedup.entries << " dang nho (cua so " << dedup.windowSeconds
+              << " giay, dung lai tu log " << dedup.recovered << "), gui trung " << dedup.duplicates
+              << ", xung dot " << dedup.conflicts << ", het han " << dedup.expired << std::endl;
     std::cout << "------------------------------------" << std::endl;
 }
 
 
 // Menu cho nguoi dung quan ly
+// Cac muc cua menu quan ly va quyen can co (Access::POLICY)
+const MenuItem ADMIN_MENU[] = {
+    {1, "Xem thong tin ca nhan", Access::Permission::ViewOwnProfile},
+    {2, "Cap nhat thong tin ca nhan (cua chinh minh)", Access::Permission::UpdateOwnProfile},
+    {3, "Thay doi mat khau (cua chinh minh)", Access::Permission::ChangeOwnPassword},
+    {4, "Theo doi danh sach tat ca tai khoan", Access::Permission::ViewAllUsers},
+    {5, "Tao tai khoan moi", Access::Permission::CreateAccounts},
+    {6, "Dieu chinh thong tin tai khoan khac", Access::Permission::UpdateOtherAccounts},
+    {7, "Xem tat ca lich su giao dich", Access::Permission::ViewAllTransactions},
+    {8, "Xem thong ke he thong", Access::Permission::ViewSystemStats},
+    {9, "Thong ke giao dich (theo ngay, theo vi)", Access::Permission::ViewTransactionStats},
+    {10, "Bao cao phan tich (du lieu cot)", Access::Permission::ViewAnalytics},
+    {11, "Tim kiem tai khoan", Access::Permission::SearchUsers},
+    {12, "Nhap tai khoan hang loat (CSV/JSONL)", Access::Permission::ImportUsers},
+    {13, "Sao luu du lieu", Access::Permission::BackupData},
+};
+
 void adminUserMenu() {
     int choice;
     do {
-        std::cout << "\n--- Menu nguoi dung quan ly (" << currentUser->getUsername() << ") ---" << std::endl;
-        std::cout << "1. Xem thong tin ca nhan" << std::endl;
-        std::cout << "2. Cap nhat thong tin ca nhan (cua chinh minh)" << std::endl;
-        std::cout << "3. Thay doi mat khau (cua chinh minh)" << std::endl;
-        std::cout << "4. Theo doi danh sach tat ca tai khoan" << std::endl;
-        std::cout << "5. Tao tai khoan moi" << std::endl;
-        std::cout << "6. Dieu chinh thong tin tai khoan khac" << std::endl;
-        std::cout << "7. Xem tat ca lich su giao dich" << std::endl;
+        std::cout << "\n--- Menu nguoi dung quan ly (" << currentUser->getUsername() << ", "
+                  << currentUser->getUserType() << ") ---" << std::endl;
+        // Chi hien cac muc vai tro duoc phep; so thu tu giu nguyen giua cac vai tro
+        for (const MenuItem& item : ADMIN_MENU) {
+            if (currentUser->can(item.permission)) std::cout << item.choice << ". " << item.label << std::endl;
+        }
         std::cout << "0. Dang xuat" << std::endl;
         std::cout << "Nhap lua chon cua ban: ";
         std::cin >> choice;
         clearInputBuffer();
 
+        bool allowed = true;
+        for (const MenuItem& item : ADMIN_MENU) {
+            if (item.choice == choice) allowed = currentUser->can(item.permission);
+        }
+        if (!allowed) {
+            std::cout << "Tai khoan " << currentUser->getUserType() << " khong co quyen thuc hien chuc nang nay." << std::endl;
+            continue;
+        }
+
         switch (choice) {
             case 1: currentUser->displayUserInfo(); break;
             case 2: updateProfile(currentUser.get()); break; // Truyen raw pointer
@@ -595,6 +1190,12 @@ void adminUserMenu() {
             case 5: adminCreateNewAccount(); break;
             case 6: adminUpdateOtherAccount(); break;
             case 7: adminViewAllTransactions(); break;
+            case 8: adminViewSystemStats(); break;
+            case 9: adminViewTransactionStats(); break;
+            case 10: adminViewAnalyticsReport(); break;
+            case 11: adminSearchUsers(); break;
+            case 12: adminImportUsers(); break;
+            case 13: adminBackupData(); break;
             case 0:
                 std::cout << "Dang xuat thanh cong." << std::endl;
                 currentUser.reset(); // Giai phong unique_ptr
@@ -604,8 +1205,159 @@ void adminUserMenu() {
     } while (choice != 0);
 }
 
-int main() {
+// Dung cac thread nen va dong bo du lieu khi thoat binh thuong
+void shutdownSystem() {
+    HoldManager::instance().shutdown(); // Dung thread hen gio cua giu cho
+    TransactionLogWriter::instance().stop(); // Ghi het log giao dich con trong hang doi
+    TransferLimits::instance().shutdown(); // Luu bo dem han muc chuyen diem
+    SupplyMonitor::instance().shutdown(); // Dung kiem tra nen, luu tong cung ky vong
+    DataIndex::instance().shutdown(); // Ghi snapshot chi muc de lan sau khoi dong nhanh
+    FileIO::closeAll(); // Dong bo du lieu con cho va dong cac file dang mo
+    // Thoat binh thuong: lan sau khong can quet phuc hoi (chi tien trinh cuoi cung tren data/ xoa file danh dau)
+    LockManager& locks = LockManager::instance();
+    LockManager::Slot instances = LockManager::resource(LockManager::Resource::Instances);
+    locks.release(instances);
+    if (locks.acquire(instances, LockManager::Mode::Exclusive, false)) {
+        std::remove(RUNNING_MARKER_FILE);
+        locks.release(instances);
+    }
+}
+
+// Ham doc cac tuy chon dong lenh
+// --durability=none|datasync|batched : chinh sach dong bo du lieu xuong dia (mac dinh: none)
+// --warm-start                       : nap san tat ca chi muc vao bo nho khi khoi dong
+// --supply-check=N                   : kiem tra tong cung diem moi N giay (0 = tat)
+// --log-queue=N                      : so o cua hang doi ghi log giao dich (luy thua cua 2, mac dinh 4096)
+// --log-backpressure=block|inline    : khi hang doi day, cho hoac tu ghi truc tiep (mac dinh: block)
+// --log-ack=none|write|sync          : giao dich cho den khi log da ghi / da xuong dia (mac dinh: none)
+// --dedup-window=N                   : nho ma yeu cau chuyen diem trong N giay (mac dinh 86400)
+// --import-users=FILE                : nhap tai khoan hang loat tu file CSV/JSONL roi thoat
+// --backup / --backup=full           : tao ban sao luu tang dan / day du vao backups/ roi thoat
+// --restore=ID|latest                : khoi phuc data/ tu ban sao luu roi thoat (khi he thong dang dung)
+// --migrate-shards=N                 : chia data/ thanh N phan vung theo bam ID roi thoat (khi he thong dang dung)
+// --shard-dirs=P0,P1,...             : thu muc cua tung phan vung khi migrate (mac dinh data/shards/0..N-1)
+// --tail-changes=TEN                 : in cac su kien moi cua data/changes.log, tiep tuc tu vi tri da luu cua TEN
+void parseCommandLine(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--durability=none") {
+            FileIO::setDurability(FileIO::Durability::None);
+        } else if (arg == "--durability=datasync") {
+            FileIO::setDurability(FileIO::Durability::DataSync);
+        } else if (arg == "--durability=batched") {
+            FileIO::setDurability(FileIO::Durability::Batched);
+        } else if (arg == "--warm-start") {
+            warmStartEnabled = true;
+        } else if (arg.compare(0, 15, "--supply-check=") == 0 &&
+                   arg.size() > 15 && arg.find_first_not_of("0123456789", 15) == std::string::npos) {
+            supplyCheckSeconds = static_cast<unsigned int>(std::stoul(arg.substr(15)));
+        } else if (arg.compare(0, 12, "--log-queue=") == 0 &&
+                   arg.size() > 12 && arg.find_first_not_of("0123456789", 12) == std::string::npos) {
+            logQueueCapacity = static_cast<std::size_t>(std::stoul(arg.substr(12)));
+        } else if (arg.compare(0, 15, "--dedup-window=") == 0 &&
+                   arg.size() > 15 && arg.find_first_not_of("0123456789", 15) == std::string::npos) {
+            dedupWindowSeconds = static_cast<unsigned int>(std::stoul(arg.substr(15)));
+        } else if (arg == "--log-backpressure=block") {
+            logBackpressure = TransactionLogWriter::Backpressure::Block;
+        } else if (arg == "--log-backpressure=inline") {
+            logBackpressure = TransactionLogWriter::Backpressure::Inline;
+        } else if (arg == "--log-ack=none") {
+            logAck = TransactionLogWriter::Ack::None;
+        } else if (arg == "--log-ack=write") {
+            logAck = TransactionLogWriter::Ack::Written;
+        } else if (arg == "--log-ack=sync") {
+            logAck = TransactionLogWriter::Ack::Synced;
+        } else if (arg.compare(0, 15, "--import-users=") == 0 && arg.size() > 15) {
+            importUsersPath = arg.substr(15);
+        } else if (arg == "--backup") {
+            backupMode = 1;
+        } else if (arg == "--backup=full") {
+            backupMode = 2;
+        } else if (arg.compare(0, 10, "--restore=") == 0 && arg.size() > 10) {
+            restoreRequested = true;
+            restoreBackupId = arg.substr(10) == "latest" ? "" : arg.substr(10);
+        } else if (arg.compare(0, 17, "--migrate-shards=") == 0 &&
+                   arg.size() > 17 && arg.find_first_not_of("0123456789", 17) == std::string::npos) {
+            migrateShardCount = static_cast<std::size_t>(std::stoul(arg.substr(17)));
+        } else if (arg.compare(0, 13, "--shard-dirs=") == 0 && arg.size() > 13) {
+            std::string list = arg.substr(13);
+            std::size_t start = 0;
+            while (start <= list.size()) {
+                std::size_t comma = list.find(',', start);
+                if (comma == std::string::npos) comma = list.size();
+                shardDirs.push_back(list.substr(start, comma - start));
+                start = comma + 1;
+            }
+        } else if (arg.compare(0, 15, "--tail-changes=") == 0 && arg.size() > 15 &&
+                   arg.find_first_of("/\\", 15) == std::string::npos) {
+            tailConsumerName = arg.substr(15);
+        } else if (arg == "--export-analytics") {
+            analyticsExportMode = 1;
+        } else if (arg == "--export-analytics=full") {
+            analyticsExportMode = 2;
+        } else {
+            std::cerr << "Canh bao: Bo qua tuy chon khong hop le: " << arg << std::endl;
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    parseCommandLine(argc, argv);
+    if (analyticsExportMode != 0) {
+        // Che do chay theo lo cho nhom bao cao: xuat du lieu cot roi thoat
+        bool ok = runAnalyticsExport(analyticsExportMode == 1);
+        FileIO::closeAll();
+        return ok ? 0 : 1;
+    }
+    if (restoreRequested) {
+        // Khoi phuc truoc khi khoi tao: khong co gi dang mo trong data/
+        if (!LockManager::instance().acquire(LockManager::resource(LockManager::Resource::Instances),
+                                             LockManager::Mode::Exclusive, false)) {
+            std::cerr << "Loi: Co tien trinh khac dang chay tren thu muc du lieu. Dung tat ca truoc khi khoi phuc." << std::endl;
+            return 1;
+        }
+        BackupManager::RestoreReport report;
+        bool ok = BackupManager::instance().restore(restoreBackupId, report);
+        if (ok) {
+            std::ostringstream out;
+            out << std::fixed << std::setprecision(3);
+            out << "Da khoi phuc tu " << report.chainLength << " ban sao luu: " << report.files << " file, "
+                << report.logBytes << " byte log trong " << report.seconds << " giay." << std::endl;
+            if (!report.previousDataDir.empty()) {
+                out << "Du lieu cu duoc giu o " << report.previousDataDir << std::endl;
+            }
+            if (report.previousShards > 1) {
+                out << "Du lieu cu da phan vung (" << report.previousShards << " phan vung); du lieu khoi phuc o bo cuc "
+                    << "phang. Chay --migrate-shards=" << report.previousShards << " de phan vung lai." << std::endl;
+            }
+            std::cout << out.str();
+        }
+        FileIO::closeAll();
+        return ok ? 0 : 1;
+    }
+    if (!tailConsumerName.empty()) {
+        // Nguoi doc ben ngoai: khong khoi tao he thong, chi doc changes.log (chay den khi bi dung)
+        runChangeTail(tailConsumerName);
+        FileIO::closeAll();
+        return 0;
+    }
+    if (migrateShardCount != 0) {
+        bool ok = runShardMigration();
+        FileIO::closeAll();
+        return ok ? 0 : 1;
+    }
     initializeSystem(); // Khoi tao he thong
+    if (backupMode != 0) {
+        bool ok = runBackup(backupMode == 2);
+        shutdownSystem();
+        return ok ? 0 : 1;
+    }
+    if (!importUsersPath.empty()) {
+        // Che do chay theo lo: nhap tai khoan roi thoat
+        bool ok = runUserImport(importUsersPath);
+        shutdownSystem();
+        return ok ? 0 : 1;
+    }
 
     int choice;
     do {
@@ -623,10 +1375,10 @@ int main() {
                 break;
             case 2:
                 if (login()) {
-                    if (currentUser->getUserType() == "normal") {
-                        normalUserMenu();
-                    } else if (currentUser->getUserType() == "admin") {
+                    if (currentUser->can(Access::Permission::AdminConsole)) {
                         adminUserMenu();
+                    } else {
+                        normalUserMenu();
                     }
                 }
                 break;
@@ -639,6 +1391,7 @@ int main() {
         }
     } while (choice != 0);
 
+    shutdownSystem();
     return 0;
 }
 
@@ -0,0 +1,227 @@
+// scheduler.cpp
+#include "scheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+
+namespace {
+    // Worker hien tai cua thread dang chay (-1 neu khong phai thread cua pool)
+    thread_local TaskScheduler* currentScheduler = nullptr;
+    thread_local int currentWorker = -1;
+}
+
+TaskScheduler::TaskScheduler()
+    : stopping(false), queued(0), maxQueued(0), nextWorker(0),
+      submittedCount(0), executedCount(0), stealCount(0), cancelledCount(0) {
+    unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < count; ++i) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (unsigned int i = 0; i < count; ++i) {
+        threads.push_back(std::thread(&TaskScheduler::workerLoop, this, static_cast<int>(i)));
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+TaskScheduler& TaskScheduler::instance() {
+    static TaskScheduler scheduler;
+    return scheduler;
+}
+
+unsigned int TaskScheduler::workerCount() const {
+    return static_cast<unsigned int>(workers.size());
+}
+
+TaskScheduler::Stats TaskScheduler::getStats() const {
+    Stats stats;
+    stats.workers = workerCount();
+    stats.queueDepth = queued.load();
+    stats.maxQueueDepth = maxQueued.load();
+    stats.submitted = submittedCount.load();
+    stats.executed = executedCount.load();
+    stats.steals = stealCount.load();
+    stats.cancelled = cancelledCount.load();
+    return stats;
+}
+
+void TaskScheduler::submit(std::function<void()> task) {
+    push([task]() {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "Loi: Cong viec nen that bai: " << e.what() << std::endl;
+        } catch (...) {
+            std::cerr << "Loi: Cong viec nen that bai." << std::endl;
+        }
+    });
+}
+
+bool TaskScheduler::parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                                const std::function<void(std::size_t, std::size_t)>& body) {
+    TaskGroup group(*this);
+    return group.parallelFor(begin, end, grain, body);
+}
+
+void TaskScheduler::push(std::function<void()> task, const TaskGroup* group) {
+    // Cong viec sinh ra tu mot worker vao hang doi cua chinh worker do (giu du lieu nong trong cache),
+    // cong viec tu ben ngoai duoc chia vong tron cho cac worker
+    int target = (currentScheduler == this) ? currentWorker
+                                            : static_cast<int>(nextWorker++ % workers.size());
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(Task{std::move(task), group});
+    }
+    std::size_t depth = ++queued;
+    std::size_t seen = maxQueued.load();
+    while (depth > seen && !maxQueued.compare_exchange_weak(seen, depth)) {}
+    submittedCount++;
+
+    { std::lock_guard<std::mutex> lock(idleMutex); }
+    idle.notify_one();
+}
+
+bool TaskScheduler::popLocal(int index, std::function<void()>& task, const TaskGroup* only) {
+    Worker& worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    // Tu cuoi hang doi: cong viec moi nhat (hoac moi nhat cua nhom 'only')
+    for (auto it = worker.tasks.rbegin(); it != worker.tasks.rend(); ++it) {
+        if (only && it->group != only) continue;
+        task = std::move(it->body);
+        worker.tasks.erase(std::next(it).base());
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+bool TaskScheduler::steal(int thief, std::function<void()>& task, const TaskGroup* only) {
+    std::size_t count = workers.size();
+    std::size_t start = thief < 0 ? 0 : static_cast<std::size_t>(thief) + 1;
+    for (std::size_t k = 0; k < count; ++k) {
+        std::size_t victim = (start + k) % count;
+        if (static_cast<int>(victim) == thief) continue;
+        Worker& worker = *workers[victim];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        // Lay tu dau doi dien voi chu hang doi
+        for (auto it = worker.tasks.begin(); it != worker.tasks.end(); ++it) {
+            if (only && it->group != only) continue;
+            task = std::move(it->body);
+            worker.tasks.erase(it);
+            queued--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::tryRunOne(const TaskGroup* only) {
+    int self = (currentScheduler == this) ? currentWorker : -1;
+    std::function<void()> task;
+    if (self >= 0 && popLocal(self, task, only)) {
+        // Lay tu hang doi cua minh
+    } else if (steal(self, task, only)) {
+        stealCount++;
+    } else {
+        return false;
+    }
+    task();
+    executedCount++;
+    return true;
+}
+
+void TaskScheduler::workerLoop(int index) {
+    currentScheduler = this;
+    currentWorker = index;
+    while (true) {
+        if (tryRunOne()) continue;
+        std::unique_lock<std::mutex> lock(idleMutex);
+        idle.wait(lock, [this]() { return queued.load() > 0 || stopping.load(); });
+        if (stopping && queued.load() == 0) break;
+    }
+}
+
+TaskGroup::TaskGroup(TaskScheduler& scheduler) : scheduler(scheduler), pending(0), cancelled(false) {}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // Ngoai le chua duoc lay ra bang wait() bi bo qua
+    }
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    pending++;
+    scheduler.push([this, task]() {
+        if (cancelled) {
+            scheduler.cancelledCount++;
+        } else {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+                cancelled = true; // Mot cong viec loi: bo qua phan con lai cua nhom
+            }
+        }
+        finishOne();
+    }, this);
+}
+
+void TaskGroup::finishOne() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--pending == 0) {
+        done.notify_all();
+    }
+}
+
+bool TaskGroup::parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                            const std::function<void(std::size_t, std::size_t)>& body) {
+    if (grain == 0) {
+        std::size_t chunks = static_cast<std::size_t>(scheduler.workerCount()) * 4;
+        grain = std::max<std::size_t>(1, (end > begin ? end - begin : 0) / chunks);
+    }
+    for (std::size_t chunkBegin = begin; chunkBegin < end; chunkBegin += grain) {
+        std::size_t chunkEnd = std::min(end, chunkBegin + grain);
+        run([&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); });
+    }
+    wait();
+    return !isCancelled();
+}
+
+void TaskGroup::wait() {
+    while (pending.load() > 0) {
+        if (scheduler.tryRunOne(this)) continue; // Chi cong viec cua nhom nay
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return pending.load() == 0; });
+    }
+    // Lay mutex lan cuoi de chac chan finishOne() cua cong viec cuoi cung da tra mutex
+    std::exception_ptr failure;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        failure = error;
+        error = nullptr;
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void TaskGroup::cancel() {
+    cancelled = true;
+}
+
+bool TaskGroup::isCancelled() const {
+    return cancelled.load();
+}
@@ -0,0 +1,126 @@
+// scheduler.h
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class TaskGroup;
+
+// Bo lap lich cong viec dung chung cho moi phan xu ly song song cua he thong
+// (nap chi muc, quet log, duyet danh sach tai khoan, ...), thay cho viec tu tao std::thread.
+// - Moi worker co mot hang doi hai dau (deque) rieng: worker lay viec o cuoi hang doi cua minh,
+//   khi het viec thi "danh cap" (steal) viec o dau hang doi cua worker khac
+// - Cong viec duoc gom theo TaskGroup de cho ket thuc, huy va nhan lai ngoai le
+// - Thread dang cho mot TaskGroup se giup chay cac cong viec con cua chinh nhom do trong hang doi
+//   (khong bi treo khi goi long nhau tu ben trong mot worker). Khong chay cong viec cua nhom khac hay
+//   submit(): nguoi cho co the dang giu khoa ma cong viec la can.
+class TaskScheduler {
+public:
+    // Thong ke hoat dong
+    struct Stats {
+        unsigned int workers;
+        std::size_t queueDepth;            // So cong viec dang cho trong tat ca hang doi
+        std::size_t maxQueueDepth;         // Do sau lon nhat tung ghi nhan
+        unsigned long long submitted;
+        unsigned long long executed;
+        unsigned long long steals;         // So cong viec lay tu hang doi cua worker khac
+        unsigned long long cancelled;      // So cong viec bi bo qua do nhom da bi huy
+    };
+
+    static TaskScheduler& instance();
+
+    // Dua mot cong viec doc lap vao hang doi (khong cho ket qua)
+    void submit(std::function<void()> task);
+
+    // Chia [begin, end) thanh cac doan 'grain' phan tu va chay song song, cho den khi xong.
+    // grain = 0: tu chon theo so worker. Tra ve false neu bi huy giua chung.
+    bool parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& body);
+
+    unsigned int workerCount() const;
+    Stats getStats() const;
+
+private:
+    friend class TaskGroup;
+
+    struct Task {
+        std::function<void()> body;
+        const TaskGroup* group;     // nullptr: submit()
+    };
+
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    TaskScheduler();
+    ~TaskScheduler();
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void push(std::function<void()> task, const TaskGroup* group = nullptr);
+    // Lay va chay mot cong viec (cua minh hoac danh cap); 'only' != nullptr: chi cong viec cua nhom do.
+    // false neu khong co
+    bool tryRunOne(const TaskGroup* only = nullptr);
+    bool popLocal(int index, std::function<void()>& task, const TaskGroup* only);
+    bool steal(int thief, std::function<void()>& task, const TaskGroup* only);
+    void workerLoop(int index);
+
+    std::vector<std::unique_ptr<Worker> > workers;
+    std::vector<std::thread> threads;
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    std::atomic<bool> stopping;
+    std::atomic<std::size_t> queued;
+    std::atomic<std::size_t> maxQueued;
+    std::atomic<unsigned int> nextWorker;   // Phan phoi vong tron cho cong viec den tu ngoai pool
+    std::atomic<unsigned long long> submittedCount;
+    std::atomic<unsigned long long> executedCount;
+    std::atomic<unsigned long long> stealCount;
+    std::atomic<unsigned long long> cancelledCount;
+};
+
+// Nhom cong viec: cho tat ca ket thuc, huy cac cong viec chua chay,
+// nem lai ngoai le dau tien (neu co) trong wait().
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskScheduler& scheduler = TaskScheduler::instance());
+    ~TaskGroup(); // Cho cac cong viec con lai (khong nem ngoai le)
+
+    void run(std::function<void()> task);
+
+    // Nhu TaskScheduler::parallelFor nhung gan voi nhom nay (co the huy bang cancel())
+    bool parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& body);
+
+    // Cho tat ca cong viec cua nhom ket thuc (thread goi se giup chay cong viec cua nhom trong luc cho)
+    void wait();
+
+    // Cac cong viec chua bat dau se bi bo qua; cong viec dang chay co the kiem tra isCancelled()
+    void cancel();
+    bool isCancelled() const;
+
+private:
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void finishOne();
+
+    TaskScheduler& scheduler;
+    std::atomic<std::size_t> pending;
+    std::atomic<bool> cancelled;
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;
+};
+
+#endif // SCHEDULER_H
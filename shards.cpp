@@ -0,0 +1,283 @@
+// shards.cpp
+#include "shards.h"
+#include "fileio.h"
+#include "scheduler.h"
+#include "utils.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <unordered_set>
+
+namespace {
+    const char* const SHARDS_CONFIG_FILE = "data/shards.conf";
+    const char* const DEFAULT_SHARDS_DIR = "data/shards";
+    const char* const FLAT_ROOT = "data";
+    const std::size_t MAX_SHARDS = 1024;
+
+    bool pathExists(const std::string& path) {
+        long long size = 0;
+        time_t modified = 0;
+        return FileIO::fileStat(path, size, modified);
+    }
+
+    // Doc mot file index, bo dong trong va ID trung (index cu co the co dong lap)
+    std::vector<std::string> readIds(const std::string& path) {
+        std::vector<std::string> ids;
+        std::unordered_set<std::string> seen;
+        for (std::string& id : Utils::readAllLines(path)) {
+            if (!id.empty() && seen.insert(id).second) ids.push_back(std::move(id));
+        }
+        return ids;
+    }
+}
+
+ShardLayout::ShardLayout() {
+    load();
+}
+
+ShardLayout& ShardLayout::instance() {
+    static ShardLayout layout;
+    return layout;
+}
+
+bool ShardLayout::load() {
+    shardRoots.clear();
+    std::vector<std::string> lines;
+    if (!FileIO::readLines(SHARDS_CONFIG_FILE, lines)) {
+        return true; // Bo cuc phang
+    }
+    std::size_t shards = 0;
+    std::vector<std::string> roots;
+    for (const std::string& line : lines) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string key = line.substr(0, colon);
+        std::string value = line.substr(colon + 1);
+        if (key == "shards") {
+            shards = std::strtoul(value.c_str(), nullptr, 10);
+            if (shards == 0 || shards > MAX_SHARDS) break;
+            roots.assign(shards, std::string());
+        } else if (key.compare(0, 6, "shard.") == 0 && shards > 0) {
+            std::size_t shard = std::strtoul(key.c_str() + 6, nullptr, 10);
+            if (shard < shards) roots[shard] = value;
+        }
+    }
+    for (const std::string& root : roots) {
+        if (root.empty()) {
+            roots.clear();
+            break;
+        }
+    }
+    if (roots.empty()) {
+        // Khong doan bo cuc: doc/ghi sai phan vung con te hon dung lai
+        std::cerr << "Loi: " << SHARDS_CONFIG_FILE << " khong hop le (can 'shards:N' va 'shard.K:<thu muc>' cho moi K)." << std::endl;
+        std::abort();
+    }
+    shardRoots = roots;
+    return true;
+}
+
+const std::string& ShardLayout::root(std::size_t shard) const {
+    static const std::string flat = FLAT_ROOT;
+    return isSharded() ? shardRoots[shard] : flat;
+}
+
+std::size_t ShardLayout::shardOf(const std::string& id, std::size_t shards) {
+    if (shards <= 1) return 0;
+    // FNV-1a 64 bit: khong dung std::hash vi ket qua phai giong nhau giua cac trinh bien dich/ban build
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned char c : id) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return static_cast<std::size_t>(hash % shards);
+}
+
+void ShardLayout::createDirectories() const {
+    Utils::createDirectoryIfNotExists(FLAT_ROOT);
+    if (isSharded()) Utils::createDirectoryIfNotExists(DEFAULT_SHARDS_DIR);
+    for (std::size_t shard = 0; shard < count(); ++shard) {
+        Utils::createDirectoryIfNotExists(root(shard));
+        Utils::createDirectoryIfNotExists(userDir(shard));
+        Utils::createDirectoryIfNotExists(walletDir(shard));
+    }
+}
+
+void ShardLayout::forEachShard(const std::function<void(std::size_t)>& task) const {
+    if (count() == 1) {
+        task(0);
+        return;
+    }
+    TaskScheduler::instance().parallelFor(0, count(), 1, [&task](std::size_t begin, std::size_t end) {
+        for (std::size_t shard = begin; shard < end; ++shard) task(shard);
+    });
+}
+
+std::vector<std::string> ShardLayout::allUsernames() const {
+    if (!isSharded()) return Utils::readAllLines(userIndexFile(0));
+    std::vector<std::vector<std::string> > perShard(count());
+    forEachShard([&](std::size_t shard) { perShard[shard] = Utils::readAllLines(userIndexFile(shard)); });
+    std::vector<std::string> all;
+    for (std::vector<std::string>& ids : perShard) all.insert(all.end(), ids.begin(), ids.end());
+    return all;
+}
+
+std::vector<std::string> ShardLayout::allWalletIds() const {
+    if (!isSharded()) return Utils::readAllLines(walletIndexFile(0));
+    std::vector<std::vector<std::string> > perShard(count());
+    forEachShard([&](std::size_t shard) { perShard[shard] = Utils::readAllLines(walletIndexFile(shard)); });
+    std::vector<std::string> all;
+    for (std::vector<std::string>& ids : perShard) all.insert(all.end(), ids.begin(), ids.end());
+    return all;
+}
+
+void ShardLayout::removeFlatFiles(const std::vector<std::string>& usernames,
+                                  const std::vector<std::string>& walletIds) const {
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    scheduler.parallelFor(0, usernames.size(), 0, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            std::remove((std::string(FLAT_ROOT) + "/users/" + usernames[i] + ".txt").c_str());
+        }
+    });
+    scheduler.parallelFor(0, walletIds.size(), 0, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            std::remove((std::string(FLAT_ROOT) + "/wallets/" + walletIds[i] + ".txt").c_str());
+        }
+    });
+    // Index xoa sau cung: con index phang nghia la viec don dep chua xong
+    std::string userIndex = std::string(FLAT_ROOT) + "/user_index.txt";
+    std::string walletIndex = std::string(FLAT_ROOT) + "/wallet_index.txt";
+    FileIO::invalidate(userIndex);
+    FileIO::invalidate(walletIndex);
+    std::remove(userIndex.c_str());
+    std::remove(walletIndex.c_str());
+    // Thu muc phang rong thi xoa luon (con file la: khong xoa, vi du *.corrupt can xem lai)
+    std::remove((std::string(FLAT_ROOT) + "/users").c_str());
+    std::remove((std::string(FLAT_ROOT) + "/wallets").c_str());
+}
+
+bool ShardLayout::migrate(std::size_t shards, std::vector<std::string> roots, MigrationReport& report) {
+    auto startTime = std::chrono::steady_clock::now();
+    report = MigrationReport{0, 0, 0, 0, 0.0};
+    std::string flatUserIndex = std::string(FLAT_ROOT) + "/user_index.txt";
+    std::string flatWalletIndex = std::string(FLAT_ROOT) + "/wallet_index.txt";
+    std::vector<std::string> usernames = readIds(flatUserIndex);
+    std::vector<std::string> walletIds = readIds(flatWalletIndex);
+
+    if (isSharded()) {
+        if (!pathExists(flatUserIndex) && !pathExists(flatWalletIndex)) {
+            std::cerr << "Loi: Du lieu da duoc phan vung (" << count() << " phan vung)." << std::endl;
+            return false;
+        }
+        // Lan truoc bi ngat sau diem commit: chi con file phang can xoa
+        removeFlatFiles(usernames, walletIds);
+        report.shards = count();
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        return true;
+    }
+    if (shards < 2 || shards > MAX_SHARDS) {
+        std::cerr << "Loi: So phan vung phai tu 2 den " << MAX_SHARDS << "." << std::endl;
+        return false;
+    }
+    if (roots.empty()) {
+        for (std::size_t shard = 0; shard < shards; ++shard) {
+            roots.push_back(std::string(DEFAULT_SHARDS_DIR) + "/" + std::to_string(shard));
+        }
+    }
+    if (roots.size() != shards) {
+        std::cerr << "Loi: Can dung " << shards << " thu muc phan vung (co " << roots.size() << ")." << std::endl;
+        return false;
+    }
+
+    Utils::createDirectoryIfNotExists(FLAT_ROOT);
+    Utils::createDirectoryIfNotExists(DEFAULT_SHARDS_DIR);
+    for (const std::string& root : roots) {
+        Utils::createDirectoryIfNotExists(root);
+        Utils::createDirectoryIfNotExists(root + "/users");
+        Utils::createDirectoryIfNotExists(root + "/wallets");
+        if (!pathExists(root + "/users") || !pathExists(root + "/wallets")) {
+            std::cerr << "Loi: Khong tao duoc thu muc phan vung " << root << " (thu muc cha phai ton tai)." << std::endl;
+            return false;
+        }
+    }
+
+    std::vector<std::vector<std::string> > usersOf(shards), walletsOf(shards);
+    for (const std::string& username : usernames) usersOf[shardOf(username, shards)].push_back(username);
+    for (const std::string& walletId : walletIds) walletsOf[shardOf(walletId, shards)].push_back(walletId);
+
+    // Moi phan vung mot tac vu: link file roi ghi index cua phan vung
+    std::atomic<std::size_t> movedUsers(0), movedWallets(0), missing(0);
+    std::atomic<bool> failed(false);
+    auto moveAll = [&](const std::vector<std::string>& ids, const std::string& fromDir, const std::string& toDir,
+                       std::atomic<std::size_t>& moved) {
+        std::string index;
+        for (const std::string& id : ids) {
+            std::string target = toDir + "/" + id + ".txt";
+            std::remove(target.c_str()); // Con sot tu lan chay bi ngat
+            if (!FileIO::linkFile(fromDir + "/" + id + ".txt", target, true)) {
+                missing++;
+                continue;
+            }
+            index += id + "\n";
+            moved++;
+        }
+        return index;
+    };
+    TaskScheduler::instance().parallelFor(0, shards, 1, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t shard = begin; shard < end; ++shard) {
+            const std::string& root = roots[shard];
+            std::string userIndex = moveAll(usersOf[shard], std::string(FLAT_ROOT) + "/users", root + "/users", movedUsers);
+            std::string walletIndex = moveAll(walletsOf[shard], std::string(FLAT_ROOT) + "/wallets", root + "/wallets",
+                                              movedWallets);
+            // File (da fdatasync khi link/sao chep), index va cac muc thu muc phai xuong dia truoc diem
+            // commit bat ke chinh sach do ben: sau do file phang bi xoa
+            if (!FileIO::replaceFile(root + "/user_index.txt", userIndex) ||
+                !FileIO::replaceFile(root + "/wallet_index.txt", walletIndex) ||
+                !FileIO::syncFile(root + "/user_index.txt") || !FileIO::syncFile(root + "/wallet_index.txt") ||
+                !FileIO::syncDirectory(root + "/users") || !FileIO::syncDirectory(root + "/wallets") ||
+                !FileIO::syncDirectory(root)) {
+                failed = true;
+            }
+        }
+    });
+    // Thu muc goc cua phan vung co the vua duoc tao
+    std::set<std::string> parents;
+    for (const std::string& root : roots) {
+        std::size_t slash = root.find_last_of('/');
+        parents.insert(slash == std::string::npos ? "." : (slash == 0 ? "/" : root.substr(0, slash)));
+    }
+    for (const std::string& parent : parents) {
+        if (!FileIO::syncDirectory(parent)) failed = true;
+    }
+    if (failed) {
+        std::cerr << "Loi: Khong ghi duoc index hoac dong bo file cua phan vung. Du lieu phang chua bi thay doi." << std::endl;
+        return false;
+    }
+
+    // Diem commit: tu day moi doc/ghi di theo phan vung
+    std::string config = "shards:" + std::to_string(shards) + "\n";
+    for (std::size_t shard = 0; shard < shards; ++shard) {
+        config += "shard." + std::to_string(shard) + ":" + roots[shard] + "\n";
+    }
+    if (!FileIO::replaceFile(SHARDS_CONFIG_FILE, config)) {
+        std::cerr << "Loi: Khong ghi duoc " << SHARDS_CONFIG_FILE << ". Du lieu phang chua bi thay doi." << std::endl;
+        return false;
+    }
+    shardRoots = roots;
+    if (!FileIO::syncFile(SHARDS_CONFIG_FILE) || !FileIO::syncDirectory(FLAT_ROOT)) {
+        // Chua chac diem commit da xuong dia: giu file phang, lan chay lai se don
+        std::cerr << "Loi: Khong dong bo duoc " << SHARDS_CONFIG_FILE << ". Chay lai --migrate-shards de hoan tat." << std::endl;
+        return false;
+    }
+
+    removeFlatFiles(usernames, walletIds);
+    report.shards = shards;
+    report.users = movedUsers.load();
+    report.wallets = movedWallets.load();
+    report.missingFiles = missing.load();
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
@@ -0,0 +1,79 @@
+// shards.h
+#ifndef SHARDS_H
+#define SHARDS_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Bo cuc thu muc du lieu: phang (mac dinh) hoac phan vung theo bam ID.
+// - Phang: data/users/, data/wallets/, data/user_index.txt, data/wallet_index.txt (nhu truoc)
+// - Phan vung: data/shards.conf liet ke N thu muc goc (co the nam tren cac o dia/mount khac nhau),
+//   moi phan vung co users/, wallets/, user_index.txt, wallet_index.txt rieng. Nguoi dung thuoc
+//   phan vung FNV-1a(username) % N, vi thuoc phan vung FNV-1a(walletId) % N (on dinh giua cac ban build).
+// transactions.log, chi muc snapshot/delta, contact_index.txt, supply.txt van nam o data/.
+// Bo cuc duoc doc mot lan khi tao doi tuong; chi migrate() (chay khi he thong dung) thay doi no.
+class ShardLayout {
+public:
+    struct MigrationReport {
+        std::size_t shards;
+        std::size_t users;
+        std::size_t wallets;
+        std::size_t missingFiles;   // ID co trong index nhung khong co file (bo qua)
+        double seconds;
+    };
+
+    static ShardLayout& instance();
+
+    bool isSharded() const { return !shardRoots.empty(); }
+    std::size_t count() const { return isSharded() ? shardRoots.size() : 1; }
+    // Thu muc goc cua phan vung ("data" voi bo cuc phang)
+    const std::string& root(std::size_t shard) const;
+
+    std::size_t shardOf(const std::string& id) const { return shardOf(id, count()); }
+    static std::size_t shardOf(const std::string& id, std::size_t shards);
+
+    std::string userDir(std::size_t shard) const { return root(shard) + "/users"; }
+    std::string walletDir(std::size_t shard) const { return root(shard) + "/wallets"; }
+    std::string userIndexFile(std::size_t shard) const { return root(shard) + "/user_index.txt"; }
+    std::string walletIndexFile(std::size_t shard) const { return root(shard) + "/wallet_index.txt"; }
+
+    std::string userFile(const std::string& username) const {
+        return userDir(shardOf(username)) + "/" + username + ".txt";
+    }
+    std::string walletFile(const std::string& walletId) const {
+        return walletDir(shardOf(walletId)) + "/" + walletId + ".txt";
+    }
+
+    // Tao thu muc cua tat ca cac phan vung (neu chua co)
+    void createDirectories() const;
+
+    // Chay 'task(shard)' song song cho moi phan vung (TaskScheduler) va cho xong
+    void forEachShard(const std::function<void(std::size_t)>& task) const;
+
+    // Danh sach tat ca username/walletId (doc song song index cua cac phan vung, theo thu tu phan vung)
+    std::vector<std::string> allUsernames() const;
+    std::vector<std::string> allWalletIds() const;
+
+    // Chuyen bo cuc phang sang 'shards' phan vung (roots rong: data/shards/0..N-1). Goi khi khong co
+    // tien trinh nao khac dang chay. File duoc hard link (sao chep neu khac o dia) vao phan vung, index
+    // cua tung phan vung duoc ghi song song; data/shards.conf la diem commit, sau do moi xoa file cu.
+    // Moi file, index va thu muc phan vung duoc fsync truoc diem commit (bat ke chinh sach do ben).
+    // Chay lai sau khi bi ngat: truoc diem commit thi lam lai tu dau, sau diem commit thi chi don file cu.
+    bool migrate(std::size_t shards, std::vector<std::string> roots, MigrationReport& report);
+
+private:
+    ShardLayout();
+    ShardLayout(const ShardLayout&) = delete;
+    ShardLayout& operator=(const ShardLayout&) = delete;
+
+    // Doc data/shards.conf (khong co file: bo cuc phang)
+    bool load();
+    // Xoa file nguoi dung/vi va index cua bo cuc phang (sau khi da phan vung)
+    void removeFlatFiles(const std::vector<std::string>& usernames, const std::vector<std::string>& walletIds) const;
+
+    std::vector<std::string> shardRoots;   // Rong: bo cuc phang
+};
+
+#endif // SHARDS_H
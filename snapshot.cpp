@@ -0,0 +1,351 @@
+// snapshot.cpp
+#include "snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <cstddef> // offsetof
+#include <ctime>
+
+namespace {
+    const char SNAPSHOT_MAGIC[8] = {'H', 'T', 'Q', 'L', 'I', 'D', 'X', '1'};
+    const std::uint32_t SNAPSHOT_VERSION = 2;
+
+    enum Section { SECTION_USERS = 0, SECTION_WALLETS, SECTION_OWNERS, SECTION_TRANSACTIONS, SECTION_COUNT };
+
+    // Ham bam 64-bit xu ly 8 byte mot lan (FNV-1a bien the), du nhanh de kiem tra file lon
+    std::uint64_t checksum(const char* data, std::size_t length) {
+        const std::uint64_t prime = 1099511628211ULL;
+        std::uint64_t hash = 1469598103934665603ULL;
+        std::size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            hash ^= word;
+            hash *= prime;
+            hash ^= hash >> 29;
+        }
+        for (; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= prime;
+        }
+        return hash;
+    }
+
+    std::size_t align8(std::size_t n) {
+        return (n + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    int compareKey(const char* data, std::size_t length, const std::string& key) {
+        int c = std::memcmp(data, key.data(), std::min(length, key.size()));
+        if (c != 0) return c;
+        if (length < key.size()) return -1;
+        if (length > key.size()) return 1;
+        return 0;
+    }
+}
+
+struct IndexSnapshot::Header {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t deltaGeneration;
+    std::uint64_t createdAt;
+    std::uint64_t logOffset;
+    std::uint64_t fileSize;
+    std::uint64_t tableOffset[SECTION_COUNT];
+    std::uint64_t tableCount[SECTION_COUNT];
+    std::uint64_t balancesOffset;  // Cot so du cua bang wallets (tableCount[SECTION_WALLETS] phan tu)
+    std::uint64_t versionsOffset;
+    std::uint64_t refsOffset;
+    std::uint64_t refsCount;
+    std::uint64_t stringsOffset;
+    std::uint64_t stringsSize;
+    std::uint64_t bodyChecksum;   // Checksum moi byte sau header
+    std::uint64_t headerChecksum; // Checksum cac truong phia tren
+};
+
+struct IndexSnapshot::SnapshotEntry {
+    std::uint64_t keyOffset;   // Vi tri khoa trong vung chuoi
+    std::uint64_t valueOffset; // Vi tri gia tri trong vung chuoi, hoac chi so trong mang LogRef
+    std::uint32_t keyLength;
+    std::uint32_t valueLength; // So byte gia tri, hoac so LogRef
+};
+
+IndexSnapshot::IndexSnapshot() {}
+
+bool IndexSnapshot::write(const std::string& path, Contents& contents) {
+    auto byKey = [](const KeyValue& a, const KeyValue& b) { return a.key < b.key; };
+    std::sort(contents.users.begin(), contents.users.end(), byKey);
+    std::sort(contents.wallets.begin(), contents.wallets.end(),
+              [](const WalletRow& a, const WalletRow& b) { return a.walletId < b.walletId; });
+    std::sort(contents.owners.begin(), contents.owners.end(), byKey);
+    std::sort(contents.transactions.begin(), contents.transactions.end(),
+              [](const KeyRefs& a, const KeyRefs& b) { return a.key < b.key; });
+
+    // Dung vung chuoi va cac bang
+    std::string strings;
+    std::vector<SnapshotEntry> tables[SECTION_COUNT];
+    std::vector<LogRef> refs;
+    auto addEntry = [&strings](std::vector<SnapshotEntry>& table, const std::string& key, const std::string& value) {
+        SnapshotEntry entry;
+        entry.keyOffset = strings.size();
+        entry.keyLength = static_cast<std::uint32_t>(key.size());
+        strings += key;
+        entry.valueOffset = strings.size();
+        entry.valueLength = static_cast<std::uint32_t>(value.size());
+        strings += value;
+        table.push_back(entry);
+    };
+    tables[SECTION_USERS].reserve(contents.users.size());
+    for (const KeyValue& kv : contents.users) addEntry(tables[SECTION_USERS], kv.key, kv.value);
+    tables[SECTION_OWNERS].reserve(contents.owners.size());
+    for (const KeyValue& kv : contents.owners) addEntry(tables[SECTION_OWNERS], kv.key, kv.value);
+    std::vector<double> balances;
+    std::vector<std::uint64_t> versions;
+    tables[SECTION_WALLETS].reserve(contents.wallets.size());
+    balances.reserve(contents.wallets.size());
+    versions.reserve(contents.wallets.size());
+    for (const WalletRow& wallet : contents.wallets) {
+        addEntry(tables[SECTION_WALLETS], wallet.walletId, wallet.ownerUserId);
+        balances.push_back(wallet.balance);
+        versions.push_back(wallet.version);
+    }
+    tables[SECTION_TRANSACTIONS].reserve(contents.transactions.size());
+    for (const KeyRefs& kr : contents.transactions) {
+        SnapshotEntry entry;
+        entry.keyOffset = strings.size();
+        entry.keyLength = static_cast<std::uint32_t>(kr.key.size());
+        strings += kr.key;
+        entry.valueOffset = refs.size();
+        entry.valueLength = static_cast<std::uint32_t>(kr.refs.size());
+        refs.insert(refs.end(), kr.refs.begin(), kr.refs.end());
+        tables[SECTION_TRANSACTIONS].push_back(entry);
+    }
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.deltaGeneration = contents.deltaGeneration;
+    header.createdAt = static_cast<std::uint64_t>(time(0));
+    header.logOffset = contents.logOffset;
+
+    std::size_t offset = align8(sizeof(Header));
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        header.tableOffset[section] = offset;
+        header.tableCount[section] = tables[section].size();
+        offset += tables[section].size() * sizeof(SnapshotEntry);
+    }
+    header.balancesOffset = offset;
+    offset += balances.size() * sizeof(double);
+    header.versionsOffset = offset;
+    offset += versions.size() * sizeof(std::uint64_t);
+    header.refsOffset = offset;
+    header.refsCount = refs.size();
+    offset += refs.size() * sizeof(LogRef);
+    header.stringsOffset = offset;
+    header.stringsSize = strings.size();
+    offset += strings.size();
+    header.fileSize = offset;
+
+    std::string content(offset, '\0');
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        if (!tables[section].empty()) {
+            std::memcpy(&content[header.tableOffset[section]], tables[section].data(),
+                        tables[section].size() * sizeof(SnapshotEntry));
+        }
+    }
+    if (!balances.empty()) {
+        std::memcpy(&content[header.balancesOffset], balances.data(), balances.size() * sizeof(double));
+        std::memcpy(&content[header.versionsOffset], versions.data(), versions.size() * sizeof(std::uint64_t));
+    }
+    if (!refs.empty()) {
+        std::memcpy(&content[header.refsOffset], refs.data(), refs.size() * sizeof(LogRef));
+    }
+    if (!strings.empty()) {
+        std::memcpy(&content[header.stringsOffset], strings.data(), strings.size());
+    }
+    header.bodyChecksum = checksum(content.data() + sizeof(Header), content.size() - sizeof(Header));
+    header.headerChecksum = checksum(reinterpret_cast<const char*>(&header), offsetof(Header, headerChecksum));
+    std::memcpy(&content[0], &header, sizeof(Header));
+
+    return FileIO::replaceFile(path, content);
+}
+
+bool IndexSnapshot::open(const std::string& path) {
+    close();
+    std::unique_ptr<FileIO::MappedFile> mapped(new FileIO::MappedFile());
+    if (!mapped->open(path) || mapped->size() < sizeof(Header)) {
+        return false;
+    }
+    const Header* h = reinterpret_cast<const Header*>(mapped->data());
+    if (std::memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        h->version != SNAPSHOT_VERSION ||
+        h->fileSize != mapped->size() ||
+        h->headerChecksum != checksum(mapped->data(), offsetof(Header, headerChecksum))) {
+        return false;
+    }
+    // Kiem tra gioi han cac vung de tra cuu khong bao gio doc ra ngoai file
+    auto fits = [h](std::uint64_t offset, std::uint64_t count, std::size_t elementSize) {
+        return offset <= h->fileSize && count <= (h->fileSize - offset) / elementSize;
+    };
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        if (h->tableOffset[section] % 8 != 0 ||
+            !fits(h->tableOffset[section], h->tableCount[section], sizeof(SnapshotEntry))) {
+            return false;
+        }
+    }
+    std::uint64_t wallets = h->tableCount[SECTION_WALLETS];
+    if (h->balancesOffset % 8 != 0 || !fits(h->balancesOffset, wallets, sizeof(double)) ||
+        h->versionsOffset % 8 != 0 || !fits(h->versionsOffset, wallets, sizeof(std::uint64_t)) ||
+        !fits(h->refsOffset, h->refsCount, sizeof(LogRef)) || !fits(h->stringsOffset, h->stringsSize, 1)) {
+        return false;
+    }
+    // Tung muc: khoa/gia tri nam trong vung chuoi, day LogRef nam trong mang LogRef (chi doc cac bang,
+    // khong doc vung chuoi; noi dung con lai duoc kiem tra bang checksum o nen)
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        const SnapshotEntry* entries = reinterpret_cast<const SnapshotEntry*>(mapped->data() + h->tableOffset[section]);
+        std::uint64_t valueLimit = section == SECTION_TRANSACTIONS ? h->refsCount : h->stringsSize;
+        for (std::uint64_t i = 0; i < h->tableCount[section]; ++i) {
+            const SnapshotEntry& entry = entries[i];
+            if (entry.keyOffset > h->stringsSize || entry.keyLength > h->stringsSize - entry.keyOffset ||
+                entry.valueOffset > valueLimit || entry.valueLength > valueLimit - entry.valueOffset) {
+                return false;
+            }
+        }
+    }
+    file = std::move(mapped);
+    return true;
+}
+
+void IndexSnapshot::close() {
+    file.reset();
+}
+
+bool IndexSnapshot::isOpen() const {
+    return file != nullptr;
+}
+
+bool IndexSnapshot::verifyBody() const {
+    if (!file) return false;
+    return header()->bodyChecksum == checksum(file->data() + sizeof(Header), file->size() - sizeof(Header));
+}
+
+const IndexSnapshot::Header* IndexSnapshot::header() const {
+    return reinterpret_cast<const Header*>(file->data());
+}
+
+const IndexSnapshot::SnapshotEntry* IndexSnapshot::table(int section) const {
+    return reinterpret_cast<const SnapshotEntry*>(file->data() + header()->tableOffset[section]);
+}
+
+std::size_t IndexSnapshot::tableSize(int section) const {
+    return file ? static_cast<std::size_t>(header()->tableCount[section]) : 0;
+}
+
+const IndexSnapshot::SnapshotEntry* IndexSnapshot::find(int section, const std::string& key) const {
+    if (!file) return nullptr;
+    const SnapshotEntry* entries = table(section);
+    const char* strings = file->data() + header()->stringsOffset;
+    std::size_t lo = 0, hi = tableSize(section);
+    while (lo < hi) {
+        std::size_t mid = lo + (hi - lo) / 2;
+        int c = compareKey(strings + entries[mid].keyOffset, entries[mid].keyLength, key);
+        if (c == 0) return &entries[mid];
+        if (c < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return nullptr;
+}
+
+std::string IndexSnapshot::keyOf(const SnapshotEntry& entry) const {
+    return std::string(file->data() + header()->stringsOffset + entry.keyOffset, entry.keyLength);
+}
+
+std::string IndexSnapshot::valueOf(const SnapshotEntry& entry) const {
+    return std::string(file->data() + header()->stringsOffset + entry.valueOffset, entry.valueLength);
+}
+
+bool IndexSnapshot::findUser(const std::string& username, std::string& record) const {
+    const SnapshotEntry* entry = find(SECTION_USERS, username);
+    if (!entry) return false;
+    record = valueOf(*entry);
+    return true;
+}
+
+bool IndexSnapshot::findWallet(const std::string& walletId, std::size_t& index) const {
+    const SnapshotEntry* entry = find(SECTION_WALLETS, walletId);
+    if (!entry) return false;
+    index = static_cast<std::size_t>(entry - table(SECTION_WALLETS));
+    return true;
+}
+
+bool IndexSnapshot::findOwner(const std::string& ownerUserId, std::string& walletId) const {
+    const SnapshotEntry* entry = find(SECTION_OWNERS, ownerUserId);
+    if (!entry) return false;
+    walletId = valueOf(*entry);
+    return true;
+}
+
+bool IndexSnapshot::hasUser(const std::string& username) const {
+    return find(SECTION_USERS, username) != nullptr;
+}
+
+bool IndexSnapshot::hasWallet(const std::string& walletId) const {
+    return find(SECTION_WALLETS, walletId) != nullptr;
+}
+
+const IndexSnapshot::LogRef* IndexSnapshot::transactionsOf(const std::string& walletId, std::size_t& count) const {
+    const SnapshotEntry* entry = find(SECTION_TRANSACTIONS, walletId);
+    if (!entry || entry->valueOffset + entry->valueLength > header()->refsCount) {
+        count = 0;
+        return nullptr;
+    }
+    count = entry->valueLength;
+    return reinterpret_cast<const LogRef*>(file->data() + header()->refsOffset) + entry->valueOffset;
+}
+
+std::size_t IndexSnapshot::userCount() const { return tableSize(SECTION_USERS); }
+std::size_t IndexSnapshot::walletCount() const { return tableSize(SECTION_WALLETS); }
+std::size_t IndexSnapshot::ownerCount() const { return tableSize(SECTION_OWNERS); }
+std::size_t IndexSnapshot::transactionKeyCount() const { return tableSize(SECTION_TRANSACTIONS); }
+
+void IndexSnapshot::userAt(std::size_t i, std::string& key, std::string& value) const {
+    key = keyOf(table(SECTION_USERS)[i]);
+    value = valueOf(table(SECTION_USERS)[i]);
+}
+
+void IndexSnapshot::walletAt(std::size_t i, std::string& walletId, std::string& ownerUserId) const {
+    walletId = keyOf(table(SECTION_WALLETS)[i]);
+    ownerUserId = valueOf(table(SECTION_WALLETS)[i]);
+}
+
+std::string IndexSnapshot::walletOwnerAt(std::size_t i) const {
+    return valueOf(table(SECTION_WALLETS)[i]);
+}
+
+const double* IndexSnapshot::walletBalances() const {
+    return file ? reinterpret_cast<const double*>(file->data() + header()->balancesOffset) : nullptr;
+}
+
+const std::uint64_t* IndexSnapshot::walletVersions() const {
+    return file ? reinterpret_cast<const std::uint64_t*>(file->data() + header()->versionsOffset) : nullptr;
+}
+
+void IndexSnapshot::ownerAt(std::size_t i, std::string& key, std::string& value) const {
+    key = keyOf(table(SECTION_OWNERS)[i]);
+    value = valueOf(table(SECTION_OWNERS)[i]);
+}
+
+const IndexSnapshot::LogRef* IndexSnapshot::transactionsAt(std::size_t i, std::string& key, std::size_t& count) const {
+    const SnapshotEntry& entry = table(SECTION_TRANSACTIONS)[i];
+    key = keyOf(entry);
+    count = entry.valueLength;
+    return reinterpret_cast<const LogRef*>(file->data() + header()->refsOffset) + entry.valueOffset;
+}
+
+std::uint64_t IndexSnapshot::logOffset() const {
+    return file ? header()->logOffset : 0;
+}
+
+std::uint32_t IndexSnapshot::deltaGeneration() const {
+    return file ? header()->deltaGeneration : 0;
+}
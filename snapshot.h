@@ -0,0 +1,106 @@
+// snapshot.h
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "fileio.h"
+
+// File snapshot cua chi muc trong bo nho (data/index.snapshot).
+// Bo cuc nhi phan, co the mmap truc tiep:
+//   Header | bang users | bang wallets | bang owners | bang giao dich | cot so du | cot phien ban
+//   | mang LogRef | vung chuoi
+// Moi bang la mang SnapshotEntry sap xep theo khoa, tra cuu bang tim kiem nhi phan
+// ngay tren vung nho anh xa nen khoi dong khong can parse lai tung ban ghi. Gia tri cua bang wallets
+// la ID chu so huu; so du va phien ban cua vi thu i nam o phan tu thu i cua hai cot (double, uint64)
+// de bang vi trong bo nho duoc nap bang mot lan sao chep khoi.
+class IndexSnapshot {
+public:
+    // Vi tri mot ban ghi trong transactions.log (dung nhu trong file)
+    struct LogRef {
+        std::uint64_t offset;
+        std::uint32_t length;
+        std::uint32_t reserved;
+    };
+
+    // Du lieu dau vao khi ghi snapshot (khong can sap xep truoc)
+    struct KeyValue {
+        std::string key;
+        std::string value;
+    };
+    struct KeyRefs {
+        std::string key;
+        std::vector<LogRef> refs;
+    };
+    struct WalletRow {
+        std::string walletId;
+        std::string ownerUserId;
+        double balance;
+        std::uint64_t version;
+    };
+    struct Contents {
+        std::vector<KeyValue> users;   // username -> ban ghi User::toString()
+        std::vector<WalletRow> wallets; // walletId -> chu so huu, so du, phien ban
+        std::vector<KeyValue> owners;  // ownerUserId -> walletId
+        std::vector<KeyRefs> transactions; // walletId -> vi tri giao dich trong log
+        std::uint64_t logOffset;       // Kich thuoc transactions.log da duoc tinh vao snapshot
+        std::uint32_t deltaGeneration; // The he journal thay doi bat dau sau snapshot nay
+    };
+
+    IndexSnapshot();
+
+    // Ghi snapshot moi mot cach nguyen tu (sap xep 'contents' tai cho)
+    static bool write(const std::string& path, Contents& contents);
+
+    // Anh xa file snapshot va kiem tra header. Tra ve false neu khong co hoac khong hop le.
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const;
+
+    // Kiem tra checksum toan bo noi dung (doc het file, nen chay o thread nen)
+    bool verifyBody() const;
+
+    // Tra cuu tren vung nho anh xa
+    bool findUser(const std::string& username, std::string& record) const;
+    // Vi tri 'index' cua vi trong bang wallets (cung chi so voi cac cot so du / phien ban)
+    bool findWallet(const std::string& walletId, std::size_t& index) const;
+    bool findOwner(const std::string& ownerUserId, std::string& walletId) const;
+    bool hasUser(const std::string& username) const;
+    bool hasWallet(const std::string& walletId) const;
+    // Con tro toi mang LogRef cua mot vi (so phan tu tra ve qua 'count')
+    const LogRef* transactionsOf(const std::string& walletId, std::size_t& count) const;
+
+    // Duyet tuan tu (dung khi gop voi cac thay doi moi de ghi snapshot tiep theo)
+    std::size_t userCount() const;
+    std::size_t walletCount() const;
+    std::size_t ownerCount() const;
+    std::size_t transactionKeyCount() const;
+    void userAt(std::size_t i, std::string& key, std::string& value) const;
+    void walletAt(std::size_t i, std::string& walletId, std::string& ownerUserId) const;
+    std::string walletOwnerAt(std::size_t i) const;
+    // Cot so du / phien ban cua bang wallets (walletCount() phan tu)
+    const double* walletBalances() const;
+    const std::uint64_t* walletVersions() const;
+    void ownerAt(std::size_t i, std::string& key, std::string& value) const;
+    const LogRef* transactionsAt(std::size_t i, std::string& key, std::size_t& count) const;
+
+    std::uint64_t logOffset() const;
+    std::uint32_t deltaGeneration() const;
+
+private:
+    struct Header;
+    struct SnapshotEntry;
+
+    const Header* header() const;
+    const SnapshotEntry* table(int section) const;
+    std::size_t tableSize(int section) const;
+    const SnapshotEntry* find(int section, const std::string& key) const;
+    std::string keyOf(const SnapshotEntry& entry) const;
+    std::string valueOf(const SnapshotEntry& entry) const;
+
+    std::unique_ptr<FileIO::MappedFile> file;
+};
+
+#endif // SNAPSHOT_H
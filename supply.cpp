@@ -0,0 +1,202 @@
+// supply.cpp
+#include "supply.h"
+#include "dataindex.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include "scheduler.h"
+#include "shards.h"
+#include "wallet.h"
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+namespace {
+    const char* const SUPPLY_FILE = "data/supply.txt";
+    const char* const EXPECTED_KEY = "expectedCents:";
+
+    long long toCents(double amount) {
+        return std::llround(amount * 100.0);
+    }
+
+    std::string formatCents(long long cents) {
+        std::string sign = cents < 0 ? "-" : "";
+        long long value = cents < 0 ? -cents : cents;
+        std::string fraction = std::to_string(value % 100);
+        if (fraction.size() < 2) fraction = "0" + fraction;
+        return sign + std::to_string(value / 100) + "." + fraction;
+    }
+
+    // Tong so du doc tu file vi cua moi phan vung (khong co bang vi). false neu co file khong doc duoc.
+    bool sumWalletFiles(long long& totalCents) {
+        const ShardLayout& layout = ShardLayout::instance();
+        totalCents = 0;
+        for (std::size_t shard = 0; shard < layout.count(); ++shard) {
+            std::string dir = layout.walletDir(shard);
+            for (const std::string& name : FileIO::listDirectory(dir)) {
+                if (name.find(".tmp-") != std::string::npos) continue;
+                std::string content;
+                if (!FileIO::readFileOnce(dir + "/" + name, content)) return false;
+                std::unique_ptr<Wallet> wallet;
+                try {
+                    wallet.reset(Wallet::fromString(content));
+                } catch (const std::exception&) {
+                    wallet.reset();
+                }
+                if (!wallet) return false;
+                totalCents += toCents(wallet->balance);
+            }
+        }
+        return true;
+    }
+}
+
+SupplyMonitor::SettleGuard::SettleGuard() : lock(SupplyMonitor::instance().settleMutex) {}
+
+SupplyMonitor::SupplyMonitor()
+    : initialized(false), expectedCents(0), observedCents(0), settledTransfers(0), checks(0), alarms(0), skipped(0),
+      lastCheck(0), interval(0), verifying(false), lastScheduled(0) {}
+
+SupplyMonitor& SupplyMonitor::instance() {
+    static SupplyMonitor monitor;
+    return monitor;
+}
+
+void SupplyMonitor::initialize() {
+    std::string content;
+    if (FileIO::readFileOnce(SUPPLY_FILE, content)) {
+        std::size_t pos = content.find(EXPECTED_KEY);
+        if (pos != std::string::npos) {
+            try {
+                expectedCents = std::stoll(content.substr(pos + std::string(EXPECTED_KEY).size()));
+                initialized = true;
+            } catch (const std::exception&) {
+                std::cerr << "Canh bao: " << SUPPLY_FILE << " khong hop le, tinh lai tu bang vi." << std::endl;
+            }
+        }
+    }
+
+    double total = 0.0;
+    bool haveTable = DataIndex::instance().totalSupply(total);
+    if (!initialized && haveTable) {
+        // Lan dau: lay tong so du hien tai lam moc
+        expectedCents = toCents(total);
+        initialized = true;
+        save();
+    }
+    if (haveTable) {
+        verify();
+    }
+    // Khong co bang vi: tong cung duoc lay tu file vi o lan kiem tra dau tien (startVerifier)
+}
+
+void SupplyMonitor::mint(double amount) {
+    if (!initialized) return;
+    expectedCents += toCents(amount);
+    save();
+}
+
+void SupplyMonitor::recordTransfer(double senderBefore, double senderAfter, double receiverBefore, double receiverAfter) {
+    // Thay doi thuc cua hai vi (tong bang 0 neu khong co loi lam tron hay ghi sai)
+    expectedCents += (toCents(senderAfter) - toCents(senderBefore)) + (toCents(receiverAfter) - toCents(receiverBefore));
+    settledTransfers++;
+    maybeScheduleVerify(time(0));
+}
+
+bool SupplyMonitor::observe(long long& observed, long long& expected) {
+    std::size_t settledBefore;
+    {
+        // Doc quyen: khong giao dich nao dang o giua hai lan ghi vi
+        std::unique_lock<std::shared_timed_mutex> lock(settleMutex);
+        double total = 0.0;
+        if (DataIndex::instance().totalSupply(total)) {
+            observed = toCents(total);
+            if (!initialized) {
+                expectedCents = observed;
+                initialized = true;
+            }
+            expected = expectedCents;
+            return true;
+        }
+        settledBefore = settledTransfers;
+    }
+    // Quet file khong giu khoa (co the lau): chi dung khi khong giao dich nao hoan tat trong luc quet.
+    // Giao dich dang do o cuoi lan quet se hoan tat truoc khi khoa doc quyen duoi day lay duoc.
+    long long total = 0;
+    if (!sumWalletFiles(total)) return false;
+    std::unique_lock<std::shared_timed_mutex> lock(settleMutex);
+    if (settledTransfers != settledBefore) return false;
+    observed = total;
+    if (!initialized) {
+        expectedCents = observed;
+        initialized = true;
+    }
+    expected = expectedCents;
+    return true;
+}
+
+bool SupplyMonitor::verify() {
+    if (LockManager::instance().heldByOtherProcess(LockManager::resource(LockManager::Resource::Instances))) {
+        skipped++; // Bang vi/bo dem cua tien trinh nay khong phan anh giao dich cua tien trinh khac
+        return true;
+    }
+    bool wasInitialized = initialized;
+    long long observed = 0, expected = 0;
+    if (!observe(observed, expected)) {
+        skipped++;
+        return true;
+    }
+    if (!wasInitialized) save(); // Lan dau: tong hien tai lam moc
+    observedCents = observed;
+    checks++;
+    lastCheck = time(0);
+    if (observed == expected) {
+        return true;
+    }
+    alarms++;
+    std::cerr << "CANH BAO: Tong cung diem bi lech! Ky vong " << formatCents(expected) << ", tong so du cac vi "
+              << formatCents(observed) << " (lech " << formatCents(observed - expected) << ")." << std::endl;
+    return false;
+}
+
+void SupplyMonitor::startVerifier(unsigned int intervalSeconds) {
+    interval = intervalSeconds;
+    if (intervalSeconds == 0) return;
+    maybeScheduleVerify(time(0)); // Lan dau: ngay (chua lap lich lan nao)
+}
+
+void SupplyMonitor::maybeScheduleVerify(time_t now) {
+    unsigned int seconds = interval.load(std::memory_order_relaxed);
+    if (seconds == 0 || now - lastScheduled.load(std::memory_order_relaxed) < static_cast<time_t>(seconds)) return;
+    if (verifying.exchange(true)) return; // Da co lan kiem tra dang cho
+    lastScheduled = now;
+    TaskScheduler::instance().submit([this]() {
+        verify();
+        verifying = false;
+    });
+}
+
+void SupplyMonitor::shutdown() {
+    interval = 0;
+    while (verifying.load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    save();
+}
+
+void SupplyMonitor::save() const {
+    if (!initialized) return;
+    FileIO::replaceFile(SUPPLY_FILE, std::string(EXPECTED_KEY) + std::to_string(expectedCents.load()) + "\n");
+}
+
+SupplyMonitor::Status SupplyMonitor::status() const {
+    Status s;
+    s.initialized = initialized;
+    s.expectedCents = expectedCents;
+    s.observedCents = observedCents;
+    s.settledTransfers = settledTransfers;
+    s.checks = checks;
+    s.alarms = alarms;
+    s.skipped = skipped;
+    s.lastCheck = lastCheck;
+    return s;
+}
@@ -0,0 +1,95 @@
+// supply.h
+#ifndef SUPPLY_H
+#define SUPPLY_H
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+// Kiem tra bat bien tong cung diem: diem chi duoc phat hanh mot lan (vi tong MASTER_WALLET)
+// va chi di chuyen qua transferPoints, nen tong so du cua tat ca cac vi phai khong doi.
+// - Bo dem tong cung ky vong (tinh bang phan tram) duoc cap nhat o moi giao dich da ghi xong
+//   va luu o data/supply.txt khi thoat de phat hien ca thay doi ngoai chuong trinh.
+// - Lan kiem tra la mot cong viec tren TaskScheduler (luc bat dau va sau giao dich khi da qua chu ky):
+//   so sanh bo dem voi tong cot so du cua bang vi (DataIndex, khi warm-start) hoac tong so du doc tu
+//   cac file vi cua moi phan vung (khong warm-start), canh bao khi lech.
+// - Bo qua khi tien trinh khac cung chay tren data/ (giu Instances): bang vi cua tien trinh nay khong
+//   thay cac lan ghi vi cua tien trinh kia nen se bao lech gia.
+// Giao dich giu SettleGuard (khoa chia se) tu luc ghi vi den luc cap nhat bo dem; lan kiem tra tren bang vi
+// giu khoa doc quyen nen khong bao gio thay trang thai nua chung. Lan quet file khong chan giao dich:
+// ket qua bi bo neu co giao dich hoan tat trong luc quet.
+class SupplyMonitor {
+public:
+    struct Status {
+        bool initialized;            // Da biet tong cung ky vong
+        long long expectedCents;     // Tong cung ky vong (x100)
+        long long observedCents;     // Tong so du cua bang vi o lan kiem tra gan nhat
+        std::size_t settledTransfers;
+        std::size_t checks;
+        std::size_t alarms;          // So lan kiem tra phat hien lech
+        std::size_t skipped;         // Khong kiem tra duoc (tien trinh khac, giao dich trong luc quet file)
+        time_t lastCheck;            // 0: chua kiem tra
+    };
+
+    // Giu trong suot qua trinh ghi hai vi cua mot giao dich va recordTransfer()
+    class SettleGuard {
+    public:
+        SettleGuard();
+    private:
+        std::shared_lock<std::shared_timed_mutex> lock;
+    };
+
+    static SupplyMonitor& instance();
+
+    // Doc tong cung ky vong da luu; neu chua co thi lay tu bang vi (can warm-start).
+    // Kiem tra ngay mot lan neu bang vi da duoc nap.
+    void initialize();
+
+    // Phat hanh diem moi (chi dung khi khoi tao vi tong)
+    void mint(double amount);
+
+    // Ghi nhan mot giao dich da ghi xong ca hai vi: so du truoc/sau cua vi gui va vi nhan
+    // (goi khi dang giu SettleGuard)
+    void recordTransfer(double senderBefore, double senderAfter, double receiverBefore, double receiverAfter);
+
+    // So sanh bo dem voi tong so du cac vi. Tra ve false neu lech (va da canh bao).
+    // Tra ve true neu khop hoac khong the kiem tra (xem Status::skipped).
+    bool verify();
+
+    // Kiem tra ngay (tren TaskScheduler) roi moi 'intervalSeconds' giay sau giao dich (0: tat)
+    void startVerifier(unsigned int intervalSeconds);
+    // Cho lan kiem tra dang chay va luu tong cung ky vong (khi thoat chuong trinh)
+    void shutdown();
+
+    Status status() const;
+
+private:
+    SupplyMonitor();
+    SupplyMonitor(const SupplyMonitor&) = delete;
+    SupplyMonitor& operator=(const SupplyMonitor&) = delete;
+
+    // Tong so du quan sat va tong cung ky vong tai cung mot thoi diem; false neu khong xac dinh duoc
+    bool observe(long long& observed, long long& expected);
+    // Lap lich verify() neu da qua chu ky va chua co lan nao dang cho
+    void maybeScheduleVerify(time_t now);
+    void save() const;
+
+    std::shared_timed_mutex settleMutex;
+    std::atomic<bool> initialized;
+    std::atomic<long long> expectedCents;
+    std::atomic<long long> observedCents;
+    std::atomic<std::size_t> settledTransfers;
+    std::atomic<std::size_t> checks;
+    std::atomic<std::size_t> alarms;
+    std::atomic<std::size_t> skipped;
+    std::atomic<time_t> lastCheck;
+
+    std::atomic<unsigned int> interval;     // 0: khong kiem tra dinh ky
+    std::atomic<bool> verifying;            // Da co lan kiem tra dang cho/dang chay tren TaskScheduler
+    std::atomic<time_t> lastScheduled;
+};
+
+#endif // SUPPLY_H
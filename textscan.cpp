@@ -0,0 +1,170 @@
+// textscan.cpp
+#include "textscan.h"
+#include <cctype>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TEXTSCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    // Bo ky tu phan cach (cac o thua lap lai ky tu dau tien)
+    struct DelimiterSet {
+        char c0, c1, c2;
+
+        explicit DelimiterSet(const std::string& delimiters)
+            : c0(delimiters.empty() ? '\n' : delimiters[0]),
+              c1(delimiters.size() > 1 ? delimiters[1] : c0),
+              c2(delimiters.size() > 2 ? delimiters[2] : c0) {}
+
+        bool matches(char c) const { return c == c0 || c == c1 || c == c2; }
+    };
+
+    void findScalar(const char* data, std::size_t begin, std::size_t length, const DelimiterSet& set,
+                    std::vector<std::size_t>& positions) {
+        for (std::size_t i = begin; i < length; ++i) {
+            if (set.matches(data[i])) positions.push_back(i);
+        }
+    }
+
+#ifdef TEXTSCAN_X86
+    // Moi bit 1 trong 'mask' la mot ky tu phan cach tai vi tri base + bit
+    inline void emitMask(unsigned int mask, std::size_t base, std::vector<std::size_t>& positions) {
+        while (mask != 0) {
+            positions.push_back(base + static_cast<std::size_t>(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+
+    __attribute__((target("sse2")))
+    void findSse2(const char* data, std::size_t length, const DelimiterSet& set, std::vector<std::size_t>& positions) {
+        const __m128i v0 = _mm_set1_epi8(set.c0);
+        const __m128i v1 = _mm_set1_epi8(set.c1);
+        const __m128i v2 = _mm_set1_epi8(set.c2);
+        std::size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v0), _mm_cmpeq_epi8(chunk, v1)),
+                                        _mm_cmpeq_epi8(chunk, v2));
+            emitMask(static_cast<unsigned int>(_mm_movemask_epi8(hits)), i, positions);
+        }
+        findScalar(data, i, length, set, positions);
+    }
+
+    __attribute__((target("avx2")))
+    void findAvx2(const char* data, std::size_t length, const DelimiterSet& set, std::vector<std::size_t>& positions) {
+        const __m256i v0 = _mm256_set1_epi8(set.c0);
+        const __m256i v1 = _mm256_set1_epi8(set.c1);
+        const __m256i v2 = _mm256_set1_epi8(set.c2);
+        std::size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, v0), _mm256_cmpeq_epi8(chunk, v1)),
+                                           _mm256_cmpeq_epi8(chunk, v2));
+            emitMask(static_cast<unsigned int>(_mm256_movemask_epi8(hits)), i, positions);
+        }
+        findScalar(data, i, length, set, positions);
+    }
+#endif
+
+    TextScan::Isa& currentIsa() {
+        static TextScan::Isa isa = TextScan::detectedIsa();
+        return isa;
+    }
+
+    bool isSpace(char c) {
+        return std::isspace(static_cast<unsigned char>(c)) != 0;
+    }
+
+    // Cat khoang trang hai dau cua [begin, end) giong Utils::trimString
+    void trimRange(const char* data, std::size_t& begin, std::size_t& end) {
+        while (begin < end && isSpace(data[begin])) ++begin;
+        while (end > begin && isSpace(data[end - 1])) --end;
+    }
+}
+
+namespace TextScan {
+
+    Isa detectedIsa() {
+#ifdef TEXTSCAN_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Isa::AVX2;
+        if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+#endif
+        return Isa::Scalar;
+    }
+
+    Isa activeIsa() {
+        return currentIsa();
+    }
+
+    void setIsa(Isa isa) {
+        Isa best = detectedIsa();
+        currentIsa() = static_cast<int>(isa) > static_cast<int>(best) ? best : isa;
+    }
+
+    const char* isaName(Isa isa) {
+        switch (isa) {
+            case Isa::AVX2: return "AVX2";
+            case Isa::SSE2: return "SSE2";
+            default: return "scalar";
+        }
+    }
+
+    void findDelimiters(const char* data, std::size_t length, const std::string& delimiters,
+                        std::vector<std::size_t>& positions) {
+        DelimiterSet set(delimiters);
+        switch (currentIsa()) {
+#ifdef TEXTSCAN_X86
+            case Isa::AVX2: findAvx2(data, length, set, positions); return;
+            case Isa::SSE2: findSse2(data, length, set, positions); return;
+#endif
+            default: findScalar(data, 0, length, set, positions); return;
+        }
+    }
+
+    std::size_t splitKeyValues(const std::string& data, char fieldDelimiter, std::vector<KeyValueRef>& fields) {
+        return splitKeyValues(data.data(), data.size(), fieldDelimiter, fields);
+    }
+
+    std::size_t splitKeyValues(const char* data, std::size_t length, char fieldDelimiter,
+                               std::vector<KeyValueRef>& fields) {
+        fields.clear();
+        if (length == 0) return 0;
+
+        // Bo dem vi tri dung lai cho moi thread (parse song song tren TaskScheduler)
+        static thread_local std::vector<std::size_t> positions;
+        positions.clear();
+        char delimiters[2] = {fieldDelimiter, ':'};
+        findDelimiters(data, length, std::string(delimiters, 2), positions);
+        positions.push_back(length); // Ket thuc truong cuoi cung
+
+        std::size_t fieldCount = 0;
+        std::size_t fieldBegin = 0;
+        std::size_t colon = std::string::npos;
+        for (std::size_t pos : positions) {
+            bool endOfData = pos == length;
+            if (!endOfData && data[pos] == ':') {
+                if (colon == std::string::npos) colon = pos;
+                continue;
+            }
+            if (endOfData && fieldBegin == length) break; // Chuoi ket thuc bang ky tu phan cach
+
+            fieldCount++;
+            if (colon != std::string::npos && colon + 1 < pos) {
+                KeyValueRef field;
+                std::size_t keyEnd = colon, valueBegin = colon + 1, valueEnd = pos;
+                field.keyBegin = fieldBegin;
+                trimRange(data, field.keyBegin, keyEnd);
+                trimRange(data, valueBegin, valueEnd);
+                field.keyLength = keyEnd - field.keyBegin;
+                field.valueBegin = valueBegin;
+                field.valueLength = valueEnd - valueBegin;
+                fields.push_back(field);
+            }
+            fieldBegin = pos + 1;
+            colon = std::string::npos;
+        }
+        return fieldCount;
+    }
+}
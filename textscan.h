@@ -0,0 +1,53 @@
+// textscan.h
+#ifndef TEXTSCAN_H
+#define TEXTSCAN_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// Quet ky tu phan cach ('\n', '|', ':') theo khoi bang SIMD cho cac dinh dang ban ghi van ban.
+// Thay vi doc tung byte qua std::getline/istringstream, moi lan so sanh 16 (SSE2) hoac
+// 32 (AVX2) byte va tra ve vi tri cac ky tu phan cach de bo parse cat truong truc tiep.
+// Tap lenh duoc chon luc chay theo CPU; may khong phai x86 dung vong lap vo huong.
+namespace TextScan {
+
+    enum class Isa {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Tap lenh tot nhat ma CPU hien tai ho tro
+    Isa detectedIsa();
+
+    // Tap lenh dang duoc dung (mac dinh = detectedIsa())
+    Isa activeIsa();
+
+    // Ep dung mot tap lenh (dung cho benchmark); tap lenh CPU khong ho tro se bi ha xuong
+    void setIsa(Isa isa);
+
+    const char* isaName(Isa isa);
+
+    // Them vao 'positions' vi tri (tinh tu 'data') cua moi ky tu thuoc 'delimiters'
+    // trong [data, data + length). 'delimiters' gom 1 den 3 ky tu.
+    void findDelimiters(const char* data, std::size_t length, const std::string& delimiters,
+                        std::vector<std::size_t>& positions);
+
+    // Mot truong "key:value" trong ban ghi (vi tri trong chuoi goc, da cat khoang trang)
+    struct KeyValueRef {
+        std::size_t keyBegin;
+        std::size_t keyLength;
+        std::size_t valueBegin;
+        std::size_t valueLength; // Gia tri la toan bo phan sau dau ':' dau tien
+    };
+
+    // Tach 'data' thanh cac truong phan cach boi 'fieldDelimiter' trong mot lan quet.
+    // Truong co dang key:value (va co gia tri) duoc them vao 'fields'.
+    // Tra ve tong so truong, dem giong std::getline (truong rong cuoi chuoi khong tinh).
+    std::size_t splitKeyValues(const std::string& data, char fieldDelimiter, std::vector<KeyValueRef>& fields);
+    std::size_t splitKeyValues(const char* data, std::size_t length, char fieldDelimiter,
+                               std::vector<KeyValueRef>& fields);
+}
+
+#endif // TEXTSCAN_H
@@ -1,5 +1,13 @@
 // user.cpp
 #include "user.h"
+#include "fileio.h"
+#include "dataindex.h"
+#include "usersearch.h"
+#include "contactindex.h"
+#include "lockmanager.h"
+#include "shards.h"
+#include "changefeed.h"
+#include "textscan.h"
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -7,10 +15,10 @@
 
 // Ham khoi tao
 User::User(std::string username, std::string hashedPassword, std::string fullName,
-           std::string email, std::string phoneNumber, std::string userType,
+           std::string email, std::string phoneNumber, Access::Role role,
            bool isAutoGenerated)
     : username(username), hashedPassword(hashedPassword), fullName(fullName),
-      email(email), phoneNumber(phoneNumber), userType(userType),
+      email(email), phoneNumber(phoneNumber), role(role),
       isAutoGeneratedPassword(isAutoGenerated) {
     this->userId = Utils::generateUniqueId(); // Sinh ID duy nhat khi tao tai khoan
     this->registrationDate = time(0); // Thoi gian dang ky hien tai
@@ -24,7 +32,7 @@ void User::displayUserInfo() const {
     std::cout << "Ho va ten: " << fullName << std::endl;
     std::cout << "Email: " << email << std::endl;
     std::cout << "So dien thoai: " << phoneNumber << std::endl;
-    std::cout << "Loai nguoi dung: " << userType << std::endl;
+    std::cout << "Loai nguoi dung: " << getUserType() << std::endl;
     std::cout << "Ngay dang ky: " << Utils::timeToString(registrationDate) << std::endl;
     std::cout << "Mat khau tu dong sinh: " << (isAutoGeneratedPassword ? "Co" : "Khong") << std::endl;
     std::cout << "------------------------" << std::endl;
@@ -60,7 +68,7 @@ std::string User::toString() const {
        << "fullName:" << fullName << "\n"
        << "email:" << email << "\n"
        << "phoneNumber:" << phoneNumber << "\n"
-       << "userType:" << userType << "\n"
+       << "userType:" << Access::roleName(role) << "\n"
        << "registrationDate:" << registrationDate << "\n" // Luu timestamp
        << "isAutoGeneratedPassword:" << (isAutoGeneratedPassword ? "1" : "0");
     return ss.str();
@@ -68,18 +76,17 @@ std::string User::toString() const {
 
 // Tao doi tuong User tu chuoi doc tu file
 User* User::fromString(const std::string& data) {
-    std::string line;
-    std::istringstream iss(data);
-
-    std::string userId, username, hashedPassword, fullName, email, phoneNumber, userType;
+    std::string userId, username, hashedPassword, fullName, email, phoneNumber;
+    Access::Role role = Access::Role::Normal; // Thieu hoac vai tro la: it quyen nhat
     time_t registrationDate = 0;
     bool isAutoGeneratedPassword = false;
 
-    while (std::getline(iss, line)) {
-        std::vector<std::string> parts = Utils::splitString(line, ':');
-        if (parts.size() < 2) continue;
-        std::string key = Utils::trimString(parts[0]);
-        std::string value = Utils::trimString(parts[1]); // Lay phan con lai sau dau ':' dau tien
+    // Moi dong mot truong key:value, tach trong mot lan quet
+    std::vector<TextScan::KeyValueRef> fields;
+    TextScan::splitKeyValues(data, '\n', fields);
+    for (const TextScan::KeyValueRef& field : fields) {
+        std::string key = data.substr(field.keyBegin, field.keyLength);
+        std::string value = data.substr(field.valueBegin, field.valueLength); // Lay phan con lai sau dau ':' dau tien
 
         if (key == "userId") userId = value;
         else if (key == "username") username = value;
@@ -87,7 +94,7 @@ User* User::fromString(const std::string& data) {
         else if (key == "fullName") fullName = value;
         else if (key == "email") email = value;
         else if (key == "phoneNumber") phoneNumber = value;
-        else if (key == "userType") userType = value;
+        else if (key == "userType") Access::parseRole(value, role); // Ten la: giu Normal
         else if (key == "registrationDate") registrationDate = std::stoll(value); // Doc timestamp
         else if (key == "isAutoGeneratedPassword") isAutoGeneratedPassword = (value == "1");
     }
@@ -96,7 +103,7 @@ User* User::fromString(const std::string& data) {
         return nullptr; // Du lieu khong hop le
     }
 
-    User* user = new User(username, hashedPassword, fullName, email, phoneNumber, userType, isAutoGeneratedPassword);
+    User* user = new User(username, hashedPassword, fullName, email, phoneNumber, role, isAutoGeneratedPassword);
     user->userId = userId; // Gan lai userId da doc tu file
     user->registrationDate = registrationDate; // Gan lai registrationDate da doc tu file
     return user;
@@ -105,41 +112,107 @@ User* User::fromString(const std::string& data) {
 // Luu doi tuong User vao file
 // (Da them cap nhat file index)
 bool User::saveToFile() const {
-    std::string userDir = "data/users/";
-    std::string userIndexFile = "data/user_index.txt"; // File index nguoi dung
-    
-    // Dam bao thu muc 'data' va 'data/users' ton tai
+    // File va index nam trong phan vung cua username (bo cuc phang: data/users/, data/user_index.txt)
+    ShardLayout& layout = ShardLayout::instance();
+    std::size_t shard = layout.shardOf(username);
+    std::string userDir = layout.userDir(shard);
+    std::string userIndexFile = layout.userIndexFile(shard); // File index nguoi dung
+
+    // Dam bao thu muc 'data' va thu muc nguoi dung ton tai
     Utils::createDirectoryIfNotExists("data");
     Utils::createDirectoryIfNotExists(userDir);
 
-    std::string filename = userDir + username + ".txt"; // Luu theo username
-    bool success = Utils::writeToFile(filename, toString());
+    std::string filename = userDir + "/" + username + ".txt"; // Luu theo username
+    // Ghi file va them vao index cua cung mot nguoi dung khong xen ke giua cac thread/tien trinh
+    LockManager::Guard lock(LockManager::entity('U', username));
+    // Kiem tra trung va giu cho email/so dien thoai trong mot lan khoa chung giua cac tien trinh:
+    // kiem tra truoc do (luc nhap thong tin) chi de bao loi som
+    ContactIndex& contactIndex = ContactIndex::instance();
+    ContactIndex::Reservation reservation;
+    std::string owner;
+    ContactIndex::Conflict conflict = contactIndex.reserve(*this, reservation, owner);
+    if (conflict != ContactIndex::Conflict::None) {
+        std::cerr << "Loi: " << (conflict == ContactIndex::Conflict::Email ? "Email" : "So dien thoai")
+                  << " vua duoc tai khoan khac su dung." << std::endl;
+        return false;
+    }
+    std::string record = toString();
+    bool success = Utils::writeToFile(filename, record);
+    if (!success) {
+        contactIndex.release(reservation);
+    }
 
     if (success) {
         // Kiem tra xem username da co trong index chua truoc khi them de tranh trung lap
-        std::vector<std::string> existingUsernames = Utils::readAllLines(userIndexFile);
-        bool foundInIndex = false;
-        for(const std::string& uname : existingUsernames) {
-            if(uname == username) {
-                foundInIndex = true;
-                break;
+        // (Khi chi muc trong bo nho da duoc nap thi khong can doc lai file index)
+        DataIndex& index = DataIndex::instance();
+        {
+            LockManager::Guard indexLock(LockManager::resource(LockManager::Resource::UserIndex));
+            bool foundInIndex = false;
+            if (index.isLoaded()) {
+                foundInIndex = index.hasUser(username);
+            } else {
+                std::vector<std::string> existingUsernames = Utils::readAllLines(userIndexFile);
+                for(const std::string& uname : existingUsernames) {
+                    if(uname == username) {
+                        foundInIndex = true;
+                        break;
+                    }
+                }
+            }
+            if(!foundInIndex) {
+                Utils::appendToFile(userIndexFile, username); // Them username vao index file
             }
         }
-        if(!foundInIndex) {
-            Utils::appendToFile(userIndexFile, username); // Them username vao index file
-        }
+        index.putUser(*this);
+        UserSearchIndex::instance().put(*this); // Giu chi muc tim kiem cua admin luon moi
+        contactIndex.put(*this); // Da giu cho o tren: thuong khong phai ghi them
+        index.recordDelta('U', username); // De snapshot chi muc duoc cap nhat lan khoi dong sau
+        // Van giu khoa cua nguoi dung: thu tu su kien trong luong thay doi dung thu tu ghi file
+        ChangeFeed::instance().publish(ChangeFeed::Kind::User, username, ChangeFeed::payloadOf(record, "hashedPassword"));
     }
     return success;
 }
 
 // Tai doi tuong User tu file dua tren username
 User* User::loadFromFile(const std::string& username) {
-    std::string userDir = "data/users/";
-    std::string filename = userDir + username + ".txt";
-    std::string content = Utils::readFileContent(filename);
-    if (content.empty()) {
-        return nullptr; // Khong tim thay file hoac file trong
+    // Tra cuu chi muc trong bo nho truoc (neu da warm-start)
+    DataIndex& index = DataIndex::instance();
+    if (index.isLoaded()) {
+        if (User* cached = index.findUser(username)) {
+            return cached;
+        }
+    }
+
+    std::string filename = ShardLayout::instance().userFile(username);
+    std::string content;
+    if (!FileIO::readFile(filename, content)) {
+        return nullptr; // Khong tim thay file
+    }
+    User* user = nullptr;
+    try {
+        user = fromString(content);
+    } catch (const std::exception&) {
+        user = nullptr;
+    }
+    if (!user) {
+        // File ton tai nhung khong doc duoc: bao loi thay vi coi nhu tai khoan khong ton tai
+        std::cerr << "Loi: Du lieu nguoi dung " << username << " bi hong (" << filename << ")." << std::endl;
+    } else {
+        index.putUser(*user); // File duoc tao ngoai chi muc (vi du them thu cong)
+    }
+    return user;
+}
+
+// Kiem tra noi dung file nguoi dung co hop le hay khong
+bool User::isValidRecord(const std::string& data) {
+    try {
+        User* user = fromString(data);
+        bool valid = user != nullptr;
+        delete user;
+        return valid;
+    } catch (const std::exception&) {
+        return false;
     }
-    return fromString(content);
 }
 
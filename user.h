@@ -7,6 +7,7 @@
 #include <iostream>
 #include <vector>
 #include "utils.h" // Bao gom cac ham tien ich
+#include "access.h"
 
 class User {
 public:
@@ -22,12 +23,12 @@ public:
     // Thuoc tinh quan ly mat khau
     bool isAutoGeneratedPassword;  // true neu mat khau duoc tu dong sinh
 
-    // Thuoc tinh phan quyen
-    std::string userType;          // "normal" hoac "admin"
+    // Thuoc tinh phan quyen (ma vai tro; tren dia ghi ten vai tro o truong userType)
+    Access::Role role;
 
     // Constructor
     User(std::string username, std::string hashedPassword, std::string fullName,
-         std::string email, std::string phoneNumber, std::string userType,
+         std::string email, std::string phoneNumber, Access::Role role,
          bool isAutoGenerated = false);
 
     // Cac ham thanh vien (methods)
@@ -40,13 +41,16 @@ public:
     void changePassword(const std::string& newHashedPassword);
 
     // Getters de truy cap cac thuoc tinh
-    std::string getUsername() const { return username; }
-    std::string getHashedPassword() const { return hashedPassword; }
-    std::string getFullName() const { return fullName; }
-    std::string getEmail() const { return email; }
-    std::string getPhoneNumber() const { return phoneNumber; }
-    std::string getUserId() const { return userId; }
-    std::string getUserType() const { return userType; }
+    const std::string& getUsername() const { return username; }
+    const std::string& getHashedPassword() const { return hashedPassword; }
+    const std::string& getFullName() const { return fullName; }
+    const std::string& getEmail() const { return email; }
+    const std::string& getPhoneNumber() const { return phoneNumber; }
+    const std::string& getUserId() const { return userId; }
+    Access::Role getRole() const { return role; }
+    const char* getUserType() const { return Access::roleName(role); }
+    // Kiem tra quyen cua vai tro (mot phep thu bit tren bang chinh sach)
+    bool can(Access::Permission permission) const { return Access::allows(role, permission); }
     bool getIsAutoGeneratedPassword() const { return isAutoGeneratedPassword; }
 
     // Phuong thuc de chuyen doi doi tuong User thanh chuoi de luu vao file
@@ -55,6 +59,9 @@ public:
     // Phuong thuc tinh de tao doi tuong User tu chuoi doc tu file
     static User* fromString(const std::string& data);
 
+    // Phuong thuc tinh kiem tra noi dung file nguoi dung co hop le (dung khi phuc hoi du lieu)
+    static bool isValidRecord(const std::string& data);
+
     // Phuong thuc de luu doi tuong User vao file
     // (Code trong .cpp se them cap nhat file index)
     bool saveToFile() const;
@@ -0,0 +1,575 @@
+// userimport.cpp
+#include "userimport.h"
+#include "changefeed.h"
+#include "contactindex.h"
+#include "dataindex.h"
+#include "fileio.h"
+#include "lockmanager.h"
+#include "scheduler.h"
+#include "shards.h"
+#include "user.h"
+#include "usersearch.h"
+#include "utils.h"
+#include "wallet.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+    const std::size_t MAX_USERNAME_LENGTH = 64;
+    const std::size_t MAX_FIELD_LENGTH = 256;
+
+    enum Column { COL_USERNAME, COL_PASSWORD, COL_FULLNAME, COL_EMAIL, COL_PHONE, COL_USERTYPE, COLUMN_COUNT };
+
+    struct Row {
+        std::size_t line;                  // So dong trong file (tu 1)
+        std::string fields[COLUMN_COUNT];
+        std::string hashedPassword;
+        Access::Role role;
+        bool generatedPassword;            // fields[COL_PASSWORD] giu mat khau tu sinh de ghi ra file
+        bool alreadyImported;
+        std::string error;                 // Rong neu dong hop le
+    };
+
+    // Ten cot/khoa JSON -> cot (bo qua hoa thuong, '_' va khoang trang); -1 neu khong dung
+    int columnOf(const std::string& name) {
+        std::string key;
+        for (char c : name) {
+            if (c == '_' || c == ' ' || c == '-') continue;
+            key += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        if (key == "username") return COL_USERNAME;
+        if (key == "password") return COL_PASSWORD;
+        if (key == "fullname" || key == "name") return COL_FULLNAME;
+        if (key == "email") return COL_EMAIL;
+        if (key == "phonenumber" || key == "phone") return COL_PHONE;
+        if (key == "usertype" || key == "type") return COL_USERTYPE;
+        return -1;
+    }
+
+    // Tach mot dong CSV (dau nhay kep, "" la mot dau nhay). false neu thieu dau nhay dong.
+    bool splitCsvLine(const std::string& line, std::vector<std::string>& out) {
+        out.clear();
+        std::string field;
+        bool quoted = false;
+        bool fieldStart = true;
+        for (std::size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted) {
+                if (c != '"') {
+                    field += c;
+                } else if (i + 1 < line.size() && line[i + 1] == '"') {
+                    field += '"';
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else if (c == '"' && fieldStart) {
+                quoted = true;
+                fieldStart = false;
+            } else if (c == ',') {
+                out.push_back(field);
+                field.clear();
+                fieldStart = true;
+            } else {
+                field += c;
+                fieldStart = false;
+            }
+        }
+        if (quoted) return false;
+        out.push_back(field);
+        return true;
+    }
+
+    std::string csvQuote(const std::string& value) {
+        if (value.find_first_of(",\"") == std::string::npos) return value;
+        std::string quoted = "\"";
+        for (char c : value) {
+            if (c == '"') quoted += '"';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    void skipSpaces(const std::string& s, std::size_t& pos) {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t')) ++pos;
+    }
+
+    void appendUtf8(std::string& out, unsigned int cp) {
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xC0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            out += static_cast<char>(0xE0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    bool parseJsonString(const std::string& s, std::size_t& pos, std::string& out) {
+        if (pos >= s.size() || s[pos] != '"') return false;
+        ++pos;
+        while (pos < s.size()) {
+            char c = s[pos++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= s.size()) return false;
+            char escaped = s[pos++];
+            switch (escaped) {
+                case '"': case '\\': case '/': out += escaped; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (pos + 4 > s.size()) return false;
+                    unsigned int cp = 0;
+                    for (int k = 0; k < 4; ++k) {
+                        char h = s[pos++];
+                        cp <<= 4;
+                        if (h >= '0' && h <= '9') cp |= static_cast<unsigned int>(h - '0');
+                        else if (h >= 'a' && h <= 'f') cp |= static_cast<unsigned int>(h - 'a' + 10);
+                        else if (h >= 'A' && h <= 'F') cp |= static_cast<unsigned int>(h - 'A' + 10);
+                        else return false;
+                    }
+                    if (cp >= 0xD800 && cp <= 0xDFFF) return false; // Khong ho tro cap surrogate
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default: return false;
+            }
+        }
+        return false;
+    }
+
+    // Object JSON phang tren mot dong; so/true/false giu nguyen van ban, null la chuoi rong
+    bool parseJsonRow(const std::string& s, Row& row) {
+        std::size_t pos = 0;
+        skipSpaces(s, pos);
+        if (pos >= s.size() || s[pos] != '{') {
+            row.error = "Dong khong phai JSON object";
+            return false;
+        }
+        ++pos;
+        skipSpaces(s, pos);
+        bool closed = pos < s.size() && s[pos] == '}';
+        if (closed) ++pos;
+        while (!closed) {
+            std::string key, value;
+            skipSpaces(s, pos);
+            if (!parseJsonString(s, pos, key)) break;
+            skipSpaces(s, pos);
+            if (pos >= s.size() || s[pos] != ':') break;
+            ++pos;
+            skipSpaces(s, pos);
+            if (pos < s.size() && s[pos] == '"') {
+                if (!parseJsonString(s, pos, value)) break;
+            } else if (pos < s.size() && (s[pos] == '{' || s[pos] == '[')) {
+                row.error = "Truong '" + key + "' phai la gia tri don";
+                return false;
+            } else {
+                std::size_t start = pos;
+                while (pos < s.size() && s[pos] != ',' && s[pos] != '}' && s[pos] != ' ' && s[pos] != '\t') ++pos;
+                value = s.substr(start, pos - start);
+                if (value.empty()) break;
+                if (value == "null") value.clear();
+            }
+            int column = columnOf(key);
+            if (column >= 0) row.fields[column] = value; // Truong khac duoc bo qua
+            skipSpaces(s, pos);
+            if (pos < s.size() && s[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            if (pos < s.size() && s[pos] == '}') {
+                ++pos;
+                closed = true;
+                continue;
+            }
+            break;
+        }
+        skipSpaces(s, pos);
+        if (!closed || pos != s.size()) {
+            row.error = "JSON khong hop le";
+            return false;
+        }
+        return true;
+    }
+
+    bool isValidUsername(const std::string& username) {
+        if (username.empty() || username.size() > MAX_USERNAME_LENGTH || username[0] == '.') return false;
+        for (char c : username) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.') return false;
+        }
+        return true;
+    }
+
+    bool isValidEmail(const std::string& email) {
+        std::size_t at = email.find('@');
+        return at != std::string::npos && at > 0 && at + 1 < email.size() &&
+               email.find('@', at + 1) == std::string::npos && email.find_first_of(" \t") == std::string::npos;
+    }
+
+    bool isValidPhone(const std::string& phone) {
+        if (phone.find_first_not_of("0123456789+-. ()") != std::string::npos) return false;
+        std::size_t digits = ContactIndex::normalizePhone(phone).size();
+        return digits >= 9 && digits <= 15;
+    }
+
+    // Kiem tra va bam mat khau mot dong (chay song song, khong dung trang thai chung)
+    void validateRow(Row& row) {
+        for (int i = 0; i < COLUMN_COUNT; ++i) {
+            std::string& field = row.fields[i];
+            if (i != COL_PASSWORD) field = Utils::trimString(field);
+            if (field.find_first_of("\r\n") != std::string::npos) {
+                row.error = "Du lieu chua ky tu xuong dong";
+                return;
+            }
+            if (field.size() > MAX_FIELD_LENGTH) {
+                row.error = "Truong qua dai (toi da 256 ky tu)";
+                return;
+            }
+        }
+        if (!isValidUsername(row.fields[COL_USERNAME])) {
+            row.error = "Ten dang nhap khong hop le (chu, so, '.', '_', '-', toi da 64 ky tu)";
+        } else if (row.fields[COL_FULLNAME].empty()) {
+            row.error = "Thieu ho va ten";
+        } else if (!isValidEmail(row.fields[COL_EMAIL])) {
+            row.error = "Email khong hop le";
+        } else if (!isValidPhone(row.fields[COL_PHONE])) {
+            row.error = "So dien thoai khong hop le";
+        }
+        if (!row.error.empty()) return;
+
+        row.role = Access::Role::Normal;
+        if (!row.fields[COL_USERTYPE].empty() && !Access::parseRole(row.fields[COL_USERTYPE], row.role)) {
+            row.error = "Loai tai khoan phai la " + Access::roleNames();
+            return;
+        }
+
+        std::string& password = row.fields[COL_PASSWORD];
+        row.generatedPassword = password.empty();
+        if (row.generatedPassword) password = Utils::generateRandomPassword();
+        row.hashedPassword = Utils::hashPassword(password);
+        if (!row.generatedPassword) password.clear(); // Khong giu mat khau ro sau khi bam
+    }
+
+    // username da dang ky thuc su (co trong file index tren dia, nguon chung cua moi tien trinh)?
+    // File nguoi dung khong co trong index la phan con lai cua mot lan nhap bi ngat: ghi de duoc.
+    bool indexedOnDisk(const std::string& username) {
+        ShardLayout& layout = ShardLayout::instance();
+        LockManager::Guard indexLock(LockManager::resource(LockManager::Resource::UserIndex), LockManager::Mode::Shared);
+        for (const std::string& line : Utils::readAllLines(layout.userIndexFile(layout.shardOf(username)))) {
+            if (line == username) return true;
+        }
+        return false;
+    }
+
+    bool sameContacts(const User& user, const Row& row) {
+        return ContactIndex::normalizeEmail(user.getEmail()) == ContactIndex::normalizeEmail(row.fields[COL_EMAIL]) &&
+               ContactIndex::normalizePhone(user.getPhoneNumber()) == ContactIndex::normalizePhone(row.fields[COL_PHONE]);
+    }
+}
+
+UserImporter::UserImporter(std::size_t batchRows) : batchRows(batchRows == 0 ? 2000 : batchRows) {}
+
+bool UserImporter::run(const std::string& path, Format format, ImportReport& report) {
+    report = ImportReport{0, 0, 0, 0, 0, 0, 0, 0.0};
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::string content;
+    if (!FileIO::readFileOnce(path, content)) {
+        std::cerr << "Loi: Khong the doc file " << path << std::endl;
+        return false;
+    }
+    std::vector<std::string> lines = Utils::splitString(content, '\n');
+    for (std::string& line : lines) {
+        if (!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+    }
+    if (!lines.empty() && lines[0].compare(0, 3, "\xEF\xBB\xBF") == 0) lines[0].erase(0, 3); // BOM UTF-8
+
+    std::size_t first = 0;
+    while (first < lines.size() && Utils::trimString(lines[first]).empty()) ++first;
+    if (format == Format::Auto) {
+        bool jsonName = path.size() >= 6 && (path.compare(path.size() - 6, 6, ".jsonl") == 0 ||
+                                             path.compare(path.size() - 5, 5, ".json") == 0);
+        bool jsonLine = first < lines.size() && Utils::trimString(lines[first]).compare(0, 1, "{") == 0;
+        format = jsonName || jsonLine ? Format::Jsonl : Format::Csv;
+    }
+
+    // CSV: anh xa cot tieu de -> truong
+    std::vector<int> columns;
+    std::size_t dataStart = first;
+    if (format == Format::Csv) {
+        std::vector<std::string> header;
+        if (first >= lines.size() || !splitCsvLine(lines[first], header)) {
+            std::cerr << "Loi: File CSV khong co dong tieu de hop le." << std::endl;
+            return false;
+        }
+        bool hasUsername = false;
+        for (const std::string& name : header) {
+            columns.push_back(columnOf(Utils::trimString(name)));
+            if (columns.back() == COL_USERNAME) hasUsername = true;
+        }
+        if (!hasUsername) {
+            std::cerr << "Loi: Tieu de CSV thieu cot username." << std::endl;
+            return false;
+        }
+        dataStart = first + 1;
+    }
+
+    // Tiep tuc lan nhap truoc neu file dau vao khong doi (so sanh dau van tay noi dung)
+    std::string fingerprint = std::to_string(content.size()) + "-" + std::to_string(std::hash<std::string>()(content));
+    std::size_t resumeLine = 0;
+    std::vector<std::string> progress;
+    if (FileIO::readLines(progressPath(path), progress) && progress.size() >= 2 &&
+        progress[0] == "input:" + fingerprint && progress[1].compare(0, 5, "line:") == 0 &&
+        progress[1].size() > 5 && progress[1].size() < 16 &&
+        progress[1].find_first_not_of("0123456789", 5) == std::string::npos) {
+        resumeLine = static_cast<std::size_t>(std::stoull(progress[1].substr(5)));
+    } else if (!progress.empty()) {
+        std::cerr << "Canh bao: File nhap da thay doi so voi lan truoc, nhap lai tu dau." << std::endl;
+    }
+    std::size_t begin = std::max(dataStart, resumeLine);
+    report.resumedFromLine = resumeLine > 0 ? begin + 1 : 0;
+    if (resumeLine == 0 && !FileIO::replaceFile(errorReportPath(path), "dong,ten dang nhap,loi\n")) {
+        return false;
+    }
+    // Mat khau tu sinh: chi chu so huu doc duoc (0600)
+    if (!FileIO::createPrivateFile(passwordsPath(path), "ten dang nhap,mat khau\n")) {
+        return false;
+    }
+
+    ShardLayout& layout = ShardLayout::instance();
+    layout.createDirectories();
+
+    // Ten dang nhap da co: dung chi muc trong bo nho neu da warm-start, neu khong doc user_index.txt mot lan
+    DataIndex& index = DataIndex::instance();
+    std::unordered_set<std::string> knownUsers;
+    if (!index.isLoaded()) {
+        for (const std::string& username : layout.allUsernames()) knownUsers.insert(username);
+    }
+    auto userExists = [&](const std::string& username) {
+        return index.isLoaded() ? index.hasUser(username) : knownUsers.count(username) > 0;
+    };
+
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    ContactIndex& contacts = ContactIndex::instance();
+    while (begin < lines.size()) {
+        std::size_t end = std::min(lines.size(), begin + batchRows);
+        std::vector<Row> rows;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (Utils::trimString(lines[i]).empty()) continue;
+            Row row;
+            row.line = i + 1;
+            row.generatedPassword = false;
+            row.alreadyImported = false;
+            rows.push_back(row);
+        }
+
+        // 1. Phan tich, kiem tra, bam mat khau song song
+        scheduler.parallelFor(0, rows.size(), 0, [&](std::size_t from, std::size_t to) {
+            std::vector<std::string> fields;
+            for (std::size_t k = from; k < to; ++k) {
+                Row& row = rows[k];
+                const std::string& line = lines[row.line - 1];
+                if (format == Format::Jsonl) {
+                    if (!parseJsonRow(line, row)) continue;
+                } else {
+                    if (!splitCsvLine(line, fields)) {
+                        row.error = "Thieu dau nhay dong";
+                        continue;
+                    }
+                    for (std::size_t c = 0; c < fields.size() && c < columns.size(); ++c) {
+                        if (columns[c] >= 0) row.fields[columns[c]] = fields[c];
+                    }
+                }
+                validateRow(row);
+            }
+        });
+
+        // 2. Kiem tra trung som (tuan tu) va tao doi tuong (sinh ID khong an toan tren nhieu thread).
+        //    Day chi de bao loi som: buoc 3 kiem tra lai duoi khoa cua tung nguoi dung.
+        std::vector<User> users;
+        std::vector<Wallet> wallets;
+        std::vector<std::size_t> rowOf;
+        std::unordered_map<std::string, std::size_t> batchUsers, batchEmails, batchPhones; // -> dong trong lo
+        for (std::size_t k = 0; k < rows.size(); ++k) {
+            Row& row = rows[k];
+            if (!row.error.empty()) continue;
+            const std::string& username = row.fields[COL_USERNAME];
+            if (userExists(username)) {
+                // Lan nhap truoc bi ngat sau khi da ghi chi muc: tai khoan trung khop thi bo qua
+                std::unique_ptr<User> existing(User::loadFromFile(username));
+                if (existing && sameContacts(*existing, row)) {
+                    row.alreadyImported = true;
+                    contacts.put(*existing);
+                } else {
+                    row.error = "Ten dang nhap da ton tai";
+                }
+                continue;
+            }
+            std::string emailKey = ContactIndex::normalizeEmail(row.fields[COL_EMAIL]);
+            std::string phoneKey = ContactIndex::normalizePhone(row.fields[COL_PHONE]);
+            std::string owner;
+            ContactIndex::Conflict conflict = contacts.check(emailKey, phoneKey, "", owner);
+            if (conflict != ContactIndex::Conflict::None) {
+                row.error = std::string(conflict == ContactIndex::Conflict::Email ? "Email" : "So dien thoai") +
+                            " da duoc su dung boi tai khoan " + owner;
+                continue;
+            }
+            auto sameUser = batchUsers.find(username);
+            auto sameEmail = batchEmails.find(emailKey);
+            auto samePhone = batchPhones.find(phoneKey);
+            if (sameUser != batchUsers.end()) {
+                row.error = "Ten dang nhap trung voi dong " + std::to_string(sameUser->second);
+                continue;
+            }
+            if (sameEmail != batchEmails.end()) {
+                row.error = "Email trung voi dong " + std::to_string(sameEmail->second);
+                continue;
+            }
+            if (samePhone != batchPhones.end()) {
+                row.error = "So dien thoai trung voi dong " + std::to_string(samePhone->second);
+                continue;
+            }
+            batchUsers.emplace(username, row.line);
+            batchEmails.emplace(emailKey, row.line);
+            batchPhones.emplace(phoneKey, row.line);
+            users.push_back(User(username, row.hashedPassword, row.fields[COL_FULLNAME], row.fields[COL_EMAIL],
+                                 row.fields[COL_PHONE], row.role, row.generatedPassword));
+            wallets.push_back(Wallet(users.back().getUserId()));
+            rowOf.push_back(k);
+        }
+
+        // 3. Ghi song song file vi roi file nguoi dung (moi tai khoan hien ra deu da co vi).
+        //    Nhu User::saveToFile: giu khoa 'U' cua username, kiem tra lai ten dang nhap va giu cho
+        //    email/so dien thoai (reserve) ngay truoc khi ghi, vi tai khoan co the vua duoc dang ky
+        //    (thread hoac tien trinh khac) sau buoc 2.
+        std::vector<char> written(users.size(), 0);
+        scheduler.parallelFor(0, users.size(), 0, [&](std::size_t from, std::size_t to) {
+            for (std::size_t i = from; i < to; ++i) {
+                Row& row = rows[rowOf[i]];
+                const std::string& username = users[i].getUsername();
+                LockManager::Guard lock(LockManager::entity('U', username));
+                long long size = 0;
+                time_t modified = 0;
+                if (FileIO::fileStat(layout.userFile(username), size, modified) && indexedOnDisk(username)) {
+                    row.error = "Ten dang nhap da ton tai";
+                    continue;
+                }
+                ContactIndex::Reservation reservation;
+                std::string owner;
+                ContactIndex::Conflict conflict = contacts.reserve(users[i], reservation, owner);
+                if (conflict != ContactIndex::Conflict::None) {
+                    row.error = std::string(conflict == ContactIndex::Conflict::Email ? "Email" : "So dien thoai") +
+                                " da duoc su dung boi tai khoan " + owner;
+                    continue;
+                }
+                written[i] = Utils::writeToFile(layout.walletFile(wallets[i].walletId), wallets[i].toString()) &&
+                             Utils::writeToFile(layout.userFile(username), users[i].toString());
+                if (!written[i]) {
+                    contacts.release(reservation);
+                    row.error = "Khong ghi duoc file nguoi dung/vi";
+                }
+            }
+        });
+
+        // 4. Cap nhat chi muc cho ca lo bang mot lan ghi moi file (moi phan vung mot file)
+        std::vector<std::string> userKeys, walletKeys;
+        std::vector<std::string> userLines(layout.count()), walletLines(layout.count());
+        std::string passwordLines;
+        for (std::size_t i = 0; i < users.size(); ++i) {
+            const Row& row = rows[rowOf[i]];
+            if (!written[i]) continue; // Loi da ghi vao dong o buoc 3
+            if (row.generatedPassword) {
+                passwordLines += csvQuote(row.fields[COL_USERNAME]) + "," + csvQuote(row.fields[COL_PASSWORD]) + "\n";
+            }
+            userLines[layout.shardOf(users[i].getUsername())] += users[i].getUsername() + "\n";
+            walletLines[layout.shardOf(wallets[i].walletId)] += wallets[i].walletId + "\n";
+            userKeys.push_back(users[i].getUsername());
+            walletKeys.push_back(wallets[i].walletId);
+        }
+        // Mat khau tu sinh duoc ghi truoc chi muc: tai khoan da hien ra thi khong mat mat khau
+        if (!passwordLines.empty()) FileIO::appendFile(passwordsPath(path), passwordLines.data(), passwordLines.size());
+        bool indexed = true;
+        if (!walletKeys.empty()) {
+            // Tien trinh khac co the dang them vao cung file index (xem LockManager)
+            LockManager::Guard indexLock(LockManager::resource(LockManager::Resource::UserIndex),
+                                         LockManager::resource(LockManager::Resource::WalletIndex));
+            for (std::size_t shard = 0; shard < layout.count() && indexed; ++shard) {
+                if (walletLines[shard].empty()) continue;
+                FileIO::invalidate(layout.walletIndexFile(shard));
+                indexed = FileIO::appendFile(layout.walletIndexFile(shard), walletLines[shard].data(),
+                                             walletLines[shard].size());
+            }
+            for (std::size_t shard = 0; shard < layout.count() && indexed; ++shard) {
+                if (userLines[shard].empty()) continue;
+                FileIO::invalidate(layout.userIndexFile(shard));
+                indexed = FileIO::appendFile(layout.userIndexFile(shard), userLines[shard].data(),
+                                             userLines[shard].size());
+            }
+        }
+        if (!indexed) {
+            // Chua ghi tien do: chay lai se lam lai lo nay
+            std::cerr << "Loi: Khong the cap nhat file index, dung nhap tai dong " << begin + 1 << "." << std::endl;
+            report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            return false;
+        }
+        UserSearchIndex& search = UserSearchIndex::instance();
+        ChangeFeed& feed = ChangeFeed::instance();
+        {
+            ChangeFeed::Batch changes; // Ca lo vao luong thay doi bang mot lan ghi
+            for (std::size_t i = 0; i < users.size(); ++i) {
+                if (!written[i]) continue;
+                index.putWallet(wallets[i]);
+                index.putUser(users[i]);
+                search.put(users[i]);
+                knownUsers.insert(users[i].getUsername());
+                contacts.put(users[i]); // Da giu cho o buoc 3: chi ghi neu lan reserve khong them duoc dong
+                feed.publish(ChangeFeed::Kind::Wallet, wallets[i].walletId, ChangeFeed::payloadOf(wallets[i].toString()));
+                feed.publish(ChangeFeed::Kind::User, users[i].getUsername(),
+                             ChangeFeed::payloadOf(users[i].toString(), "hashedPassword"));
+            }
+        }
+        index.recordDeltas('W', walletKeys);
+        index.recordDeltas('U', userKeys);
+
+        // 5. Bao cao loi roi moi ghi tien do
+        std::string errorLines;
+        for (const Row& row : rows) {
+            report.rows++;
+            if (row.alreadyImported) {
+                report.alreadyImported++;
+            } else if (!row.error.empty()) {
+                report.failed++;
+                errorLines += std::to_string(row.line) + "," + csvQuote(row.fields[COL_USERNAME]) + "," +
+                              csvQuote(row.error) + "\n";
+            } else {
+                report.imported++;
+                if (row.generatedPassword) report.generatedPasswords++;
+            }
+        }
+        if (!errorLines.empty()) FileIO::appendFile(errorReportPath(path), errorLines.data(), errorLines.size());
+        FileIO::replaceFile(progressPath(path), "input:" + fingerprint + "\nline:" + std::to_string(end) + "\n");
+        report.batches++;
+        begin = end;
+    }
+
+    std::remove(progressPath(path).c_str()); // Da nhap xong
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return true;
+}
@@ -0,0 +1,49 @@
+// userimport.h
+#ifndef USERIMPORT_H
+#define USERIMPORT_H
+
+#include <cstddef>
+#include <string>
+
+// Nhap tai khoan hang loat tu file CSV hoac JSONL (moi dong mot tai khoan).
+// - CSV: dong dau la tieu de, cac cot username, password, fullName, email, phoneNumber, userType
+//   (khong phan biet hoa thuong, thu tu tuy y; password/userType co the bo trong)
+// - JSONL: moi dong mot object phang {"username": "...", "password": "...", ...}
+// Tung lo dong duoc phan tich, kiem tra va bam mat khau song song (TaskScheduler), sau do kiem tra
+// trung ten dang nhap/email/so dien thoai, ghi song song cac file nguoi dung va vi, roi them vao
+// user_index.txt, wallet_index.txt va cac chi muc bang mot lan ghi cho ca lo.
+// File di kem (canh file nhap):
+//   <file>.errors.csv     dong | ten dang nhap | loi  (moi dong bi tu choi)
+//   <file>.passwords.csv  ten dang nhap, mat khau tu sinh (dong de trong password), quyen 0600
+//   <file>.progress       so dong da xu ly xong; chay lai cung file se tiep tuc tu day,
+//                         bi xoa khi nhap xong
+class UserImporter {
+public:
+    enum class Format { Auto, Csv, Jsonl };
+
+    struct ImportReport {
+        std::size_t rows;              // So dong du lieu da xu ly o lan chay nay
+        std::size_t imported;          // Tai khoan moi (kem vi)
+        std::size_t alreadyImported;   // Tai khoan da co dung thong tin (lan nhap truoc bi ngat)
+        std::size_t failed;            // Dong bi tu choi (xem file loi)
+        std::size_t generatedPasswords;
+        std::size_t resumedFromLine;   // 0 neu nhap tu dau
+        std::size_t batches;
+        double seconds;
+    };
+
+    explicit UserImporter(std::size_t batchRows = 2000);
+
+    // Nhap toan bo file. Tra ve false neu khong doc duoc file/tieu de hoac khong ghi duoc chi muc
+    // (chay lai se tiep tuc tu lo chua hoan tat). Loi cua tung dong khong lam that bai ca lan nhap.
+    bool run(const std::string& path, Format format, ImportReport& report);
+
+    static std::string errorReportPath(const std::string& path) { return path + ".errors.csv"; }
+    static std::string passwordsPath(const std::string& path) { return path + ".passwords.csv"; }
+    static std::string progressPath(const std::string& path) { return path + ".progress"; }
+
+private:
+    std::size_t batchRows;
+};
+
+#endif // USERIMPORT_H
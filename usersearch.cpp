@@ -0,0 +1,294 @@
+// usersearch.cpp
+#include "usersearch.h"
+#include "scheduler.h"
+#include "shards.h"
+#include "utils.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+#include <mutex>
+
+namespace {
+    const std::size_t MIN_SUBSTRING_TERM = 3;
+
+    // Diem xep hang cua mot tu truy van
+    const int SCORE_USERNAME_EXACT = 100;
+    const int SCORE_USERNAME_PREFIX = 80;
+    const int SCORE_FIELD_PREFIX = 60;
+    const int SCORE_USERNAME_SUBSTRING = 40;
+    const int SCORE_FIELD_SUBSTRING = 20;
+
+    std::string toLower(const std::string& text) {
+        std::string result(text);
+        for (char& c : result) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return result;
+    }
+
+    // Ky tu ASCII khong phai chu/so la ranh gioi tu; byte UTF-8 (>= 0x80) thuoc ve tu
+    bool isWordChar(char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return u >= 0x80 || std::isalnum(u);
+    }
+
+    void splitWords(const std::string& text, std::vector<std::string>& out) {
+        std::size_t i = 0;
+        while (i < text.size()) {
+            while (i < text.size() && !isWordChar(text[i])) ++i;
+            std::size_t start = i;
+            while (i < text.size() && isWordChar(text[i])) ++i;
+            if (i > start) out.push_back(text.substr(start, i - start));
+        }
+    }
+
+    void addTrigrams(const std::string& field, std::vector<std::uint32_t>& out) {
+        for (std::size_t i = 0; i + 3 <= field.size(); ++i) {
+            out.push_back((static_cast<std::uint32_t>(static_cast<unsigned char>(field[i])) << 16) |
+                          (static_cast<std::uint32_t>(static_cast<unsigned char>(field[i + 1])) << 8) |
+                          static_cast<std::uint32_t>(static_cast<unsigned char>(field[i + 2])));
+        }
+    }
+
+    bool startsWith(const std::string& text, std::size_t pos, const std::string& prefix) {
+        return text.size() - pos >= prefix.size() && text.compare(pos, prefix.size(), prefix) == 0;
+    }
+
+    // 'term' la tien to cua mot tu trong 'field'
+    bool hasWordPrefix(const std::string& field, const std::string& term) {
+        for (std::size_t i = 0; i < field.size(); ++i) {
+            if ((i == 0 || !isWordChar(field[i - 1])) && startsWith(field, i, term)) return true;
+        }
+        return false;
+    }
+
+    void intersectInto(std::vector<std::uint32_t>& acc, const std::vector<std::uint32_t>& other) {
+        std::vector<std::uint32_t> result;
+        std::set_intersection(acc.begin(), acc.end(), other.begin(), other.end(), std::back_inserter(result));
+        acc.swap(result);
+    }
+}
+
+UserSearchIndex::UserSearchIndex() : built(false), building(false) {}
+
+UserSearchIndex& UserSearchIndex::instance() {
+    static UserSearchIndex index;
+    return index;
+}
+
+void UserSearchIndex::build() {
+    {
+        // Tu day moi put() deu duoc giu lai: ban luu sau thoi diem nay co the moi hon ban doc duoi day
+        std::unique_lock<std::shared_timed_mutex> lock(mutex);
+        if (built) return;
+        building = true;
+    }
+    // Doc song song cac file nguoi dung (giong adminViewAllUsers), chi khoa khi dua vao chi muc
+    std::vector<std::string> usernames = ShardLayout::instance().allUsernames();
+    std::vector<std::unique_ptr<User> > users(usernames.size());
+    TaskScheduler::instance().parallelFor(0, usernames.size(), 0, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!usernames[i].empty()) users[i].reset(User::loadFromFile(usernames[i]));
+        }
+    });
+
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if (built) return;
+    docs.reserve(users.size());
+    for (const std::unique_ptr<User>& user : users) {
+        if (user) putLocked(makeDoc(*user), false);
+    }
+    // Cap nhat den trong luc doc file: ap dung sau, theo thu tu
+    for (const Doc& doc : pendingPuts) putLocked(doc, true);
+    pendingPuts.clear();
+    pendingPuts.shrink_to_fit();
+    building = false;
+    built = true;
+}
+
+void UserSearchIndex::collectTerms(const Doc& doc, std::vector<std::string>& words, std::vector<std::uint32_t>& grams) {
+    words.push_back(doc.username);
+    words.push_back(doc.email);
+    words.push_back(doc.phoneNumber);
+    splitWords(doc.username, words);
+    splitWords(doc.fullName, words);
+    splitWords(doc.email, words);
+    addTrigrams(doc.username, grams);
+    addTrigrams(doc.fullName, grams);
+    addTrigrams(doc.email, grams);
+    addTrigrams(doc.phoneNumber, grams);
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+void UserSearchIndex::insertLocked(DocId id) {
+    std::vector<std::string> words;
+    std::vector<std::uint32_t> grams;
+    collectTerms(docs[id], words, grams);
+    for (const std::string& word : words) {
+        if (!word.empty()) tokens.insert(std::make_pair(word, id));
+    }
+    for (std::uint32_t gram : grams) {
+        std::vector<DocId>& posting = trigrams[gram];
+        posting.insert(std::lower_bound(posting.begin(), posting.end(), id), id);
+    }
+}
+
+void UserSearchIndex::eraseLocked(DocId id) {
+    // Tinh lai cac tu/trigram cua ban cu de chi xoa dung cac muc cua tai lieu nay
+    std::vector<std::string> words;
+    std::vector<std::uint32_t> grams;
+    collectTerms(docs[id], words, grams);
+    for (const std::string& word : words) {
+        tokens.erase(std::make_pair(word, id));
+    }
+    for (std::uint32_t gram : grams) {
+        auto posting = trigrams.find(gram);
+        if (posting == trigrams.end()) continue;
+        auto pos = std::lower_bound(posting->second.begin(), posting->second.end(), id);
+        if (pos != posting->second.end() && *pos == id) posting->second.erase(pos);
+        if (posting->second.empty()) trigrams.erase(posting);
+    }
+}
+
+UserSearchIndex::Doc UserSearchIndex::makeDoc(const User& user) {
+    Doc doc;
+    doc.username = toLower(user.getUsername());
+    doc.fullName = toLower(user.getFullName());
+    doc.email = toLower(user.getEmail());
+    doc.phoneNumber = user.getPhoneNumber();
+    doc.account = user.getUsername();
+    doc.displayName = user.getFullName();
+    doc.displayEmail = user.getEmail();
+    return doc;
+}
+
+void UserSearchIndex::putLocked(const Doc& doc, bool replace) {
+    auto it = docOf.find(doc.account);
+    if (it == docOf.end()) {
+        DocId id = static_cast<DocId>(docs.size());
+        docs.push_back(doc);
+        docOf.emplace(doc.account, id);
+        insertLocked(id);
+        return;
+    }
+    if (!replace) return;
+    DocId id = it->second;
+    eraseLocked(id);
+    docs[id] = doc;
+    insertLocked(id);
+}
+
+void UserSearchIndex::put(const User& user) {
+    Doc doc = makeDoc(user);
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    if (built) {
+        putLocked(doc, true);
+    } else if (building) {
+        pendingPuts.push_back(std::move(doc)); // Ban doc tu file co the cu hon
+    }
+    // Chua dung: lan dung dau tien se doc ban moi nhat tu file
+}
+
+int UserSearchIndex::scoreTerm(const Doc& doc, const std::string& term) const {
+    if (doc.username == term) return SCORE_USERNAME_EXACT;
+    if (startsWith(doc.username, 0, term)) return SCORE_USERNAME_PREFIX;
+    if (hasWordPrefix(doc.fullName, term) || hasWordPrefix(doc.email, term) || startsWith(doc.phoneNumber, 0, term)) {
+        return SCORE_FIELD_PREFIX;
+    }
+    if (term.size() < MIN_SUBSTRING_TERM) return 0;
+    if (doc.username.find(term) != std::string::npos) return SCORE_USERNAME_SUBSTRING;
+    if (doc.fullName.find(term) != std::string::npos || doc.email.find(term) != std::string::npos ||
+        doc.phoneNumber.find(term) != std::string::npos) {
+        return SCORE_FIELD_SUBSTRING;
+    }
+    return 0;
+}
+
+UserSearchIndex::Page UserSearchIndex::search(const std::string& query, std::size_t page, std::size_t pageSize) {
+    bool needBuild;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mutex);
+        needBuild = !built;
+    }
+    if (needBuild) build();
+
+    std::vector<std::string> terms;
+    splitWords(toLower(query), terms);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    std::vector<DocId> candidates;
+    if (terms.empty()) {
+        // Truy van rong: liet ke tat ca (theo ten dang nhap)
+        for (DocId id = 0; id < docs.size(); ++id) candidates.push_back(id);
+    }
+    for (std::size_t t = 0; t < terms.size(); ++t) {
+        const std::string& term = terms[t];
+        std::vector<DocId> matches;
+        if (term.size() >= MIN_SUBSTRING_TERM) {
+            // Giao cac danh sach trigram, danh sach ngan nhat truoc
+            std::vector<std::uint32_t> grams;
+            addTrigrams(term, grams);
+            std::vector<const std::vector<DocId>*> postings;
+            bool missing = false;
+            for (std::uint32_t gram : grams) {
+                auto it = trigrams.find(gram);
+                if (it == trigrams.end()) { missing = true; break; }
+                postings.push_back(&it->second);
+            }
+            if (!missing) {
+                std::sort(postings.begin(), postings.end(),
+                          [](const std::vector<DocId>* a, const std::vector<DocId>* b) { return a->size() < b->size(); });
+                matches = *postings[0];
+                for (std::size_t i = 1; i < postings.size() && !matches.empty(); ++i) intersectInto(matches, *postings[i]);
+            }
+        } else {
+            for (auto it = tokens.lower_bound(std::make_pair(term, DocId(0)));
+                 it != tokens.end() && startsWith(it->first, 0, term); ++it) {
+                matches.push_back(it->second);
+            }
+            std::sort(matches.begin(), matches.end());
+            matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+        }
+        if (t == 0) candidates.swap(matches);
+        else intersectInto(candidates, matches);
+        if (candidates.empty()) break;
+    }
+
+    // Kiem tra lai (trigram co the khop sai) va tinh diem
+    std::vector<std::pair<int, DocId> > ranked;
+    for (DocId id : candidates) {
+        int score = 0;
+        for (const std::string& term : terms) {
+            int termScore = scoreTerm(docs[id], term);
+            if (termScore == 0) { score = -1; break; }
+            score += termScore;
+        }
+        if (score >= 0) ranked.push_back(std::make_pair(score, id));
+    }
+    std::sort(ranked.begin(), ranked.end(), [this](const std::pair<int, DocId>& a, const std::pair<int, DocId>& b) {
+        if (a.first != b.first) return a.first > b.first;
+        return docs[a.second].username < docs[b.second].username;
+    });
+
+    Page result;
+    if (pageSize == 0) pageSize = 10;
+    result.total = ranked.size();
+    result.pages = (ranked.size() + pageSize - 1) / pageSize;
+    result.page = std::max<std::size_t>(1, std::min(page, std::max<std::size_t>(1, result.pages)));
+    std::size_t begin = (result.page - 1) * pageSize;
+    std::size_t end = std::min(ranked.size(), begin + pageSize);
+    for (std::size_t i = begin; i < end; ++i) {
+        const Doc& doc = docs[ranked[i].second];
+        Hit hit = {doc.account, doc.displayName, doc.displayEmail, doc.phoneNumber, ranked[i].first};
+        result.hits.push_back(hit);
+    }
+    return result;
+}
+
+std::size_t UserSearchIndex::size() const {
+    std::shared_lock<std::shared_timed_mutex> lock(mutex);
+    return docs.size();
+}
@@ -0,0 +1,86 @@
+// usersearch.h
+#ifndef USERSEARCH_H
+#define USERSEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "user.h"
+
+// Chi muc tim kiem tai khoan cho admin (ten dang nhap, ho ten, email, so dien thoai).
+// - Tien to: tap hop co thu tu cac tu (token) da chuan hoa chu thuong, tim bang lower_bound
+// - Chuoi con (tu 3 ky tu): danh sach tai lieu theo trigram, giao cac danh sach roi kiem tra lai
+// - Ket qua duoc xep hang (khop ten dang nhap truoc, khop tien to truoc khop chuoi con) va chia trang
+// Chi muc duoc dung lan dau khi tim kiem (doc song song cac file nguoi dung), sau do
+// User::saveToFile cap nhat tung tai khoan nen khong phai dung lai. Cap nhat den trong luc dang dung
+// duoc xep hang doi va ap dung sau cac ban doc tu file (file doc truoc do co the da cu).
+class UserSearchIndex {
+public:
+    struct Hit {
+        std::string username;
+        std::string fullName;
+        std::string email;
+        std::string phoneNumber;
+        int score;
+    };
+
+    struct Page {
+        std::vector<Hit> hits;
+        std::size_t total;   // Tong so ket qua khop
+        std::size_t page;    // Trang hien tai (tu 1)
+        std::size_t pages;
+    };
+
+    static UserSearchIndex& instance();
+
+    // Tim cac tai khoan khop moi tu trong 'query' (cach nhau bang khoang trang).
+    // Tu ngan hon 3 ky tu chi khop tien to.
+    Page search(const std::string& query, std::size_t page, std::size_t pageSize);
+
+    // Them hoac cap nhat mot tai khoan (goi sau khi luu thanh cong)
+    void put(const User& user);
+
+    std::size_t size() const;
+
+private:
+    UserSearchIndex();
+    UserSearchIndex(const UserSearchIndex&) = delete;
+    UserSearchIndex& operator=(const UserSearchIndex&) = delete;
+
+    typedef std::uint32_t DocId;
+
+    // Cac truong da chuan hoa chu thuong cua mot tai khoan
+    struct Doc {
+        std::string username;
+        std::string fullName;
+        std::string email;
+        std::string phoneNumber;
+        std::string account;       // Ten dang nhap goc (khoa cua User::loadFromFile)
+        std::string displayName;   // Ho ten goc de hien thi
+        std::string displayEmail;
+    };
+
+    void build();
+    static Doc makeDoc(const User& user);
+    static void collectTerms(const Doc& doc, std::vector<std::string>& words, std::vector<std::uint32_t>& grams);
+    void insertLocked(DocId id);
+    void eraseLocked(DocId id);
+    void putLocked(const Doc& doc, bool replace);
+    int scoreTerm(const Doc& doc, const std::string& term) const;
+
+    mutable std::shared_timed_mutex mutex;
+    bool built;
+    bool building;                     // Dang doc file de dung chi muc: put() vao hang doi
+    std::vector<Doc> pendingPuts;
+    std::vector<Doc> docs;
+    std::unordered_map<std::string, DocId> docOf;                      // username -> tai lieu
+    std::set<std::pair<std::string, DocId> > tokens;                   // (tu, tai lieu)
+    std::unordered_map<std::uint32_t, std::vector<DocId> > trigrams;   // trigram -> tai lieu (tang dan)
+};
+
+#endif // USERSEARCH_H
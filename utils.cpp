@@ -1,5 +1,7 @@
 // utils.cpp
 #include "utils.h"
+#include "fileio.h"
+#include "textscan.h"
 #include <iostream>
 #include <functional> // De su dung std::hash
 #include <algorithm> // De su dung std::remove_if
@@ -88,62 +90,50 @@ namespace Utils {
     }
 
     // Ham doc toan bo noi dung tu mot file
+    // (Doc qua FileIO: tai su dung file descriptor, doc thang vao chuoi ket qua bang pread)
     std::string readFileContent(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            return "";
-        }
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        return buffer.str();
+        std::string content;
+        FileIO::readFile(filename, content);
+        return content;
     }
 
     // Ham ghi noi dung vao mot file (ghi de)
+    // (Ghi nguyen tu: file tam + rename, file cu khong bao gio bi cat ngan giua chung)
     bool writeToFile(const std::string& filename, const std::string& content) {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Loi: Khong the mo file " << filename << " de ghi." << std::endl;
-            return false;
-        }
-        file << content;
-        file.close();
-        return true;
+        return FileIO::replaceFile(filename, content);
     }
 
     // Ham them noi dung vao cuoi mot file
+    // (Noi dung va ky tu xuong dong duoc ghi trong mot lan goi, khong flush tung dong nhu std::endl)
     bool appendToFile(const std::string& filename, const std::string& content) {
-        std::ofstream file(filename, std::ios::app); // Mo o che do append
-        if (!file.is_open()) {
-            std::cerr << "Loi: Khong the mo file " << filename << " de them." << std::endl;
-            return false;
-        }
-        file << content << std::endl; // Them noi dung va xuong dong
-        file.close();
-        return true;
+        std::string record;
+        record.reserve(content.size() + 1);
+        record += content;
+        record += '\n';
+        return FileIO::appendFile(filename, record.data(), record.size());
     }
 
     // Ham doc tat ca cac dong tu mot file
     std::vector<std::string> readAllLines(const std::string& filename) {
-        std::ifstream file(filename);
         std::vector<std::string> lines;
-        if (!file.is_open()) {
-            return lines;
-        }
-        std::string line;
-        while (std::getline(file, line)) {
-            lines.push_back(line);
-        }
-        file.close();
+        FileIO::readLines(filename, lines);
         return lines;
     }
 
     // Ham tach chuoi theo delimiter
+    // (Quet ky tu phan cach bang SIMD, ket qua giong std::getline: khong co token rong o cuoi)
     std::vector<std::string> splitString(const std::string& s, char delimiter) {
         std::vector<std::string> tokens;
-        std::string token;
-        std::istringstream tokenStream(s);
-        while (std::getline(tokenStream, token, delimiter)) {
-            tokens.push_back(token);
+        std::vector<std::size_t> positions;
+        TextScan::findDelimiters(s.data(), s.size(), std::string(1, delimiter), positions);
+        tokens.reserve(positions.size() + 1);
+        std::size_t begin = 0;
+        for (std::size_t pos : positions) {
+            tokens.push_back(s.substr(begin, pos - begin));
+            begin = pos + 1;
+        }
+        if (begin < s.size()) {
+            tokens.push_back(s.substr(begin));
         }
         return tokens;
     }
@@ -42,7 +42,7 @@ namespace Utils {
     // Ham doc toan bo noi dung tu mot file
     std::string readFileContent(const std::string& filename);
 
-    // Ham ghi noi dung vao mot file (ghi de neu file ton tai)
+    // Ham ghi noi dung vao mot file (ghi de nguyen tu neu file ton tai)
     bool writeToFile(const std::string& filename, const std::string& content);
 
     // Ham them noi dung vao cuoi mot file
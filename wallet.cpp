@@ -1,60 +1,186 @@
 // wallet.cpp
 #include "wallet.h"
+#include "fileio.h"
+#include "dataindex.h"
+#include "scheduler.h"
+#include "textscan.h"
+#include "supply.h"
+#include "logwriter.h"
+#include "idempotency.h"
+#include "holds.h"
+#include "backup.h"
+#include "lockmanager.h"
+#include "shards.h"
+#include "changefeed.h"
+#include "logscan.h"
 #include <fstream>
 #include <sstream>
 #include <vector>
 #include <iomanip> // De dinh dang so thuc (std::fixed, std::setprecision)
 #include <stdexcept> // De su dung std::runtime_error
+#include <mutex>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
 
 // --- Trien khai cho cau truc Transaction ---
 
 std::string Transaction::toString() const {
-    std::stringstream ss;
-    ss << "transactionId:" << transactionId << "|"
-       << "senderWalletId:" << senderWalletId << "|"
-       << "receiverWalletId:" << receiverWalletId << "|"
-       << "amount:" << std::fixed << std::setprecision(2) << amount << "|"
-       << "timestamp:" << timestamp << "|" // Luu timestamp
-       << "status:" << status << "|"
-       << "description:" << description;
-    return ss.str();
+    // Ghep truc tiep vao mot chuoi (khong qua stringstream): ham nay nam tren duong ghi log cua moi giao dich
+    char number[64];
+    std::string result;
+    result.reserve(160 + transactionId.size() + status.size() + description.size());
+    result += "transactionId:";
+    result += transactionId;
+    result += "|senderWalletId:";
+    IdInterner::instance().appendTo(sender, result);
+    result += "|receiverWalletId:";
+    IdInterner::instance().appendTo(receiver, result);
+    std::snprintf(number, sizeof(number), "|amount:%.2f|timestamp:%lld|status:", amount,
+                  static_cast<long long>(timestamp));
+    result += number;
+    result += status;
+    if (!requestKey.empty()) {
+        // Truong tuy chon: ban ghi khong co ma yeu cau giu nguyen dinh dang cu (7 truong)
+        result += "|requestKey:";
+        result += requestKey;
+    }
+    result += "|description:";
+    result += description;
+    return result;
 }
 
 Transaction* Transaction::fromString(const std::string& data) {
-    std::vector<std::string> parts = Utils::splitString(data, '|');
-    if (parts.size() != 7) { // 7 truong du lieu
+    TransactionView view;
+    if (!TransactionView::parse(data.data(), data.size(), view)) {
         return nullptr;
     }
+    std::unique_ptr<Transaction> transaction(new Transaction());
+    transaction->transactionId = view.transactionId.str();
+    transaction->sender = view.sender;
+    transaction->receiver = view.receiver;
+    transaction->amount = view.amount;
+    transaction->timestamp = view.timestamp;
+    transaction->status = view.status.str();
+    transaction->requestKey = view.requestKey.str();
+    transaction->description = view.description.str();
+    return transaction.release();
+}
+
+namespace {
+    long long toCents(double amount) {
+        return std::llround(amount * 100.0);
+    }
+
+    // Doc so tu mot truong (khong co '\0' o cuoi) qua bo dem tren stack
+    bool parseNumber(const char* data, std::size_t length, double& value) {
+        char buffer[64];
+        if (length == 0 || length >= sizeof(buffer)) return false;
+        std::memcpy(buffer, data, length);
+        buffer[length] = '\0';
+        char* end = nullptr;
+        value = std::strtod(buffer, &end);
+        return end != buffer;
+    }
+
+    bool parseInteger(const char* data, std::size_t length, long long& value) {
+        char buffer[32];
+        if (length == 0 || length >= sizeof(buffer)) return false;
+        std::memcpy(buffer, data, length);
+        buffer[length] = '\0';
+        char* end = nullptr;
+        value = std::strtoll(buffer, &end, 10);
+        return end != buffer;
+    }
+
+    bool keyIs(const char* data, const TextScan::KeyValueRef& field, const char* key, std::size_t keyLength) {
+        return field.keyLength == keyLength && std::memcmp(data + field.keyBegin, key, keyLength) == 0;
+    }
+
+    // File vi nam trong phan vung cua walletId (bo cuc phang: data/wallets/)
+    std::string walletPath(const std::string& walletId) {
+        return ShardLayout::instance().walletFile(walletId);
+    }
+    // Bien nhan cua giao dich co ma yeu cau: ton tai tu luc commit hai vi den khi ban ghi log da xuong dia
+    const char* const RECEIPTS_DIR = "data/requests";
+
+    std::string receiptPath(const std::string& transactionId) {
+        return std::string(RECEIPTS_DIR) + "/" + transactionId + ".txt";
+    }
+
+    // Khoa doc-so sanh-ghi cua vi (giua cac thread va cac tien trinh dung chung data/, xem LockManager).
+    // Chi giu trong luc kiem tra phien ban va rename file, khong phai trong ca giao dich.
+    LockManager::Slot walletSlot(const std::string& walletId) {
+        return LockManager::entity('W', walletId);
+    }
+
+    // Phien ban trong noi dung file vi (khong co truong version: 0)
+    unsigned long long parseVersion(const std::string& data) {
+        std::vector<TextScan::KeyValueRef> fields;
+        TextScan::splitKeyValues(data, '\n', fields);
+        for (const TextScan::KeyValueRef& field : fields) {
+            if (keyIs(data.data(), field, "version", 7)) {
+                return std::strtoull(data.c_str() + field.valueBegin, nullptr, 10);
+            }
+        }
+        return 0;
+    }
+}
 
-    Transaction* transaction = new Transaction();
-    for (const std::string& part : parts) {
-        std::vector<std::string> keyValue = Utils::splitString(part, ':');
-        if (keyValue.size() < 2) continue;
-        std::string key = Utils::trimString(keyValue[0]);
-        std::string value = Utils::trimString(keyValue[1]);
+bool TransactionView::parse(const char* data, std::size_t length, TransactionView& out) {
+    // Tach cac truong '|' va vi tri ':' trong mot lan quet (bo dem vi tri dung lai theo thread)
+    static thread_local std::vector<TextScan::KeyValueRef> fields;
+    // 7 truong du lieu, them requestKey neu giao dich co ma yeu cau
+    std::size_t fieldCount = TextScan::splitKeyValues(data, length, '|', fields);
+    if (fieldCount != 7 && fieldCount != 8) {
+        return false;
+    }
 
-        if (key == "transactionId") transaction->transactionId = value;
-        else if (key == "senderWalletId") transaction->senderWalletId = value;
-        else if (key == "receiverWalletId") transaction->receiverWalletId = value;
-        else if (key == "amount") transaction->amount = std::stod(value);
-        else if (key == "timestamp") transaction->timestamp = std::stoll(value);
-        else if (key == "status") transaction->status = value;
-        else if (key == "description") transaction->description = value;
+    out = TransactionView();
+    out.sender = out.receiver = IdInterner::NONE;
+    out.amount = 0.0;
+    out.timestamp = 0;
+    IdInterner& interner = IdInterner::instance();
+    for (const TextScan::KeyValueRef& field : fields) {
+        const char* value = data + field.valueBegin; // Phan con lai sau dau ':' dau tien
+        if (keyIs(data, field, "transactionId", 13)) {
+            out.transactionId = StringRef(value, field.valueLength);
+        } else if (keyIs(data, field, "senderWalletId", 14)) {
+            out.sender = interner.intern(value, field.valueLength);
+        } else if (keyIs(data, field, "receiverWalletId", 16)) {
+            out.receiver = interner.intern(value, field.valueLength);
+        } else if (keyIs(data, field, "amount", 6)) {
+            if (!parseNumber(value, field.valueLength, out.amount)) return false;
+        } else if (keyIs(data, field, "timestamp", 9)) {
+            long long timestamp = 0;
+            if (!parseInteger(value, field.valueLength, timestamp)) return false;
+            out.timestamp = static_cast<time_t>(timestamp);
+        } else if (keyIs(data, field, "status", 6)) {
+            out.status = StringRef(value, field.valueLength);
+        } else if (keyIs(data, field, "requestKey", 10)) {
+            out.requestKey = StringRef(value, field.valueLength);
+        } else if (keyIs(data, field, "description", 11)) {
+            out.description = StringRef(value, field.valueLength);
+        }
     }
-    return transaction;
+    return true;
 }
 
 // --- Trien khai cho lop Wallet ---
 
 // Constructor cho vi moi
 Wallet::Wallet(std::string ownerUserId)
-    : ownerUserId(ownerUserId), balance(0.0) {
+    : ownerUserId(ownerUserId), balance(0.0), version(0) {
     this->walletId = Utils::generateUniqueId(); // Sinh ID duy nhat cho vi
 }
 
 // Constructor khi doc tu file
-Wallet::Wallet(std::string walletId, std::string ownerUserId, double balance)
-    : walletId(walletId), ownerUserId(ownerUserId), balance(balance) {}
+Wallet::Wallet(std::string walletId, std::string ownerUserId, double balance, unsigned long long version)
+    : walletId(walletId), ownerUserId(ownerUserId), balance(balance), version(version) {}
 
 // Hien thi thong tin vi
 void Wallet::displayWalletInfo() const {
@@ -62,6 +188,12 @@ void Wallet::displayWalletInfo() const {
     std::cout << "ID Vi: " << walletId << std::endl;
     std::cout << "ID Nguoi so huu: " << ownerUserId << std::endl;
     std::cout << "So du: " << std::fixed << std::setprecision(2) << balance << " diem" << std::endl;
+    IdHandle handle = IdInterner::instance().find(walletId);
+    long long held = handle == IdInterner::NONE ? 0 : HoldManager::instance().heldCents(handle);
+    if (held > 0) {
+        std::cout << "Dang giu cho giao dich: " << held / 100.0 << " diem, kha dung: " << balance - held / 100.0
+                  << " diem" << std::endl;
+    }
     std::cout << "--------------------------" << std::endl;
 }
 
@@ -70,98 +202,212 @@ std::string Wallet::toString() const {
     std::stringstream ss;
     ss << "walletId:" << walletId << "\n"
        << "ownerUserId:" << ownerUserId << "\n"
-       << "balance:" << std::fixed << std::setprecision(2) << balance;
+       << "balance:" << std::fixed << std::setprecision(2) << balance << "\n"
+       << "version:" << version;
     return ss.str();
 }
 
 // Tao doi tuong Wallet tu chuoi doc tu file
 Wallet* Wallet::fromString(const std::string& data) {
-    std::string line;
-    std::istringstream iss(data);
-
     std::string walletId, ownerUserId;
     double balance = 0.0;
+    unsigned long long version = 0; // File cu (truoc khi co phien ban): 0
 
-    while (std::getline(iss, line)) {
-        std::vector<std::string> parts = Utils::splitString(line, ':');
-        if (parts.size() < 2) continue;
-        std::string key = Utils::trimString(parts[0]);
-        std::string value = Utils::trimString(parts[1]);
+    std::vector<TextScan::KeyValueRef> fields;
+    TextScan::splitKeyValues(data, '\n', fields);
+    for (const TextScan::KeyValueRef& field : fields) {
+        std::string key = data.substr(field.keyBegin, field.keyLength);
+        std::string value = data.substr(field.valueBegin, field.valueLength);
 
         if (key == "walletId") walletId = value;
         else if (key == "ownerUserId") ownerUserId = value;
         else if (key == "balance") balance = std::stod(value);
+        else if (key == "version") version = std::stoull(value);
     }
 
     if (walletId.empty() || ownerUserId.empty()) {
         return nullptr; // Du lieu khong hop le
     }
 
-    return new Wallet(walletId, ownerUserId, balance);
+    return new Wallet(walletId, ownerUserId, balance, version);
 }
 
 // Luu doi tuong Wallet vao file
 // (Da them cap nhat file index)
-bool Wallet::saveToFile() const {
-    std::string walletDir = "data/wallets/";
-    std::string walletIndexFile = "data/wallet_index.txt"; // File index vi
-    
-    // Dam bao thu muc 'data' va 'data/wallets' ton tai
+bool Wallet::saveToFile() {
+    LockManager::Guard lock(walletSlot(walletId));
+    SaveResult result = stageSave();
+    if (result == SaveResult::Conflict) {
+        std::cerr << "Loi: Vi " << walletId << " da bi cap nhat boi phien khac (phien ban " << version
+                  << " da cu). Vui long tai lai vi." << std::endl;
+        return false;
+    }
+    if (result == SaveResult::Saved) {
+        publishSave(); // Van giu khoa: chi muc khong bi ghi de boi ban cu hon
+    }
+    return result == SaveResult::Saved;
+}
+
+bool Wallet::readStoredVersion(unsigned long long& stored) const {
+    // Doc truc tiep (khong qua fd trong cache): file co the vua bi tien trinh khac thay the
+    std::string content;
+    if (!FileIO::readFileOnce(walletPath(walletId), content)) {
+        return false;
+    }
+    stored = parseVersion(content);
+    return true;
+}
+
+Wallet::SaveResult Wallet::stageSave() {
+    // Dam bao thu muc 'data' va thu muc vi ton tai
+    ShardLayout& layout = ShardLayout::instance();
     Utils::createDirectoryIfNotExists("data");
-    Utils::createDirectoryIfNotExists(walletDir);
+    Utils::createDirectoryIfNotExists(layout.walletDir(layout.shardOf(walletId)));
 
-    std::string filename = walletDir + walletId + ".txt"; // Luu theo walletId
-    bool success = Utils::writeToFile(filename, toString());
+    // Chua co file (vi moi): khong co gi de ghi de
+    unsigned long long stored = 0;
+    if (readStoredVersion(stored) && stored != version) {
+        return SaveResult::Conflict;
+    }
+    version++;
+    std::string filename = walletPath(walletId); // Luu theo walletId
+    if (!Utils::writeToFile(filename, toString())) {
+        version--;
+        return SaveResult::Failed;
+    }
+    return SaveResult::Saved;
+}
 
-    if (success) {
-        // Kiem tra xem walletId da co trong index chua truoc khi them de tranh trung lap
-        std::vector<std::string> existingWalletIds = Utils::readAllLines(walletIndexFile);
+void Wallet::publishSave() const {
+    ShardLayout& layout = ShardLayout::instance();
+    std::string walletIndexFile = layout.walletIndexFile(layout.shardOf(walletId)); // File index vi
+
+    // Kiem tra xem walletId da co trong index chua truoc khi them de tranh trung lap
+    // (Khi chi muc trong bo nho da duoc nap thi khong can doc lai file index)
+    DataIndex& index = DataIndex::instance();
+    {
+        // Kiem tra va them duoi cung mot khoa: tien trinh khac khong them trung walletId vao giua
+        LockManager::Guard indexLock(LockManager::resource(LockManager::Resource::WalletIndex));
         bool foundInIndex = false;
-        for(const std::string& wid : existingWalletIds) {
-            if(wid == walletId) {
-                foundInIndex = true;
-                break;
+        if (index.isLoaded()) {
+            foundInIndex = index.hasWallet(walletId);
+        } else {
+            std::vector<std::string> existingWalletIds = Utils::readAllLines(walletIndexFile);
+            for(const std::string& wid : existingWalletIds) {
+                if(wid == walletId) {
+                    foundInIndex = true;
+                    break;
+                }
             }
         }
         if(!foundInIndex) {
             Utils::appendToFile(walletIndexFile, walletId); // Them walletId vao index file
         }
     }
-    return success;
+    index.putWallet(*this);
+    index.recordDelta('W', walletId); // De snapshot chi muc duoc cap nhat lan khoi dong sau
+    ChangeFeed::instance().publish(ChangeFeed::Kind::Wallet, walletId, ChangeFeed::payloadOf(toString()));
 }
 
 // Tai doi tuong Wallet tu file dua tren walletId
 // Thay doi kieu tra ve tu Wallet* sang std::unique_ptr<Wallet>
 std::unique_ptr<Wallet> Wallet::loadFromFile(const std::string& walletId) {
-    std::string walletDir = "data/wallets/";
-    std::string filename = walletDir + walletId + ".txt";
-    std::string content = Utils::readFileContent(filename);
-    if (content.empty()) {
-        return nullptr; // Khong tim thay file hoac file trong
+    // Tra cuu chi muc trong bo nho truoc (neu da warm-start)
+    DataIndex& index = DataIndex::instance();
+    if (index.isLoaded()) {
+        if (std::unique_ptr<Wallet> cached = index.findWallet(walletId)) {
+            return cached;
+        }
+    }
+
+    std::string filename = walletPath(walletId);
+    std::string content;
+    if (!FileIO::readFile(filename, content)) {
+        return nullptr; // Khong tim thay file
     }
     // Tra ve unique_ptr tu con tro duoc cap phat dong
-    return std::unique_ptr<Wallet>(fromString(content));
+    std::unique_ptr<Wallet> wallet;
+    try {
+        wallet.reset(fromString(content));
+    } catch (const std::exception&) {
+        wallet.reset();
+    }
+    if (!wallet) {
+        // File ton tai nhung khong doc duoc: khong coi nhu vi khong ton tai
+        std::cerr << "Loi: Du lieu vi " << walletId << " bi hong (" << filename << ")." << std::endl;
+    } else {
+        index.putWallet(*wallet); // File duoc tao ngoai chi muc (vi du them thu cong)
+    }
+    return wallet;
+}
+
+std::unique_ptr<Wallet> Wallet::reloadFromFile(const std::string& walletId) {
+    std::string content;
+    if (!FileIO::readFileOnce(walletPath(walletId), content)) {
+        return nullptr;
+    }
+    std::unique_ptr<Wallet> wallet;
+    try {
+        wallet.reset(fromString(content));
+    } catch (const std::exception&) {
+        wallet.reset();
+    }
+    if (wallet) {
+        DataIndex::instance().putWallet(*wallet);
+    }
+    return wallet;
+}
+
+// Kiem tra noi dung file vi co hop le hay khong (dung khi phuc hoi du lieu)
+bool Wallet::isValidRecord(const std::string& data) {
+    try {
+        std::unique_ptr<Wallet> wallet(fromString(data));
+        return wallet != nullptr;
+    } catch (const std::exception&) {
+        return false;
+    }
 }
 
 // Tai doi tuong Wallet tu file dua tren ownerUserId
 // Thay doi kieu tra ve tu Wallet* sang std::unique_ptr<Wallet>
 std::unique_ptr<Wallet> Wallet::loadWalletByUserId(const std::string& userId) {
-    std::string walletIndexFile = "data/wallet_index.txt"; // File index vi
-    std::vector<std::string> walletIds = Utils::readAllLines(walletIndexFile); // Doc tat ca walletIds tu file index
-
-    for (const std::string& walletId : walletIds) {
-        // Su dung auto de unique_ptr tu dong quan ly bo nho
-        if (auto wallet = loadFromFile(walletId)) { // loadFromFile tra ve unique_ptr
-            if (wallet->ownerUserId == userId) {
-                return wallet; // Tra ve unique_ptr tim duoc
+    // Chi muc owner -> vi: tra cuu O(1) thay vi doc lan luot tat ca cac vi
+    DataIndex& index = DataIndex::instance();
+    std::string indexedWalletId;
+    if (index.isLoaded() && index.findWalletIdByOwner(userId, indexedWalletId)) {
+        return loadFromFile(indexedWalletId);
+    }
+
+    // Doc tat ca walletIds tu file index (cua moi phan vung)
+    std::vector<std::string> walletIds = ShardLayout::instance().allWalletIds();
+
+    // Doc song song cac vi; tim thay thi huy cac phan chua duoc quet
+    TaskGroup scan;
+    std::mutex foundMutex;
+    std::unique_ptr<Wallet> found;
+    scan.parallelFor(0, walletIds.size(), 0, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end && !scan.isCancelled(); ++i) {
+            // Su dung auto de unique_ptr tu dong quan ly bo nho
+            if (auto wallet = loadFromFile(walletIds[i])) { // loadFromFile tra ve unique_ptr
+                if (wallet->ownerUserId == userId) {
+                    std::lock_guard<std::mutex> lock(foundMutex);
+                    found = std::move(wallet);
+                    scan.cancel();
+                }
             }
         }
-    }
-    return nullptr; // Khong tim thay vi cho userId nay
+    });
+    return found; // nullptr neu khong tim thay vi cho userId nay
 }
 
 // Phuong thuc thuc hien giao dich chuyen diem (atomic)
-bool Wallet::transferPoints(const std::string& senderUserId, const std::string& receiverWalletId, double amount) {
+bool Wallet::transferPoints(const std::string& senderUserId, const std::string& receiverWalletId, double amount,
+                            const TransferLimits::Limits& limits, const std::string& requestKey) {
+    if (!requestKey.empty() && !IdempotencyTable::isValidKey(requestKey)) {
+        std::cout << "Loi: Ma yeu cau khong hop le (1-64 ky tu, khong co khoang trang hoac '|')." << std::endl;
+        return false;
+    }
+
     // Su dung unique_ptr de tu dong giai phong bo nho
     std::unique_ptr<Wallet> senderWallet = Wallet::loadWalletByUserId(senderUserId);
     if (!senderWallet) {
@@ -181,45 +427,177 @@ bool Wallet::transferPoints(const std::string& senderUserId, const std::string&
         return false;
     }
 
+    return executeTransfer(senderWallet.get(), receiverWallet.get(), amount, limits, requestKey, nullptr);
+}
+
+Wallet::SaveResult Wallet::saveTransfer(Wallet* senderWallet, Wallet* receiverWallet, double amount,
+                                        const Transaction& transaction) {
+    LockManager::Guard lock(walletSlot(senderWallet->walletId), walletSlot(receiverWallet->walletId));
+    senderWallet->balance -= amount;
+    receiverWallet->balance += amount;
+
+    // Hai vi duoc ghi ra file tam roi commit cung nhau: neu mot ben loi, khong file nao bi thay doi.
+    SaveResult result;
+    bool committed = false;
+    {
+        FileIO::ReplaceGroup saveGroup;
+        result = senderWallet->stageSave();
+        if (result == SaveResult::Saved) {
+            result = receiverWallet->stageSave();
+            if (result != SaveResult::Saved) senderWallet->version--; // File tam cua vi gui bi bo
+        }
+        if (result == SaveResult::Saved && !transaction.requestKey.empty()) {
+            Transaction receipt = transaction;
+            receipt.status = "completed";
+            if (!FileIO::replaceFile(receiptPath(receipt.transactionId), receipt.toString())) {
+                senderWallet->version--;
+                receiverWallet->version--;
+                result = SaveResult::Failed;
+            }
+        }
+        committed = result == SaveResult::Saved && saveGroup.commit();
+    }
+    if (committed) {
+        // Hai vi va giao dich vao luong thay doi bang mot lan ghi, trong luc van giu khoa hai vi
+        ChangeFeed::Batch changes;
+        senderWallet->publishSave();
+        receiverWallet->publishSave();
+        Transaction completed = transaction;
+        completed.status = "completed";
+        ChangeFeed::instance().publish(ChangeFeed::Kind::Transfer, completed.transactionId, completed.toString());
+        return SaveResult::Saved;
+    }
+
+    // Phuc hoi trang thai ban dau
+    senderWallet->balance += amount; // Hoan lai diem cho nguoi gui
+    receiverWallet->balance -= amount; // Tru diem da cong cho nguoi nhan
+    if (result != SaveResult::Saved) {
+        return result; // Chua commit: file tren dia chua bi thay doi
+    }
+    // Commit loi giua chung: vi nao da duoc thay file thi ghi lai so du cu (con giu khoa nen
+    // phien ban trong file chinh la ban vua ghi)
+    Wallet* wallets[2] = {senderWallet, receiverWallet};
+    for (Wallet* wallet : wallets) {
+        unsigned long long stored = 0;
+        if (wallet->readStoredVersion(stored) && stored == wallet->version) {
+            if (wallet->stageSave() == SaveResult::Saved) wallet->publishSave();
+        } else {
+            wallet->version--;
+        }
+    }
+    return SaveResult::Failed;
+}
+
+// Phan chung cua transferPoints va commitTransfer: ghi hai vi va log giao dich.
+// 'hold' (neu co) la giu cho cua chinh giao dich nay: so diem do duoc tinh vao so du kha dung.
+bool Wallet::executeTransfer(Wallet* senderWallet, Wallet* receiverWallet, double amount,
+                             const TransferLimits::Limits& limits, const std::string& requestKey,
+                             const HoldManager::Hold* hold) {
     Transaction newTransaction;
+    newTransaction.sender = internId(senderWallet->walletId);
+    newTransaction.receiver = internId(receiverWallet->walletId);
+
+    // Chong trung lap: yeu cau gui lai (cung ma) tra ve ket qua cua lan dau, khong chuyen diem lan nua
+    IdempotencyTable& dedup = IdempotencyTable::instance();
+    if (!requestKey.empty()) {
+        IdempotencyTable::Outcome previous;
+        IdempotencyTable::Claim claim = dedup.claim(newTransaction.sender, requestKey, newTransaction.receiver, amount, previous);
+        if (claim == IdempotencyTable::Claim::Conflict) {
+            std::cout << "Loi: Ma yeu cau da duoc dung cho mot giao dich khac (nguoi nhan hoac so diem khac)." << std::endl;
+            return false;
+        }
+        if (claim == IdempotencyTable::Claim::Duplicate) {
+            std::cout << "Yeu cau nay da duoc xu ly luc " << Utils::timeToString(previous.timestamp)
+                      << " (ma giao dich " << previous.transactionId << ", "
+                      << (previous.completed ? "thanh cong" : "that bai") << "). Khong thuc hien lai." << std::endl;
+            return previous.completed;
+        }
+    }
+
     newTransaction.transactionId = Utils::generateUniqueId();
-    newTransaction.senderWalletId = senderWallet->walletId;
-    newTransaction.receiverWalletId = receiverWallet->walletId;
+    newTransaction.requestKey = requestKey;
     newTransaction.amount = amount;
     newTransaction.timestamp = time(0);
     newTransaction.description = "Chuyen diem";
 
     bool transactionSuccess = false; // Bien de luu ket qua giao dich
 
+    // Han muc: kiem tra va ghi nhan truoc khi ghi vi; hoan lai neu giao dich khong thanh cong
+    TransferLimits& limiter = TransferLimits::instance();
+    TransferLimits::Usage usage;
+    TransferLimits::Verdict verdict = limiter.consume(newTransaction.sender, limits, toCents(amount), usage);
+    if (verdict != TransferLimits::Verdict::Allowed) {
+        newTransaction.status = "failed";
+        newTransaction.description = TransferLimits::describe(verdict);
+        std::cout << TransferLimits::describe(verdict) << " Khong the tien hanh giao dich." << std::endl;
+        logTransaction(newTransaction);
+        if (!requestKey.empty()) {
+            IdempotencyTable::Outcome outcome = {newTransaction.transactionId, false, newTransaction.timestamp};
+            dedup.complete(newTransaction.sender, requestKey, outcome);
+        }
+        return false;
+    }
+
+    // Ban sao luu khong cat giua luc ghi hai vi va luc ghi log cua giao dich nay
+    BackupManager::CommitFence backupFence;
     try {
-        if (senderWallet->balance < amount) {
-            newTransaction.status = "failed";
-            newTransaction.description = "So du khong du. Khong the tien hanh.";
-            std::cout << "So du khong du. Khong the tien hanh giao dich." << std::endl;
-            // Khong throw ngoai le o day, chi dat status va return false
-            transactionSuccess = false; // Cap nhat ket qua
-        } else {
-            // Tac vu 3_1: Tru diem tu vi A
-            senderWallet->balance -= amount;
-            // Tac vu 3_2: Cong diem vao vi B
-            receiverWallet->balance += amount;
-
-            // Luu thay doi vao file
-            bool senderSaveSuccess = senderWallet->saveToFile();
-            bool receiverSaveSuccess = receiverWallet->saveToFile();
-
-            if (!senderSaveSuccess || !receiverSaveSuccess) {
-                // Neu co loi khi luu, phuc hoi trang thai ban dau
-                senderWallet->balance += amount; // Hoan lai diem cho nguoi gui
-                receiverWallet->balance -= amount; // Tru diem da cong cho nguoi nhan
-                senderWallet->saveToFile(); // Co gang luu lai trang thai cu
-                receiverWallet->saveToFile(); // Co gang luu lai trang thai cu
-                throw std::runtime_error("Loi khi luu du lieu vi. Giao dich da duoc hoan tac.");
+        // So du kha dung: tru cac giu cho khac dang cho commit tren vi gui
+        HoldManager& holds = HoldManager::instance();
+        long long heldByOthers = holds.heldCents(newTransaction.sender) - (hold ? hold->cents : 0);
+        for (int attempt = 1; ; ++attempt) {
+            unsigned long long storedVersion = 0;
+            bool insufficient = toCents(senderWallet->balance) - heldByOthers < toCents(amount);
+            if (insufficient && attempt < MAX_SAVE_ATTEMPTS && senderWallet->readStoredVersion(storedVersion) &&
+                storedVersion != senderWallet->version) {
+                // So du trong chi muc da cu (tien trinh khac vua ghi vi): kiem tra lai voi ban trong file
+                if (std::unique_ptr<Wallet> fresh = reloadFromFile(senderWallet->walletId)) {
+                    *senderWallet = *fresh;
+                    continue;
+                }
+            }
+            if (insufficient) {
+                newTransaction.status = "failed";
+                newTransaction.description = "So du khong du. Khong the tien hanh.";
+                std::cout << "So du khong du. Khong the tien hanh giao dich." << std::endl;
+                // Khong throw ngoai le o day, chi dat status va return false
+                transactionSuccess = false; // Cap nhat ket qua
+                break;
             }
 
-            newTransaction.status = "completed";
-            std::cout << "Chuyen diem thanh cong!" << std::endl;
-            transactionSuccess = true; // Cap nhat ket qua
+            // Tac vu 3_1 + 3_2: tru diem vi A, cong diem vi B va luu ca hai (theo phien ban)
+            // SettleGuard: bo kiem tra tong cung khong chay giua luc ghi hai vi va luc cap nhat bo dem
+            SaveResult result;
+            {
+                SupplyMonitor::SettleGuard settle;
+                double senderBefore = senderWallet->balance, receiverBefore = receiverWallet->balance;
+                result = saveTransfer(senderWallet, receiverWallet, amount, newTransaction);
+                if (result == SaveResult::Saved) {
+                    SupplyMonitor::instance().recordTransfer(senderBefore, senderWallet->balance, receiverBefore,
+                                                             receiverWallet->balance);
+                }
+            }
+            if (result == SaveResult::Saved) {
+                newTransaction.status = "completed";
+                std::cout << "Chuyen diem thanh cong!" << std::endl;
+                transactionSuccess = true; // Cap nhat ket qua
+                break;
+            }
+            if (result == SaveResult::Failed) {
+                throw std::runtime_error("Loi khi luu du lieu vi. Giao dich da duoc hoan tac.");
+            }
+            // Xung dot phien ban: vi vua bi ghi boi thread/tien trinh khac. Doc lai hai vi va thu lai
+            // (so du moi duoc kiem tra lai o dau vong lap).
+            if (attempt >= MAX_SAVE_ATTEMPTS) {
+                throw std::runtime_error("Vi dang duoc cap nhat dong thoi, vui long thu lai sau.");
+            }
+            std::unique_ptr<Wallet> freshSender = reloadFromFile(senderWallet->walletId);
+            std::unique_ptr<Wallet> freshReceiver = reloadFromFile(receiverWallet->walletId);
+            if (!freshSender || !freshReceiver) {
+                throw std::runtime_error("Khong doc lai duoc du lieu vi.");
+            }
+            *senderWallet = *freshSender;
+            *receiverWallet = *freshReceiver;
+            std::this_thread::sleep_for(std::chrono::microseconds(50 << attempt)); // Lui dan truoc khi thu lai
         }
 
     } catch (const std::exception& e) {
@@ -229,13 +607,176 @@ bool Wallet::transferPoints(const std::string& senderUserId, const std::string&
         transactionSuccess = false; // Cap nhat ket qua
     }
 
+    if (!transactionSuccess) limiter.refund(usage);
+
     // Ghi log giao dich vao transactions.log bat ke thanh cong hay that bai
     // Phan nay se luon duoc thuc thi sau try-catch block
-    Utils::appendToFile("data/transactions.log", newTransaction.toString());
+    // Co ma yeu cau: bao ket qua cho client chi sau khi ban ghi (mang ma) da xuong dia, roi moi bo bien nhan
+    bool receipt = transactionSuccess && !requestKey.empty();
+    if (!logTransaction(newTransaction, receipt)) {
+        std::cerr << "Canh bao: Giao dich " << newTransaction.transactionId
+                  << " chua duoc xac nhan da ghi vao transactions.log." << std::endl;
+    } else if (receipt) {
+        std::remove(receiptPath(newTransaction.transactionId).c_str());
+    }
+    if (!requestKey.empty()) {
+        IdempotencyTable::Outcome outcome = {newTransaction.transactionId, transactionSuccess, newTransaction.timestamp};
+        dedup.complete(newTransaction.sender, requestKey, outcome);
+    }
     
-    // unique_ptr senderWallet va receiverWallet se tu dong giai phong bo nho khi ra khoi ham
 	// hihihi
 	
     return transactionSuccess; // Tra ve ket qua giao dich
 }
 
+bool Wallet::holdsAvailable() {
+    return !LockManager::instance().heldByOtherProcess(LockManager::resource(LockManager::Resource::Instances));
+}
+
+HoldManager::HoldId Wallet::reserveTransfer(const std::string& senderUserId, const std::string& receiverWalletId,
+                                            double amount, const TransferLimits::Limits& limits,
+                                            const std::string& requestKey, unsigned int holdSeconds) {
+    if (!requestKey.empty() && !IdempotencyTable::isValidKey(requestKey)) {
+        std::cout << "Loi: Ma yeu cau khong hop le (1-64 ky tu, khong co khoang trang hoac '|')." << std::endl;
+        return HoldManager::NO_HOLD;
+    }
+    std::unique_ptr<Wallet> senderWallet = Wallet::loadWalletByUserId(senderUserId);
+    if (!senderWallet) {
+        std::cout << "Loi: Khong tim thay vi cua nguoi gui." << std::endl;
+        return HoldManager::NO_HOLD;
+    }
+    std::unique_ptr<Wallet> receiverWallet = Wallet::loadFromFile(receiverWalletId);
+    if (!receiverWallet) {
+        std::cout << "Loi: Khong tim thay vi cua nguoi nhan." << std::endl;
+        return HoldManager::NO_HOLD;
+    }
+    if (senderWallet->walletId == receiverWallet->walletId) {
+        std::cout << "Loi: Khong the chuyen diem cho chinh vi cua ban." << std::endl;
+        return HoldManager::NO_HOLD;
+    }
+
+    if (!holdsAvailable()) {
+        std::cout << "Loi: Co tien trinh khac dang dung chung du lieu, khong the giu diem (chuyen diem hai giai doan)."
+                  << std::endl;
+        return HoldManager::NO_HOLD;
+    }
+    // Chi muc co the cu (tien trinh khac vua ghi vi truoc khi khoi dong lai o che do mot tien trinh):
+    // giu diem theo so du trong file
+    unsigned long long storedVersion = 0;
+    if (senderWallet->readStoredVersion(storedVersion) && storedVersion != senderWallet->version) {
+        std::unique_ptr<Wallet> fresh = reloadFromFile(senderWallet->walletId);
+        if (!fresh) {
+            std::cout << "Loi: Khong doc lai duoc du lieu vi." << std::endl;
+            return HoldManager::NO_HOLD;
+        }
+        senderWallet = std::move(fresh);
+    }
+
+    IdHandle sender = internId(senderWallet->walletId);
+    IdHandle receiver = internId(receiverWallet->walletId);
+    IdempotencyTable::Outcome previous;
+    if (!requestKey.empty() && IdempotencyTable::instance().find(sender, requestKey, previous)) {
+        // Yeu cau gui lai: khong giu diem, bao lai ket qua cu
+        std::cout << "Yeu cau nay da duoc xu ly luc " << Utils::timeToString(previous.timestamp)
+                  << " (ma giao dich " << previous.transactionId << ", "
+                  << (previous.completed ? "thanh cong" : "that bai") << "). Khong thuc hien lai." << std::endl;
+        return HoldManager::NO_HOLD;
+    }
+
+    // Vuot han muc thi bao ngay, khong giu diem va khong gui OTP (commit van kiem tra lai)
+    TransferLimits::Verdict verdict = TransferLimits::instance().check(sender, limits, toCents(amount));
+    HoldManager::HoldId hold = HoldManager::NO_HOLD;
+    if (verdict == TransferLimits::Verdict::Allowed) {
+        hold = HoldManager::instance().place(sender, receiver, toCents(amount), toCents(senderWallet->balance),
+                                             holdSeconds);
+    }
+    if (hold == HoldManager::NO_HOLD) {
+        // Giong transferPoints: lan chuyen bi tu choi vi so du hoac han muc van duoc ghi vao log
+        Transaction rejected;
+        rejected.transactionId = Utils::generateUniqueId();
+        rejected.sender = sender;
+        rejected.receiver = receiver;
+        rejected.amount = amount;
+        rejected.timestamp = time(0);
+        rejected.status = "failed";
+        if (verdict != TransferLimits::Verdict::Allowed) {
+            rejected.description = TransferLimits::describe(verdict);
+            std::cout << TransferLimits::describe(verdict) << " Khong the tien hanh giao dich." << std::endl;
+        } else {
+            rejected.description = "So du kha dung khong du. Khong the tien hanh.";
+            std::cout << "So du kha dung khong du. Khong the tien hanh giao dich." << std::endl;
+        }
+        logTransaction(rejected);
+    }
+    return hold;
+}
+
+bool Wallet::commitTransfer(const std::string& senderUserId, HoldManager::HoldId holdId,
+                            const TransferLimits::Limits& limits, const std::string& requestKey) {
+    HoldManager::Hold hold;
+    if (!HoldManager::instance().beginCommit(holdId, hold)) {
+        std::cout << "Loi: Giu cho da het han hoac da bi huy. Vui long thuc hien lai giao dich." << std::endl;
+        return false;
+    }
+    std::unique_ptr<Wallet> senderWallet = Wallet::loadFromFile(idToString(hold.sender));
+    std::unique_ptr<Wallet> receiverWallet = Wallet::loadFromFile(idToString(hold.receiver));
+    if (!senderWallet || senderWallet->ownerUserId != senderUserId || !receiverWallet) {
+        HoldManager::instance().release(holdId);
+        std::cout << "Loi: Giu cho khong thuoc ve vi cua ban hoac vi khong con ton tai." << std::endl;
+        return false;
+    }
+    bool success = executeTransfer(senderWallet.get(), receiverWallet.get(), hold.cents / 100.0, limits, requestKey,
+                                   &hold);
+    // Hai vi da ghi xong (hoac giao dich bi tu choi): so diem khong con can giu
+    HoldManager::instance().release(holdId);
+    return success;
+}
+
+bool Wallet::cancelTransfer(HoldManager::HoldId holdId) {
+    return HoldManager::instance().cancel(holdId);
+}
+
+// Dua mot giao dich vao hang doi ghi transactions.log (thread ghi cap nhat chi muc giao dich)
+bool Wallet::logTransaction(const Transaction& transaction, bool durable) {
+    std::string record = transaction.toString();
+    record += '\n';
+    return TransactionLogWriter::instance().append(std::move(record), transaction.sender, transaction.receiver, durable);
+}
+
+int Wallet::recoverReceipts() {
+    std::unordered_map<std::string, std::unique_ptr<Transaction> > receipts;
+    std::vector<std::string> files;
+    for (const std::string& name : FileIO::listDirectory(RECEIPTS_DIR)) {
+        std::string path = std::string(RECEIPTS_DIR) + "/" + name;
+        files.push_back(path);
+        std::string content;
+        if (name.find(".tmp-") != std::string::npos || !FileIO::readFileOnce(path, content)) continue;
+        // File tam con sot: nhom commit chua hoan tat (journal da duoc xu ly truoc), hai vi khong doi
+        std::unique_ptr<Transaction> transaction(Transaction::fromString(content));
+        if (transaction) receipts[transaction->transactionId] = std::move(transaction);
+    }
+    if (files.empty()) return 0;
+
+    // Bo cac giao dich da co trong log (crash sau khi log da xuong dia, truoc khi xoa bien nhan)
+    if (!receipts.empty()) {
+        LogScanner scanner;
+        MonotonicArena arena;
+        ArenaVector<TransactionView> logged{ArenaAllocator<TransactionView>(arena)};
+        if (scanner.collect([&receipts](const TransactionView& view) {
+                return receipts.count(view.transactionId.str()) > 0;
+            }, logged)) {
+            for (const TransactionView& view : logged) receipts.erase(view.transactionId.str());
+        }
+    }
+
+    int appended = 0;
+    for (const auto& entry : receipts) {
+        if (!logTransaction(*entry.second, true)) {
+            std::cerr << "Loi: Khong ghi bo sung duoc giao dich " << entry.first << " vao transactions.log." << std::endl;
+            return appended; // Giu bien nhan de lan khoi dong sau thu lai
+        }
+        appended++;
+    }
+    for (const std::string& path : files) std::remove(path.c_str());
+    return appended;
+}
@@ -8,15 +8,20 @@
 #include <iostream>
 #include <memory> // Them dong nay de su dung std::unique_ptr
 #include "utils.h"
+#include "intern.h"
+#include "arena.h"
+#include "holds.h"
+#include "limits.h"
 
 // Cau truc de luu thong tin giao dich
 struct Transaction {
     std::string transactionId;
-    std::string senderWalletId;
-    std::string receiverWalletId;
+    IdHandle sender;         // Handle cua senderWalletId (IdInterner)
+    IdHandle receiver;       // Handle cua receiverWalletId
     double amount;
     time_t timestamp;
     std::string status; // "completed" (hoan thanh), "pending" (cho xu ly), "failed" (that bai)
+    std::string requestKey;  // Ma yeu cau (idempotency key) cua client, rong neu khong co
     std::string description;
 
     // Chuyen doi Transaction thanh chuoi de luu
@@ -25,16 +30,34 @@ struct Transaction {
     static Transaction* fromString(const std::string& data);
 };
 
+// Ban ghi giao dich chi doc dung cho truy van: cac truong chuoi tro thang vao dong log
+// (vung log da mmap hoac ban sao trong MonotonicArena cua truy van) nen parse khong cap phat heap.
+// Chi hop le trong khi bo dem chua dong log con ton tai.
+struct TransactionView {
+    StringRef transactionId;
+    IdHandle sender;
+    IdHandle receiver;
+    double amount;
+    time_t timestamp;
+    StringRef status;
+    StringRef requestKey;    // Rong voi ban ghi khong co ma yeu cau
+    StringRef description;
+
+    // Parse mot dong log [data, data + length). Tra ve false neu dong khong hop le.
+    static bool parse(const char* data, std::size_t length, TransactionView& out);
+};
+
 class Wallet {
 public:
     std::string walletId;    // ID duy nhat cho vi
     std::string ownerUserId; // ID nguoi dung so huu vi
     double balance;          // So du diem
+    unsigned long long version; // Phien ban ban ghi: tang 1 moi lan luu (0 voi vi chua luu hoac file cu)
 
     // Constructor cho vi moi
     Wallet(std::string ownerUserId);
     // Constructor khi doc tu file
-    Wallet(std::string walletId, std::string ownerUserId, double balance);
+    Wallet(std::string walletId, std::string ownerUserId, double balance, unsigned long long version = 0);
 
     // Cac ham thanh vien
     void displayWalletInfo() const;
@@ -44,8 +67,13 @@ public:
     // Phuong thuc tinh de tao doi tuong Wallet tu chuoi doc tu file
     static Wallet* fromString(const std::string& data);
 
-    // Phuong thuc de luu doi tuong Wallet vao file
-    bool saveToFile() const;
+    // Phuong thuc tinh kiem tra noi dung file vi co hop le (dung khi phuc hoi du lieu)
+    static bool isValidRecord(const std::string& data);
+
+    // Phuong thuc de luu doi tuong Wallet vao file (so sanh-va-hoan-doi theo phien ban):
+    // chi ghi neu phien ban trong file van bang 'version' (chua bi thread/tien trinh khac ghi de
+    // tu luc doc), khi do 'version' tang 1. Tra ve false neu xung dot phien ban hoac loi ghi.
+    bool saveToFile();
 
     // Phuong thuc tinh de tai doi tuong Wallet tu file dua tren walletId
     // Thay doi kieu tra ve tu Wallet* sang std::unique_ptr<Wallet>
@@ -55,9 +83,65 @@ public:
     // Thay doi kieu tra ve tu Wallet* sang std::unique_ptr<Wallet>
     static std::unique_ptr<Wallet> loadWalletByUserId(const std::string& userId);
 
+    // Doc lai vi tu file, bo qua chi muc trong bo nho (dung sau xung dot phien ban) va cap nhat chi muc
+    static std::unique_ptr<Wallet> reloadFromFile(const std::string& walletId);
+
     // Phuong thuc thuc hien giao dich chuyen diem (atomic)
+    // Hai vi duoc ghi theo phien ban: neu vi bi ghi dong thoi (thread/tien trinh khac), doc lai
+    // hai vi va thu lai (toi da MAX_SAVE_ATTEMPTS lan).
     // Tra ve true neu thanh cong, false neu that bai
-    static bool transferPoints(const std::string& senderUserId, const std::string& receiverWalletId, double amount);
+    // 'requestKey' (tuy chon): ma yeu cau cua client; gui lai cung ma tra ve ket qua cua lan dau
+    // ma khong chuyen diem lan nua (xem IdempotencyTable)
+    // 'limits': han muc cua nguoi gui (TransferLimits::limitsFor); lan chuyen vuot han muc bi tu choi va ghi log
+    static bool transferPoints(const std::string& senderUserId, const std::string& receiverWalletId, double amount,
+                               const TransferLimits::Limits& limits, const std::string& requestKey = "");
+
+    // Chuyen diem hai giai doan (dung cung xac thuc OTP). Giu cho chi nam trong bo nho tien trinh nay nen
+    // chi dung duoc khi khong co tien trinh khac tren data/ (holdsAvailable); nguoc lai dung transferPoints.
+    static bool holdsAvailable();
+    // 1. reserveTransfer: kiem tra hai vi va giu 'amount' tren vi gui trong 'holdSeconds' giay
+    //    (chi trong bo nho, khong ghi file; so du lay theo phien ban trong file). Tra ve NO_HOLD neu bi
+    //    tu choi (so du, han muc, co tien trinh khac) hoac yeu cau da duoc xu ly. Han muc chi duoc kiem tra
+    //    o day, ghi nhan khi commit.
+    static HoldManager::HoldId reserveTransfer(const std::string& senderUserId, const std::string& receiverWalletId,
+                                               double amount, const TransferLimits::Limits& limits,
+                                               const std::string& requestKey, unsigned int holdSeconds);
+    // 2a. commitTransfer: chuyen so diem da giu (nhu transferPoints) va bo giu cho
+    static bool commitTransfer(const std::string& senderUserId, HoldManager::HoldId hold,
+                               const TransferLimits::Limits& limits, const std::string& requestKey = "");
+    // 2b. cancelTransfer: bo giu cho ma khong chuyen diem
+    static bool cancelTransfer(HoldManager::HoldId hold);
+
+    // Ghi giao dich vao transactions.log qua TransactionLogWriter (bat dong bo khi thread ghi dang chay).
+    // durable = true: cho den khi ban ghi da xuong dia.
+    static bool logTransaction(const Transaction& transaction, bool durable = false);
+
+    // Goi khi khoi dong (truoc khi dung lai bang ma yeu cau): giao dich co ma yeu cau da ghi hai vi
+    // nhung chua kip vao transactions.log (crash) duoc ghi bo sung tu bien nhan trong data/requests/.
+    // Tra ve so giao dich da ghi bo sung.
+    static int recoverReceipts();
+
+    static const int MAX_SAVE_ATTEMPTS = 8;
+
+private:
+    enum class SaveResult { Saved, Conflict, Failed };
+
+    // Kiem tra phien ban trong file va ghi (ghi tam neu dang trong FileIO::ReplaceGroup); goi khi da
+    // giu khoa cua vi. Chua cap nhat chi muc: goi publishSave() sau khi file da duoc commit.
+    SaveResult stageSave();
+    void publishSave() const;
+    // Phien ban dang luu trong file; false neu chua co file
+    bool readStoredVersion(unsigned long long& stored) const;
+    // Ghi hai vi cua mot lan chuyen 'amount' (da giu khoa hai vi). Neu khong Saved, so du trong bo nho
+    // duoc hoan lai. Saved: hai vi va 'transaction' (trang thai completed) vao luong thay doi.
+    // Giao dich co ma yeu cau: bien nhan (ban ghi log) duoc commit cung nhom voi hai vi, nen sau crash
+    // ma yeu cau khong the mat trong khi so du da doi.
+    static SaveResult saveTransfer(Wallet* senderWallet, Wallet* receiverWallet, double amount,
+                                   const Transaction& transaction);
+
+    static bool executeTransfer(Wallet* senderWallet, Wallet* receiverWallet, double amount,
+                                const TransferLimits::Limits& limits, const std::string& requestKey,
+                                const HoldManager::Hold* hold);
 };
 
 #endif // WALLET_H
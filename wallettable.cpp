@@ -0,0 +1,203 @@
+// wallettable.cpp
+#include "wallettable.h"
+#include "textscan.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WALLETTABLE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    // Ket qua mot lan quet mang so du
+    struct Moments {
+        double sum;
+        double sumSquares;
+        double min;
+        double max;
+        std::size_t zeros;
+    };
+
+    double sumScalar(const double* values, std::size_t n) {
+        // Bon tong rieng: bot phu thuoc giua cac phep cong lien tiep
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += values[i];
+            s1 += values[i + 1];
+            s2 += values[i + 2];
+            s3 += values[i + 3];
+        }
+        for (; i < n; ++i) s0 += values[i];
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    Moments momentsScalar(const double* values, std::size_t n) {
+        Moments m = {0.0, 0.0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0};
+        for (std::size_t i = 0; i < n; ++i) {
+            double v = values[i];
+            m.sum += v;
+            m.sumSquares += v * v;
+            m.min = std::min(m.min, v);
+            m.max = std::max(m.max, v);
+            if (v == 0.0) m.zeros++;
+        }
+        return m;
+    }
+
+#ifdef WALLETTABLE_X86
+    // 16 so du moi vong, bon thanh ghi tich luy doc lap
+    __attribute__((target("avx2")))
+    double sumAvx2(const double* values, std::size_t n) {
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+        __m256d s2 = _mm256_setzero_pd(), s3 = _mm256_setzero_pd();
+        std::size_t i = 0;
+        for (; i + 16 <= n; i += 16) {
+            s0 = _mm256_add_pd(s0, _mm256_loadu_pd(values + i));
+            s1 = _mm256_add_pd(s1, _mm256_loadu_pd(values + i + 4));
+            s2 = _mm256_add_pd(s2, _mm256_loadu_pd(values + i + 8));
+            s3 = _mm256_add_pd(s3, _mm256_loadu_pd(values + i + 12));
+        }
+        __m256d s = _mm256_add_pd(_mm256_add_pd(s0, s1), _mm256_add_pd(s2, s3));
+        double lanes[4];
+        _mm256_storeu_pd(lanes, s);
+        double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        for (; i < n; ++i) total += values[i];
+        return total;
+    }
+
+    __attribute__((target("avx2")))
+    Moments momentsAvx2(const double* values, std::size_t n) {
+        __m256d sum = _mm256_setzero_pd(), squares = _mm256_setzero_pd();
+        __m256d low = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+        __m256d high = _mm256_set1_pd(-std::numeric_limits<double>::infinity());
+        const __m256d zero = _mm256_setzero_pd();
+        std::size_t zeros = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m256d v = _mm256_loadu_pd(values + i);
+            sum = _mm256_add_pd(sum, v);
+            squares = _mm256_add_pd(squares, _mm256_mul_pd(v, v));
+            low = _mm256_min_pd(low, v);
+            high = _mm256_max_pd(high, v);
+            zeros += static_cast<std::size_t>(__builtin_popcount(_mm256_movemask_pd(_mm256_cmp_pd(v, zero, _CMP_EQ_OQ))));
+        }
+        double lanes[4], lanesSquares[4], lanesLow[4], lanesHigh[4];
+        _mm256_storeu_pd(lanes, sum);
+        _mm256_storeu_pd(lanesSquares, squares);
+        _mm256_storeu_pd(lanesLow, low);
+        _mm256_storeu_pd(lanesHigh, high);
+        Moments tail = momentsScalar(values + i, n - i);
+        Moments m;
+        m.sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + tail.sum;
+        m.sumSquares = (lanesSquares[0] + lanesSquares[1]) + (lanesSquares[2] + lanesSquares[3]) + tail.sumSquares;
+        m.min = std::min(std::min(std::min(lanesLow[0], lanesLow[1]), std::min(lanesLow[2], lanesLow[3])), tail.min);
+        m.max = std::max(std::max(std::max(lanesHigh[0], lanesHigh[1]), std::max(lanesHigh[2], lanesHigh[3])), tail.max);
+        m.zeros = zeros + tail.zeros;
+        return m;
+    }
+#endif
+}
+
+void WalletTable::clear() {
+    walletIds.clear();
+    owners.clear();
+    balances.clear();
+    versions.clear();
+    rowOf.clear();
+    rowOfOwner.clear();
+    baseRows = 0;
+}
+
+void WalletTable::loadBase(const double* base, const std::uint64_t* baseVersions, std::size_t count) {
+    clear();
+    balances.assign(base, base + count);
+    versions.assign(baseVersions, baseVersions + count);
+    const IdHandle none = IdInterner::NONE;
+    walletIds.assign(count, none);
+    owners.assign(count, none);
+    baseRows = count;
+}
+
+void WalletTable::bind(Row row, IdHandle walletId, IdHandle ownerUserId) {
+    walletIds[row] = walletId;
+    owners[row] = ownerUserId;
+    rowOf[walletId] = row;
+    rowOfOwner[ownerUserId] = row;
+}
+
+void WalletTable::reserve(std::size_t wallets) {
+    walletIds.reserve(wallets);
+    owners.reserve(wallets);
+    balances.reserve(wallets);
+    versions.reserve(wallets);
+    rowOf.reserve(wallets);
+    rowOfOwner.reserve(wallets);
+}
+
+WalletTable::Row WalletTable::upsert(IdHandle walletId, IdHandle ownerUserId, double balance, std::uint64_t version) {
+    auto it = rowOf.find(walletId);
+    if (it != rowOf.end()) {
+        Row row = it->second;
+        if (owners[row] != ownerUserId) {
+            auto previous = rowOfOwner.find(owners[row]);
+            if (previous != rowOfOwner.end() && previous->second == row) rowOfOwner.erase(previous);
+            owners[row] = ownerUserId;
+        }
+        rowOfOwner[ownerUserId] = row;
+        balances[row] = balance;
+        versions[row] = version;
+        return row;
+    }
+    Row row = static_cast<Row>(balances.size());
+    walletIds.push_back(walletId);
+    owners.push_back(ownerUserId);
+    balances.push_back(balance);
+    versions.push_back(version);
+    rowOf.emplace(walletId, row);
+    rowOfOwner[ownerUserId] = row;
+    return row;
+}
+
+WalletTable::Row WalletTable::find(IdHandle walletId) const {
+    auto it = rowOf.find(walletId);
+    return it == rowOf.end() ? NO_ROW : it->second;
+}
+
+WalletTable::Row WalletTable::findByOwner(IdHandle ownerUserId) const {
+    auto it = rowOfOwner.find(ownerUserId);
+    return it == rowOfOwner.end() ? NO_ROW : it->second;
+}
+
+double WalletTable::totalSupply() const {
+#ifdef WALLETTABLE_X86
+    if (TextScan::activeIsa() == TextScan::Isa::AVX2) {
+        return sumAvx2(balances.data(), balances.size());
+    }
+#endif
+    return sumScalar(balances.data(), balances.size());
+}
+
+WalletTable::Distribution WalletTable::distribution() const {
+    Distribution d = {balances.size(), 0.0, 0.0, 0.0, 0.0, 0.0, 0};
+    if (balances.empty()) return d;
+    Moments m;
+#ifdef WALLETTABLE_X86
+    if (TextScan::activeIsa() == TextScan::Isa::AVX2) {
+        m = momentsAvx2(balances.data(), balances.size());
+    } else
+#endif
+    {
+        m = momentsScalar(balances.data(), balances.size());
+    }
+    double n = static_cast<double>(balances.size());
+    d.total = m.sum;
+    d.min = m.min;
+    d.max = m.max;
+    d.mean = m.sum / n;
+    d.stddev = std::sqrt(std::max(0.0, m.sumSquares / n - d.mean * d.mean));
+    d.empty = m.zeros;
+    return d;
+}
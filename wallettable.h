@@ -0,0 +1,68 @@
+// wallettable.h
+#ifndef WALLETTABLE_H
+#define WALLETTABLE_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+#include "intern.h"
+
+// Bang vi thuong tru dang struct-of-arrays: moi cot (ID vi, chu so huu, so du, phien ban) la mot
+// mang lien tuc, vi tri (row) cua mot vi khong doi suot vong doi cua bang (cho den clear()).
+// Cac phep tong hop chi quet mang so du lien tuc (AVX2 neu CPU ho tro) thay vi doc tung file vi.
+// Cac hang dau tien co the duoc nap thang tu cot so du / phien ban cua snapshot (loadBase): ID vi va
+// chu so huu cua cac hang nay chua duoc intern (IdInterner::NONE) cho den khi vi thay doi lan dau (bind).
+// Bang khong tu dong bo: nguoi dung (DataIndex) giu khoa cua minh khi truy cap.
+class WalletTable {
+public:
+    typedef std::uint32_t Row;
+    static const Row NO_ROW = 0xffffffffu;
+
+    // Phan bo so du cua tat ca cac vi
+    struct Distribution {
+        std::size_t wallets;
+        double total;       // Tong cung diem
+        double min;
+        double max;
+        double mean;
+        double stddev;      // Do lech chuan (tong the)
+        std::size_t empty;  // So vi co so du 0
+    };
+
+    void clear();
+    void reserve(std::size_t wallets);
+
+    // Xoa bang roi nap 'count' hang dau tu cac cot cua snapshot (sao chep khoi, khong parse, khong intern)
+    void loadBase(const double* balances, const std::uint64_t* versions, std::size_t count);
+    std::size_t baseSize() const { return baseRows; }
+    // Gan ID cho mot hang nap tu snapshot de cac lan upsert/find sau tim thay hang bang handle
+    void bind(Row row, IdHandle walletId, IdHandle ownerUserId);
+
+    // Them vi moi hoac cap nhat vi da co (kem phien ban ban ghi cua vi). Tra ve hang cua vi.
+    Row upsert(IdHandle walletId, IdHandle ownerUserId, double balance, std::uint64_t version);
+
+    Row find(IdHandle walletId) const;          // NO_ROW neu khong co
+    Row findByOwner(IdHandle ownerUserId) const; // NO_ROW neu khong co
+
+    std::size_t size() const { return balances.size(); }
+    IdHandle walletAt(Row row) const { return walletIds[row]; }
+    IdHandle ownerAt(Row row) const { return owners[row]; }
+    double balanceAt(Row row) const { return balances[row]; }
+    std::uint64_t versionAt(Row row) const { return versions[row]; }
+
+    // Tong so du cua tat ca cac vi
+    double totalSupply() const;
+    Distribution distribution() const;
+
+private:
+    std::vector<IdHandle> walletIds;
+    std::vector<IdHandle> owners;
+    std::vector<double> balances;
+    std::vector<std::uint64_t> versions;    // Phien ban ban ghi vi (truong version: trong file vi)
+    std::unordered_map<IdHandle, Row> rowOf;        // walletId -> hang
+    std::unordered_map<IdHandle, Row> rowOfOwner;   // ownerUserId -> hang
+    std::size_t baseRows = 0;                       // So hang nap tu snapshot
+};
+
+#endif // WALLETTABLE_H